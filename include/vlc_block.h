@@ -134,6 +134,11 @@ struct block_t
  *      with preheader and or body (increase
  *      and decrease are supported). Use it as it is optimised.
  * - block_Duplicate : create a copy of a block.
+ * - block_Shared : turn a block into a reference counted shared block.
+ * - block_Share : take a new reference to the payload of a shared block
+ *      (the payload is read-only), or copy a block that is not shared.
+ * - block_Unshare : get a writable block, copying the payload only if it is
+ *      still referenced elsewhere. block_Realloc does it when needed.
  ****************************************************************************/
 VLC_API void block_Init( block_t *, void *, size_t );
 VLC_API block_t *block_Alloc( size_t ) VLC_USED VLC_MALLOC;
@@ -166,6 +171,10 @@ static inline void block_Release( block_t *p_block )
     p_block->pf_release( p_block );
 }
 
+VLC_API block_t *block_Shared( block_t * ) VLC_USED;
+VLC_API block_t *block_Share( block_t * ) VLC_USED;
+VLC_API block_t *block_Unshare( block_t * ) VLC_USED;
+
 VLC_API block_t *block_heap_Alloc(void *, size_t) VLC_USED VLC_MALLOC;
 VLC_API block_t *block_mmap_Alloc(void *addr, size_t length) VLC_USED VLC_MALLOC;
 VLC_API block_t * block_shm_Alloc(void *addr, size_t length) VLC_USED VLC_MALLOC;
@@ -250,6 +250,40 @@ VLC_API int filter_Blend( filter_t *, picture_t *p_dst, int i_dst_x, int i_dst_y
  */
 VLC_API void filter_DeleteBlend( filter_t * );
 
+/**
+ * Slice callback of a slice-parallel filter.
+ *
+ * It processes the i_slice-th of i_slices horizontal bands of the picture,
+ * see filter_SliceRow().
+ */
+typedef void (*filter_slice_t)( filter_t *, void *p_data,
+                                unsigned i_slice, unsigned i_slices );
+
+/**
+ * It runs a slice-parallel filter.
+ *
+ * The callback is called once for each slice, on the slice worker pool
+ * shared by all filters (see --video-filter-threads) and on the calling
+ * thread. It returns once all slices are done. There are at most i_max
+ * slices, so that a filter can keep bands a minimum size; the actual count
+ * depends on the pool size and is passed to the callback.
+ *
+ * Slices may run concurrently: they must not write outside their band.
+ */
+VLC_API void filter_RunSlices( filter_t *, unsigned i_max, filter_slice_t, void *p_data );
+
+/**
+ * It returns the first of i_rows rows of the i_slice-th of i_slices bands.
+ *
+ * The band ends where the next one starts. Bands computed this way for
+ * different planes of a picture cover them completely.
+ */
+static inline unsigned filter_SliceRow( unsigned i_slice, unsigned i_slices,
+                                        unsigned i_rows )
+{
+    return (uint64_t)i_rows * i_slice / i_slices;
+}
+
 /**
  * Create a picture_t *(*)( filter_t *, picture_t * ) compatible wrapper
  * using a void (*)( filter_t *, picture_t *, picture_t * ) function
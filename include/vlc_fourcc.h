@@ -227,6 +227,8 @@
 #define VLC_CODEC_NV16            VLC_FOURCC('N','V','1','6')
 /* 2 planes Y/VU 4:2:2 */
 #define VLC_CODEC_NV61            VLC_FOURCC('N','V','6','1')
+/* 2 planes Y/UV 4:2:0 10-bit stored in the MSBs of 16 bits LE */
+#define VLC_CODEC_P010            VLC_FOURCC('P','0','1','0')
 
 /* Image codec (video) */
 #define VLC_CODEC_PNG             VLC_FOURCC('p','n','g',' ')
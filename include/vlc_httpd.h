@@ -139,6 +139,17 @@ VLC_API httpd_stream_t * httpd_StreamNew( httpd_host_t *, const char *psz_url, c
 VLC_API void httpd_StreamDelete( httpd_stream_t * );
 VLC_API int httpd_StreamHeader( httpd_stream_t *, uint8_t *p_data, int i_data );
 VLC_API int httpd_StreamSend( httpd_stream_t *, uint8_t *p_data, int i_data );
+VLC_API int httpd_StreamSendBlock( httpd_stream_t *, block_t * );
+VLC_API void httpd_StreamSetBufferSize( httpd_stream_t *, size_t );
+
+/* What happens to stream clients that fall out of the buffer */
+enum
+{
+    HTTPD_STREAM_SLOW_SKIP,         /* resume at the live position */
+    HTTPD_STREAM_SLOW_KEYFRAME,     /* resume at the last keyframe (default) */
+    HTTPD_STREAM_SLOW_DISCONNECT,   /* close the connection */
+};
+VLC_API void httpd_StreamSetSlowPolicy( httpd_stream_t *, int );
 
 
 /* Msg functions facilities */
@@ -305,6 +305,8 @@ struct input_stats_t
     /* Vout */
     int64_t i_displayed_pictures;
     int64_t i_lost_pictures;
+    int64_t i_copied_pictures; /* not rendered into the display buffers */
+    float f_picture_copy_rate;
 
     /* Sout */
     int64_t i_sent_packets;
@@ -34,8 +34,11 @@
 /**
  * Picture pool handle
  *
- * XXX it is not thread safe, all pool manipulations and picture_Release
- * must be properly locked if needed.
+ * picture_pool_Get, picture_pool_Wait and picture_Release of the pool
+ * pictures may be called from any thread. picture_pool_Get does not lock.
+ * picture_Release only takes the pool mutex, used by picture_pool_Wait,
+ * when a thread waits. The other pool manipulations must be properly
+ * locked if needed.
  */
 typedef struct picture_pool_t picture_pool_t;
 
@@ -106,6 +109,15 @@ VLC_API picture_t * picture_pool_Get( picture_pool_t * ) VLC_USED;
  */
 VLC_API void picture_pool_NonEmpty( picture_pool_t *, bool reset );
 
+/**
+ * It waits until a picture has been released to the pool since the last
+ * picture_pool_Get that returned NULL, or until the given deadline.
+ *
+ * It replaces polling picture_pool_Get when the pool is empty. A picture
+ * may still be unavailable when it returns, if its lock callback failed.
+ */
+VLC_API void picture_pool_Wait( picture_pool_t *, mtime_t deadline );
+
 /**
  * It reserves picture_count pictures from the given pool and returns
  * a new pool with thoses pictures.
@@ -121,6 +133,14 @@ VLC_API picture_pool_t * picture_pool_Reserve(picture_pool_t *, int picture_coun
  */
 VLC_API int picture_pool_GetSize(picture_pool_t *);
 
+/**
+ * It tells if a picture comes from the given pool.
+ *
+ * The pictures of a pool reserved with picture_pool_Reserve() belong to
+ * its master pool, and to the pools reserved from the same master.
+ */
+VLC_API bool picture_pool_OwnsPic(picture_pool_t *, picture_t *) VLC_USED;
+
 
 #endif /* VLC_PICTURE_POOL_H */
 
@@ -39,6 +39,7 @@ extern "C" {
 
 #include <sys/types.h>
 #include <vlc_es.h>
+#include <vlc_atomic.h>
 
 /** Stream output instance (FIXME: should be private to src/ to avoid
  * invalid unsynchronized access) */
@@ -51,6 +52,9 @@ struct sout_instance_t
     /** count of output that can't control the space */
     int                 i_out_pace_nocontrol;
 
+    /** count of mux inputs queueing more than their bounds allow */
+    atomic_uint         i_congested;
+
     vlc_mutex_t         lock;
     sout_stream_t       *p_stream;
 };
@@ -132,6 +136,9 @@ struct  sout_mux_t
     bool  b_waiting_stream;
     /* we wait one second after first stream added */
     mtime_t     i_add_stream_start;
+    /* bounds of each input queue, 0 if unbounded */
+    size_t      i_max_bytes;
+    mtime_t     i_max_delay;
 };
 
 enum sout_mux_query_e
@@ -149,6 +156,14 @@ struct sout_input_t
     block_fifo_t    *p_fifo;
 
     void            *p_sys;
+
+    /* XXX private to stream_output.c */
+    bool            b_congested;
+    bool            b_resync;       /* dropping until the next keyframe */
+    bool            b_keyframes;    /* the stream flags its keyframes */
+    size_t          i_queued_peak;  /* most bytes ever queued */
+    unsigned        i_dropped;
+    size_t          i_dropped_bytes;
 };
 
 
@@ -54,6 +54,11 @@
 
 #include <assert.h>
 #include <limits.h>
+/* Without poll.h, vlc_fixups.h declares struct pollfd and poll(), and
+ * libcompat implements it: the idle connection probe works everywhere */
+#ifdef HAVE_POLL
+#   include <poll.h>
+#endif
 
 /*****************************************************************************
  * Module descriptor
@@ -88,6 +93,16 @@ static void Close( vlc_object_t * );
 #define REFERER_TEXT N_("HTTP referer value")
 #define REFERER_LONGTEXT N_("Customize the HTTP referer, simulating a previous document")
 
+#define KEEP_ALIVE_TEXT N_("Persistent connections")
+#define KEEP_ALIVE_LONGTEXT N_("Keep idle HTTP/1.1 connections open and " \
+    "reuse them for the next requests to the same server, instead of " \
+    "connecting again on every seek.")
+
+#define PARALLEL_TEXT N_("Parallel connections")
+#define PARALLEL_LONGTEXT N_("Number of connections used to download " \
+    "ahead of the read position with concurrent range requests. This may " \
+    "be faster on high latency links. 0 and 1 disable this.")
+
 #define UA_TEXT N_("User Agent")
 #define UA_LONGTEXT N_("The name and version of the program will be " \
     "provided to the HTTP server. They must be separated by a forward " \
@@ -118,6 +133,10 @@ vlc_module_begin ()
         change_safe()
     add_bool( "http-forward-cookies", true, FORWARD_COOKIES_TEXT,
               FORWARD_COOKIES_LONGTEXT, true )
+    add_bool( "http-keep-alive", true, KEEP_ALIVE_TEXT,
+              KEEP_ALIVE_LONGTEXT, true )
+    add_integer( "http-parallel", 0, PARALLEL_TEXT, PARALLEL_LONGTEXT, true )
+        change_integer_range( 0, 8 )
     /* 'itpc' = iTunes Podcast */
     add_shortcut( "http", "https", "unsv", "itpc", "icyx" )
     set_callbacks( Open, Close )
@@ -127,14 +146,48 @@ vlc_module_end ()
  * Local prototypes
  *****************************************************************************/
 
+typedef struct http_pool_t http_pool_t;
+
+/* A range of the resource downloaded ahead of the read position */
+typedef struct http_range_t http_range_t;
+struct http_range_t
+{
+    uint64_t      i_start;
+    size_t        i_size;
+    size_t        i_filled;   /* bytes received so far */
+    uint8_t      *p_buffer;
+    bool          b_busy;     /* being downloaded by a worker */
+    bool          b_dropped;  /* to be freed by its worker */
+    bool          b_failed;
+    http_range_t *p_next;
+};
+
+typedef struct
+{
+    access_t     *p_access;
+    vlc_thread_t  thread;
+    int           fd;
+    vlc_tls_t    *p_tls;
+    bool          b_persist;
+} http_worker_t;
+
 struct access_sys_t
 {
     int fd;
     bool b_error;
-    vlc_tls_creds_t *p_creds;
+    vlc_tls_creds_t *p_creds; /* owned by the connection pool */
     vlc_tls_t *p_tls;
     v_socket_t *p_vs;
 
+    /* Persistent connections */
+    http_pool_t *p_pool;
+    char       *psz_conn_key;
+    bool        b_keep_alive;
+    mtime_t     i_idle_timeout;
+    bool        b_ranges;   /* the server answered a Range request */
+    uint64_t    i_range;    /* length of the next bounded range, 0 if none */
+    bool        b_bounded;  /* the response is a bounded range */
+
     /* From uri */
     vlc_url_t url;
     char    *psz_user_agent;
@@ -185,6 +238,23 @@ struct access_sys_t
     bool b_has_size;
 
     vlc_array_t * cookies;
+
+    /* Parallel read-ahead */
+    bool b_ahead;
+    struct
+    {
+        vlc_mutex_t    lock;
+        vlc_cond_t     wait;
+        http_worker_t *p_workers;
+        unsigned       i_workers;
+        http_range_t  *p_ranges;  /* contiguous, in order */
+        http_range_t **pp_last;
+        uint64_t       i_pos;     /* read position */
+        uint64_t       i_next;    /* first byte not requested yet */
+        size_t         i_chunk;   /* size of the next requests */
+        bool           b_error;
+        bool           b_close;
+    } ahead;
 };
 
 /* */
@@ -202,6 +272,62 @@ static int Connect( access_t *, uint64_t );
 static int Request( access_t *p_access, uint64_t i_tell );
 static void Disconnect( access_t * );
 
+/* Persistent connections
+ *
+ * Idle HTTP/1.1 connections are kept in a pool shared by all the HTTP
+ * accesses of a libvlc instance, so that seeking or opening another URL on
+ * the same server does not cost a new TCP (and TLS) handshake. The pool
+ * also owns the TLS credentials. It is created by the first HTTP access and
+ * destroyed, with its idle connections, when the last one is closed: only
+ * accesses whose lifetimes overlap share connections.
+ *
+ * A response can only be drained cheaply near its end, so once the server
+ * is known to honour ranges, reading after a seek requests bounded ranges,
+ * starting small and doubling, instead of the rest of the file. A seek
+ * close to the end of such a range reuses the connection. Otherwise the
+ * connection is closed, and the next request opens a new one. */
+#define HTTP_POOL_SIZE      8       /* idle connections kept at most */
+#define HTTP_IDLE_TIMEOUT   (INT64_C(5) * CLOCK_FREQ)
+#define HTTP_DRAIN_MAX      65536   /* bytes read to finish a response */
+
+typedef struct http_conn_t http_conn_t;
+struct http_conn_t
+{
+    char        *psz_key;
+    int          fd;
+    vlc_tls_t   *p_tls;
+    mtime_t      i_expiry;
+    http_conn_t *p_next;
+};
+
+struct http_pool_t
+{
+    unsigned         i_refs;
+    vlc_tls_creds_t *p_creds;
+    http_conn_t     *p_idle;    /* most recently used first */
+    unsigned         i_idle;
+    uint64_t         i_new;     /* connections opened */
+    uint64_t         i_reused;  /* connections taken from the pool */
+};
+
+static vlc_mutex_t pool_lock = VLC_STATIC_MUTEX;
+
+static http_pool_t *PoolHold( access_t *, bool );
+static void PoolRelease( access_t *, http_pool_t * );
+static bool PoolTake( access_t *, int *, vlc_tls_t ** );
+static int PoolPut( access_t *, int, vlc_tls_t *, mtime_t );
+
+/* Parallel read-ahead */
+#define HTTP_AHEAD_MIN      (256 * 1024)
+#define HTTP_AHEAD_MAX      (8 * 1024 * 1024)
+#define HTTP_AHEAD_DURATION (2 * CLOCK_FREQ) /* wanted duration of a request */
+
+static void AheadStart( access_t * );
+static void AheadStop( access_t * );
+static ssize_t ReadAhead( access_t *, uint8_t *, size_t );
+static void SeekAhead( access_t *, uint64_t );
+static void SendCookies( access_t *, int, v_socket_t * );
+
 /* Small Cookie utilities. Cookies support is partial. */
 static char * cookie_get_content( const char * cookie );
 static char * cookie_get_domain( const char * cookie );
@@ -249,6 +375,11 @@ static int OpenWithCookies( vlc_object_t *p_this, const char *psz_access,
     p_access->pf_read = ReadCompressed;
 #endif
     p_sys->fd = -1;
+    p_sys->p_pool = NULL;
+    p_sys->psz_conn_key = NULL;
+    p_sys->b_ranges = false;
+    p_sys->i_range = 0;
+    p_sys->b_bounded = false;
     p_sys->b_proxy = false;
     p_sys->psz_proxy_passbuf = NULL;
     p_sys->i_version = 1;
@@ -305,14 +436,18 @@ static int OpenWithCookies( vlc_object_t *p_this, const char *psz_access,
     if( !strncmp( psz_access, "https", 5 ) )
     {
         /* HTTP over SSL */
-        p_sys->p_creds = vlc_tls_ClientCreate( p_this );
-        if( p_sys->p_creds == NULL )
+        p_sys->p_pool = PoolHold( p_access, true );
+        if( p_sys->p_pool == NULL )
             goto error;
+        p_sys->p_creds = p_sys->p_pool->p_creds;
         if( p_sys->url.i_port <= 0 )
             p_sys->url.i_port = 443;
     }
     else
     {
+        p_sys->p_pool = PoolHold( p_access, false );
+        if( p_sys->p_pool == NULL )
+            goto error;
         if( p_sys->url.i_port <= 0 )
             p_sys->url.i_port = 80;
     }
@@ -412,6 +547,27 @@ static int OpenWithCookies( vlc_object_t *p_this, const char *psz_access,
 
     p_sys->b_reconnect = var_InheritBool( p_access, "http-reconnect" );
     p_sys->b_continuous = var_InheritBool( p_access, "http-continuous" );
+    p_sys->b_keep_alive = var_InheritBool( p_access, "http-keep-alive" );
+
+    /* Idle connections are shared with the requests going through the same
+     * socket: to the proxy, unless there is a TLS tunnel to the server */
+    int i_key;
+    if( p_sys->b_proxy && p_sys->p_creds == NULL )
+        i_key = asprintf( &p_sys->psz_conn_key, "proxy://%s:%d",
+                          p_sys->proxy.psz_host, p_sys->proxy.i_port );
+    else if( p_sys->b_proxy )
+        i_key = asprintf( &p_sys->psz_conn_key, "https://%s:%d@%s:%d",
+                          p_sys->url.psz_host, p_sys->url.i_port,
+                          p_sys->proxy.psz_host, p_sys->proxy.i_port );
+    else
+        i_key = asprintf( &p_sys->psz_conn_key, "%s://%s:%d",
+                          p_sys->p_creds != NULL ? "https" : "http",
+                          p_sys->url.psz_host, p_sys->url.i_port );
+    if( i_key == -1 )
+    {
+        p_sys->psz_conn_key = NULL;
+        goto error;
+    }
 
 connect:
     /* Connect */
@@ -512,8 +668,11 @@ connect:
         free( p_sys->psz_user_agent );
         free( p_sys->psz_referrer );
 
+        /* The pool is released after the new run, so that it can reuse the
+         * connection if the redirection points to the same server */
         Disconnect( p_access );
-        vlc_tls_Delete( p_sys->p_creds );
+        http_pool_t *p_pool = p_sys->p_pool;
+        free( p_sys->psz_conn_key );
         cookies = p_sys->cookies;
 #ifdef HAVE_ZLIB_H
         inflateEnd( &p_sys->inflate.stream );
@@ -521,8 +680,10 @@ connect:
         free( p_sys );
 
         /* Do new Open() run with new data */
-        return OpenWithCookies( p_this, psz_protocol, i_redirect - 1,
-                                cookies );
+        int i_ret = OpenWithCookies( p_this, psz_protocol, i_redirect - 1,
+                                     cookies );
+        PoolRelease( p_access, p_pool );
+        return i_ret;
     }
 
     if( p_sys->b_mms )
@@ -593,6 +754,8 @@ connect:
 
     if( p_sys->b_reconnect ) msg_Dbg( p_access, "auto re-connect enabled" );
 
+    AheadStart( p_access );
+
     return VLC_SUCCESS;
 
 error:
@@ -606,7 +769,8 @@ error:
     free( p_sys->psz_referrer );
 
     Disconnect( p_access );
-    vlc_tls_Delete( p_sys->p_creds );
+    PoolRelease( p_access, p_sys->p_pool );
+    free( p_sys->psz_conn_key );
 
     if( p_sys->cookies )
     {
@@ -631,6 +795,9 @@ static void Close( vlc_object_t *p_this )
     access_t     *p_access = (access_t*)p_this;
     access_sys_t *p_sys = p_access->p_sys;
 
+    if( p_sys->b_ahead )
+        AheadStop( p_access );
+
     vlc_UrlClean( &p_sys->url );
     http_auth_Reset( &p_sys->auth );
     vlc_UrlClean( &p_sys->proxy );
@@ -648,7 +815,8 @@ static void Close( vlc_object_t *p_this )
     free( p_sys->psz_referrer );
 
     Disconnect( p_access );
-    vlc_tls_Delete( p_sys->p_creds );
+    PoolRelease( p_access, p_sys->p_pool );
+    free( p_sys->psz_conn_key );
 
     if( p_sys->cookies )
     {
@@ -726,9 +894,23 @@ static ssize_t Read( access_t *p_access, uint8_t *p_buffer, size_t i_len )
     access_sys_t *p_sys = p_access->p_sys;
     int i_read;
 
+    if( p_sys->b_ahead )
+        return ReadAhead( p_access, p_buffer, i_len );
+
     if( p_sys->fd == -1 )
         goto fatal;
 
+    if( p_sys->b_bounded && p_sys->i_remaining == 0
+     && p_access->info.i_pos < p_access->info.i_size )
+    {
+        /* End of a bounded range: the connection goes back to the pool,
+         * and the next range, twice as long, is requested on it */
+        p_sys->i_range = __MIN( 2 * p_sys->i_range, HTTP_AHEAD_MAX );
+        Disconnect( p_access );
+        if( Connect( p_access, p_access->info.i_pos ) )
+            goto fatal;
+    }
+
     if( p_sys->b_has_size )
     {
         /* Remaining bytes in the file */
@@ -931,6 +1113,12 @@ static int Seek( access_t *p_access, uint64_t i_pos )
 {
     msg_Dbg( p_access, "trying to seek to %"PRId64, i_pos );
 
+    if( p_access->p_sys->b_ahead )
+    {
+        SeekAhead( p_access, i_pos );
+        return VLC_SUCCESS;
+    }
+
     Disconnect( p_access );
 
     if( p_access->info.i_size
@@ -944,6 +1132,10 @@ static int Seek( access_t *p_access, uint64_t i_pos )
         }
         return retval;
     }
+    /* Ask for a bounded range, so that the connection can be reused by the
+     * next seek or range */
+    if( p_access->p_sys->b_ranges && p_access->p_sys->b_keep_alive )
+        p_access->p_sys->i_range = HTTP_AHEAD_MIN;
     if( Connect( p_access, i_pos ) )
     {
         msg_Err( p_access, "seek failed" );
@@ -1058,18 +1250,36 @@ static int Connect( access_t *p_access, uint64_t i_tell )
     p_sys->i_remaining = 0;
     p_sys->b_persist = false;
     p_sys->b_has_size = false;
+    p_sys->i_code = 0;
+    p_sys->i_idle_timeout = HTTP_IDLE_TIMEOUT;
     p_access->info.i_size = 0;
     p_access->info.i_pos  = i_tell;
     p_access->info.b_eof  = false;
 
     /* Open connection */
     assert( p_sys->fd == -1 ); /* No open sockets (leaking fds is BAD) */
+    if( PoolTake( p_access, &p_sys->fd, &p_sys->p_tls ) )
+    {
+        p_sys->p_vs = p_sys->p_tls != NULL ? &p_sys->p_tls->sock : NULL;
+        if( Request( p_access, i_tell ) == VLC_SUCCESS )
+            return 0;
+        /* The server may close an idle connection at any time: retry on a
+         * new one if the request got no answer at all */
+        if( p_sys->i_code != 0 || p_sys->b_error ||
+            !vlc_object_alive( p_access ) )
+            return -2;
+        msg_Dbg( p_access, "idle connection was closed, connecting again" );
+    }
+
     p_sys->fd = net_ConnectTCP( p_access, srv.psz_host, srv.i_port );
     if( p_sys->fd == -1 )
     {
         msg_Err( p_access, "cannot connect to %s:%d", srv.psz_host, srv.i_port );
         return -1;
     }
+    vlc_mutex_lock( &pool_lock );
+    p_sys->p_pool->i_new++;
+    vlc_mutex_unlock( &pool_lock );
     setsockopt (p_sys->fd, SOL_SOCKET, SO_KEEPALIVE, &(int){ 1 }, sizeof (int));
 
     /* Initialize TLS/SSL session */
@@ -1152,12 +1362,43 @@ static int Connect( access_t *p_access, uint64_t i_tell )
 }
 
 
+static void SendCookies( access_t *p_access, int fd, v_socket_t *pvs )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    if( p_sys->cookies )
+    {
+        int i;
+        for( i = 0; i < vlc_array_count( p_sys->cookies ); i++ )
+        {
+            const char * cookie = vlc_array_item_at_index( p_sys->cookies, i );
+            char * psz_cookie_content = cookie_get_content( cookie );
+            char * psz_cookie_domain = cookie_get_domain( cookie );
+
+            assert( psz_cookie_content );
+
+            /* FIXME: This is clearly not conforming to the rfc */
+            bool is_in_right_domain = (!psz_cookie_domain || strstr( p_sys->url.psz_host, psz_cookie_domain ));
+
+            if( is_in_right_domain )
+            {
+                msg_Dbg( p_access, "Sending Cookie %s", psz_cookie_content );
+                if( net_Printf( p_access, fd, pvs, "Cookie: %s\r\n", psz_cookie_content ) < 0 )
+                    msg_Err( p_access, "failed to send Cookie" );
+            }
+            free( psz_cookie_content );
+            free( psz_cookie_domain );
+        }
+    }
+}
+
 static int Request( access_t *p_access, uint64_t i_tell )
 {
     access_sys_t   *p_sys = p_access->p_sys;
     char           *psz ;
     v_socket_t     *pvs = p_sys->p_vs;
     p_sys->b_persist = false;
+    p_sys->b_bounded = false;
 
     p_sys->i_remaining = 0;
 
@@ -1190,38 +1431,25 @@ static int Request( access_t *p_access, uint64_t i_tell )
     /* Offset */
     if( p_sys->i_version == 1 && ! p_sys->b_continuous )
     {
-        p_sys->b_persist = true;
-        net_Printf( p_access, p_sys->fd, pvs,
-                    "Range: bytes=%"PRIu64"-\r\n", i_tell );
-        net_Printf( p_access, p_sys->fd, pvs, "Connection: close\r\n" );
-    }
-
-    /* Cookies */
-    if( p_sys->cookies )
-    {
-        int i;
-        for( i = 0; i < vlc_array_count( p_sys->cookies ); i++ )
+        if( p_sys->b_keep_alive && p_sys->i_range > 0 )
         {
-            const char * cookie = vlc_array_item_at_index( p_sys->cookies, i );
-            char * psz_cookie_content = cookie_get_content( cookie );
-            char * psz_cookie_domain = cookie_get_domain( cookie );
-
-            assert( psz_cookie_content );
-
-            /* FIXME: This is clearly not conforming to the rfc */
-            bool is_in_right_domain = (!psz_cookie_domain || strstr( p_sys->url.psz_host, psz_cookie_domain ));
-
-            if( is_in_right_domain )
-            {
-                msg_Dbg( p_access, "Sending Cookie %s", psz_cookie_content );
-                if( net_Printf( p_access, p_sys->fd, pvs, "Cookie: %s\r\n", psz_cookie_content ) < 0 )
-                    msg_Err( p_access, "failed to send Cookie" );
-            }
-            free( psz_cookie_content );
-            free( psz_cookie_domain );
+            net_Printf( p_access, p_sys->fd, pvs,
+                        "Range: bytes=%"PRIu64"-%"PRIu64"\r\n",
+                        i_tell, i_tell + p_sys->i_range - 1 );
+            p_sys->b_bounded = true;
         }
+        else
+            net_Printf( p_access, p_sys->fd, pvs,
+                        "Range: bytes=%"PRIu64"-\r\n", i_tell );
+        if( p_sys->b_keep_alive )
+            p_sys->b_persist = true;
+        else
+            net_Printf( p_access, p_sys->fd, pvs, "Connection: close\r\n" );
     }
 
+    /* Cookies */
+    SendCookies( p_access, p_sys->fd, pvs );
+
     /* Authentication */
     if( p_sys->url.psz_username || p_sys->url.psz_password )
         AuthReply( p_access, "", &p_sys->url, &p_sys->auth );
@@ -1237,6 +1465,7 @@ static int Request( access_t *p_access, uint64_t i_tell )
     if( net_Printf( p_access, p_sys->fd, pvs, "\r\n" ) < 0 )
     {
         msg_Err( p_access, "failed to send request" );
+        p_sys->b_persist = false;
         Disconnect( p_access );
         return VLC_EGENERIC;
     }
@@ -1251,12 +1480,16 @@ static int Request( access_t *p_access, uint64_t i_tell )
     {
         p_sys->psz_protocol = "HTTP";
         p_sys->i_code = atoi( &psz[9] );
+        /* HTTP/1.0 servers close the connection after the response */
+        if( psz[7] == '0' )
+            p_sys->b_persist = false;
     }
     else if( !strncmp( psz, "ICY", 3 ) )
     {
         p_sys->psz_protocol = "ICY";
         p_sys->i_code = atoi( &psz[4] );
         p_sys->b_reconnect = true;
+        p_sys->b_persist = false;
     }
     else
     {
@@ -1349,6 +1582,7 @@ static int Request( access_t *p_access, uint64_t i_tell )
             uint64_t i_nsize = p_access->info.i_size;
             sscanf(p,"bytes %"SCNu64"-%"SCNu64"/%"SCNu64,&i_ntell,&i_nend,&i_nsize);
             if(i_nend > i_ntell ) {
+                p_sys->b_ranges = true;
                 p_access->info.i_pos = i_ntell;
                 p_sys->i_icy_offset  = i_ntell;
                 p_sys->i_remaining = i_nend+1-i_ntell;
@@ -1369,6 +1603,17 @@ static int Request( access_t *p_access, uint64_t i_tell )
                 p_sys->b_persist = false;
             }
         }
+        else if( !strcasecmp( psz, "Keep-Alive" ) )
+        {
+            /* The server tells how long it keeps an idle connection */
+            const char *psz_timeout = strstr( p, "timeout=" );
+            if( psz_timeout != NULL )
+            {
+                int i_timeout = atoi( psz_timeout + 8 );
+                if( i_timeout > 0 && CLOCK_FREQ * i_timeout < p_sys->i_idle_timeout )
+                    p_sys->i_idle_timeout = CLOCK_FREQ * i_timeout;
+            }
+        }
         else if( !strcasecmp( psz, "Location" ) )
         {
             char * psz_new_loc;
@@ -1546,6 +1791,7 @@ static int Request( access_t *p_access, uint64_t i_tell )
     return VLC_SUCCESS;
 
 error:
+    p_sys->b_persist = false;
     Disconnect( p_access );
     return VLC_EGENERIC;
 }
@@ -1553,10 +1799,23 @@ error:
 /*****************************************************************************
  * Disconnect:
  *****************************************************************************/
+static bool ConnectionReusable( access_t *p_access );
+
 static void Disconnect( access_t *p_access )
 {
     access_sys_t *p_sys = p_access->p_sys;
 
+    /* Hand the connection over to the pool if the server keeps it open */
+    if( p_sys->fd != -1 && ConnectionReusable( p_access )
+     && PoolPut( p_access, p_sys->fd, p_sys->p_tls,
+                 p_sys->i_idle_timeout ) == VLC_SUCCESS )
+    {
+        p_sys->fd = -1;
+        p_sys->p_tls = NULL;
+        p_sys->p_vs = NULL;
+        return;
+    }
+
     if( p_sys->p_tls != NULL)
     {
         vlc_tls_SessionDelete( p_sys->p_tls );
@@ -1571,6 +1830,717 @@ static void Disconnect( access_t *p_access )
 
 }
 
+/*****************************************************************************
+ * Persistent connections
+ *****************************************************************************/
+
+/* Finishes reading the current response, if this is cheap enough, so that
+ * the next request can be sent on the same connection */
+static bool ConnectionReusable( access_t *p_access )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    if( !p_sys->b_persist || p_sys->b_error || p_sys->i_icy_meta > 0 )
+        return false;
+
+    if( p_sys->b_chunked )
+    {
+        /* The last chunk must have been read, skip the trailer */
+        if( p_sys->i_chunk >= 0 )
+            return false;
+        for( ;; )
+        {
+            char *psz = net_Gets( p_access, p_sys->fd, p_sys->p_vs );
+            if( psz == NULL )
+                return false;
+            bool b_end = *psz == '\0';
+            free( psz );
+            if( b_end )
+                return true;
+        }
+    }
+
+    if( !p_sys->b_has_size || p_sys->i_remaining > HTTP_DRAIN_MAX )
+        return false;
+
+    while( p_sys->i_remaining > 0 )
+    {
+        uint8_t p_buffer[4096];
+        int i_read = net_Read( p_access, p_sys->fd, p_sys->p_vs, p_buffer,
+                               __MIN( sizeof( p_buffer ), p_sys->i_remaining ),
+                               true );
+        if( i_read <= 0 )
+            return false;
+        p_sys->i_remaining -= i_read;
+    }
+    return true;
+}
+
+static void ConnectionClose( http_conn_t *p_conn )
+{
+    if( p_conn->p_tls != NULL )
+        vlc_tls_SessionDelete( p_conn->p_tls );
+    net_Close( p_conn->fd );
+    free( p_conn->psz_key );
+    free( p_conn );
+}
+
+/* Unlinks the connections which idled for too long, or all of them if
+ * i_now is 0. Must be called with pool_lock held. */
+static http_conn_t *PoolExpire( http_pool_t *p_pool, mtime_t i_now )
+{
+    http_conn_t *p_expired = NULL;
+
+    for( http_conn_t **pp = &p_pool->p_idle; *pp != NULL; )
+    {
+        http_conn_t *p_conn = *pp;
+
+        if( i_now == 0 || p_conn->i_expiry <= i_now )
+        {
+            *pp = p_conn->p_next;
+            p_conn->p_next = p_expired;
+            p_expired = p_conn;
+            p_pool->i_idle--;
+        }
+        else
+            pp = &p_conn->p_next;
+    }
+    return p_expired;
+}
+
+static void ConnectionCloseAll( http_conn_t *p_conn )
+{
+    while( p_conn != NULL )
+    {
+        http_conn_t *p_next = p_conn->p_next;
+        ConnectionClose( p_conn );
+        p_conn = p_next;
+    }
+}
+
+static http_pool_t *PoolHold( access_t *p_access, bool b_tls )
+{
+    vlc_object_t *p_libvlc = VLC_OBJECT( p_access->p_libvlc );
+    http_pool_t *p_pool;
+
+    vlc_mutex_lock( &pool_lock );
+    p_pool = var_GetAddress( p_libvlc, "http-pool" );
+    if( p_pool == NULL )
+    {
+        p_pool = calloc( 1, sizeof( *p_pool ) );
+        if( unlikely( p_pool == NULL ) )
+        {
+            vlc_mutex_unlock( &pool_lock );
+            return NULL;
+        }
+        var_Create( p_libvlc, "http-pool", VLC_VAR_ADDRESS );
+        var_SetAddress( p_libvlc, "http-pool", p_pool );
+    }
+    p_pool->i_refs++;
+
+    /* The credentials must outlive any access using the TLS sessions */
+    if( b_tls && p_pool->p_creds == NULL )
+        p_pool->p_creds = vlc_tls_ClientCreate( p_libvlc );
+    bool b_error = b_tls && p_pool->p_creds == NULL;
+    vlc_mutex_unlock( &pool_lock );
+
+    if( b_error )
+    {
+        PoolRelease( p_access, p_pool );
+        return NULL;
+    }
+    return p_pool;
+}
+
+static void PoolRelease( access_t *p_access, http_pool_t *p_pool )
+{
+    if( p_pool == NULL )
+        return;
+
+    vlc_mutex_lock( &pool_lock );
+    if( --p_pool->i_refs > 0 )
+    {
+        vlc_mutex_unlock( &pool_lock );
+        return;
+    }
+    var_Destroy( p_access->p_libvlc, "http-pool" );
+    vlc_mutex_unlock( &pool_lock );
+
+    msg_Dbg( p_access, "HTTP connections: %"PRIu64" opened, %"PRIu64
+             " reused", p_pool->i_new, p_pool->i_reused );
+
+    ConnectionCloseAll( PoolExpire( p_pool, 0 ) );
+    vlc_tls_Delete( p_pool->p_creds );
+    free( p_pool );
+}
+
+/* Takes an idle connection to the server of the access, if any */
+static bool PoolTake( access_t *p_access, int *pi_fd, vlc_tls_t **pp_tls )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    http_pool_t *p_pool = p_sys->p_pool;
+
+    if( !p_sys->b_keep_alive || p_sys->i_version != 1 )
+        return false;
+
+    for( ;; )
+    {
+        http_conn_t *p_conn = NULL, *p_expired;
+
+        vlc_mutex_lock( &pool_lock );
+        p_expired = PoolExpire( p_pool, mdate() );
+        for( http_conn_t **pp = &p_pool->p_idle; *pp != NULL;
+             pp = &(*pp)->p_next )
+        {
+            if( !strcmp( (*pp)->psz_key, p_sys->psz_conn_key ) )
+            {
+                p_conn = *pp;
+                *pp = p_conn->p_next;
+                p_pool->i_idle--;
+                break;
+            }
+        }
+        vlc_mutex_unlock( &pool_lock );
+        ConnectionCloseAll( p_expired );
+
+        if( p_conn == NULL )
+            return false;
+
+        /* An idle connection is readable only if the server closed it */
+        struct pollfd ufd = { .fd = p_conn->fd, .events = POLLIN };
+        if( poll( &ufd, 1, 0 ) != 0 )
+        {
+            msg_Dbg( p_access, "idle connection to %s was closed",
+                     p_conn->psz_key );
+            ConnectionClose( p_conn );
+            continue;
+        }
+
+        *pi_fd = p_conn->fd;
+        *pp_tls = p_conn->p_tls;
+        free( p_conn->psz_key );
+        free( p_conn );
+
+        vlc_mutex_lock( &pool_lock );
+        p_pool->i_reused++;
+        msg_Dbg( p_access, "reusing connection to %s (%"PRIu64" reused, %"
+                 PRIu64" opened)", p_sys->psz_conn_key, p_pool->i_reused,
+                 p_pool->i_new );
+        vlc_mutex_unlock( &pool_lock );
+        return true;
+    }
+}
+
+/* Gives an idle connection to the server of the access to the pool */
+static int PoolPut( access_t *p_access, int fd, vlc_tls_t *p_tls,
+                    mtime_t i_timeout )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    http_pool_t *p_pool = p_sys->p_pool;
+
+    http_conn_t *p_conn = malloc( sizeof( *p_conn ) );
+    if( unlikely( p_conn == NULL ) )
+        return VLC_ENOMEM;
+    p_conn->psz_key = strdup( p_sys->psz_conn_key );
+    if( unlikely( p_conn->psz_key == NULL ) )
+    {
+        free( p_conn );
+        return VLC_ENOMEM;
+    }
+    p_conn->fd = fd;
+    p_conn->p_tls = p_tls;
+    p_conn->i_expiry = mdate() + i_timeout;
+
+    vlc_mutex_lock( &pool_lock );
+    http_conn_t *p_expired = PoolExpire( p_pool, mdate() );
+    if( p_pool->i_idle >= HTTP_POOL_SIZE )
+    {
+        /* Drop the least recently used connection */
+        http_conn_t **pp = &p_pool->p_idle;
+        while( (*pp)->p_next != NULL )
+            pp = &(*pp)->p_next;
+        (*pp)->p_next = p_expired;
+        p_expired = *pp;
+        *pp = NULL;
+        p_pool->i_idle--;
+    }
+    p_conn->p_next = p_pool->p_idle;
+    p_pool->p_idle = p_conn;
+    p_pool->i_idle++;
+    vlc_mutex_unlock( &pool_lock );
+
+    ConnectionCloseAll( p_expired );
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Parallel read-ahead
+ *****************************************************************************
+ * A single TCP connection seldom fills a long fat pipe. Worker threads fetch
+ * the data ahead of the read position with concurrent Range requests, each
+ * on its own persistent connection, and Read() reassembles them in order.
+ *****************************************************************************/
+
+/* Must be called with ahead.lock held */
+static void RangeDrop( http_range_t *p_range )
+{
+    if( p_range->b_busy )
+        p_range->b_dropped = true; /* the worker frees it */
+    else
+    {
+        free( p_range->p_buffer );
+        free( p_range );
+    }
+}
+
+/* Drops the ranges which end before i_pos, or all of them if i_pos is
+ * UINT64_MAX. Must be called with ahead.lock held. */
+static void RangeDropBefore( access_sys_t *p_sys, uint64_t i_pos )
+{
+    http_range_t *p_range;
+
+    while( (p_range = p_sys->ahead.p_ranges) != NULL
+        && ( i_pos == UINT64_MAX
+          || p_range->i_start + p_range->i_size <= i_pos ) )
+    {
+        p_sys->ahead.p_ranges = p_range->p_next;
+        RangeDrop( p_range );
+    }
+    if( p_sys->ahead.p_ranges == NULL )
+        p_sys->ahead.pp_last = &p_sys->ahead.p_ranges;
+}
+
+static void WorkerDisconnect( http_worker_t *p_worker )
+{
+    if( p_worker->p_tls != NULL )
+        vlc_tls_SessionDelete( p_worker->p_tls );
+    if( p_worker->fd != -1 )
+        net_Close( p_worker->fd );
+    p_worker->fd = -1;
+    p_worker->p_tls = NULL;
+}
+
+static int WorkerConnect( http_worker_t *p_worker )
+{
+    access_t *p_access = p_worker->p_access;
+    access_sys_t *p_sys = p_access->p_sys;
+    vlc_url_t srv = p_sys->b_proxy ? p_sys->proxy : p_sys->url;
+
+    if( PoolTake( p_access, &p_worker->fd, &p_worker->p_tls ) )
+        return VLC_SUCCESS;
+
+    p_worker->fd = net_ConnectTCP( p_access, srv.psz_host, srv.i_port );
+    if( p_worker->fd == -1 )
+        return VLC_EGENERIC;
+
+    vlc_mutex_lock( &pool_lock );
+    p_sys->p_pool->i_new++;
+    vlc_mutex_unlock( &pool_lock );
+
+    if( p_sys->p_creds != NULL )
+    {
+        p_worker->p_tls = vlc_tls_ClientSessionCreate( p_sys->p_creds,
+                                                       p_worker->fd,
+                                                       p_sys->url.psz_host,
+                                                       "https" );
+        if( p_worker->p_tls == NULL )
+        {
+            WorkerDisconnect( p_worker );
+            return VLC_EGENERIC;
+        }
+    }
+    return VLC_SUCCESS;
+}
+
+/* Sends the request for a range and reads the response header */
+static int WorkerRequest( http_worker_t *p_worker, const http_range_t *p_range )
+{
+    access_t *p_access = p_worker->p_access;
+    access_sys_t *p_sys = p_access->p_sys;
+    v_socket_t *pvs = p_worker->p_tls != NULL ? &p_worker->p_tls->sock : NULL;
+    int fd = p_worker->fd;
+    uint64_t i_end = p_range->i_start + p_range->i_size - 1;
+
+    const char *psz_path = p_sys->url.psz_path;
+    if( !psz_path || !*psz_path )
+        psz_path = "/";
+    if( p_sys->b_proxy && pvs == NULL )
+        net_Printf( p_access, fd, NULL, "GET http://%s:%d%s HTTP/1.1\r\n",
+                    p_sys->url.psz_host, p_sys->url.i_port, psz_path );
+    else
+        net_Printf( p_access, fd, pvs, "GET %s HTTP/1.1\r\n", psz_path );
+    if( p_sys->url.i_port != (pvs ? 443 : 80) )
+        net_Printf( p_access, fd, pvs, "Host: %s:%d\r\n",
+                    p_sys->url.psz_host, p_sys->url.i_port );
+    else
+        net_Printf( p_access, fd, pvs, "Host: %s\r\n", p_sys->url.psz_host );
+    net_Printf( p_access, fd, pvs, "User-Agent: %s\r\n",
+                p_sys->psz_user_agent );
+    if( p_sys->psz_referrer )
+        net_Printf( p_access, fd, pvs, "Referer: %s\r\n",
+                    p_sys->psz_referrer );
+    net_Printf( p_access, fd, pvs, "Range: bytes=%"PRIu64"-%"PRIu64"\r\n",
+                p_range->i_start, i_end );
+    SendCookies( p_access, fd, pvs );
+    if( net_Printf( p_access, fd, pvs, "\r\n" ) < 0 )
+        return VLC_EGENERIC;
+
+    char *psz = net_Gets( p_access, fd, pvs );
+    if( psz == NULL )
+        return VLC_EGENERIC;
+
+    unsigned i_minor = 0, i_code = 0;
+    sscanf( psz, "HTTP/1.%u %3u", &i_minor, &i_code );
+    free( psz );
+    if( i_code != 206 )
+    {
+        msg_Warn( p_access, "range request answered with code %u", i_code );
+        return VLC_EGENERIC;
+    }
+    p_worker->b_persist = i_minor >= 1;
+
+    uint64_t i_length = 0;
+    bool b_error = false;
+    for( ;; )
+    {
+        char *p;
+
+        psz = net_Gets( p_access, fd, pvs );
+        if( psz == NULL )
+            return VLC_EGENERIC;
+        if( *psz == '\0' )
+        {
+            free( psz );
+            break;
+        }
+
+        if( ( p = strchr( psz, ':' ) ) != NULL )
+        {
+            *p++ = '\0';
+            p += strspn( p, " \t" );
+
+            if( !strcasecmp( psz, "Content-Length" ) )
+                i_length = (uint64_t)atoll( p );
+            else if( !strcasecmp( psz, "Transfer-Encoding" ) )
+                b_error = true;
+            else if( !strcasecmp( psz, "Connection" ) &&
+                     !strncasecmp( p, "close", 5 ) )
+                p_worker->b_persist = false;
+        }
+        free( psz );
+    }
+
+    if( b_error || i_length != p_range->i_size )
+    {
+        msg_Warn( p_access, "unexpected answer to range request" );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+/* Downloads a range. It may be dropped meanwhile by a seek. */
+static int WorkerFetch( http_worker_t *p_worker, http_range_t *p_range )
+{
+    access_t *p_access = p_worker->p_access;
+    access_sys_t *p_sys = p_access->p_sys;
+
+    if( p_worker->fd == -1 && WorkerConnect( p_worker ) )
+        return VLC_EGENERIC;
+
+    if( WorkerRequest( p_worker, p_range ) )
+    {
+        /* The idle connection may have been closed by the server */
+        WorkerDisconnect( p_worker );
+        if( WorkerConnect( p_worker ) || WorkerRequest( p_worker, p_range ) )
+            return VLC_EGENERIC;
+    }
+
+    v_socket_t *pvs = p_worker->p_tls != NULL ? &p_worker->p_tls->sock : NULL;
+    size_t i_filled = 0;
+
+    while( i_filled < p_range->i_size )
+    {
+        int i_read = net_Read( p_access, p_worker->fd, pvs,
+                               p_range->p_buffer + i_filled,
+                               __MIN( p_range->i_size - i_filled, 65536 ),
+                               false );
+        if( i_read <= 0 )
+            return VLC_EGENERIC;
+        i_filled += i_read;
+
+        vlc_mutex_lock( &p_sys->ahead.lock );
+        p_range->i_filled = i_filled;
+        bool b_dropped = p_range->b_dropped || p_sys->ahead.b_close;
+        vlc_cond_broadcast( &p_sys->ahead.wait );
+        vlc_mutex_unlock( &p_sys->ahead.lock );
+
+        /* The rest of the response is not wanted anymore */
+        if( b_dropped && i_filled < p_range->i_size )
+        {
+            WorkerDisconnect( p_worker );
+            return VLC_SUCCESS;
+        }
+    }
+
+    if( !p_worker->b_persist )
+        WorkerDisconnect( p_worker );
+    return VLC_SUCCESS;
+}
+
+static void *WorkerThread( void *p_data )
+{
+    http_worker_t *p_worker = p_data;
+    access_t *p_access = p_worker->p_access;
+    access_sys_t *p_sys = p_access->p_sys;
+
+    int canc = vlc_savecancel();
+
+    vlc_mutex_lock( &p_sys->ahead.lock );
+    for( ;; )
+    {
+        uint64_t i_window = (uint64_t)p_sys->ahead.i_chunk
+                          * p_sys->ahead.i_workers * 2;
+
+        if( p_sys->ahead.b_close )
+            break;
+        if( p_sys->ahead.b_error
+         || p_sys->ahead.i_next >= p_access->info.i_size
+         || p_sys->ahead.i_next - p_sys->ahead.i_pos >= i_window )
+        {
+            vlc_cond_wait( &p_sys->ahead.wait, &p_sys->ahead.lock );
+            continue;
+        }
+
+        http_range_t *p_range = malloc( sizeof( *p_range ) );
+        size_t i_size = __MIN( p_sys->ahead.i_chunk,
+                           p_access->info.i_size - p_sys->ahead.i_next );
+        uint8_t *p_buffer = malloc( i_size );
+        if( unlikely( p_range == NULL || p_buffer == NULL ) )
+        {
+            free( p_range );
+            free( p_buffer );
+            p_sys->ahead.b_error = true;
+            vlc_cond_broadcast( &p_sys->ahead.wait );
+            continue;
+        }
+        p_range->i_start = p_sys->ahead.i_next;
+        p_range->i_size = i_size;
+        p_range->i_filled = 0;
+        p_range->p_buffer = p_buffer;
+        p_range->b_busy = true;
+        p_range->b_dropped = false;
+        p_range->b_failed = false;
+        p_range->p_next = NULL;
+        *p_sys->ahead.pp_last = p_range;
+        p_sys->ahead.pp_last = &p_range->p_next;
+        p_sys->ahead.i_next += i_size;
+        vlc_mutex_unlock( &p_sys->ahead.lock );
+
+        mtime_t i_start = mdate();
+        int i_ret = WorkerFetch( p_worker, p_range );
+        mtime_t i_duration = __MAX( mdate() - i_start, 1 );
+
+        vlc_mutex_lock( &p_sys->ahead.lock );
+        p_range->b_busy = false;
+        if( p_range->b_dropped )
+            RangeDrop( p_range );
+        else if( i_ret != VLC_SUCCESS )
+        {
+            msg_Warn( p_access, "range %"PRIu64"-%"PRIu64" failed",
+                      p_range->i_start, p_range->i_start + i_size - 1 );
+            WorkerDisconnect( p_worker );
+            p_range->b_failed = true;
+            p_sys->ahead.b_error = true;
+        }
+        else
+        {
+            /* Requests should last long enough for their latency not to
+             * matter, and not so long that the data comes too late */
+            uint64_t i_target = i_size * HTTP_AHEAD_DURATION / i_duration;
+            i_target = (p_sys->ahead.i_chunk + i_target) / 2;
+            p_sys->ahead.i_chunk = VLC_CLIP( i_target, HTTP_AHEAD_MIN,
+                                             HTTP_AHEAD_MAX );
+        }
+        vlc_cond_broadcast( &p_sys->ahead.wait );
+    }
+    vlc_mutex_unlock( &p_sys->ahead.lock );
+
+    if( p_worker->fd != -1 )
+    {
+        if( PoolPut( p_access, p_worker->fd, p_worker->p_tls,
+                     HTTP_IDLE_TIMEOUT ) != VLC_SUCCESS )
+            WorkerDisconnect( p_worker );
+    }
+
+    vlc_restorecancel( canc );
+    return NULL;
+}
+
+static void AheadStop( access_t *p_access )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    vlc_mutex_lock( &p_sys->ahead.lock );
+    p_sys->ahead.b_close = true;
+    RangeDropBefore( p_sys, UINT64_MAX );
+    vlc_cond_broadcast( &p_sys->ahead.wait );
+    vlc_mutex_unlock( &p_sys->ahead.lock );
+
+    for( unsigned i = 0; i < p_sys->ahead.i_workers; i++ )
+        vlc_join( p_sys->ahead.p_workers[i].thread, NULL );
+    free( p_sys->ahead.p_workers );
+
+    vlc_cond_destroy( &p_sys->ahead.wait );
+    vlc_mutex_destroy( &p_sys->ahead.lock );
+    p_sys->b_ahead = false;
+}
+
+/* Switches to parallel read-ahead, if requested and possible */
+static void AheadStart( access_t *p_access )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    unsigned i_workers = var_InheritInteger( p_access, "http-parallel" );
+
+    if( i_workers < 2 || !p_sys->b_keep_alive )
+        return;
+    /* Only plain byte ranges of a known resource can be split, and the
+     * authentication state can not be shared between connections */
+    if( !p_sys->b_seekable || !p_sys->b_has_size || p_sys->b_chunked
+     || p_sys->i_version != 1 || p_sys->b_continuous || p_sys->i_icy_meta > 0
+     || p_sys->url.psz_username || p_sys->url.psz_password
+     || p_sys->proxy.psz_username || p_sys->proxy.psz_password
+     || ( p_sys->b_proxy && p_sys->p_creds != NULL ) )
+        return;
+#ifdef HAVE_ZLIB_H
+    if( p_sys->b_compressed )
+        return;
+#endif
+    if( p_access->info.i_size - p_access->info.i_pos
+            < 2 * HTTP_AHEAD_MIN * i_workers )
+        return;
+
+    p_sys->ahead.p_workers = calloc( i_workers, sizeof( http_worker_t ) );
+    if( unlikely( p_sys->ahead.p_workers == NULL ) )
+        return;
+
+    vlc_mutex_init( &p_sys->ahead.lock );
+    vlc_cond_init( &p_sys->ahead.wait );
+    p_sys->ahead.p_ranges = NULL;
+    p_sys->ahead.pp_last = &p_sys->ahead.p_ranges;
+    p_sys->ahead.i_pos = p_access->info.i_pos;
+    p_sys->ahead.i_next = p_access->info.i_pos;
+    p_sys->ahead.i_chunk = HTTP_AHEAD_MIN;
+    p_sys->ahead.i_workers = 0;
+    p_sys->ahead.b_error = false;
+    p_sys->ahead.b_close = false;
+    p_sys->b_ahead = true;
+
+    /* The current response is not needed anymore */
+    Disconnect( p_access );
+
+    for( unsigned i = 0; i < i_workers; i++ )
+    {
+        http_worker_t *p_worker = &p_sys->ahead.p_workers[i];
+
+        p_worker->p_access = p_access;
+        p_worker->fd = -1;
+        p_worker->p_tls = NULL;
+        if( vlc_clone( &p_worker->thread, WorkerThread, p_worker,
+                       VLC_THREAD_PRIORITY_INPUT ) )
+            break;
+        /* Workers only look at i_workers for the read-ahead window */
+        vlc_mutex_lock( &p_sys->ahead.lock );
+        p_sys->ahead.i_workers++;
+        vlc_mutex_unlock( &p_sys->ahead.lock );
+    }
+    msg_Dbg( p_access, "reading ahead with %u connections",
+             p_sys->ahead.i_workers );
+
+    if( p_sys->ahead.i_workers == 0 )
+    {
+        AheadStop( p_access );
+        Connect( p_access, p_access->info.i_pos );
+    }
+}
+
+static ssize_t ReadAhead( access_t *p_access, uint8_t *p_buffer, size_t i_len )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    uint64_t i_pos = p_access->info.i_pos;
+
+    if( i_pos >= p_access->info.i_size )
+    {
+        p_access->info.b_eof = true;
+        return 0;
+    }
+
+    vlc_mutex_lock( &p_sys->ahead.lock );
+    for( ;; )
+    {
+        http_range_t *p_range;
+
+        RangeDropBefore( p_sys, i_pos );
+        p_range = p_sys->ahead.p_ranges;
+
+        if( p_sys->ahead.b_error && ( p_range == NULL || p_range->b_failed ) )
+            break;
+
+        if( p_range != NULL && p_range->i_start + p_range->i_filled > i_pos )
+        {
+            size_t i_copy = __MIN( i_len,
+                          p_range->i_start + p_range->i_filled - i_pos );
+            memcpy( p_buffer, p_range->p_buffer + (i_pos - p_range->i_start),
+                    i_copy );
+            p_access->info.i_pos += i_copy;
+            p_sys->ahead.i_pos = p_access->info.i_pos;
+            vlc_cond_broadcast( &p_sys->ahead.wait );
+            vlc_mutex_unlock( &p_sys->ahead.lock );
+            return i_copy;
+        }
+
+        if( !vlc_object_alive( p_access ) )
+        {
+            vlc_mutex_unlock( &p_sys->ahead.lock );
+            p_access->info.b_eof = true;
+            return 0;
+        }
+        vlc_cond_timedwait( &p_sys->ahead.wait, &p_sys->ahead.lock,
+                            mdate() + CLOCK_FREQ / 10 );
+    }
+    vlc_mutex_unlock( &p_sys->ahead.lock );
+
+    /* Carry on with a single connection */
+    msg_Warn( p_access, "read-ahead failed, reading sequentially" );
+    AheadStop( p_access );
+    if( Connect( p_access, i_pos ) )
+    {
+        p_access->info.b_eof = true;
+        return 0;
+    }
+    return Read( p_access, p_buffer, i_len );
+}
+
+static void SeekAhead( access_t *p_access, uint64_t i_pos )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    vlc_mutex_lock( &p_sys->ahead.lock );
+    /* Keep the ranges which are still ahead of the new position */
+    if( p_sys->ahead.p_ranges == NULL
+     || i_pos < p_sys->ahead.p_ranges->i_start
+     || i_pos >= p_sys->ahead.i_next )
+    {
+        RangeDropBefore( p_sys, UINT64_MAX );
+        p_sys->ahead.i_next = i_pos;
+    }
+    p_sys->ahead.i_pos = i_pos;
+    vlc_cond_broadcast( &p_sys->ahead.wait );
+    vlc_mutex_unlock( &p_sys->ahead.lock );
+
+    p_access->info.i_pos = i_pos;
+    p_access->info.b_eof = false;
+}
+
 /*****************************************************************************
  * Cookies (FIXME: we may want to rewrite that using a nice structure to hold
  * them) (FIXME: only support the "domain=" param)
@@ -57,8 +57,21 @@ static void Close( vlc_object_t * );
 #define MIME_TEXT N_("Mime")
 #define MIME_LONGTEXT N_("MIME returned by the server (autodetected " \
                         "if not specified)." )
+#define SLOW_TEXT N_("Late clients")
+#define SLOW_LONGTEXT N_("What to do with clients that cannot keep up with " \
+                        "the stream: resume at the last keyframe, resume " \
+                        "at the live position, or disconnect them." )
+#define BUFFER_TEXT N_("Buffer size")
+#define BUFFER_LONGTEXT N_("Amount of stream data in bytes kept for the " \
+                          "clients. Clients lagging further behind skip " \
+                          "data." )
 
 
+static const char *const ppsz_slow[] = { "keyframe", "skip", "disconnect" };
+static const char *const ppsz_slow_text[] = {
+    N_("Resume at the last keyframe"), N_("Resume at the live position"),
+    N_("Disconnect") };
+
 vlc_module_begin ()
     set_description( N_("HTTP stream output") )
     set_capability( "sout access", 0 )
@@ -72,6 +85,12 @@ vlc_module_begin ()
                   PASS_TEXT, PASS_LONGTEXT, true )
     add_string( SOUT_CFG_PREFIX "mime", "",
                 MIME_TEXT, MIME_LONGTEXT, true )
+    add_integer( SOUT_CFG_PREFIX "buffer", 5000000,
+                 BUFFER_TEXT, BUFFER_LONGTEXT, true )
+        change_integer_range( 65536, 1 << 30 )
+    add_string( SOUT_CFG_PREFIX "slow", "keyframe",
+                SLOW_TEXT, SLOW_LONGTEXT, true )
+        change_string_list( ppsz_slow, ppsz_slow_text )
     set_callbacks( Open, Close )
 vlc_module_end ()
 
@@ -80,7 +99,7 @@ vlc_module_end ()
  * Exported prototypes
  *****************************************************************************/
 static const char *const ppsz_sout_options[] = {
-    "user", "pwd", "mime", NULL
+    "user", "pwd", "mime", "buffer", "slow", NULL
 };
 
 static ssize_t Write( sout_access_out_t *, block_t * );
@@ -205,6 +224,19 @@ static int Open( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
+    httpd_StreamSetBufferSize( p_sys->p_httpd_stream,
+                               var_GetInteger( p_access,
+                                               SOUT_CFG_PREFIX "buffer" ) );
+
+    char *psz_slow = var_GetString( p_access, SOUT_CFG_PREFIX "slow" );
+    if( psz_slow != NULL && !strcmp( psz_slow, "skip" ) )
+        httpd_StreamSetSlowPolicy( p_sys->p_httpd_stream,
+                                   HTTPD_STREAM_SLOW_SKIP );
+    else if( psz_slow != NULL && !strcmp( psz_slow, "disconnect" ) )
+        httpd_StreamSetSlowPolicy( p_sys->p_httpd_stream,
+                                   HTTPD_STREAM_SLOW_DISCONNECT );
+    free( psz_slow );
+
     p_sys->i_header_allocated = 1024;
     p_sys->i_header_size      = 0;
     p_sys->p_header           = xmalloc( p_sys->i_header_allocated );
@@ -257,14 +289,11 @@ static int Control( sout_access_out_t *p_access, int i_query, va_list args )
 static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 {
     sout_access_out_sys_t *p_sys = p_access->p_sys;
-    int i_err = 0;
     int i_len = 0;
 
-    while( p_buffer )
+    for( block_t *p_block = p_buffer; p_block; p_block = p_block->p_next )
     {
-        block_t *p_next;
-
-        if( p_buffer->i_flags & BLOCK_FLAG_HEADER )
+        if( p_block->i_flags & BLOCK_FLAG_HEADER )
         {
             /* gather header */
             if( p_sys->b_header_complete )
@@ -273,18 +302,18 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
                 p_sys->i_header_size = 0;
                 p_sys->b_header_complete = false;
             }
-            if( (int)(p_buffer->i_buffer + p_sys->i_header_size) >
+            if( (int)(p_block->i_buffer + p_sys->i_header_size) >
                 p_sys->i_header_allocated )
             {
                 p_sys->i_header_allocated =
-                    p_buffer->i_buffer + p_sys->i_header_size + 1024;
+                    p_block->i_buffer + p_sys->i_header_size + 1024;
                 p_sys->p_header = xrealloc( p_sys->p_header,
                                                   p_sys->i_header_allocated );
             }
             memcpy( &p_sys->p_header[p_sys->i_header_size],
-                    p_buffer->p_buffer,
-                    p_buffer->i_buffer );
-            p_sys->i_header_size += p_buffer->i_buffer;
+                    p_block->p_buffer,
+                    p_block->i_buffer );
+            p_sys->i_header_size += p_block->i_buffer;
         }
         else if( !p_sys->b_header_complete )
         {
@@ -294,27 +323,16 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
                                 p_sys->i_header_size );
         }
 
-        i_len += p_buffer->i_buffer;
-        /* send data */
-        i_err = httpd_StreamSend( p_sys->p_httpd_stream, p_buffer->p_buffer,
-                                  p_buffer->i_buffer );
-
-        p_next = p_buffer->p_next;
-        block_Release( p_buffer );
-        p_buffer = p_next;
-
-        if( i_err < 0 )
-        {
-            break;
-        }
+        i_len += p_block->i_buffer;
     }
 
-    if( i_err < 0 )
-    {
-        block_ChainRelease( p_buffer );
-    }
+    /* The blocks are queued as they are, without copy: the stream marks
+     * the keyframes from their flags, and the clients send several of
+     * them at once */
+    if( httpd_StreamSendBlock( p_sys->p_httpd_stream, p_buffer ) < 0 )
+        return VLC_EGENERIC;
 
-    return( i_err < 0 ? VLC_EGENERIC : i_len );
+    return i_len;
 }
 
 /*****************************************************************************
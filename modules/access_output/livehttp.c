@@ -45,6 +45,7 @@
 #include <vlc_fs.h>
 #include <vlc_strings.h>
 #include <vlc_charset.h>
+#include <vlc_httpd.h>
 
 #include <gcrypt.h>
 #include <vlc_gcrypt.h>
@@ -104,6 +105,13 @@ static void Close( vlc_object_t * );
 #define RANDOMIV_TEXT N_("Use randomized IV for encryption")
 #define RANDOMIV_LONGTEXT N_("Generate IV instead using segment-number as IV")
 
+#define MEMSEGS_TEXT N_("Segments kept in memory")
+#define MEMSEGS_LONGTEXT N_("Keep this many segments in memory and serve them, "\
+                            "along with the index, from the HTTP server (see "\
+                            "--http-host and --http-port) instead of writing "\
+                            "files. The output path and the index are then "\
+                            "URL paths. 0 writes segments to disk.")
+
 vlc_module_begin ()
     set_description( N_("HTTP Live streaming output") )
     set_shortname( N_("LiveHTTP" ))
@@ -123,6 +131,9 @@ vlc_module_begin ()
               NOCACHE_TEXT, NOCACHE_LONGTEXT, true )
     add_bool( SOUT_CFG_PREFIX "generate-iv", false,
               RANDOMIV_TEXT, RANDOMIV_LONGTEXT, true )
+    add_integer( SOUT_CFG_PREFIX "memsegs", 0,
+                 MEMSEGS_TEXT, MEMSEGS_LONGTEXT, true )
+        change_integer_range( 0, 1000 )
     add_string( SOUT_CFG_PREFIX "index", NULL,
                 INDEX_TEXT, INDEX_LONGTEXT, false )
     add_string( SOUT_CFG_PREFIX "index-url", NULL,
@@ -153,6 +164,7 @@ static const char *const ppsz_sout_options[] = {
     "key-file",
     "key-loadfile",
     "generate-iv",
+    "memsegs",
     NULL
 };
 
@@ -166,8 +178,12 @@ typedef struct output_segment
     char *psz_uri;
     char *psz_key_uri;
     char *psz_duration;
+    char *psz_key_line; /* #EXT-X-KEY tag, rendered when the segment closes */
+    char *psz_entry;    /* #EXTINF tag and URI, rendered likewise */
     uint32_t i_segment_number;
     uint8_t aes_ivs[16];
+    block_t *p_data;        /* segment contents, in memory mode */
+    httpd_file_t *p_file;
 } output_segment_t;
 
 struct sout_access_out_sys_t
@@ -190,16 +206,67 @@ struct sout_access_out_sys_t
     bool b_splitanywhere;
     bool b_caching;
     bool b_generate_iv;
+    bool b_mux_headers;
     uint8_t aes_ivs[16];
     gcry_cipher_hd_t aes_ctx;
     char *key_uri;
     uint8_t stuffing_bytes[16];
     ssize_t stuffing_size;
     vlc_array_t *segments_t;
+
+    /* Memory mode: segments are served by httpd instead of written */
+    unsigned i_memsegs;
+    block_t *p_segdata;
+    block_t **pp_segdata_last;
+    httpd_host_t *p_httpd_host;
+    httpd_file_t *p_index_file;
+    vlc_mutex_t lock;
+    char *psz_index;    /* last rendered index, protected by lock */
+    size_t i_index;
 };
 
 static int LoadCryptFile( sout_access_out_t *p_access);
 static int CryptSetup( sout_access_out_t *p_access, char *keyfile );
+
+/*****************************************************************************
+ * IndexFill/SegmentFill: httpd callbacks for memory mode
+ *****************************************************************************/
+static int IndexFill( httpd_file_sys_t *p_data, httpd_file_t *p_file,
+                      uint8_t *psz_request, uint8_t **pp_data, int *pi_data )
+{
+    sout_access_out_sys_t *p_sys = (sout_access_out_sys_t *)p_data;
+    (void) p_file; (void) psz_request;
+
+    vlc_mutex_lock( &p_sys->lock );
+    *pp_data = NULL;
+    *pi_data = 0;
+    if( p_sys->psz_index && ( *pp_data = malloc( p_sys->i_index ) ) )
+    {
+        memcpy( *pp_data, p_sys->psz_index, p_sys->i_index );
+        *pi_data = p_sys->i_index;
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+    return VLC_SUCCESS;
+}
+
+static int SegmentFill( httpd_file_sys_t *p_data, httpd_file_t *p_file,
+                        uint8_t *psz_request, uint8_t **pp_data, int *pi_data )
+{
+    /* A segment is only published once complete, and it is removed from
+     * httpd before being freed, so its data can be read without locking. */
+    const output_segment_t *segment = (const output_segment_t *)p_data;
+    (void) p_file; (void) psz_request;
+
+    *pi_data = 0;
+    *pp_data = malloc( segment->p_data->i_buffer );
+    if( likely( *pp_data != NULL ) )
+    {
+        memcpy( *pp_data, segment->p_data->p_buffer, segment->p_data->i_buffer );
+        *pi_data = segment->p_data->i_buffer;
+    }
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * Open: open the file
  *****************************************************************************/
@@ -231,6 +298,19 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_ratecontrol = var_GetBool( p_access, SOUT_CFG_PREFIX "ratecontrol") ;
     p_sys->b_caching = var_GetBool( p_access, SOUT_CFG_PREFIX "caching") ;
     p_sys->b_generate_iv = var_GetBool( p_access, SOUT_CFG_PREFIX "generate-iv") ;
+    p_sys->b_mux_headers = false;
+
+    /* The index can only list segments that are still held in memory */
+    p_sys->i_memsegs = var_GetInteger( p_access, SOUT_CFG_PREFIX "memsegs" );
+    if( p_sys->i_memsegs &&
+        ( !p_sys->i_numsegs || p_sys->i_numsegs > p_sys->i_memsegs ) )
+        p_sys->i_numsegs = p_sys->i_memsegs;
+    p_sys->p_segdata = NULL;
+    p_sys->pp_segdata_last = &p_sys->p_segdata;
+    p_sys->p_httpd_host = NULL;
+    p_sys->p_index_file = NULL;
+    p_sys->psz_index = NULL;
+    p_sys->i_index = 0;
 
     p_sys->segments_t = vlc_array_new();
 
@@ -248,9 +328,12 @@ static int Open( vlc_object_t *p_this )
             free( p_sys );
             return VLC_ENOMEM;
         }
-        path_sanitize( psz_tmp );
+        if( !p_sys->i_memsegs )
+        {
+            path_sanitize( psz_tmp );
+            vlc_unlink( psz_tmp );
+        }
         p_sys->psz_indexPath = psz_tmp;
-        vlc_unlink( p_sys->psz_indexPath );
     }
 
     p_sys->psz_indexUrl = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "index-url" );
@@ -276,6 +359,32 @@ static int Open( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
+    if( p_sys->i_memsegs )
+    {
+        if( !p_sys->psz_indexPath || p_sys->psz_indexPath[0] != '/' )
+        {
+            msg_Err( p_access, "memory segments need an index URL path" );
+            goto error;
+        }
+        p_sys->p_httpd_host = vlc_http_HostNew( VLC_OBJECT(p_access) );
+        if( !p_sys->p_httpd_host )
+            goto error;
+        vlc_mutex_init( &p_sys->lock );
+        p_sys->p_index_file = httpd_FileNew( p_sys->p_httpd_host,
+                                             p_sys->psz_indexPath,
+                                             "application/vnd.apple.mpegurl",
+                                             NULL, NULL, IndexFill,
+                                             (httpd_file_sys_t *)p_sys );
+        if( !p_sys->p_index_file )
+        {
+            msg_Err( p_access, "cannot serve index at `%s'",
+                     p_sys->psz_indexPath );
+            vlc_mutex_destroy( &p_sys->lock );
+            httpd_HostDelete( p_sys->p_httpd_host );
+            goto error;
+        }
+    }
+
     p_sys->i_handle = -1;
     p_sys->i_segment = 0;
     p_sys->psz_cursegPath = NULL;
@@ -285,6 +394,19 @@ static int Open( vlc_object_t *p_this )
     p_access->pf_control = Control;
 
     return VLC_SUCCESS;
+
+error:
+    if( p_sys->key_uri )
+    {
+        gcry_cipher_close( p_sys->aes_ctx );
+        free( p_sys->key_uri );
+    }
+    free( p_sys->psz_keyfile );
+    vlc_array_destroy( p_sys->segments_t );
+    free( p_sys->psz_indexUrl );
+    free( p_sys->psz_indexPath );
+    free( p_sys );
+    return VLC_EGENERIC;
 }
 
 /************************************************************************
@@ -481,19 +603,67 @@ static char *formatSegmentPath( char *psz_path, uint32_t i_seg, bool b_sanitize
 
 static void destroySegment( output_segment_t *segment )
 {
+    if( segment->p_file )
+        httpd_FileDelete( segment->p_file );
+    if( segment->p_data )
+        block_Release( segment->p_data );
     free( segment->psz_filename );
     free( segment->psz_duration );
     free( segment->psz_uri );
     free( segment->psz_key_uri );
+    free( segment->psz_key_line );
+    free( segment->psz_entry );
     free( segment );
 }
 
 /************************************************************************
- * updateIndexAndDel: If necessary, update index file & delete old segments
+ * renderSegment: format the index lines of a closed segment once, so that
+ * index updates only have to concatenate them
  ************************************************************************/
-static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys, bool b_isend )
+static int renderSegment( sout_access_out_sys_t *p_sys, output_segment_t *segment )
 {
+    if( segment->psz_key_uri )
+    {
+        int ret;
+        if( p_sys->b_generate_iv )
+        {
+            unsigned long long iv_hi = 0, iv_lo = 0;
+            for( unsigned short i = 0; i < 8; i++ )
+            {
+                iv_hi |= segment->aes_ivs[i] & 0xff;
+                iv_hi <<= 8;
+                iv_lo |= segment->aes_ivs[8+i] & 0xff;
+                iv_lo <<= 8;
+            }
+            ret = asprintf( &segment->psz_key_line,
+                            "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\",IV=0X%16.16llx%16.16llx\n",
+                            segment->psz_key_uri, iv_hi, iv_lo );
+        }
+        else
+            ret = asprintf( &segment->psz_key_line,
+                            "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"\n",
+                            segment->psz_key_uri );
+        if( ret < 0 )
+        {
+            segment->psz_key_line = NULL;
+            return -1;
+        }
+    }
+
+    if( asprintf( &segment->psz_entry, "#EXTINF:%s,\n%s\n",
+                  segment->psz_duration, segment->psz_uri ) < 0 )
+    {
+        segment->psz_entry = NULL;
+        return -1;
+    }
+    return 0;
+}
 
+/************************************************************************
+ * renderIndex: assemble the index from the pre-rendered segment lines
+ ************************************************************************/
+static char *renderIndex( sout_access_out_sys_t *p_sys, bool b_isend, size_t *pi_len )
+{
     uint32_t i_firstseg;
     unsigned i_index_offset = 0;
 
@@ -505,113 +675,137 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
         i_index_offset = vlc_array_count( p_sys->segments_t ) - p_sys->i_numsegs;
     }
 
-    // First update index
-    if ( p_sys->psz_indexPath )
-    {
-        int val;
-        FILE *fp;
-        char *psz_idxTmp;
-        if ( asprintf( &psz_idxTmp, "%s.tmp", p_sys->psz_indexPath ) < 0)
-            return -1;
-
-        fp = vlc_fopen( psz_idxTmp, "wt");
-        if ( !fp )
-        {
-            msg_Err( p_access, "cannot open index file `%s'", psz_idxTmp );
-            free( psz_idxTmp );
-            return -1;
-        }
+    char *psz_header;
+    int i_header = asprintf( &psz_header, "#EXTM3U\n#EXT-X-TARGETDURATION:%zu\n#EXT-X-VERSION:3\n#EXT-X-ALLOW-CACHE:%s"
+                             "%s\n#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n", p_sys->i_seglen,
+                             p_sys->b_caching ? "YES" : "NO",
+                             p_sys->i_numsegs > 0 ? "" : b_isend ? "\n#EXT-X-PLAYLIST-TYPE:VOD" : "\n#EXT-X-PLAYLIST-TYPE:EVENT",
+                             i_firstseg );
+    if( i_header < 0 )
+        return NULL;
 
-        if ( fprintf( fp, "#EXTM3U\n#EXT-X-TARGETDURATION:%zu\n#EXT-X-VERSION:3\n#EXT-X-ALLOW-CACHE:%s"
-                          "%s\n#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n", p_sys->i_seglen,
-                          p_sys->b_caching ? "YES" : "NO",
-                          p_sys->i_numsegs > 0 ? "" : b_isend ? "\n#EXT-X-PLAYLIST-TYPE:VOD" : "\n#EXT-X-PLAYLIST-TYPE:EVENT",
-                          i_firstseg ) < 0 )
-        {
-            free( psz_idxTmp );
-            fclose( fp );
-            return -1;
-        }
-        char *psz_current_uri=NULL;
+    /* First pass sizes the index, second one copies the lines */
+    size_t i_len = 0;
+    char *psz_index = NULL;
+    for( int pass = 0; pass < 2; pass++ )
+    {
+        const char *psz_current_uri = NULL;
+        char *p = psz_index;
 
+#define APPEND( str ) \
+    do { \
+        size_t i_str = strlen( str ); \
+        if( p ) { memcpy( p, str, i_str ); p += i_str; } \
+        else i_len += i_str; \
+    } while( 0 )
 
+        APPEND( psz_header );
         for ( uint32_t i = i_firstseg; i <= p_sys->i_segment; i++ )
         {
             //scale to i_index_offset..numsegs + i_index_offset
             uint32_t index = i - i_firstseg + i_index_offset;
 
             output_segment_t *segment = (output_segment_t *)vlc_array_item_at_index( p_sys->segments_t, index );
-            if( p_sys->key_uri &&
-                ( !psz_current_uri ||  strcmp( psz_current_uri, segment->psz_key_uri ) )
-              )
+            if( !segment->psz_entry )
+                continue;
+            if( segment->psz_key_line &&
+                ( !psz_current_uri || strcmp( psz_current_uri, segment->psz_key_uri ) ) )
             {
-                int ret = 0;
-                free( psz_current_uri );
-                psz_current_uri = strdup( segment->psz_key_uri );
-                if( p_sys->b_generate_iv )
-                {
-                    unsigned long long iv_hi = 0, iv_lo = 0;
-                    for( unsigned short i = 0; i < 8; i++ )
-                    {
-                        iv_hi |= segment->aes_ivs[i] & 0xff;
-                        iv_hi <<= 8;
-                        iv_lo |= segment->aes_ivs[8+i] & 0xff;
-                        iv_lo <<= 8;
-                    }
-                    ret = fprintf( fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\",IV=0X%16.16llx%16.16llx\n",
-                                   segment->psz_key_uri, iv_hi, iv_lo );
+                psz_current_uri = segment->psz_key_uri;
+                APPEND( segment->psz_key_line );
+            }
+            APPEND( segment->psz_entry );
+        }
+        if ( b_isend )
+            APPEND( STR_ENDLIST );
+#undef APPEND
 
-                } else {
-                    ret = fprintf( fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"\n", segment->psz_key_uri );
-                }
-                if( ret < 0 )
-                {
-                    free( psz_idxTmp );
-                    fclose( fp );
-                    return -1;
-                }
+        if( pass == 0 && !( psz_index = malloc( i_len ) ) )
+            break;
+    }
+    free( psz_header );
+
+    *pi_len = i_len;
+    return psz_index;
+}
+
+/************************************************************************
+ * updateIndexAndDel: If necessary, update index file & delete old segments
+ ************************************************************************/
+static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys, bool b_isend )
+{
+    // First update index
+    if ( p_sys->psz_indexPath )
+    {
+        size_t i_len;
+        char *psz_index = renderIndex( p_sys, b_isend, &i_len );
+        if( unlikely( !psz_index ) )
+            return -1;
+
+        if( p_sys->i_memsegs )
+        {
+            /* Clients get either the previous or the new index, whole */
+            vlc_mutex_lock( &p_sys->lock );
+            char *psz_old = p_sys->psz_index;
+            p_sys->psz_index = psz_index;
+            p_sys->i_index = i_len;
+            vlc_mutex_unlock( &p_sys->lock );
+            free( psz_old );
+        }
+        else
+        {
+            int val;
+            FILE *fp;
+            char *psz_idxTmp;
+            if ( asprintf( &psz_idxTmp, "%s.tmp", p_sys->psz_indexPath ) < 0)
+            {
+                free( psz_index );
+                return -1;
             }
 
-            val = fprintf( fp, "#EXTINF:%s,\n%s\n", segment->psz_duration, segment->psz_uri);
-            if ( val < 0 )
+            fp = vlc_fopen( psz_idxTmp, "wt");
+            if ( !fp )
             {
-                fclose( fp );
+                msg_Err( p_access, "cannot open index file `%s'", psz_idxTmp );
+                free( psz_idxTmp );
+                free( psz_index );
                 return -1;
             }
-        }
-        free( psz_current_uri );
 
-        if ( b_isend )
-        {
-            if ( fputs ( STR_ENDLIST, fp ) < 0)
+            /* Make the new index durable before it replaces the old one */
+            val = fwrite( psz_index, 1, i_len, fp ) == i_len &&
+                  fflush( fp ) == 0 && fsync( fileno( fp ) ) == 0 ? 0 : -1;
+            free( psz_index );
+            if ( fclose( fp ) || val < 0 )
             {
+                msg_Err( p_access, "cannot write index file `%s'", psz_idxTmp );
+                vlc_unlink( psz_idxTmp );
                 free( psz_idxTmp );
-                fclose( fp ) ;
                 return -1;
             }
 
-        }
-        fclose( fp );
+            val = vlc_rename ( psz_idxTmp, p_sys->psz_indexPath);
 
-        val = vlc_rename ( psz_idxTmp, p_sys->psz_indexPath);
+            if ( val < 0 )
+            {
+                vlc_unlink( psz_idxTmp );
+                msg_Err( p_access, "Error moving LiveHttp index file" );
+            }
+            else
+                msg_Dbg( p_access, "LiveHttpIndexComplete: %s" , p_sys->psz_indexPath );
 
-        if ( val < 0 )
-        {
-            vlc_unlink( psz_idxTmp );
-            msg_Err( p_access, "Error moving LiveHttp index file" );
+            free( psz_idxTmp );
         }
-        else
-            msg_Dbg( p_access, "LiveHttpIndexComplete: %s" , p_sys->psz_indexPath );
-
-        free( psz_idxTmp );
     }
 
     // Then take care of deletion
-    while( p_sys->b_delsegs && p_sys->i_numsegs && ( (vlc_array_count( p_sys->segments_t ) ) > p_sys->i_numsegs ) )
+    while( p_sys->i_memsegs ?
+           (unsigned)vlc_array_count( p_sys->segments_t ) > p_sys->i_memsegs :
+           p_sys->b_delsegs && p_sys->i_numsegs && ( (vlc_array_count( p_sys->segments_t ) ) > p_sys->i_numsegs ) )
     {
          output_segment_t *segment = vlc_array_item_at_index( p_sys->segments_t, 0 );
          vlc_array_remove( p_sys->segments_t, 0 );
-         if ( segment->psz_filename )
+         if ( segment->psz_filename && !p_sys->i_memsegs )
          {
              vlc_unlink( segment->psz_filename );
          }
@@ -622,6 +816,50 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
     return 0;
 }
 
+/*****************************************************************************
+ * writeSegment: append data to the current segment, file or memory
+ *****************************************************************************/
+static ssize_t writeSegment( sout_access_out_sys_t *p_sys, const void *p_data, size_t i_data )
+{
+    if( p_sys->i_handle < 0 )
+    {
+        errno = EBADF;
+        return -1;
+    }
+    if( !p_sys->i_memsegs )
+        return write( p_sys->i_handle, p_data, i_data );
+
+    block_t *p_block = block_Alloc( i_data );
+    if( unlikely( !p_block ) )
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+    memcpy( p_block->p_buffer, p_data, i_data );
+    block_ChainLastAppend( &p_sys->pp_segdata_last, p_block );
+    return i_data;
+}
+
+/*****************************************************************************
+ * publishSegment: hand the completed in-memory segment over to httpd
+ *****************************************************************************/
+static void publishSegment( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys,
+                            output_segment_t *segment )
+{
+    segment->p_data = p_sys->p_segdata ? block_ChainGather( p_sys->p_segdata )
+                                       : block_Alloc( 0 );
+    p_sys->p_segdata = NULL;
+    p_sys->pp_segdata_last = &p_sys->p_segdata;
+    if( unlikely( !segment->p_data ) )
+        return;
+
+    segment->p_file = httpd_FileNew( p_sys->p_httpd_host, segment->psz_filename,
+                                     "video/MP2T", NULL, NULL, SegmentFill,
+                                     (httpd_file_sys_t *)segment );
+    if( !segment->p_file )
+        msg_Err( p_access, "cannot serve segment at `%s'", segment->psz_filename );
+}
+
 /*****************************************************************************
  * closeCurrentSegment: Close the segment file
  *****************************************************************************/
@@ -640,7 +878,7 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
             if( err ) {
                msg_Err( p_access, "Couldn't encrypt 16 bytes: %s", gpg_strerror(err) );
             } else {
-            int ret = write( p_sys->i_handle, p_sys->stuffing_bytes, 16 );
+            ssize_t ret = writeSegment( p_sys, p_sys->stuffing_bytes, 16 );
             if( ret != 16 )
                 msg_Err( p_access, "Couldn't write 16 bytes" );
             }
@@ -648,7 +886,10 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
         }
 
 
-        close( p_sys->i_handle );
+        if( p_sys->i_memsegs )
+            publishSegment( p_access, p_sys, segment );
+        else
+            close( p_sys->i_handle );
         p_sys->i_handle = -1;
 
         if( ! ( us_asprintf( &segment->psz_duration, "%.2f", p_sys->f_seglen ) ) )
@@ -656,6 +897,8 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
             msg_Err( p_access, "Couldn't set duration on closed segment");
             return;
         }
+        if( renderSegment( p_sys, segment ) )
+            msg_Err( p_access, "Couldn't render index entry of closed segment" );
 
         segment->i_segment_number = p_sys->i_segment;
 
@@ -710,7 +953,7 @@ static void Close( vlc_object_t * p_this )
             }
             crypted = true;
         }
-        ssize_t val = write( p_sys->i_handle, p_sys->block_buffer->p_buffer, p_sys->block_buffer->i_buffer );
+        ssize_t val = writeSegment( p_sys, p_sys->block_buffer->p_buffer, p_sys->block_buffer->i_buffer );
         if ( val == -1 )
         {
            if ( errno == EINTR )
@@ -754,6 +997,16 @@ static void Close( vlc_object_t * p_this )
     }
     vlc_array_destroy( p_sys->segments_t );
 
+    if( p_sys->i_memsegs )
+    {
+        /* The final index cannot outlive the output: clients lose it */
+        block_ChainRelease( p_sys->p_segdata );
+        httpd_FileDelete( p_sys->p_index_file );
+        httpd_HostDelete( p_sys->p_httpd_host );
+        vlc_mutex_destroy( &p_sys->lock );
+        free( p_sys->psz_index );
+    }
+
     free( p_sys->psz_indexUrl );
     free( p_sys->psz_indexPath );
     free( p_sys );
@@ -798,7 +1051,7 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
     memset( segment, 0 , sizeof( output_segment_t ) );
 
     segment->i_segment_number = i_newseg;
-    segment->psz_filename = formatSegmentPath( p_access->psz_path, i_newseg, true );
+    segment->psz_filename = formatSegmentPath( p_access->psz_path, i_newseg, !p_sys->i_memsegs );
     char *psz_idxFormat = p_sys->psz_indexUrl ? p_sys->psz_indexUrl : p_access->psz_path;
     segment->psz_uri = formatSegmentPath( psz_idxFormat , i_newseg, false );
 
@@ -808,7 +1061,9 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
         return -1;
     }
 
-    fd = vlc_open( segment->psz_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
+    /* In memory mode, the handle only marks the segment as open */
+    fd = p_sys->i_memsegs ? 0 :
+         vlc_open( segment->psz_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
                      O_TRUNC, 0666 );
     if ( fd == -1 )
     {
@@ -839,6 +1094,23 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
     return fd;
 }
 
+/*****************************************************************************
+ * isSegmentBoundary: can a new segment start with this block
+ *****************************************************************************/
+static bool isSegmentBoundary( sout_access_out_sys_t *p_sys, const block_t *p_block )
+{
+    if( p_sys->b_splitanywhere )
+        return true;
+    /* With use-key-frames, the TS muxer repeats PAT/PMT before each keyframe
+     * and flags them. Otherwise, cut on the keyframe packet itself. */
+    if( p_block->i_flags & BLOCK_FLAG_HEADER )
+    {
+        p_sys->b_mux_headers = true;
+        return true;
+    }
+    return !p_sys->b_mux_headers && ( p_block->i_flags & BLOCK_FLAG_TYPE_I );
+}
+
 /*****************************************************************************
  * Write: standard write on a file descriptor.
  *****************************************************************************/
@@ -850,14 +1122,14 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 
     while( p_buffer )
     {
-        if ( ( p_sys->b_splitanywhere || ( p_buffer->i_flags & BLOCK_FLAG_HEADER ) ) )
+        if ( isSegmentBoundary( p_sys, p_buffer ) )
         {
             bool crypted = false;
             block_t *output = p_sys->block_buffer;
             p_sys->block_buffer = NULL;
 
 
-            if( p_sys->i_handle > 0 &&
+            if( p_sys->i_handle >= 0 &&
                 ( p_buffer->i_dts - p_sys->i_opendts +
                   p_buffer->i_length * CLOCK_FREQ / INT64_C(1000000)
                 ) >= p_sys->i_seglenm )
@@ -902,7 +1174,7 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
                     crypted=true;
 
                 }
-                ssize_t val = write( p_sys->i_handle, output->p_buffer, output->i_buffer );
+                ssize_t val = writeSegment( p_sys, output->p_buffer, output->i_buffer );
                 if ( val == -1 )
                 {
                    if ( errno == EINTR )
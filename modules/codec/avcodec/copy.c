@@ -32,29 +32,10 @@
 
 #include "copy.h"
 
-int CopyInitCache(copy_cache_t *cache, unsigned width)
-{
-#ifdef CAN_COMPILE_SSE2
-    cache->size = __MAX((width + 0x0f) & ~ 0x0f, 4096);
-    cache->buffer = vlc_memalign(16, cache->size);
-    if (!cache->buffer)
-        return VLC_EGENERIC;
-#else
-    (void) cache; (void) width;
-#endif
-    return VLC_SUCCESS;
-}
-
-void CopyCleanCache(copy_cache_t *cache)
-{
-#ifdef CAN_COMPILE_SSE2
-    vlc_free(cache->buffer);
-    cache->buffer = NULL;
-    cache->size   = 0;
-#else
-    (void) cache;
+#if defined(HAVE_AVX2_INTRINSICS) && defined(VLC_CPU_AVX2)
+# include <immintrin.h>
+# define CAN_COMPILE_AVX2 1
 #endif
-}
 
 #ifdef CAN_COMPILE_SSE2
 /* Copy 64 bytes from srcp to dstp loading data with the SSE>=2 instruction
@@ -311,39 +292,188 @@ static void SSE_SplitPlanes(uint8_t *dstu, size_t dstu_pitch,
     asm volatile ("mfence");
 }
 
-static void SSE_CopyFromNv12(picture_t *dst,
-                             uint8_t *src[2], size_t src_pitch[2],
-                             unsigned width, unsigned height,
-                             copy_cache_t *cache, unsigned cpu)
+#undef COPY64
+#endif /* CAN_COMPILE_SSE2 */
+
+#ifdef CAN_COMPILE_AVX2
+/* Copy 128 bytes from srcp to dstp with the given 32 bytes load and store
+ * intrinsics.
+ */
+#define COPY128(dstp, srcp, load, store) do { \
+    const __m256i *s_ = (const __m256i *)(srcp); \
+    __m256i *d_ = (__m256i *)(dstp); \
+    const __m256i y0_ = load(s_ + 0); \
+    const __m256i y1_ = load(s_ + 1); \
+    const __m256i y2_ = load(s_ + 2); \
+    const __m256i y3_ = load(s_ + 3); \
+    store(d_ + 0, y0_); \
+    store(d_ + 1, y1_); \
+    store(d_ + 2, y2_); \
+    store(d_ + 3, y3_); \
+} while (0)
+
+/* CopyFromUswc() with 32 bytes streaming loads */
+VLC_AVX2
+static void AVX2_CopyFromUswc(uint8_t *dst, size_t dst_pitch,
+                              const uint8_t *src, size_t src_pitch,
+                              unsigned width, unsigned height)
 {
-    SSE_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch,
-                  src[0], src_pitch[0],
-                  cache->buffer, cache->size,
-                  width, height, cpu);
-    SSE_SplitPlanes(dst->p[2].p_pixels, dst->p[2].i_pitch,
-                    dst->p[1].p_pixels, dst->p[1].i_pitch,
-                    src[1], src_pitch[1],
-                    cache->buffer, cache->size,
-                    width/2, height/2, cpu);
-    asm volatile ("emms");
+    assert(((intptr_t)dst & 0x1f) == 0 && (dst_pitch & 0x1f) == 0);
+
+    _mm_mfence();
+
+    for (unsigned y = 0; y < height; y++) {
+        const unsigned unaligned = __MIN((-(uintptr_t)src) & 0x1f, width);
+        unsigned x = 0;
+
+        for (; x < unaligned; x++)
+            dst[x] = src[x];
+
+        if (!unaligned) {
+            for (; x+127 < width; x += 128)
+                COPY128(&dst[x], &src[x], _mm256_stream_load_si256,
+                        _mm256_store_si256);
+        } else {
+            for (; x+127 < width; x += 128)
+                COPY128(&dst[x], &src[x], _mm256_stream_load_si256,
+                        _mm256_storeu_si256);
+        }
+        for (; x+31 < width; x += 32)
+            _mm256_storeu_si256((__m256i *)&dst[x],
+                _mm256_stream_load_si256((const __m256i *)&src[x]));
+
+        for (; x < width; x++)
+            dst[x] = src[x];
+
+        src += src_pitch;
+        dst += dst_pitch;
+    }
 }
 
-static void SSE_CopyFromYv12(picture_t *dst,
-                             uint8_t *src[3], size_t src_pitch[3],
-                             unsigned width, unsigned height,
-                             copy_cache_t *cache, unsigned cpu)
+VLC_AVX2
+static void AVX2_Copy2d(uint8_t *dst, size_t dst_pitch,
+                        const uint8_t *src, size_t src_pitch,
+                        unsigned width, unsigned height)
 {
-    for (unsigned n = 0; n < 3; n++) {
-        const unsigned d = n > 0 ? 2 : 1;
-        SSE_CopyPlane(dst->p[n].p_pixels, dst->p[n].i_pitch,
-                      src[n], src_pitch[n],
-                      cache->buffer, cache->size,
-                      width/d, height/d, cpu);
+    assert(((intptr_t)src & 0x1f) == 0 && (src_pitch & 0x1f) == 0);
+
+    _mm_mfence();
+
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        bool unaligned = ((intptr_t)dst & 0x1f) != 0;
+        if (!unaligned) {
+            for (; x+127 < width; x += 128)
+                COPY128(&dst[x], &src[x], _mm256_load_si256,
+                        _mm256_stream_si256);
+        } else {
+            for (; x+127 < width; x += 128)
+                COPY128(&dst[x], &src[x], _mm256_load_si256,
+                        _mm256_storeu_si256);
+        }
+        for (; x+31 < width; x += 32)
+            _mm256_storeu_si256((__m256i *)&dst[x],
+                _mm256_load_si256((const __m256i *)&src[x]));
+
+        for (; x < width; x++)
+            dst[x] = src[x];
+
+        src += src_pitch;
+        dst += dst_pitch;
+    }
+}
+
+VLC_AVX2
+static void AVX2_SplitUV(uint8_t *dstu, size_t dstu_pitch,
+                         uint8_t *dstv, size_t dstv_pitch,
+                         const uint8_t *src, size_t src_pitch,
+                         unsigned width, unsigned height)
+{
+    /* Even bytes to the low quadword of each lane, odd bytes to the high */
+    const __m256i shuffle = _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14,
+                                             1, 3, 5, 7, 9, 11, 13, 15,
+                                             0, 2, 4, 6, 8, 10, 12, 14,
+                                             1, 3, 5, 7, 9, 11, 13, 15);
+
+    assert(((intptr_t)src & 0x1f) == 0 && (src_pitch & 0x1f) == 0);
+
+    _mm_mfence();
+
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x;
+
+        for (x = 0; x < (width & ~31); x += 32) {
+            __m256i a = _mm256_load_si256((const __m256i *)&src[2*x]);
+            __m256i b = _mm256_load_si256((const __m256i *)&src[2*x+32]);
+
+            /* U0 V0 U1 V1 quadwords to U0 U1 V0 V1 */
+            a = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(a, shuffle), 0xd8);
+            b = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(b, shuffle), 0xd8);
+            _mm256_storeu_si256((__m256i *)&dstu[x],
+                                _mm256_permute2x128_si256(a, b, 0x20));
+            _mm256_storeu_si256((__m256i *)&dstv[x],
+                                _mm256_permute2x128_si256(a, b, 0x31));
+        }
+
+        for (; x < width; x++) {
+            dstu[x] = src[2*x+0];
+            dstv[x] = src[2*x+1];
+        }
+        src  += src_pitch;
+        dstu += dstu_pitch;
+        dstv += dstv_pitch;
     }
-    asm volatile ("emms");
 }
-#undef COPY64
-#endif /* CAN_COMPILE_SSE2 */
+
+VLC_AVX2
+static void AVX2_CopyPlane(uint8_t *dst, size_t dst_pitch,
+                           const uint8_t *src, size_t src_pitch,
+                           uint8_t *cache, size_t cache_size,
+                           unsigned width, unsigned height)
+{
+    const unsigned w32 = (width+31) & ~31;
+    const unsigned hstep = cache_size / w32;
+    assert(hstep > 0);
+
+    for (unsigned y = 0; y < height; y += hstep) {
+        const unsigned hblock =  __MIN(hstep, height - y);
+
+        AVX2_CopyFromUswc(cache, w32, src, src_pitch, width, hblock);
+        AVX2_Copy2d(dst, dst_pitch, cache, w32, width, hblock);
+
+        src += src_pitch * hblock;
+        dst += dst_pitch * hblock;
+    }
+    _mm_mfence();
+}
+
+VLC_AVX2
+static void AVX2_SplitPlanes(uint8_t *dstu, size_t dstu_pitch,
+                             uint8_t *dstv, size_t dstv_pitch,
+                             const uint8_t *src, size_t src_pitch,
+                             uint8_t *cache, size_t cache_size,
+                             unsigned width, unsigned height)
+{
+    const unsigned w2_32 = (2*width+31) & ~31;
+    const unsigned hstep = cache_size / w2_32;
+    assert(hstep > 0);
+
+    for (unsigned y = 0; y < height; y += hstep) {
+        const unsigned hblock =  __MIN(hstep, height - y);
+
+        AVX2_CopyFromUswc(cache, w2_32, src, src_pitch, 2*width, hblock);
+        AVX2_SplitUV(dstu, dstu_pitch, dstv, dstv_pitch,
+                     cache, w2_32, width, hblock);
+
+        src  += src_pitch  * hblock;
+        dstu += dstu_pitch * hblock;
+        dstv += dstv_pitch * hblock;
+    }
+    _mm_mfence();
+}
+#undef COPY128
+#endif /* CAN_COMPILE_AVX2 */
 
 static void CopyPlane(uint8_t *dst, size_t dst_pitch,
                       const uint8_t *src, size_t src_pitch,
@@ -372,45 +502,299 @@ static void SplitPlanes(uint8_t *dstu, size_t dstu_pitch,
     }
 }
 
-void CopyFromNv12(picture_t *dst, uint8_t *src[2], size_t src_pitch[2],
-                  unsigned width, unsigned height,
-                  copy_cache_t *cache)
+
+static void CopyPlaneAny(uint8_t *dst, size_t dst_pitch,
+                         const uint8_t *src, size_t src_pitch,
+                         unsigned width, unsigned height,
+                         copy_cache_t *cache, unsigned cpu)
 {
+#ifdef CAN_COMPILE_AVX2
+    if (cpu & VLC_CPU_AVX2)
+        return AVX2_CopyPlane(dst, dst_pitch, src, src_pitch,
+                              cache->buffer, cache->size, width, height);
+#endif
 #ifdef CAN_COMPILE_SSE2
-    unsigned cpu = vlc_CPU();
-    if (vlc_CPU_SSE2())
-        return SSE_CopyFromNv12(dst, src, src_pitch, width, height,
-                                cache, cpu);
-#else
-    (void) cache;
+    if (cpu & VLC_CPU_SSE2)
+        return SSE_CopyPlane(dst, dst_pitch, src, src_pitch,
+                             cache->buffer, cache->size, width, height, cpu);
 #endif
+    (void) cache; (void) cpu;
+    CopyPlane(dst, dst_pitch, src, src_pitch, width, height);
+}
 
-    CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch,
-              src[0], src_pitch[0],
-              width, height);
-    SplitPlanes(dst->p[2].p_pixels, dst->p[2].i_pitch,
-                dst->p[1].p_pixels, dst->p[1].i_pitch,
-                src[1], src_pitch[1],
-                width/2, height/2);
+static void SplitPlanesAny(uint8_t *dstu, size_t dstu_pitch,
+                           uint8_t *dstv, size_t dstv_pitch,
+                           const uint8_t *src, size_t src_pitch,
+                           unsigned width, unsigned height,
+                           copy_cache_t *cache, unsigned cpu)
+{
+#ifdef CAN_COMPILE_AVX2
+    if (cpu & VLC_CPU_AVX2)
+        return AVX2_SplitPlanes(dstu, dstu_pitch, dstv, dstv_pitch,
+                                src, src_pitch, cache->buffer, cache->size,
+                                width, height);
+#endif
+#ifdef CAN_COMPILE_SSE2
+    if (cpu & VLC_CPU_SSE2)
+        return SSE_SplitPlanes(dstu, dstu_pitch, dstv, dstv_pitch,
+                               src, src_pitch, cache->buffer, cache->size,
+                               width, height, cpu);
+#endif
+    (void) cache; (void) cpu;
+    SplitPlanes(dstu, dstu_pitch, dstv, dstv_pitch,
+                src, src_pitch, width, height);
 }
 
-void CopyFromYv12(picture_t *dst, uint8_t *src[3], size_t src_pitch[3],
-                  unsigned width, unsigned height,
-                  copy_cache_t *cache)
+/* A NV12 or YV12 surface to copy into a YV12 picture */
+typedef struct {
+    picture_t *dst;
+    uint8_t   **src;
+    size_t    *src_pitch;
+    unsigned  width;
+    unsigned  height;
+    bool      nv12;
+    unsigned  cpu;
+} copy_frame_t;
+
+/* Copies the slice-th of slices bands of rows of every plane */
+static void CopySlice(const copy_frame_t *frame, copy_cache_t *cache,
+                      unsigned slice, unsigned slices)
 {
+    const unsigned planes = frame->nv12 ? 2 : 3;
+
+    for (unsigned n = 0; n < planes; n++) {
+        const unsigned d = n > 0 ? 2 : 1;
+        const unsigned rows = frame->height / d;
+        const unsigned y = (uint64_t)rows * slice / slices;
+        const unsigned h = (uint64_t)rows * (slice + 1) / slices - y;
+        const uint8_t *src = frame->src[n] + y * frame->src_pitch[n];
+        const plane_t *p = frame->dst->p;
+
+        if (frame->nv12 && n == 1)
+            /* U goes to the third plane of YV12, V to the second */
+            SplitPlanesAny(&p[2].p_pixels[y * p[2].i_pitch], p[2].i_pitch,
+                           &p[1].p_pixels[y * p[1].i_pitch], p[1].i_pitch,
+                           src, frame->src_pitch[1],
+                           frame->width / 2, h, cache, frame->cpu);
+        else
+            CopyPlaneAny(&p[n].p_pixels[y * p[n].i_pitch], p[n].i_pitch,
+                         src, frame->src_pitch[n],
+                         frame->width / d, h, cache, frame->cpu);
+    }
 #ifdef CAN_COMPILE_SSE2
-    unsigned cpu = vlc_CPU();
-    if (vlc_CPU_SSE2())
-        return SSE_CopyFromYv12(dst, src, src_pitch, width, height,
-                                cache, cpu);
+    if (frame->cpu & VLC_CPU_SSE2)
+        asm volatile ("emms");
+#endif
+}
+
+/*
+ * Reading back from video memory is bound by the latency of the uncached
+ * loads more than by the bandwidth, so large frames are split in bands of
+ * rows copied at the same time by a few threads. Each worker has its own
+ * cache buffer and always copies the same band; the calling thread copies
+ * the first one.
+ */
+#define COPY_SLICE_PIXELS (1 << 19)
+#define COPY_MAX_SLICES   8
+
+typedef struct {
+    copy_pool_t  *pool;
+    unsigned     slice;
+    copy_cache_t cache;
+    vlc_thread_t thread;
+} copy_worker_t;
+
+struct copy_pool_t {
+    vlc_mutex_t lock;
+    vlc_cond_t  wait;  /* workers wait for a frame */
+    vlc_cond_t  done;  /* the caller waits for the workers */
+
+    const copy_frame_t *frame;
+    unsigned    slices;
+    unsigned    pending; /* slices not done by the workers yet */
+    unsigned    serial;  /* frames posted so far */
+    bool        closing;
+
+    unsigned      count;
+    copy_worker_t workers[];
+};
+
+static int InitCache(copy_cache_t *, unsigned width, unsigned threads);
+
+static void *CopyWorker(void *data)
+{
+    copy_worker_t *worker = data;
+    copy_pool_t *pool = worker->pool;
+    unsigned serial = 0;
+
+    vlc_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->serial == serial && !pool->closing)
+            vlc_cond_wait(&pool->wait, &pool->lock);
+        if (pool->closing)
+            break;
+        serial = pool->serial;
+
+        const copy_frame_t *frame = pool->frame;
+        const unsigned slices = pool->slices;
+        if (worker->slice >= slices)
+            continue;
+
+        vlc_mutex_unlock(&pool->lock);
+        CopySlice(frame, &worker->cache, worker->slice, slices);
+        vlc_mutex_lock(&pool->lock);
+
+        if (--pool->pending == 0)
+            vlc_cond_signal(&pool->done);
+    }
+    vlc_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static void DestroyPool(copy_pool_t *pool)
+{
+    vlc_mutex_lock(&pool->lock);
+    pool->closing = true;
+    vlc_cond_broadcast(&pool->wait);
+    vlc_mutex_unlock(&pool->lock);
+
+    for (unsigned i = 0; i < pool->count; i++) {
+        vlc_join(pool->workers[i].thread, NULL);
+        CopyCleanCache(&pool->workers[i].cache);
+    }
+    vlc_cond_destroy(&pool->done);
+    vlc_cond_destroy(&pool->wait);
+    vlc_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+static copy_pool_t *CreatePool(unsigned threads, unsigned width)
+{
+    copy_pool_t *pool = malloc(sizeof (*pool)
+                               + threads * sizeof (pool->workers[0]));
+    if (unlikely(pool == NULL))
+        return NULL;
+
+    vlc_mutex_init(&pool->lock);
+    vlc_cond_init(&pool->wait);
+    vlc_cond_init(&pool->done);
+    pool->frame   = NULL;
+    pool->slices  = 0;
+    pool->pending = 0;
+    pool->serial  = 0;
+    pool->closing = false;
+    pool->count   = 0;
+
+    for (unsigned i = 0; i < threads; i++) {
+        copy_worker_t *worker = &pool->workers[i];
+
+        worker->pool  = pool;
+        worker->slice = i + 1;
+        if (InitCache(&worker->cache, width, 0))
+            break;
+        if (vlc_clone(&worker->thread, CopyWorker, worker,
+                      VLC_THREAD_PRIORITY_VIDEO)) {
+            CopyCleanCache(&worker->cache);
+            break;
+        }
+        pool->count++;
+    }
+
+    if (pool->count == 0) {
+        DestroyPool(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+static void CopyFrame(copy_cache_t *cache, const copy_frame_t *frame)
+{
+    unsigned slices = (uint64_t)frame->width * frame->height
+                    / COPY_SLICE_PIXELS;
+    if (slices > cache->threads + 1)
+        slices = cache->threads + 1;
+
+    if (slices > 1 && cache->pool == NULL) {
+        /* Started by the first large frame */
+        cache->pool = CreatePool(cache->threads, frame->width);
+        if (cache->pool == NULL)
+            cache->threads = 0;
+    }
+
+    copy_pool_t *pool = cache->pool;
+    if (slices <= 1 || pool == NULL) {
+        CopySlice(frame, cache, 0, 1);
+        return;
+    }
+    if (slices > pool->count + 1)
+        slices = pool->count + 1;
+
+    vlc_mutex_lock(&pool->lock);
+    pool->frame   = frame;
+    pool->slices  = slices;
+    pool->pending = slices - 1;
+    pool->serial++;
+    vlc_cond_broadcast(&pool->wait);
+    vlc_mutex_unlock(&pool->lock);
+
+    CopySlice(frame, cache, 0, slices);
+
+    vlc_mutex_lock(&pool->lock);
+    while (pool->pending > 0)
+        vlc_cond_wait(&pool->done, &pool->lock);
+    pool->frame = NULL;
+    vlc_mutex_unlock(&pool->lock);
+}
+
+static int InitCache(copy_cache_t *cache, unsigned width, unsigned threads)
+{
+    cache->threads = threads;
+    cache->pool    = NULL;
+#ifdef CAN_COMPILE_SSE2
+    cache->size = __MAX((width + 0x1f) & ~ 0x1f, 4096);
+    cache->buffer = vlc_memalign(32, cache->size);
+    if (!cache->buffer)
+        return VLC_EGENERIC;
 #else
-    (void) cache;
+    (void) width;
 #endif
+    return VLC_SUCCESS;
+}
 
-     CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch,
-               src[0], src_pitch[0], width, height);
-     CopyPlane(dst->p[1].p_pixels, dst->p[1].i_pitch,
-               src[1], src_pitch[1], width / 2, height / 2);
-     CopyPlane(dst->p[2].p_pixels, dst->p[2].i_pitch,
-               src[1], src_pitch[2], width / 2, height / 2);
+int CopyInitCache(copy_cache_t *cache, unsigned width)
+{
+    return InitCache(cache, width,
+                     __MIN(vlc_GetCPUCount(), COPY_MAX_SLICES) - 1);
+}
+
+void CopyCleanCache(copy_cache_t *cache)
+{
+    if (cache->pool != NULL)
+        DestroyPool(cache->pool);
+    cache->pool = NULL;
+#ifdef CAN_COMPILE_SSE2
+    vlc_free(cache->buffer);
+    cache->buffer = NULL;
+    cache->size   = 0;
+#endif
+}
+
+void CopyFromNv12(picture_t *dst, uint8_t *src[2], size_t src_pitch[2],
+                  unsigned width, unsigned height,
+                  copy_cache_t *cache)
+{
+    const copy_frame_t frame = {
+        dst, src, src_pitch, width, height, true, vlc_CPU()
+    };
+    CopyFrame(cache, &frame);
+}
+
+void CopyFromYv12(picture_t *dst, uint8_t *src[3], size_t src_pitch[3],
+                  unsigned width, unsigned height,
+                  copy_cache_t *cache)
+{
+    const copy_frame_t frame = {
+        dst, src, src_pitch, width, height, false, vlc_CPU()
+    };
+    CopyFrame(cache, &frame);
 }
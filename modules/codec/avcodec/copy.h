@@ -24,11 +24,15 @@
 #ifndef _VLC_AVCODEC_COPY_H
 #define _VLC_AVCODEC_COPY_H 1
 
+typedef struct copy_pool_t copy_pool_t;
+
 typedef struct {
 # ifdef CAN_COMPILE_SSE2
     uint8_t *buffer;
     size_t  size;
 # endif
+    unsigned    threads; /* extra threads copying large frames */
+    copy_pool_t *pool;   /* started by the first large frame */
 } copy_cache_t;
 
 int  CopyInitCache(copy_cache_t *cache, unsigned width);
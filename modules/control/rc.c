@@ -1762,6 +1762,9 @@ static int updateStatistics( intf_thread_t *p_intf, input_item_t *p_item )
             p_item->p_stats->i_displayed_pictures );
     msg_rc(_("| frames lost      :    %5"PRIi64),
             p_item->p_stats->i_lost_pictures );
+    msg_rc(_("| frames copied    :    %5"PRIi64" (%.0f/s)"),
+            p_item->p_stats->i_copied_pictures,
+            p_item->p_stats->f_picture_copy_rate * CLOCK_FREQ );
     msg_rc("|");
     /* Audio*/
     msg_rc("%s", _("+-[Audio Decoding]"));
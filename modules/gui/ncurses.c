@@ -821,6 +821,9 @@ static int DrawStats(intf_thread_t *intf)
                 p_stats->i_displayed_pictures);
         MainBoxWrite(sys, l++, _("| frames lost      :    %5"PRIi64),
                 p_stats->i_lost_pictures);
+        MainBoxWrite(sys, l++, _("| frames copied    :    %5"PRIi64" (%.0f/s)"),
+                p_stats->i_copied_pictures,
+                p_stats->f_picture_copy_rate * CLOCK_FREQ);
     }
     /* Audio*/
     if (i_audio) {
@@ -569,6 +569,10 @@ InputStatsPanel::InputStatsPanel( QWidget *parent ): QWidget( parent )
                            "0", video, qtr("frames") );
     CREATE_AND_ADD_TO_CAT( vlost_frames_stat, qtr("Lost"),
                            "0", video, qtr("frames") );
+    CREATE_AND_ADD_TO_CAT( vcopied_frames_stat, qtr("Copied"),
+                           "0", video, qtr("frames") );
+    CREATE_AND_ADD_TO_CAT( vcopy_rate_stat, qtr("Copy rate"),
+                           "0", video, qtr("frames/s") );
 
     CREATE_AND_ADD_TO_CAT( send_stat, qtr("Sent"), "0", streaming, qtr("packets") );
     CREATE_AND_ADD_TO_CAT( send_bytes_stat, qtr("Sent"),
@@ -642,6 +646,8 @@ void InputStatsPanel::update( input_item_t *p_item )
     UPDATE_INT( vdecoded_stat,     p_item->p_stats->i_decoded_video );
     UPDATE_INT( vdisplayed_stat,   p_item->p_stats->i_displayed_pictures );
     UPDATE_INT( vlost_frames_stat, p_item->p_stats->i_lost_pictures );
+    UPDATE_INT( vcopied_frames_stat, p_item->p_stats->i_copied_pictures );
+    UPDATE_FLOAT( vcopy_rate_stat, "%6.0f", (float)(p_item->p_stats->f_picture_copy_rate * CLOCK_FREQ ) );
 
     /* Sout */
     UPDATE_INT( send_stat,        p_item->p_stats->i_sent_packets );
@@ -139,6 +139,8 @@ private:
     QTreeWidgetItem *vdecoded_stat;
     QTreeWidgetItem *vdisplayed_stat;
     QTreeWidgetItem *vlost_frames_stat;
+    QTreeWidgetItem *vcopied_frames_stat;
+    QTreeWidgetItem *vcopy_rate_stat;
     QTreeWidgetItem *vfps_stat;
 
     QTreeWidgetItem *streaming;
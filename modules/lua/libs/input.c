@@ -189,6 +189,8 @@ static int vlclua_input_item_stats( lua_State *L )
         STATS_INT( decoded_video )
         STATS_INT( displayed_pictures )
         STATS_INT( lost_pictures )
+        STATS_INT( copied_pictures )
+        STATS_FLOAT( picture_copy_rate )
         STATS_INT( sent_packets )
         STATS_INT( sent_bytes )
         STATS_FLOAT( send_bitrate )
@@ -65,13 +65,7 @@ void*       DASHDownloader::download    (void *thread_sys)
     {
         ret = conManager->read(block);
         if(ret > 0)
-        {
-            block_t *bufBlock = block_Alloc(ret);
-            memcpy(bufBlock->p_buffer, block->p_buffer, ret);
-
-            bufBlock->i_length = block->i_length;
-            buffer->put(bufBlock);
-        }
+            buffer->put(block->p_buffer, ret, block->i_length);
     }while(ret && !buffer->getEOF());
 
     buffer->setEOF(true);
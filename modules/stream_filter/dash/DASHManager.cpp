@@ -26,6 +26,7 @@
 #endif
 
 #include "DASHManager.h"
+#include "mpd/SegmentIndex.h"
 
 using namespace dash;
 using namespace dash::http;
@@ -87,11 +88,106 @@ int     DASHManager::seekBackwards( unsigned i_len )
     return this->buffer->seekBackwards( i_len );
 }
 
+int     DASHManager::seekForward( unsigned i_len )
+{
+    return this->buffer->seekForward( i_len );
+}
+
 int     DASHManager::peek( const uint8_t **pp_peek, size_t i_peek )
 {
     return this->buffer->peek(pp_peek, i_peek);
 }
 
+int64_t DASHManager::seekTime( mtime_t time )
+{
+    const Representation *rep = this->adaptationLogic->getCurrentRepresentation();
+
+    if ( rep == NULL || rep->getSegmentBase() == NULL ||
+         !rep->getSegmentBase()->loadSegmentIndex( this->stream ) )
+        return -1;
+
+    const SegmentIndex *index = rep->getSegmentBase()->getSegmentIndex();
+
+    int entry = index->getEntryByTime( time );
+    if ( entry < 0 )
+        return -1;
+
+    /* The init segment, if any, precedes the indexed segments */
+    size_t segment = entry;
+    if ( rep->getSegmentBase()->getInitSegment() != NULL )
+        segment++;
+
+    return this->restart( rep, segment );
+}
+
+int64_t DASHManager::seekPosition( uint64_t pos )
+{
+    const Representation *rep = this->adaptationLogic->getCurrentRepresentation();
+
+    if ( rep == NULL )
+        return -1;
+    if ( rep->getSegmentBase() != NULL )
+        rep->getSegmentBase()->loadSegmentIndex( this->stream );
+
+    std::vector<Segment *> segments = this->mpdManager->getSegments( rep );
+    uint64_t offset = 0;
+
+    for ( size_t i = 0; i < segments.size(); i++ )
+    {
+        Segment *seg = segments.at( i );
+
+        if ( !seg->hasByteRange() )
+            return -1;
+
+        uint64_t size = seg->getEndByte() - seg->getStartByte() + 1;
+        if ( pos < offset + size )
+            return this->restart( rep, i );
+        offset += size;
+    }
+    return -1;
+}
+
+bool    DASHManager::isSeekable() const
+{
+    if ( this->mpd->isLive() )
+        return false;
+
+    /* Answered from the MPD: the index is only loaded by the first seek */
+    const Representation *rep = this->adaptationLogic->getCurrentRepresentation();
+
+    return rep != NULL && rep->getSegmentBase() != NULL &&
+           rep->getSegmentBase()->hasIndexRange();
+}
+
+int64_t DASHManager::restart( const Representation *rep, size_t segment )
+{
+    std::vector<Segment *> segments = this->mpdManager->getSegments( rep );
+    uint64_t offset = 0;
+
+    if ( segment >= segments.size() )
+        return -1;
+
+    for ( size_t i = 0; i < segment; i++ )
+    {
+        Segment *seg = segments.at( i );
+        if ( !seg->hasByteRange() )
+            return -1;
+        offset += seg->getEndByte() - seg->getStartByte() + 1;
+    }
+
+    /* Stop the download thread before touching its state */
+    delete this->downloader;
+    this->conManager->closeAllConnections();
+    this->buffer->reset();
+    this->adaptationLogic->setSegmentNumber( segment );
+
+    this->downloader = new DASHDownloader( this->conManager, this->buffer );
+    if ( !this->downloader->start() )
+        return -1;
+
+    return offset;
+}
+
 const mpd::IMPDManager*         DASHManager::getMpdManager() const
 {
     return this->mpdManager;
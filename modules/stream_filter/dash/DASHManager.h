@@ -48,6 +48,20 @@ namespace dash
             int     read          ( void *p_buffer, size_t len );
             int     peek          ( const uint8_t **pp_peek, size_t i_peek );
             int     seekBackwards ( unsigned len );
+            int     seekForward   ( unsigned len );
+            /**
+             *  Restarts the download at the subsegment containing time,
+             *  using the segment index of the current representation.
+             *  @return The stream position of the new read point, or -1.
+             */
+            int64_t seekTime      ( mtime_t time );
+            /**
+             *  Restarts the download at the segment containing the stream
+             *  position pos.
+             *  @return The stream position of the new read point, or -1.
+             */
+            int64_t seekPosition  ( uint64_t pos );
+            bool    isSeekable    () const;
 
             const mpd::IMPDManager*         getMpdManager   () const;
             const logic::IAdaptationLogic*  getAdaptionLogic() const;
@@ -63,6 +77,8 @@ namespace dash
             stream_t                            *stream;
             DASHDownloader                      *downloader;
             buffer::BlockBuffer                 *buffer;
+
+            int64_t restart             ( const mpd::Representation *rep, size_t segment );
     };
 }
 
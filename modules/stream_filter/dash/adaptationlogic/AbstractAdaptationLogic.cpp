@@ -67,3 +67,8 @@ int AbstractAdaptationLogic::getBufferPercent        () const
 {
     return this->bufferedPercent;
 }
+void AbstractAdaptationLogic::loadSegmentIndex       (const Representation *rep)
+{
+    if (rep->getSegmentBase() != NULL)
+        rep->getSegmentBase()->loadSegmentIndex(this->stream);
+}
@@ -53,6 +53,13 @@ namespace dash
                 uint64_t                    getBpsLastChunk         () const;
                 int                         getBufferPercent        () const;
 
+            protected:
+                /**
+                 *  Loads the segment index of a representation, the first
+                 *  time it is selected.
+                 */
+                void                        loadSegmentIndex        (const dash::mpd::Representation *rep);
+
             private:
                 int                     bpsAvg;
                 long                    bpsLastChunk;
@@ -80,6 +80,7 @@ void    AlwaysBestAdaptationLogic::initSchedule ()
 
             if(best != NULL)
             {
+                this->loadSegmentIndex(best);
                 std::vector<Segment *> segments = this->mpdManager->getSegments(best);
                 for(size_t j = 0; j < segments.size(); j++)
                 {
@@ -89,3 +90,8 @@ void    AlwaysBestAdaptationLogic::initSchedule ()
         }
     }
 }
+
+void AlwaysBestAdaptationLogic::setSegmentNumber(size_t number)
+{
+    this->count = number;
+}
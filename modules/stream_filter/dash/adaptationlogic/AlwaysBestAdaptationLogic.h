@@ -46,6 +46,7 @@ namespace dash
 
                 dash::http::Chunk* getNextChunk();
                 const mpd::Representation *getCurrentRepresentation() const;
+                void setSegmentNumber(size_t number);
 
             private:
                 std::vector<mpd::Segment *>         schedule;
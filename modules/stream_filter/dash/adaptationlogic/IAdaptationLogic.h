@@ -48,6 +48,11 @@ namespace dash
 
                 virtual dash::http::Chunk*                  getNextChunk            ()          = 0;
                 virtual const dash::mpd::Representation*    getCurrentRepresentation() const    = 0;
+                /**
+                 *  Makes the next call to getNextChunk() return the given
+                 *  segment of the current period.
+                 */
+                virtual void                                setSegmentNumber        (size_t number) = 0;
                 /**
                  *  \return     The average bitrate in bits per second.
                  */
@@ -62,6 +62,7 @@ Chunk*  RateBasedAdaptationLogic::getNextChunk()
     if ( rep == NULL )
         return NULL;
 
+    this->loadSegmentIndex( rep );
     std::vector<Segment *> segments = this->mpdManager->getSegments(rep);
 
     if ( this->count == segments.size() )
@@ -88,3 +89,8 @@ const Representation *RateBasedAdaptationLogic::getCurrentRepresentation() const
 {
     return this->mpdManager->getRepresentation( this->currentPeriod, this->getBpsAvg() );
 }
+
+void RateBasedAdaptationLogic::setSegmentNumber(size_t number)
+{
+    this->count = number;
+}
@@ -47,6 +47,7 @@ namespace dash
 
                 dash::http::Chunk*      getNextChunk();
                 const dash::mpd::Representation *getCurrentRepresentation() const;
+                void setSegmentNumber(size_t number);
 
             private:
                 dash::mpd::IMPDManager  *mpdManager;
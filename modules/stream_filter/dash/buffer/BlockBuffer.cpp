@@ -21,6 +21,7 @@
  * along with this program; if not, write to the Free Software Foundation,
  * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
+
 #ifdef HAVE_CONFIG_H
 # include "config.h"
 #endif
@@ -33,17 +34,30 @@ BlockBuffer::BlockBuffer    (stream_t *stream) :
              sizeMicroSec   (0),
              sizeBytes      (0),
              stream         (stream),
-             isEOF          (false)
-
+             isEOF          (false),
+             isBuffering    (true),
+             lastPercent    (-1),
+             underruns      (0),
+             oldRing        (NULL),
+             ringSize       (INITIALRINGSIZE),
+             readPos        (0),
+             historyBytes   (0)
 {
     this->capacityMicroSec  = var_InheritInteger(stream, "dash-buffersize") * 1000000;
 
     if(this->capacityMicroSec <= 0)
         this->capacityMicroSec = DEFAULTBUFFERLENGTH;
 
+    this->minMicroSec       = var_InheritInteger(stream, "dash-minbuffer") * 1000000;
+
+    if(this->minMicroSec < 0)
+        this->minMicroSec = 0;
+    if(this->minMicroSec > this->capacityMicroSec)
+        this->minMicroSec = this->capacityMicroSec;
+
+    this->ring      = new uint8_t[this->ringSize];
     this->peekBlock = block_Alloc(INTIALPEEKSIZE);
 
-    block_BytestreamInit(&this->buffer);
     vlc_mutex_init(&this->monitorMutex);
     vlc_cond_init(&this->empty);
     vlc_cond_init(&this->full);
@@ -52,7 +66,8 @@ BlockBuffer::~BlockBuffer   ()
 {
     block_Release(this->peekBlock);
 
-    block_BytestreamRelease(&this->buffer);
+    delete[] this->oldRing;
+    delete[] this->ring;
     vlc_mutex_destroy(&this->monitorMutex);
     vlc_cond_destroy(&this->empty);
     vlc_cond_destroy(&this->full);
@@ -62,8 +77,7 @@ int     BlockBuffer::peek                 (const uint8_t **pp_peek, unsigned int
 {
     vlc_mutex_lock(&this->monitorMutex);
 
-    while(this->sizeBytes == 0 && !this->isEOF)
-        vlc_cond_wait(&this->full, &this->monitorMutex);
+    this->waitData();
 
     if(this->sizeBytes == 0)
     {
@@ -74,11 +88,19 @@ int     BlockBuffer::peek                 (const uint8_t **pp_peek, unsigned int
 
     size_t ret = len > this->sizeBytes ? this->sizeBytes : len;
 
-    if(ret > this->peekBlock->i_buffer)
-        this->peekBlock = block_Realloc(this->peekBlock, 0, ret);
+    if(this->readPos + ret <= this->ringSize)
+    {
+        /* The writer only touches the free part of the ring */
+        *pp_peek = this->ring + this->readPos;
+    }
+    else
+    {
+        if(ret > this->peekBlock->i_buffer)
+            this->peekBlock = block_Realloc(this->peekBlock, 0, ret);
 
-    block_PeekBytes(&this->buffer, this->peekBlock->p_buffer, ret);
-    *pp_peek = this->peekBlock->p_buffer;
+        this->copyOut(this->peekBlock->p_buffer, 0, ret);
+        *pp_peek = this->peekBlock->p_buffer;
+    }
 
     vlc_mutex_unlock(&this->monitorMutex);
     return ret;
@@ -87,10 +109,31 @@ int     BlockBuffer::peek                 (const uint8_t **pp_peek, unsigned int
 int     BlockBuffer::seekBackwards       (unsigned len)
 {
     vlc_mutex_lock(&this->monitorMutex);
-    if( this->buffer.i_offset > len )
+    if( this->historyBytes >= len )
     {
-        this->buffer.i_offset -= len;
-        this->sizeBytes += len;
+        Span span = { len, 0 };
+
+        this->readPos       = (this->readPos + this->ringSize - len) % this->ringSize;
+        this->historyBytes -= len;
+        this->sizeBytes    += len;
+        this->spans.push_front(span);
+        vlc_mutex_unlock(&this->monitorMutex);
+        return VLC_SUCCESS;
+    }
+
+    vlc_mutex_unlock(&this->monitorMutex);
+    return VLC_EGENERIC;
+}
+
+int     BlockBuffer::seekForward         (unsigned len)
+{
+    vlc_mutex_lock(&this->monitorMutex);
+    if( this->sizeBytes >= len )
+    {
+        this->readPos = (this->readPos + len) % this->ringSize;
+        this->updateBufferSize(len);
+        this->notify();
+        vlc_cond_signal(&this->empty);
         vlc_mutex_unlock(&this->monitorMutex);
         return VLC_SUCCESS;
     }
@@ -103,8 +146,7 @@ int     BlockBuffer::get                  (void *p_data, unsigned int len)
 {
     vlc_mutex_lock(&this->monitorMutex);
 
-    while(this->sizeBytes == 0 && !this->isEOF)
-        vlc_cond_wait(&this->full, &this->monitorMutex);
+    this->waitData();
 
     if(this->sizeBytes == 0)
     {
@@ -115,25 +157,31 @@ int     BlockBuffer::get                  (void *p_data, unsigned int len)
 
     int ret = len > this->sizeBytes ? this->sizeBytes : len;
 
-    if(p_data == NULL)
-        block_SkipBytes(&this->buffer, ret);
-    else
-        block_GetBytes(&this->buffer, (uint8_t *)p_data, ret);
+    if(p_data != NULL)
+        this->copyOut((uint8_t *)p_data, 0, ret);
 
-    block_BytestreamFlush(&this->buffer);
+    this->readPos = (this->readPos + ret) % this->ringSize;
     this->updateBufferSize(ret);
 
+    if(this->sizeBytes == 0 && !this->isEOF && this->minMicroSec > 0)
+    {
+        this->isBuffering = true;
+        this->underruns++;
+        msg_Dbg(this->stream, "buffer underrun (%u), rebuffering", this->underruns);
+    }
+
     this->notify();
 
     vlc_cond_signal(&this->empty);
     vlc_mutex_unlock(&this->monitorMutex);
     return ret;
 }
-void    BlockBuffer::put                  (block_t *block)
+void    BlockBuffer::put                  (const uint8_t *p_data, size_t len, mtime_t length)
 {
     vlc_mutex_lock(&this->monitorMutex);
 
-    while(this->sizeMicroSec >= this->capacityMicroSec && !this->isEOF)
+    while(!this->isEOF && (this->sizeMicroSec >= this->capacityMicroSec ||
+          (this->ringSize - this->sizeBytes < len && !this->grow(this->sizeBytes + len))))
         vlc_cond_wait(&this->empty, &this->monitorMutex);
 
     if(this->isEOF)
@@ -143,10 +191,22 @@ void    BlockBuffer::put                  (block_t *block)
         return;
     }
 
-    this->sizeMicroSec  += block->i_length;
-    this->sizeBytes     += block->i_buffer;
+    size_t writePos = (this->readPos + this->sizeBytes) % this->ringSize;
+    size_t first    = __MIN(len, this->ringSize - writePos);
+
+    memcpy(this->ring + writePos, p_data, first);
+    memcpy(this->ring, p_data + first, len - first);
+
+    Span span = { len, length };
+    this->spans.push_back(span);
+
+    this->sizeMicroSec  += length;
+    this->sizeBytes     += len;
+
+    /* Writing may have overwritten the oldest already read bytes */
+    if(this->historyBytes > this->ringSize - this->sizeBytes)
+        this->historyBytes = this->ringSize - this->sizeBytes;
 
-    block_BytestreamPush(&this->buffer, block);
     this->notify();
 
     vlc_cond_signal(&this->full);
@@ -160,6 +220,20 @@ void    BlockBuffer::setEOF               (bool value)
     vlc_cond_signal(&this->full);
     vlc_mutex_unlock(&this->monitorMutex);
 }
+void    BlockBuffer::reset                ()
+{
+    vlc_mutex_lock(&this->monitorMutex);
+    this->spans.clear();
+    this->readPos       = 0;
+    this->historyBytes  = 0;
+    this->sizeMicroSec  = 0;
+    this->sizeBytes     = 0;
+    this->isEOF         = false;
+    this->isBuffering   = true;
+    this->lastPercent   = -1;
+    this->notify();
+    vlc_mutex_unlock(&this->monitorMutex);
+}
 bool    BlockBuffer::getEOF               ()
 {
     vlc_mutex_locker    lock(&this->monitorMutex);
@@ -172,22 +246,96 @@ void    BlockBuffer::attach               (IBufferObserver *observer)
 }
 void    BlockBuffer::notify               ()
 {
+    int percent = (this->sizeMicroSec * 100) / this->capacityMicroSec;
+
+    /* Observers only care about the level, not about every single byte */
+    if(percent == this->lastPercent)
+        return;
+    this->lastPercent = percent;
+
     for(size_t i = 0; i < this->bufferObservers.size(); i++)
-        this->bufferObservers.at(i)->bufferLevelChanged(this->sizeMicroSec, ((float)this->sizeMicroSec / this->capacityMicroSec) * 100);
+        this->bufferObservers.at(i)->bufferLevelChanged(this->sizeMicroSec, percent);
 }
-void    BlockBuffer::updateBufferSize     (size_t bytes)
+void    BlockBuffer::waitData             ()
+{
+    /* The previous ring can no longer be referenced by a peek pointer */
+    delete[] this->oldRing;
+    this->oldRing = NULL;
+
+    while(!this->isEOF && (this->sizeBytes == 0 ||
+          (this->isBuffering && this->sizeMicroSec < this->minMicroSec &&
+           this->sizeBytes < MAXRINGSIZE / 2)))
+        vlc_cond_wait(&this->full, &this->monitorMutex);
+
+    this->isBuffering = false;
+}
+bool    BlockBuffer::grow                 (size_t needed)
 {
-    block_t *block = this->buffer.p_block;
+    size_t newSize = this->ringSize;
 
-    this->sizeMicroSec = 0;
+    while(newSize < needed && newSize < MAXRINGSIZE)
+        newSize *= 2;
 
-    while(block)
+    if(newSize > MAXRINGSIZE)
+        newSize = MAXRINGSIZE;
+
+    if(newSize < needed || newSize == this->ringSize)
+        return false;
+
+    uint8_t *newRing = new uint8_t[newSize];
+    size_t  start    = (this->readPos + this->ringSize - this->historyBytes) % this->ringSize;
+    size_t  total    = this->historyBytes + this->sizeBytes;
+    size_t  first    = __MIN(total, this->ringSize - start);
+
+    memcpy(newRing, this->ring + start, first);
+    memcpy(newRing + first, this->ring, total - first);
+
+    /* The reader may still hold a pointer into the current ring: only
+     * release it once it called get() or peek() again. */
+    if(this->oldRing == NULL)
+        this->oldRing = this->ring;
+    else
+        delete[] this->ring;
+
+    this->ring      = newRing;
+    this->ringSize  = newSize;
+    this->readPos   = this->historyBytes;
+
+    return true;
+}
+void    BlockBuffer::copyOut              (uint8_t *p_data, size_t offset, size_t len) const
+{
+    size_t pos   = (this->readPos + offset) % this->ringSize;
+    size_t first = __MIN(len, this->ringSize - pos);
+
+    memcpy(p_data, this->ring + pos, first);
+    memcpy(p_data + first, this->ring, len - first);
+}
+void    BlockBuffer::updateBufferSize     (size_t bytes)
+{
+    this->sizeBytes     -= bytes;
+    this->historyBytes  += bytes;
+
+    while(bytes > 0 && !this->spans.empty())
     {
-        this->sizeMicroSec += block->i_length;
-        block = block->p_next;
+        Span &span = this->spans.front();
+
+        if(span.bytes <= bytes)
+        {
+            bytes              -= span.bytes;
+            this->sizeMicroSec -= span.length;
+            this->spans.pop_front();
+        }
+        else
+        {
+            mtime_t part = span.length * bytes / span.bytes;
+
+            span.bytes         -= bytes;
+            span.length        -= part;
+            this->sizeMicroSec -= part;
+            bytes               = 0;
+        }
     }
-
-    this->sizeBytes -= bytes;
 }
 mtime_t BlockBuffer::size                 ()
 {
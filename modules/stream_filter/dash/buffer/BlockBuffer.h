@@ -28,36 +28,66 @@
 #include "buffer/IBufferObserver.h"
 
 #include <vlc_stream.h>
-#include <vlc_block_helper.h>
 #include <vector>
+#include <deque>
 
 #include <iostream>
 
 #define DEFAULTBUFFERLENGTH 30000000
 #define INTIALPEEKSIZE      32768
+#define INITIALRINGSIZE     (1 << 20)
+#define MAXRINGSIZE         (256 << 20)
 
 namespace dash
 {
     namespace buffer
     {
+        /**
+         *  Contiguous ring buffer between the download thread and the
+         *  stream filter. Already read bytes are kept as long as they are
+         *  not overwritten, so that short backward seeks can be served.
+         */
         class BlockBuffer
         {
             public:
                 BlockBuffer           (stream_t *stream);
                 virtual ~BlockBuffer  ();
 
-                void    put           (block_t *block);
+                /**
+                 *  Copies len bytes into the ring, blocking while the buffer
+                 *  holds more than its maximum duration.
+                 *  @param  length  Playback duration of those bytes.
+                 */
+                void    put           (const uint8_t *p_data, size_t len, mtime_t length);
                 int     get           (void *p_data, unsigned int len);
+                /**
+                 *  The returned pointer refers to the ring itself unless the
+                 *  requested range wraps around its end. It stays valid until
+                 *  the next get(), peek() or seekBackwards() call.
+                 */
                 int     peek          (const uint8_t **pp_peek, unsigned int i_peek);
                 int     seekBackwards (unsigned len);
+                /**
+                 *  Skips len bytes if they are all buffered already, without
+                 *  waiting for data.
+                 */
+                int     seekForward   (unsigned len);
                 void    setEOF        (bool value);
+                void    reset         ();
                 bool    getEOF        ();
                 mtime_t size          ();
                 void    attach        (IBufferObserver *observer);
                 void    notify        ();
 
             private:
+                struct Span
+                {
+                    size_t  bytes;
+                    mtime_t length;
+                };
+
                 mtime_t             capacityMicroSec;
+                mtime_t             minMicroSec;
                 mtime_t             sizeMicroSec;
                 size_t              sizeBytes;
                 vlc_mutex_t         monitorMutex;
@@ -65,12 +95,23 @@ namespace dash
                 vlc_cond_t          full;
                 stream_t            *stream;
                 bool                isEOF;
-                block_bytestream_t  buffer;
+                bool                isBuffering;
+                int                 lastPercent;
+                unsigned            underruns;
+                uint8_t             *ring;
+                uint8_t             *oldRing;
+                size_t              ringSize;
+                size_t              readPos;
+                size_t              historyBytes;
+                std::deque<Span>    spans;
                 block_t             *peekBlock;
 
                 std::vector<IBufferObserver *> bufferObservers;
 
-                void updateBufferSize(size_t bytes);
+                void    waitData        ();
+                bool    grow            (size_t needed);
+                void    copyOut         (uint8_t *p_data, size_t offset, size_t len) const;
+                void    updateBufferSize(size_t bytes);
         };
     }
 }
@@ -40,8 +40,6 @@
 #include "adaptationlogic/IAdaptationLogic.h"
 #include "mpd/MPDFactory.h"
 
-#define SEEK 0
-
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -57,6 +55,10 @@ static void Close   (vlc_object_t *);
 #define DASH_BUFFER_TEXT N_("Buffer Size (Seconds)")
 #define DASH_BUFFER_LONGTEXT N_("Buffer size in seconds")
 
+#define DASH_MINBUFFER_TEXT N_("Minimum Buffer (Seconds)")
+#define DASH_MINBUFFER_LONGTEXT N_("Duration to buffer before starting " \
+    "playback and after an underrun")
+
 vlc_module_begin ()
         set_shortname( N_("DASH"))
         set_description( N_("Dynamic Adaptive Streaming over HTTP") )
@@ -66,6 +68,7 @@ vlc_module_begin ()
         add_integer( "dash-prefwidth",  480, DASH_WIDTH_TEXT,  DASH_WIDTH_LONGTEXT,  true )
         add_integer( "dash-prefheight", 360, DASH_HEIGHT_TEXT, DASH_HEIGHT_LONGTEXT, true )
         add_integer( "dash-buffersize", 30, DASH_BUFFER_TEXT, DASH_BUFFER_LONGTEXT, true )
+        add_integer( "dash-minbuffer", 0, DASH_MINBUFFER_TEXT, DASH_MINBUFFER_LONGTEXT, true )
         set_callbacks( Open, Close )
 vlc_module_end ()
 
@@ -150,6 +153,23 @@ static void Close(vlc_object_t *p_obj)
 /*****************************************************************************
  * Callbacks:
  *****************************************************************************/
+static int  SeekIndexed     ( stream_t *p_stream, uint64_t pos )
+{
+    stream_sys_t        *p_sys          = (stream_sys_t *) p_stream->p_sys;
+    int64_t             i_start         = p_sys->p_dashManager->seekPosition( pos );
+
+    if( i_start < 0 || (uint64_t)i_start > pos || pos - i_start > UINT_MAX )
+        return VLC_EGENERIC;
+
+    /* Skip from the start of the segment to the requested position */
+    p_sys->position = i_start;
+    unsigned i_len = pos - i_start;
+    if( i_len > 0 && (unsigned)Read( p_stream, NULL, i_len ) != i_len )
+        return VLC_EGENERIC;
+
+    return VLC_SUCCESS;
+}
+
 static int  Seek            ( stream_t *p_stream, uint64_t pos )
 {
     stream_sys_t        *p_sys          = (stream_sys_t *) p_stream->p_sys;
@@ -169,6 +189,8 @@ static int  Seek            ( stream_t *p_stream, uint64_t pos )
         i_ret = p_dashManager->seekBackwards( i_len );
         if( i_ret == VLC_EGENERIC )
         {
+            if( p_dashManager->isSeekable() )
+                return SeekIndexed( p_stream, pos );
             msg_Err( p_stream, "Cannot seek backward outside the current block :-/" );
             return VLC_EGENERIC;
         }
@@ -176,7 +198,14 @@ static int  Seek            ( stream_t *p_stream, uint64_t pos )
             return VLC_SUCCESS;
     }
 
-    /* Seek forward */
+    /* Seek forward, within the buffered data if possible */
+    if( pos - p_sys->position <= UINT_MAX &&
+        p_dashManager->seekForward( pos - p_sys->position ) == VLC_SUCCESS )
+        return VLC_SUCCESS;
+
+    if( p_dashManager->isSeekable() )
+        return SeekIndexed( p_stream, pos );
+
     if( pos - p_sys->position > UINT_MAX )
     {
         msg_Err( p_stream, "Cannot seek forward that far!" );
@@ -243,9 +272,10 @@ static int  Control         (stream_t *p_stream, int i_query, va_list args)
     switch (i_query)
     {
         case STREAM_CAN_SEEK:
+            *(va_arg (args, bool *)) = p_sys->p_dashManager->isSeekable();
+            break;
         case STREAM_CAN_FASTSEEK:
-            /*TODO Support Seek */
-            *(va_arg (args, bool *)) = SEEK;
+            *(va_arg (args, bool *)) = false;
             break;
         case STREAM_CAN_PAUSE:
         case STREAM_CAN_CONTROL_PACE:
@@ -41,11 +41,11 @@ Chunk::Chunk        () :
 {
 }
 
-int                 Chunk::getEndByte           () const
+uint64_t            Chunk::getEndByte           () const
 {
     return endByte;
 }
-int                 Chunk::getStartByte         () const
+uint64_t            Chunk::getStartByte         () const
 {
     return startByte;
 }
@@ -53,11 +53,11 @@ const std::string&  Chunk::getUrl               () const
 {
     return url;
 }
-void                Chunk::setEndByte           (int endByte)
+void                Chunk::setEndByte           (uint64_t endByte)
 {
     this->endByte = endByte;
 }
-void                Chunk::setStartByte         (int startByte)
+void                Chunk::setStartByte         (uint64_t startByte)
 {
     this->startByte = startByte;
 }
@@ -43,8 +43,8 @@ namespace dash
             public:
                 Chunk           ();
 
-                int                 getEndByte              () const;
-                int                 getStartByte            () const;
+                uint64_t            getEndByte              () const;
+                uint64_t            getStartByte            () const;
                 const std::string&  getUrl                  () const;
                 bool                hasHostname             () const;
                 const std::string&  getHostname             () const;
@@ -59,8 +59,8 @@ namespace dash
                 void                setConnection   (IHTTPConnection *connection);
                 void                setBytesRead    (uint64_t bytes);
                 void                setLength       (uint64_t length);
-                void                setEndByte      (int endByte);
-                void                setStartByte    (int startByte);
+                void                setEndByte      (uint64_t endByte);
+                void                setStartByte    (uint64_t startByte);
                 void                setUrl          (const std::string& url);
                 void                addOptionalUrl  (const std::string& url);
                 bool                useByteRange    ();
@@ -73,8 +73,8 @@ namespace dash
                 std::string                 path;
                 std::string                 hostname;
                 std::vector<std::string>    optionalUrls;
-                int                         startByte;
-                int                         endByte;
+                uint64_t                    startByte;
+                uint64_t                    endByte;
                 bool                        hasByteRange;
                 int                         bitrate;
                 int                         port;
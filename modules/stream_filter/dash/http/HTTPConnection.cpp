@@ -30,6 +30,7 @@
 using namespace dash::http;
 
 HTTPConnection::HTTPConnection  (stream_t *stream) :
+                httpSocket      (-1),
                 stream          (stream),
                 peekBufferLen   (0),
                 contentLength   (0)
@@ -43,16 +43,21 @@ std::vector<Segment*>       IsoffMainManager::getSegments           (const Repre
 {
     std::vector<Segment *>  retSegments;
     SegmentList*            list= rep->getSegmentList();
+    SegmentBase*            base= rep->getSegmentBase();
 
-    if(rep->getSegmentBase())
+    if(base)
     {
-        Segment* initSegment = rep->getSegmentBase()->getInitSegment();
+        Segment* initSegment = base->getInitSegment();
 
         if(initSegment)
             retSegments.push_back(initSegment);
     }
 
-    retSegments.insert(retSegments.end(), list->getSegments().begin(), list->getSegments().end());
+    if(list)
+        retSegments.insert(retSegments.end(), list->getSegments().begin(), list->getSegments().end());
+    else if(base)
+        retSegments.insert(retSegments.end(), base->getIndexedSegments().begin(), base->getIndexedSegments().end());
+
     return retSegments;
 }
 const std::vector<Period*>& IsoffMainManager::getPeriods            () const
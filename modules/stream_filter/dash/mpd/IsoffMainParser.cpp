@@ -112,6 +112,13 @@ void    IsoffMainParser::setRepresentations (Node *adaptationSetNode, Adaptation
         this->currentRepresentation = new Representation;
         Node *repNode = representations.at(i);
 
+        /* On demand profile: the representation is a single file */
+        std::vector<Node *> baseUrls = DOMHelper::getChildElementByTagName(repNode, "BaseURL");
+        if(baseUrls.size() > 0)
+            this->currentRepresentationUrl = baseUrls.at(0)->getText();
+        else
+            this->currentRepresentationUrl.clear();
+
         if(repNode->hasAttribute("width"))
             this->currentRepresentation->setWidth(atoi(repNode->getAttributeValue("width").c_str()));
 
@@ -134,6 +141,7 @@ void    IsoffMainParser::setSegmentBase     (dash::xml::Node *repNode, Represent
     {
         SegmentBase *base = new SegmentBase();
         this->setInitSegment(segmentBase.at(0), base);
+        this->setIndexSegment(segmentBase.at(0), base);
         rep->setSegmentBase(base);
     }
 }
@@ -159,14 +167,13 @@ void    IsoffMainParser::setInitSegment     (dash::xml::Node *segBaseNode, Segme
     if(initSeg.size() > 0)
     {
         Segment *seg = new Segment( this->currentRepresentation );
-        seg->setSourceUrl(initSeg.at(0)->getAttributeValue("sourceURL"));
+        if(initSeg.at(0)->hasAttribute("sourceURL"))
+            seg->setSourceUrl(initSeg.at(0)->getAttributeValue("sourceURL"));
+        else
+            seg->setSourceUrl(this->currentRepresentationUrl);
 
         if(initSeg.at(0)->hasAttribute("range"))
-        {
-            std::string range = initSeg.at(0)->getAttributeValue("range");
-            size_t pos = range.find("-");
-            seg->setByteRange(atoi(range.substr(0, pos).c_str()), atoi(range.substr(pos + 1, range.size()).c_str()));
-        }
+            this->setByteRange(seg, initSeg.at(0)->getAttributeValue("range"));
 
         for(size_t i = 0; i < this->mpd->getBaseUrls().size(); i++)
             seg->addBaseUrl(this->mpd->getBaseUrls().at(i));
@@ -174,6 +181,20 @@ void    IsoffMainParser::setInitSegment     (dash::xml::Node *segBaseNode, Segme
         base->addInitSegment(seg);
     }
 }
+void    IsoffMainParser::setIndexSegment    (dash::xml::Node *segBaseNode, SegmentBase *base)
+{
+    if(!segBaseNode->hasAttribute("indexRange") || this->currentRepresentationUrl.empty())
+        return;
+
+    Segment *seg = new Segment( this->currentRepresentation );
+    seg->setSourceUrl(this->currentRepresentationUrl);
+    this->setByteRange(seg, segBaseNode->getAttributeValue("indexRange"));
+
+    for(size_t i = 0; i < this->mpd->getBaseUrls().size(); i++)
+        seg->addBaseUrl(this->mpd->getBaseUrls().at(i));
+
+    base->addIndexSegment(seg);
+}
 void    IsoffMainParser::setSegments        (dash::xml::Node *segListNode, SegmentList *list)
 {
     std::vector<Node *> segments = DOMHelper::getElementByTagName(segListNode, "SegmentURL", false);
@@ -184,11 +205,7 @@ void    IsoffMainParser::setSegments        (dash::xml::Node *segListNode, Segme
         seg->setSourceUrl(segments.at(i)->getAttributeValue("media"));
 
         if(segments.at(i)->hasAttribute("mediaRange"))
-        {
-            std::string range = segments.at(i)->getAttributeValue("mediaRange");
-            size_t pos = range.find("-");
-            seg->setByteRange(atoi(range.substr(0, pos).c_str()), atoi(range.substr(pos + 1, range.size()).c_str()));
-        }
+            this->setByteRange(seg, segments.at(i)->getAttributeValue("mediaRange"));
 
         for(size_t j = 0; j < this->mpd->getBaseUrls().size(); j++)
             seg->addBaseUrl(this->mpd->getBaseUrls().at(j));
@@ -196,6 +213,23 @@ void    IsoffMainParser::setSegments        (dash::xml::Node *segListNode, Segme
         list->addSegment(seg);
     }
 }
+void    IsoffMainParser::setByteRange       (Segment *seg, const std::string &range)
+{
+    const char          *psz_range = range.c_str();
+    char                *psz_end;
+    unsigned long long  start, end;
+
+    /* Offsets of a single file representation may be past 4 GiB */
+    start = strtoull(psz_range, &psz_end, 10);
+    if(psz_end == psz_range || *psz_end != '-')
+        return;
+    psz_range = psz_end + 1;
+    end = strtoull(psz_range, &psz_end, 10);
+    if(psz_end == psz_range || end < start)
+        return;
+
+    seg->setByteRange(start, end);
+}
 void    IsoffMainParser::print              ()
 {
     if(this->mpd)
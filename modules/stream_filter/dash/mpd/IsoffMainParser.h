@@ -63,6 +63,7 @@ namespace dash
                 stream_t        *p_stream;
                 MPD             *mpd;
                 Representation  *currentRepresentation;
+                std::string     currentRepresentationUrl;
 
                 void    setMPDAttributes    ();
                 void    setMPDBaseUrl       ();
@@ -72,7 +73,9 @@ namespace dash
                 void    setSegmentBase      (dash::xml::Node *repNode, Representation *rep);
                 void    setSegmentList      (dash::xml::Node *repNode, Representation *rep);
                 void    setInitSegment      (dash::xml::Node *segBaseNode, SegmentBase *base);
+                void    setIndexSegment     (dash::xml::Node *segBaseNode, SegmentBase *base);
                 void    setSegments         (dash::xml::Node *segListNode, SegmentList *list);
+                void    setByteRange        (Segment *seg, const std::string &range);
         };
     }
 }
@@ -34,8 +34,9 @@ using namespace dash::mpd;
 using namespace dash::http;
 
 Segment::Segment(const Representation *parent) :
-        startByte  (-1),
-        endByte    (-1),
+        startByte  (0),
+        endByte    (0),
+        byteRange  (false),
         parentRepresentation( parent )
 {
     assert( parent != NULL );
@@ -71,16 +72,21 @@ const std::vector<BaseUrl *>&  Segment::getBaseUrls    () const
 {
     return this->baseUrls;
 }
-void                    Segment::setByteRange   (int start, int end)
+void                    Segment::setByteRange   (uint64_t start, uint64_t end)
 {
     this->startByte = start;
     this->endByte   = end;
+    this->byteRange = true;
 }
-int                     Segment::getStartByte   () const
+bool                    Segment::hasByteRange   () const
+{
+    return this->byteRange;
+}
+uint64_t                Segment::getStartByte   () const
 {
     return this->startByte;
 }
-int                     Segment::getEndByte     () const
+uint64_t                Segment::getEndByte     () const
 {
     return this->endByte;
 }
@@ -88,7 +94,7 @@ dash::http::Chunk*      Segment::toChunk        ()
 {
     Chunk *chunk = new Chunk();
 
-    if(this->startByte != -1 && this->endByte != -1)
+    if(this->byteRange)
     {
         chunk->setUseByteRange(true);
         chunk->setStartByte(this->startByte);
@@ -52,9 +52,10 @@ namespace dash
                 virtual void                            done            ();
                 virtual void                            addBaseUrl      (BaseUrl *url);
                 virtual const std::vector<BaseUrl *>&   getBaseUrls     () const;
-                virtual void                            setByteRange    (int start, int end);
-                virtual int                             getStartByte    () const;
-                virtual int                             getEndByte      () const;
+                virtual void                            setByteRange    (uint64_t start, uint64_t end);
+                virtual bool                            hasByteRange    () const;
+                virtual uint64_t                        getStartByte    () const;
+                virtual uint64_t                        getEndByte      () const;
                 virtual dash::http::Chunk*              toChunk         ();
                 const Representation*                   getParentRepresentation() const;
                 virtual int                             getSize() const;
@@ -62,8 +63,9 @@ namespace dash
             protected:
                 std::string             sourceUrl;
                 std::vector<BaseUrl *>  baseUrls;
-                int                     startByte;
-                int                     endByte;
+                uint64_t                startByte;
+                uint64_t                endByte;
+                bool                    byteRange;
                 const Representation*   parentRepresentation;
                 int                     size;
         };
@@ -27,15 +27,31 @@
 #endif
 
 #include "SegmentBase.h"
+#include "http/HTTPConnection.h"
+
+#include <vlc_arrays.h>
+
+#include <new>
 
 using namespace dash::mpd;
 
+/* Segment indexes take a few dozen bytes per subsegment */
+#define MAX_INDEX_SIZE  (1 << 20)
+
 SegmentBase::SegmentBase    () :
-             initSeg        (NULL)
+             initSeg        (NULL),
+             indexSeg       (NULL),
+             segmentIndex   (NULL),
+             indexLoaded    (false)
 {
+    vlc_mutex_init(&this->indexLock);
 }
 SegmentBase::~SegmentBase   ()
 {
+    vlc_mutex_destroy(&this->indexLock);
+    vlc_delete_all(this->indexedSegments);
+    delete this->segmentIndex;
+    delete this->indexSeg;
 }
 
 void        SegmentBase::addInitSegment  (Segment *seg)
@@ -46,3 +62,91 @@ Segment*    SegmentBase::getInitSegment  ()
 {
     return this->initSeg;
 }
+void        SegmentBase::addIndexSegment (Segment *seg)
+{
+    this->indexSeg = seg;
+}
+Segment*    SegmentBase::getIndexSegment ()
+{
+    return this->indexSeg;
+}
+void        SegmentBase::setSegmentIndex (SegmentIndex *index, const Segment *url)
+{
+    vlc_delete_all(this->indexedSegments);
+    delete this->segmentIndex;
+
+    this->segmentIndex = index;
+
+    const std::vector<SegmentIndex::Entry> &entries = index->getEntries();
+
+    for(size_t i = 0; i < entries.size(); i++)
+    {
+        Segment *seg = new Segment(url->getParentRepresentation());
+        seg->setSourceUrl(url->getSourceUrl());
+        seg->setByteRange(entries.at(i).offset, entries.at(i).offset + entries.at(i).size - 1);
+
+        for(size_t j = 0; j < url->getBaseUrls().size(); j++)
+            seg->addBaseUrl(url->getBaseUrls().at(j));
+
+        this->indexedSegments.push_back(seg);
+    }
+}
+bool                            SegmentBase::loadSegmentIndex    (stream_t *stream)
+{
+    vlc_mutex_locker    lock(&this->indexLock);
+
+    /* Only tried once, a failure leaves the representation unindexed */
+    if(this->indexLoaded || this->indexSeg == NULL || !this->indexSeg->hasByteRange())
+        return this->segmentIndex != NULL;
+    this->indexLoaded = true;
+
+    uint64_t len = this->indexSeg->getEndByte() - this->indexSeg->getStartByte() + 1;
+    if(len > MAX_INDEX_SIZE)
+    {
+        msg_Err(stream, "segment index of %s too large (%" PRIu64 " bytes)",
+                this->indexSeg->getSourceUrl().c_str(), len);
+        return false;
+    }
+
+    uint8_t *p_data = new (std::nothrow) uint8_t[len];
+    if(p_data == NULL)
+        return false;
+
+    dash::http::Chunk       *chunk  = this->indexSeg->toChunk();
+
+    dash::http::HTTPConnection connection(stream);
+    if(connection.init(chunk))
+    {
+        size_t  total = 0;
+        int     i_read;
+
+        while(total < len && (i_read = connection.read(p_data + total, len - total)) > 0)
+            total += i_read;
+
+        SegmentIndex *index = new SegmentIndex();
+        if(index->parse(p_data, total, this->indexSeg->getStartByte()))
+        {
+            this->setSegmentIndex(index, this->indexSeg);
+            msg_Dbg(stream, "loaded %zu subsegments from segment index of %s",
+                    index->getEntries().size(), this->indexSeg->getSourceUrl().c_str());
+        }
+        else
+            delete index;
+    }
+
+    delete chunk;
+    delete[] p_data;
+    return this->segmentIndex != NULL;
+}
+bool                            SegmentBase::hasIndexRange       () const
+{
+    return this->indexSeg != NULL && this->indexSeg->hasByteRange();
+}
+const SegmentIndex*             SegmentBase::getSegmentIndex     () const
+{
+    return this->segmentIndex;
+}
+const std::vector<Segment *>&   SegmentBase::getIndexedSegments  () const
+{
+    return this->indexedSegments;
+}
@@ -26,6 +26,9 @@
 #define SEGMENTBASE_H_
 
 #include "mpd/Segment.h"
+#include "mpd/SegmentIndex.h"
+
+#include <vector>
 
 namespace dash
 {
@@ -39,9 +42,37 @@ namespace dash
 
                 void        addInitSegment  (Segment *seg);
                 Segment*    getInitSegment  ();
+                void        addIndexSegment (Segment *seg);
+                Segment*    getIndexSegment ();
+                /**
+                 *  Takes ownership of index and builds one media segment
+                 *  per subsegment it references.
+                 *  @param  url     Source url of the single file representation.
+                 */
+                void                            setSegmentIndex     (SegmentIndex *index, const Segment *url);
+                /**
+                 *  Downloads and parses the index range the first time it
+                 *  is called, from whichever thread selects the
+                 *  representation first. The segment index and the indexed
+                 *  segments must not be used before it returned.
+                 *  @return true if the segment index is available.
+                 */
+                bool                            loadSegmentIndex    (stream_t *stream);
+                /**
+                 *  @return true if the MPD gives the byte range of a segment
+                 *  index, without loading it.
+                 */
+                bool                            hasIndexRange       () const;
+                const SegmentIndex*             getSegmentIndex     () const;
+                const std::vector<Segment *>&   getIndexedSegments  () const;
 
             private:
-                Segment *initSeg;
+                Segment                 *initSeg;
+                Segment                 *indexSeg;
+                SegmentIndex            *segmentIndex;
+                std::vector<Segment *>  indexedSegments;
+                bool                    indexLoaded;
+                vlc_mutex_t             indexLock;
         };
     }
 }
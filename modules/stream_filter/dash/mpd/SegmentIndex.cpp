@@ -0,0 +1,158 @@
+/*
+ * SegmentIndex.cpp
+ *****************************************************************************
+ * Copyright (C) 2012 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "SegmentIndex.h"
+
+#include <algorithm>
+
+using namespace dash::mpd;
+
+static bool compareOffsets (const SegmentIndex::Entry &a, const SegmentIndex::Entry &b)
+{
+    return a.offset < b.offset;
+}
+
+SegmentIndex::SegmentIndex  ()
+{
+}
+SegmentIndex::~SegmentIndex ()
+{
+}
+
+bool                                    SegmentIndex::parse         (const uint8_t *p_data, size_t i_data, uint64_t rangeStart)
+{
+    size_t pos = 0;
+
+    /* The index range may also cover other boxes (styp, ...) and several
+     * daisy chained sidx boxes: walk all top level boxes it contains. */
+    while(i_data - pos >= 8)
+    {
+        uint64_t    boxSize     = GetDWBE(p_data + pos);
+        size_t      headerSize  = 8;
+
+        if(boxSize == 1)
+        {
+            if(i_data - pos < 16)
+                break;
+            boxSize     = GetQWBE(p_data + pos + 8);
+            headerSize  = 16;
+        }
+        else if(boxSize == 0)
+        {
+            boxSize = i_data - pos;
+        }
+
+        if(boxSize < headerSize || boxSize > i_data - pos)
+            break;
+
+        if(!memcmp(p_data + pos + 4, "sidx", 4))
+            this->parseSidx(p_data + pos + headerSize, boxSize - headerSize,
+                            rangeStart + pos + boxSize);
+
+        pos += boxSize;
+    }
+
+    std::sort(this->entries.begin(), this->entries.end(), compareOffsets);
+
+    return this->entries.size() > 0;
+}
+bool                                    SegmentIndex::parseSidx     (const uint8_t *p_box, size_t i_box, uint64_t anchor)
+{
+    if(i_box < 4 + 8)
+        return false;
+
+    int         version     = p_box[0];
+    uint32_t    timescale   = GetDWBE(p_box + 8);
+    uint64_t    earliestTime;
+    uint64_t    firstOffset;
+    size_t      pos         = 12;
+
+    if(timescale == 0)
+        return false;
+
+    if(version == 0)
+    {
+        if(i_box < pos + 8)
+            return false;
+        earliestTime    = GetDWBE(p_box + pos);
+        firstOffset     = GetDWBE(p_box + pos + 4);
+        pos += 8;
+    }
+    else
+    {
+        if(i_box < pos + 16)
+            return false;
+        earliestTime    = GetQWBE(p_box + pos);
+        firstOffset     = GetQWBE(p_box + pos + 8);
+        pos += 16;
+    }
+
+    if(i_box < pos + 4)
+        return false;
+
+    uint16_t    count   = GetWBE(p_box + pos + 2);
+    uint64_t    offset  = anchor + firstOffset;
+    uint64_t    time    = earliestTime;
+    pos += 4;
+
+    for(uint16_t i = 0; i < count && i_box >= pos + 12; i++, pos += 12)
+    {
+        uint32_t    ref         = GetDWBE(p_box + pos);
+        uint32_t    duration    = GetDWBE(p_box + pos + 4);
+        uint32_t    size        = ref & 0x7fffffff;
+
+        /* References to other sidx boxes are followed when they are part
+         * of the same index range, they are not media subsegments. */
+        if(!(ref & 0x80000000))
+        {
+            Entry entry;
+            entry.offset    = offset;
+            entry.size      = size;
+            entry.time      = CLOCK_FREQ * time / timescale;
+            entry.duration  = CLOCK_FREQ * (uint64_t)duration / timescale;
+            this->entries.push_back(entry);
+        }
+
+        offset  += size;
+        time    += duration;
+    }
+
+    return true;
+}
+const std::vector<SegmentIndex::Entry>& SegmentIndex::getEntries    () const
+{
+    return this->entries;
+}
+int                                     SegmentIndex::getEntryByTime(mtime_t time) const
+{
+    if(this->entries.size() == 0)
+        return -1;
+
+    for(size_t i = 0; i < this->entries.size(); i++)
+    {
+        if(time < this->entries.at(i).time + this->entries.at(i).duration)
+            return i;
+    }
+
+    return this->entries.size() - 1;
+}
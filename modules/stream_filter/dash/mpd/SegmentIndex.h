@@ -0,0 +1,74 @@
+/*
+ * SegmentIndex.h
+ *****************************************************************************
+ * Copyright (C) 2012 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef SEGMENTINDEX_H_
+#define SEGMENTINDEX_H_
+
+#include <vlc_common.h>
+
+#include <vector>
+#include <stdint.h>
+
+namespace dash
+{
+    namespace mpd
+    {
+        /**
+         *  Parsed content of an ISO BMFF Segment Index box ('sidx').
+         *  Maps media time to the byte ranges of the subsegments of a
+         *  single file representation.
+         */
+        class SegmentIndex
+        {
+            public:
+                struct Entry
+                {
+                    uint64_t    offset;     /* absolute byte offset in the file */
+                    uint32_t    size;       /* referenced size in bytes */
+                    mtime_t     time;       /* earliest presentation time */
+                    mtime_t     duration;
+                };
+
+                SegmentIndex            ();
+                virtual ~SegmentIndex   ();
+
+                /**
+                 *  Parses the boxes contained in an index range.
+                 *  @param  p_data      The bytes fetched for the index range.
+                 *  @param  i_data      Their size.
+                 *  @param  rangeStart  Offset in the file of the first byte of p_data.
+                 *  @return false if no usable sidx box was found.
+                 */
+                bool                        parse       (const uint8_t *p_data, size_t i_data, uint64_t rangeStart);
+                const std::vector<Entry>&   getEntries  () const;
+                /**
+                 *  @return The index of the entry containing time, or -1.
+                 */
+                int                         getEntryByTime  (mtime_t time) const;
+
+            private:
+                std::vector<Entry>  entries;
+
+                bool    parseSidx   (const uint8_t *p_box, size_t i_box, uint64_t anchor);
+        };
+    }
+}
+
+#endif /* SEGMENTINDEX_H_ */
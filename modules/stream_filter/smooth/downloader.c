@@ -106,6 +106,68 @@ static unsigned set_track_id( chunk_t *chunk, const unsigned tid )
     return ret;
 }
 
+/* Takes a recycled buffer of at least size bytes, or allocates a new one.
+ * Must be called with download.lock_wait held. */
+static uint8_t *pool_Get( stream_sys_t *p_sys, int size, int *alloc_size )
+{
+    unsigned count = p_sys->download.pool_count;
+    uint8_t *data;
+
+    for( unsigned i = 0; i < count; i++ )
+    {
+        if( p_sys->download.pool_size[i] < size )
+            continue;
+
+        data = p_sys->download.pool[i];
+        *alloc_size = p_sys->download.pool_size[i];
+        p_sys->download.pool[i] = p_sys->download.pool[count - 1];
+        p_sys->download.pool_size[i] = p_sys->download.pool_size[count - 1];
+        p_sys->download.pool_count--;
+        return data;
+    }
+
+    if( count > 0 )
+    {
+        /* No buffer is big enough: grow the last one */
+        data = realloc( p_sys->download.pool[count - 1], size );
+        if( data != NULL )
+            p_sys->download.pool_count--;
+    }
+    else
+        data = malloc( size );
+
+    if( data != NULL )
+        *alloc_size = size;
+    return data;
+}
+
+/* Must be called with download.lock_wait held */
+void chunk_Recycle( stream_sys_t *p_sys, chunk_t *chunk )
+{
+    if( chunk->data == NULL )
+        return;
+
+    unsigned count = p_sys->download.pool_count;
+    if( count < SMS_POOL_SIZE )
+    {
+        p_sys->download.pool[count] = chunk->data;
+        p_sys->download.pool_size[count] = chunk->alloc_size;
+        p_sys->download.pool_count++;
+    }
+    else
+        free( chunk->data );
+
+    chunk->data = NULL;
+    chunk->alloc_size = 0;
+}
+
+void chunk_PoolClean( stream_sys_t *p_sys )
+{
+    for( unsigned i = 0; i < p_sys->download.pool_count; i++ )
+        free( p_sys->download.pool[i] );
+    p_sys->download.pool_count = 0;
+}
+
 static int sms_Download( stream_t *s, chunk_t *chunk, char *url )
 {
     stream_sys_t *p_sys = s->p_sys;
@@ -117,11 +179,9 @@ static int sms_Download( stream_t *s, chunk_t *chunk, char *url )
 
     int64_t size = stream_Size( p_ts );
 
-    chunk->size = size;
-    chunk->offset = p_sys->download.next_chunk_offset;
-    p_sys->download.next_chunk_offset += chunk->size;
-
-    chunk->data = malloc( size );
+    vlc_mutex_lock( &p_sys->download.lock_wait );
+    chunk->data = pool_Get( p_sys, size, &chunk->alloc_size );
+    vlc_mutex_unlock( &p_sys->download.lock_wait );
 
     if( chunk->data == NULL )
     {
@@ -134,19 +194,14 @@ static int sms_Download( stream_t *s, chunk_t *chunk, char *url )
     {
         msg_Warn( s, "sms_Download: I requested %"PRIi64" bytes, "\
                 "but I got only %i", size, read );
-        chunk->data = realloc( chunk->data, read );
+        size = __MAX( read, 0 );
     }
+    chunk->size = size;
 
     stream_Delete( p_ts );
 
-    vlc_mutex_lock( &p_sys->download.lock_wait );
-    int index = es_cat_to_index( chunk->type );
-    p_sys->download.lead[index] += chunk->duration;
-    vlc_mutex_unlock( &p_sys->download.lock_wait );
-
     return VLC_SUCCESS;
 }
-
 #ifdef DISABLE_BANDWIDTH_ADAPTATION
 static unsigned BandwidthAdaptation( stream_t *s,
         sms_stream_t *sms, uint64_t *bandwidth )
@@ -373,12 +428,39 @@ build_init_chunk_error:
     return NULL;
 }
 
+/* The bandwidth left for video once the other tracks are served */
+static uint64_t video_budget( stream_t *s, const sms_stream_t *video,
+                              uint64_t bandwidth )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    for( int i = 0; i < vlc_array_count( p_sys->selected_st ); i++ )
+    {
+        sms_stream_t *sms = vlc_array_item_at_index( p_sys->selected_st, i );
+        if( sms == video )
+            continue;
+
+        quality_level_t *qlevel = get_qlevel( sms, sms->download_qlvl );
+        if( qlevel == NULL )
+            continue;
+        if( qlevel->Bitrate >= bandwidth )
+            return 0;
+        bandwidth -= qlevel->Bitrate;
+    }
+    return bandwidth;
+}
+
 static int Download( stream_t *s, sms_stream_t *sms )
 {
     stream_sys_t *p_sys = s->p_sys;
 
     int index = es_cat_to_index( sms->type );
+
+    vlc_mutex_lock( &p_sys->download.lock_wait );
     int64_t start_time = p_sys->download.lead[index];
+    unsigned generation = p_sys->download.generation;
+    uint64_t avg_bw = sms_queue_avg( p_sys->bws );
+    vlc_mutex_unlock( &p_sys->download.lock_wait );
 
     quality_level_t *qlevel = get_qlevel( sms, sms->download_qlvl );
     if( unlikely( !qlevel ) )
@@ -413,7 +495,6 @@ static int Download( stream_t *s, sms_stream_t *sms )
     }
 
     /* sanity check - can we download this chunk on time? */
-    uint64_t avg_bw = sms_queue_avg( p_sys->bws );
     if( (avg_bw > 0) && (qlevel->Bitrate > 0) )
     {
         /* duration in ms */
@@ -428,14 +509,25 @@ static int Download( stream_t *s, sms_stream_t *sms )
         }
     }
 
+    vlc_mutex_lock( &p_sys->download.lock_wait );
+    p_sys->download.active++;
+    vlc_mutex_unlock( &p_sys->download.lock_wait );
+
     mtime_t start = mdate();
-    if( sms_Download( s, chunk, url ) != VLC_SUCCESS )
+    int i_ret = sms_Download( s, chunk, url );
+    mtime_t duration = mdate() - start;
+
+    vlc_mutex_lock( &p_sys->download.lock_wait );
+    /* Number of downloads which shared the link with this one */
+    unsigned active = p_sys->download.active--;
+    vlc_mutex_unlock( &p_sys->download.lock_wait );
+
+    if( i_ret != VLC_SUCCESS )
     {
         msg_Err( s, "downloaded chunk %u from stream %s at quality\
             %u failed", chunk->sequence, sms->name, qlevel->Bitrate );
         return VLC_EGENERIC;
     }
-    mtime_t duration = mdate() - start;
 
     unsigned real_id = set_track_id( chunk, sms->id );
     if( real_id == 0)
@@ -450,17 +542,22 @@ static int Download( stream_t *s, sms_stream_t *sms )
         get_new_chunks( s, chunk );
 
     vlc_mutex_lock( &p_sys->download.lock_wait );
-    vlc_array_append( p_sys->download.chunks, chunk );
-    vlc_cond_signal( &p_sys->download.wait );
-    vlc_mutex_unlock( &p_sys->download.lock_wait );
+    if( generation != p_sys->download.generation )
+    {
+        /* A time seek happened meanwhile: this chunk is not wanted anymore */
+        chunk_Recycle( p_sys, chunk );
+        vlc_mutex_unlock( &p_sys->download.lock_wait );
+        return VLC_SUCCESS;
+    }
 
-    msg_Info( s, "downloaded chunk %d from stream %s at quality %u",
-                chunk->sequence, sms->name, qlevel->Bitrate );
+    chunk->offset = p_sys->download.next_chunk_offset;
+    p_sys->download.next_chunk_offset += chunk->size;
+    p_sys->download.lead[index] += chunk->duration;
+    vlc_array_append( p_sys->download.chunks, chunk );
 
     uint64_t actual_lead = chunk->start_time + chunk->duration;
-    int ind = es_cat_to_index( sms->type );
-    p_sys->download.ck_index[ind] = chunk->sequence;
-    p_sys->download.lead[ind] = __MIN( p_sys->download.lead[ind], actual_lead );
+    p_sys->download.ck_index[index] = chunk->sequence;
+    p_sys->download.lead[index] = __MIN( p_sys->download.lead[index], actual_lead );
 
     if( sms->type == VIDEO_ES ||
             ( !SMS_GET_SELECTED_ST( VIDEO_ES ) && sms->type == AUDIO_ES ) )
@@ -469,12 +566,22 @@ static int Download( stream_t *s, sms_stream_t *sms )
                                             (uint64_t)chunk->start_time );
     }
 
+    /* The tracks are downloaded concurrently: scale the throughput of this
+     * download to estimate the bandwidth of the whole link. */
     unsigned dur_ms = __MAX( 1, duration / 1000 );
-    uint64_t bw = chunk->size * 8 * 1000 / dur_ms; /* bits / s */
-    if( sms_queue_put( p_sys->bws, bw ) != VLC_SUCCESS )
-        return VLC_EGENERIC;
+    uint64_t bw = chunk->size * 8 * 1000 / dur_ms * active; /* bits / s */
+    i_ret = sms_queue_put( p_sys->bws, bw );
     avg_bw = sms_queue_avg( p_sys->bws );
 
+    vlc_cond_broadcast( &p_sys->download.wait );
+    vlc_mutex_unlock( &p_sys->download.lock_wait );
+
+    if( i_ret != VLC_SUCCESS )
+        return VLC_EGENERIC;
+
+    msg_Info( s, "downloaded chunk %d from stream %s at quality %u",
+                chunk->sequence, sms->name, qlevel->Bitrate );
+
     if( sms->type != VIDEO_ES )
         return VLC_SUCCESS;
 
@@ -482,7 +589,8 @@ static int Download( stream_t *s, sms_stream_t *sms )
     if( chunk->sequence <= 1 )
         return VLC_SUCCESS;
 
-    unsigned new_qlevel_id = BandwidthAdaptation( s, sms, avg_bw );
+    unsigned new_qlevel_id = BandwidthAdaptation( s, sms,
+                                        video_budget( s, sms, avg_bw ) );
     quality_level_t *new_qlevel = get_qlevel( sms, new_qlevel_id );
     if( unlikely( !new_qlevel ) )
     {
@@ -508,10 +616,10 @@ static int Download( stream_t *s, sms_stream_t *sms )
             return VLC_EGENERIC;
         }
 
+        vlc_mutex_lock( &p_sys->download.lock_wait );
         new_init_ck->offset = p_sys->download.next_chunk_offset;
         p_sys->download.next_chunk_offset += new_init_ck->size;
 
-        vlc_mutex_lock( &p_sys->download.lock_wait );
         vlc_array_append( p_sys->download.chunks, new_init_ck );
         vlc_array_append( p_sys->init_chunks, new_init_ck );
         vlc_mutex_unlock( &p_sys->download.lock_wait );
@@ -519,42 +627,113 @@ static int Download( stream_t *s, sms_stream_t *sms )
     return VLC_SUCCESS;
 }
 
-static inline int64_t get_lead( stream_t *s )
+/* Drops the downloaded chunks and restarts every track from the time seek
+ * position. Must be called with download.lock_wait held. */
+static int reset_downloads( stream_t *s )
 {
     stream_sys_t *p_sys = s->p_sys;
-    int64_t lead = 0;
-    int64_t alead = p_sys->download.lead[es_cat_to_index( AUDIO_ES )];
-    int64_t vlead = p_sys->download.lead[es_cat_to_index( VIDEO_ES )];
-    bool video = SMS_GET_SELECTED_ST( VIDEO_ES ) ? true : false;
-    bool audio = SMS_GET_SELECTED_ST( AUDIO_ES ) ? true : false;
-
-    if( video && audio )
-        lead = __MIN( vlead, alead );
-    else if( video )
-        lead = vlead;
-    else
-        lead = alead;
 
-    lead -= p_sys->playback.toffset;
-    return lead;
+    int count = vlc_array_count( p_sys->download.chunks );
+    chunk_t *ck = NULL;
+    for( int i = 0; i < count; i++ )
+    {
+        ck = vlc_array_item_at_index( p_sys->download.chunks, i );
+        if( unlikely( !ck ) )
+            return VLC_EGENERIC;
+        ck->read_pos = 0;
+        if( ck->data == NULL )
+            continue;
+        chunk_Recycle( p_sys, ck );
+    }
+
+    vlc_array_destroy( p_sys->download.chunks );
+    p_sys->download.chunks = vlc_array_new();
+
+    p_sys->playback.toffset = p_sys->time_pos;
+    for( int i = 0; i < 3; i++ )
+    {
+        p_sys->download.lead[i] = p_sys->time_pos;
+        p_sys->download.ck_index[i] = 0;
+    }
+    p_sys->download.next_chunk_offset = 0;
+    p_sys->download.generation++;
+
+    p_sys->playback.boffset = 0;
+    p_sys->playback.index = 0;
+
+    chunk_t *new_init_ck = build_init_chunk( s );
+    if( !new_init_ck )
+        return VLC_EGENERIC;
+
+    new_init_ck->offset = p_sys->download.next_chunk_offset;
+    p_sys->download.next_chunk_offset += new_init_ck->size;
+
+    vlc_array_append( p_sys->download.chunks, new_init_ck );
+    vlc_array_append( p_sys->init_chunks, new_init_ck );
+    p_sys->b_tseek = false;
+    vlc_cond_broadcast( &p_sys->download.wait );
+
+    return VLC_SUCCESS;
+}
+
+static bool track_done( stream_sys_t *p_sys, const sms_stream_t *sms )
+{
+    unsigned ck_index = p_sys->download.ck_index[es_cat_to_index( sms->type )];
+    return !p_sys->b_live && ck_index >= sms->vod_chunks_nb - 1;
 }
 
-static int next_track( stream_t *s )
+/* Each selected track has its own download thread, so that a slow video
+ * fragment does not hold back the audio ones and vice versa. */
+static void* sms_TrackThread( void *p_this )
 {
+    sms_track_t *track = p_this;
+    stream_t *s = track->s;
     stream_sys_t *p_sys = s->p_sys;
-    uint64_t tmp, min = 0;
-    int cat, ret = UNKNOWN_ES;
-    for( int i = 0; i < 3; i++ )
+    sms_stream_t *sms = track->sms;
+    int index = es_cat_to_index( sms->type );
+
+    int canc = vlc_savecancel();
+
+    for( ;; )
     {
-        tmp = p_sys->download.lead[i];
-        cat = index_to_es_cat( i );
-        if( (!min || tmp < min) && SMS_GET_SELECTED_ST( cat ) )
+        vlc_mutex_lock( &p_sys->download.lock_wait );
+        for( ;; )
+        {
+            if( p_sys->b_close || p_sys->b_error )
+            {
+                vlc_mutex_unlock( &p_sys->download.lock_wait );
+                goto end;
+            }
+
+            if( p_sys->b_tseek )
+            {
+                if( reset_downloads( s ) != VLC_SUCCESS )
+                    p_sys->b_error = true;
+                continue;
+            }
+
+            int64_t lead = p_sys->download.lead[index] - p_sys->playback.toffset;
+            if( lead <= (int64_t)p_sys->buffer_time * p_sys->timescale
+                        + p_sys->download.start_time && !track_done( p_sys, sms ) )
+                break;
+
+            vlc_cond_wait( &p_sys->download.wait, &p_sys->download.lock_wait );
+        }
+        vlc_mutex_unlock( &p_sys->download.lock_wait );
+
+        if( Download( s, sms ) != VLC_SUCCESS )
         {
-            min = tmp;
-            ret = cat;
+            vlc_mutex_lock( &p_sys->download.lock_wait );
+            p_sys->b_error = true;
+            vlc_cond_broadcast( &p_sys->download.wait );
+            vlc_mutex_unlock( &p_sys->download.lock_wait );
+            break;
         }
     }
-    return ret;
+
+end:
+    vlc_restorecancel( canc );
+    return NULL;
 }
 
 void* sms_Thread( void *p_this )
@@ -563,6 +742,7 @@ void* sms_Thread( void *p_this )
     stream_sys_t *p_sys = s->p_sys;
     sms_stream_t *sms = NULL;
     chunk_t *chunk;
+    unsigned tracks = 0;
 
     int canc = vlc_savecancel();
 
@@ -579,17 +759,16 @@ void* sms_Thread( void *p_this )
     vlc_mutex_lock( &p_sys->download.lock_wait );
     vlc_array_append( p_sys->download.chunks, init_ck );
     vlc_array_append( p_sys->init_chunks, init_ck );
-    vlc_mutex_unlock( &p_sys->download.lock_wait );
-
     p_sys->download.next_chunk_offset = init_ck->size;
+    vlc_mutex_unlock( &p_sys->download.lock_wait );
 
     /* XXX Sometimes, the video stream is cut into pieces of one exact length,
      * while the audio stream fragments can't be made to match exactly,
      * and for some reason the n^th advertised video fragment is related to
      * the n+1^th advertised audio chunk or vice versa */
 
-    int64_t start_time = 0, lead = 0;
-
+    /* The first chunks are fetched in order, so that the demux finds every
+     * track at the beginning of the stream. */
     for( int i = 0; i < 3; i++ )
     {
         sms = SMS_GET_SELECTED_ST( index_to_es_cat( i ) );
@@ -597,83 +776,42 @@ void* sms_Thread( void *p_this )
         {
             chunk = vlc_array_item_at_index( sms->chunks, 0 );
             p_sys->download.lead[i] = chunk->start_time + p_sys->timescale / 1000;
-            if( !start_time )
-                start_time = chunk->start_time;
+            if( !p_sys->download.start_time )
+                p_sys->download.start_time = chunk->start_time;
 
             if( Download( s, sms ) != VLC_SUCCESS )
                 goto cancel;
         }
     }
 
-    while( 1 )
+    for( int i = 0; i < 3; i++ )
     {
-        /* XXX replace magic number 10 by a value depending on
-         * LookAheadFragmentCount and DVRWindowLength */
-        vlc_mutex_lock( &p_sys->download.lock_wait );
+        sms = SMS_GET_SELECTED_ST( index_to_es_cat( i ) );
+        if( !sms )
+            continue;
 
-        if( p_sys->b_close )
+        sms_track_t *track = &p_sys->download.tracks[tracks];
+        track->s = s;
+        track->sms = sms;
+        if( vlc_clone( &track->thread, sms_TrackThread, track,
+                       VLC_THREAD_PRIORITY_INPUT ) )
         {
+            msg_Err( s, "could not start download thread of stream %s",
+                     sms->name );
+            vlc_mutex_lock( &p_sys->download.lock_wait );
+            p_sys->b_error = true;
+            vlc_cond_broadcast( &p_sys->download.wait );
             vlc_mutex_unlock( &p_sys->download.lock_wait );
             break;
         }
+        tracks++;
+    }
 
-        lead = get_lead( s );
-
-        while( lead > 10 * p_sys->timescale + start_time || NO_MORE_CHUNKS )
-        {
-            vlc_cond_wait( &p_sys->download.wait, &p_sys->download.lock_wait );
-            lead = get_lead( s );
-
-            if( p_sys->b_close )
-                break;
-        }
-
-        if( p_sys->b_tseek )
-        {
-            int count = vlc_array_count( p_sys->download.chunks );
-            chunk_t *ck = NULL;
-            for( int i = 0; i < count; i++ )
-            {
-                ck = vlc_array_item_at_index( p_sys->download.chunks, i );
-                if( unlikely( !ck ) )
-                    goto cancel;
-                ck->read_pos = 0;
-                if( ck->data == NULL )
-                    continue;
-                FREENULL( ck->data );
-            }
-
-            vlc_array_destroy( p_sys->download.chunks );
-            p_sys->download.chunks = vlc_array_new();
-
-            p_sys->playback.toffset = p_sys->time_pos;
-            for( int i = 0; i < 3; i++ )
-            {
-                p_sys->download.lead[i] = p_sys->time_pos;
-                p_sys->download.ck_index[i] = 0;
-            }
-            p_sys->download.next_chunk_offset = 0;
-
-            p_sys->playback.boffset = 0;
-            p_sys->playback.index = 0;
-
-            chunk_t *new_init_ck = build_init_chunk( s );
-            if( !new_init_ck )
-                goto cancel;
-
-            new_init_ck->offset = p_sys->download.next_chunk_offset;
-            p_sys->download.next_chunk_offset += new_init_ck->size;
-
-            vlc_array_append( p_sys->download.chunks, new_init_ck );
-            vlc_array_append( p_sys->init_chunks, new_init_ck );
-            p_sys->b_tseek = false;
-        }
-        vlc_mutex_unlock( &p_sys->download.lock_wait );
+    for( unsigned i = 0; i < tracks; i++ )
+        vlc_join( p_sys->download.tracks[i].thread, NULL );
 
-        sms = SMS_GET_SELECTED_ST( next_track( s ) );
-        if( Download( s, sms ) != VLC_SUCCESS )
-            goto cancel;
-    }
+    vlc_restorecancel( canc );
+    return NULL;
 
 cancel:
     p_sys->b_error = true;
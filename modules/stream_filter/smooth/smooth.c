@@ -55,6 +55,10 @@
 static int  Open( vlc_object_t * );
 static void Close( vlc_object_t * );
 
+#define BUFFER_TEXT N_("Buffer duration (seconds)")
+#define BUFFER_LONGTEXT N_("How far ahead of the playback position the " \
+    "fragments of each track are downloaded.")
+
 vlc_module_begin()
     set_category( CAT_INPUT )
     set_subcategory( SUBCAT_INPUT_STREAM_FILTER )
@@ -63,6 +67,8 @@ vlc_module_begin()
     add_shortcut( "smooth" )
     set_capability( "stream_filter", 30 )
     set_callbacks( Open, Close )
+    add_integer( "smooth-buffer", 10, BUFFER_TEXT, BUFFER_LONGTEXT, true )
+        change_integer_range( 1, 3600 )
 vlc_module_end()
 
 static int   Read( stream_t *, void *, unsigned );
@@ -397,6 +403,10 @@ static int Open( vlc_object_t *p_this )
     *pos = '\0';
     p_sys->base_url = uri;
 
+    /* XXX the buffer duration should depend on
+     * LookAheadFragmentCount and DVRWindowLength */
+    p_sys->buffer_time = var_InheritInteger( s, "smooth-buffer" );
+
     /* XXX I don't know wether or not we should allow caching */
     p_sys->b_cache = false;
 
@@ -481,10 +491,11 @@ static void Close( vlc_object_t *p_this )
     for( int i = 0; i < 3; i++ )
         p_sys->download.lead[i] = 0;
     p_sys->playback.toffset = 0;
-    vlc_cond_signal(&p_sys->download.wait);
+    vlc_cond_broadcast(&p_sys->download.wait);
     vlc_mutex_unlock( &p_sys->download.lock_wait );
 
     vlc_join( p_sys->thread, NULL );
+    chunk_PoolClean( p_sys );
     vlc_mutex_destroy( &p_sys->download.lock_wait );
     vlc_cond_destroy( &p_sys->download.wait );
 
@@ -575,11 +586,13 @@ static int sms_Read( stream_t *s, uint8_t *p_read, int i_read )
                 vlc_mutex_lock( &p_sys->download.lock_wait );
                 p_sys->playback.toffset += chunk->duration;
                 vlc_mutex_unlock( &p_sys->download.lock_wait );
-                vlc_cond_signal( &p_sys->download.wait);
+                vlc_cond_broadcast( &p_sys->download.wait);
             }
             if( !p_sys->b_cache || p_sys->b_live )
             {
-                FREENULL( chunk->data );
+                vlc_mutex_lock( &p_sys->download.lock_wait );
+                chunk_Recycle( p_sys, chunk );
+                vlc_mutex_unlock( &p_sys->download.lock_wait );
                 chunk->read_pos = 0;
             }
 
@@ -721,7 +734,7 @@ static int chunk_Seek( stream_t *s, const uint64_t pos )
             p_sys->download.lead[i] = 0;
         p_sys->playback.toffset = 0;
 
-        vlc_cond_signal( &p_sys->download.wait);
+        vlc_cond_broadcast( &p_sys->download.wait);
         vlc_mutex_unlock( &p_sys->download.lock_wait );
 
         return VLC_SUCCESS;
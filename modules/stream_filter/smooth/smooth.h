@@ -50,6 +50,7 @@ typedef struct chunk_s
     int         type;       /* video, audio, or subtitles */
 
     uint8_t     *data;
+    int         alloc_size; /* allocated size of data */
 } chunk_t;
 
 typedef struct quality_level_s
@@ -85,6 +86,15 @@ typedef struct sms_stream_s
 
 } sms_stream_t;
 
+#define SMS_POOL_SIZE 8 /* number of recycled chunk buffers */
+
+typedef struct sms_track_s
+{
+    stream_t       *s;
+    sms_stream_t   *sms;
+    vlc_thread_t   thread;        /* download thread of this track */
+} sms_track_t;
+
 struct stream_sys_t
 {
     char         *base_url;    /* URL common part for chunks */
@@ -98,6 +108,7 @@ struct stream_sys_t
     uint64_t     vod_duration; /* total duration of the VOD media */
     int64_t      time_pos;
     unsigned     timescale;
+    unsigned     buffer_time;  /* how far ahead to download, in seconds */
 
     /* Download */
     struct sms_download_s
@@ -111,6 +122,15 @@ struct stream_sys_t
         vlc_array_t  *chunks;     /* chunks that have been downloaded */
         vlc_mutex_t  lock_wait;   /* protect chunk download counter. */
         vlc_cond_t   wait;        /* some condition to wait on */
+
+        sms_track_t  tracks[3];   /* one download thread per selected track */
+        unsigned     generation;  /* bumped when time seeking drops downloads */
+        unsigned     active;      /* number of downloads in progress */
+        int64_t      start_time;  /* start time of the first chunk */
+
+        uint8_t      *pool[SMS_POOL_SIZE]; /* buffers of consumed chunks */
+        int          pool_size[SMS_POOL_SIZE];
+        unsigned     pool_count;
     } download;
 
     /* Playback */
@@ -176,6 +196,8 @@ quality_level_t * ql_New( void );
 void ql_Free( quality_level_t *);
 chunk_t *chunk_New( sms_stream_t* , uint64_t , uint64_t );
 void chunk_Free( chunk_t *);
+void chunk_Recycle( stream_sys_t *, chunk_t * );
+void chunk_PoolClean( stream_sys_t * );
 sms_stream_t * sms_New( void );
 void sms_Free( sms_stream_t *);
 uint8_t *decode_string_hex_to_binary( const char * );
@@ -177,6 +177,11 @@ static int Send( sout_stream_t *p_stream, sout_stream_id_t *id,
 
         if( id != NULL && p_buffer->i_buffer > 0 )
         {
+            /* Decoders may modify their input in place */
+            p_buffer = block_Unshare( p_buffer );
+            if( p_buffer == NULL )
+                break;
+
             if( p_buffer->i_dts <= VLC_TS_INVALID )
                 p_buffer->i_dts = 0;
             else
@@ -576,6 +576,12 @@ static int Send( sout_stream_t *p_stream, sout_stream_id_t *id,
                 continue;
             }
         }
+        else if( p_sys->p_vf2 == NULL )
+        {
+            /* The decoded picture is only read from now on: no need to
+             * copy it, the mosaic holds a reference until it is done. */
+            p_new_pic = picture_Hold( p_pic );
+        }
         else
         {
             /* TODO: chroma conversion if needed */
@@ -145,6 +145,11 @@
 #define PROTO_LONGTEXT N_( \
     "This selects which transport protocol to use for RTP." )
 
+#define THREADS_TEXT N_("Sender threads")
+#define THREADS_LONGTEXT N_( \
+    "Number of threads sending the RTP packets of all streams and " \
+    "sessions. 0 selects a value based on the number of CPUs." )
+
 #define SRTP_KEY_TEXT N_("SRTP key (hexadecimal)")
 #define SRTP_KEY_LONGTEXT N_( \
     "RTP packets will be integrity-protected and ciphered "\
@@ -174,6 +179,12 @@ static const char *const ppsz_protocols[] = {
     "negative value or zero disables timeouts. The default is 60 (one " \
     "minute)." )
 
+#define RTSP_SHARE_TEXT N_( "Shared playback window (ms)" )
+#define RTSP_SHARE_LONGTEXT N_( "VoD sessions starting to play a " \
+    "media from the beginning within this delay from each other share " \
+    "the same input and RTP packetization. Sessions leave the shared " \
+    "playback when they pause or seek. 0 disables sharing." )
+
 #define RTSP_USER_TEXT N_("Username")
 #define RTSP_USER_LONGTEXT N_("User name that will be " \
                               "requested to access the stream." )
@@ -232,6 +243,9 @@ vlc_module_begin ()
               RTCP_MUX_TEXT, RTCP_MUX_LONGTEXT, false )
     add_integer( SOUT_CFG_PREFIX "caching", DEFAULT_PTS_DELAY / 1000,
                  CACHING_TEXT, CACHING_LONGTEXT, true )
+    add_integer( SOUT_CFG_PREFIX "threads", 0,
+                 THREADS_TEXT, THREADS_LONGTEXT, true )
+        change_integer_range( 0, 16 )
 
 #ifdef HAVE_SRTP
     add_string( SOUT_CFG_PREFIX "key", "",
@@ -255,6 +269,9 @@ vlc_module_begin ()
     add_shortcut( "rtsp" )
     add_integer( "rtsp-timeout", 60, RTSP_TIMEOUT_TEXT,
                  RTSP_TIMEOUT_LONGTEXT, true )
+    add_integer( "rtsp-share-window", 0, RTSP_SHARE_TEXT,
+                 RTSP_SHARE_LONGTEXT, true )
+        change_integer_range( 0, 60000 )
     add_string( "sout-rtsp-user", "",
                 RTSP_USER_TEXT, RTSP_USER_LONGTEXT, true )
     add_password( "sout-rtsp-pwd", "",
@@ -285,7 +302,7 @@ static int               MuxSend( sout_stream_t *, sout_stream_id_t *,
                                   block_t* );
 
 static sout_access_out_t *GrabberCreate( sout_stream_t *p_sout );
-static void* ThreadSend( void * );
+static void  SendChain( void *, block_t * );
 static void *rtp_listen_thread( void * );
 
 static void SDPHandleUrl( sout_stream_t *, const char * );
@@ -351,6 +368,7 @@ typedef struct rtp_sink_t
 {
     int rtp_fd;
     rtcp_sender_t *rtcp;
+    bool dgram; /* datagram socket */
 } rtp_sink_t;
 
 struct sout_stream_id_t
@@ -377,7 +395,6 @@ struct sout_stream_id_t
 #endif
 
     /* Packets sinks */
-    vlc_thread_t      thread;
     vlc_mutex_t       lock_sink;
     int               sinkc;
     rtp_sink_t       *sinkv;
@@ -387,7 +404,7 @@ struct sout_stream_id_t
         vlc_thread_t  thread;
     } listen;
 
-    block_fifo_t     *p_fifo;
+    rtp_queue_t      *queue;
     int64_t           i_caching;
 };
 
@@ -980,7 +997,7 @@ static sout_stream_id_t *Add( sout_stream_t *p_stream, es_format_t *p_fmt )
     id->sinkc = 0;
     id->sinkv = NULL;
     id->rtsp_id = NULL;
-    id->p_fifo = NULL;
+    id->queue = NULL;
     id->listen.fd = NULL;
 
     id->b_first_packet = true;
@@ -1181,15 +1198,9 @@ static sout_stream_id_t *Add( sout_stream_t *p_stream, es_format_t *p_fmt )
         id->rtsp_id = RtspAddId( p_sys->rtsp, id, GetDWBE( id->ssrc ),
                                  id->rtp_fmt.clock_rate, mcast_fd );
 
-    id->p_fifo = block_FifoNew();
-    if( unlikely(id->p_fifo == NULL) )
-        goto error;
-    if( vlc_clone( &id->thread, ThreadSend, id, VLC_THREAD_PRIORITY_HIGHEST ) )
-    {
-        block_FifoRelease( id->p_fifo );
-        id->p_fifo = NULL;
+    id->queue = rtp_queue_New( VLC_OBJECT(p_stream), SendChain, id );
+    if( unlikely(id->queue == NULL) )
         goto error;
-    }
 
     /* Update p_sys context */
     vlc_mutex_lock( &p_sys->lock_es );
@@ -1224,11 +1235,17 @@ static int Del( sout_stream_t *p_stream, sout_stream_id_t *id )
     TAB_REMOVE( p_sys->i_es, p_sys->es, id );
     vlc_mutex_unlock( &p_sys->lock_es );
 
-    if( likely(id->p_fifo != NULL) )
+    if( likely(id->queue != NULL) )
     {
-        vlc_cancel( id->thread );
-        vlc_join( id->thread, NULL );
-        block_FifoRelease( id->p_fifo );
+        rtp_queue_stats_t stats;
+
+        rtp_queue_Delete( id->queue, &stats );
+        if( stats.i_packets > 0 )
+            msg_Dbg( p_stream, "sent %u packets in %u batches, %u late, "
+                     "lateness avg %"PRId64" us max %"PRId64" us",
+                     stats.i_packets, stats.i_batches, stats.i_late,
+                     stats.i_lateness / stats.i_packets,
+                     stats.i_lateness_max );
     }
 
     free( id->rtp_fmt.fmtp );
@@ -1394,7 +1411,49 @@ static int  HttpCallback( httpd_file_sys_t *p_args,
 /****************************************************************************
  * RTP send
  ****************************************************************************/
-static void* ThreadSend( void *data )
+#ifdef HAVE_SENDMMSG
+# define RTP_BATCH 64
+
+/* Sends a chain of packets on a datagram socket, up to RTP_BATCH packets
+ * per system call. As with send(), a packet that fails is dropped. */
+static void SendBatch( int fd, const block_t *chain )
+{
+    struct mmsghdr msgv[RTP_BATCH];
+    struct iovec iov[RTP_BATCH];
+
+    while( chain != NULL )
+    {
+        unsigned n = 0;
+
+        for( const block_t *out = chain; out != NULL && n < RTP_BATCH;
+             out = out->p_next )
+        {
+            iov[n].iov_base = out->p_buffer;
+            iov[n].iov_len = out->i_buffer;
+            memset( &msgv[n], 0, sizeof (msgv[n]) );
+            msgv[n].msg_hdr.msg_iov = &iov[n];
+            msgv[n].msg_hdr.msg_iovlen = 1;
+            n++;
+        }
+
+        int val = sendmmsg( fd, msgv, n, 0 );
+        if( val <= 0 )
+        {
+            if( net_errno != EAGAIN && net_errno != EWOULDBLOCK
+             && net_errno != ENOBUFS && net_errno != ENOMEM )
+                /* ICMP soft error: ignore and retry */
+                send( fd, chain->p_buffer, chain->i_buffer, 0 );
+            val = 1;
+        }
+        while( val-- > 0 )
+            chain = chain->p_next;
+    }
+}
+#endif
+
+/* Sends a chain of due packets to all sinks, one sink at a time.
+ * Called from the shared sender pool, see rtpsend.c */
+static void SendChain( void *data, block_t *chain )
 {
 #ifdef WIN32
 # define ENOBUFS      WSAENOBUFS
@@ -1402,84 +1461,57 @@ static void* ThreadSend( void *data )
 # define EWOULDBLOCK  WSAEWOULDBLOCK
 #endif
     sout_stream_id_t *id = data;
-    unsigned i_caching = id->i_caching;
 
-    for (;;)
-    {
-        block_t *out = block_FifoGet( id->p_fifo );
-        block_cleanup_push (out);
+    vlc_mutex_lock( &id->lock_sink );
+    unsigned deadc = 0; /* How many dead sockets? */
+    int deadv[id->sinkc]; /* Dead sockets list */
 
+    for( int i = 0; i < id->sinkc; i++ )
+    {
 #ifdef HAVE_SRTP
-        if( id->srtp )
-        {   /* FIXME: this is awfully inefficient */
-            size_t len = out->i_buffer;
-            out = block_Realloc( out, 0, len + 10 );
-            out->i_buffer = len;
-
-            int canc = vlc_savecancel ();
-            int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
-            vlc_restorecancel (canc);
-            if( val )
-            {
-                errno = val;
-                msg_Dbg( id->p_stream, "SRTP sending error: %m" );
-                block_Release( out );
-                out = NULL;
-            }
-            else
-                out->i_buffer = len;
-        }
-        if (out)
-            mwait (out->i_dts + i_caching);
-        vlc_cleanup_pop ();
-        if (out == NULL)
-            continue;
-#else
-        mwait (out->i_dts + i_caching);
-        vlc_cleanup_pop ();
+        if( !id->srtp ) /* FIXME: SRTCP support */
 #endif
+            for( block_t *out = chain; out != NULL; out = out->p_next )
+                SendRTCP( id->sinkv[i].rtcp, out );
 
-        ssize_t len = out->i_buffer;
-        int canc = vlc_savecancel ();
-
-        vlc_mutex_lock( &id->lock_sink );
-        unsigned deadc = 0; /* How many dead sockets? */
-        int deadv[id->sinkc]; /* Dead sockets list */
-
-        for( int i = 0; i < id->sinkc; i++ )
+#ifdef HAVE_SENDMMSG
+        if( id->sinkv[i].dgram )
         {
-#ifdef HAVE_SRTP
-            if( !id->srtp ) /* FIXME: SRTCP support */
+            SendBatch( id->sinkv[i].rtp_fd, chain );
+            continue;
+        }
 #endif
-                SendRTCP( id->sinkv[i].rtcp, out );
-
-            if( send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 ) == -1
+        for( block_t *out = chain; out != NULL; out = out->p_next )
+        {
+            if( send( id->sinkv[i].rtp_fd, out->p_buffer, out->i_buffer, 0 ) == -1
              && net_errno != EAGAIN && net_errno != EWOULDBLOCK
              && net_errno != ENOBUFS && net_errno != ENOMEM )
             {
-                int type;
-                getsockopt( id->sinkv[i].rtp_fd, SOL_SOCKET, SO_TYPE,
-                            &type, &(socklen_t){ sizeof(type) });
-                if( type == SOCK_DGRAM )
+                if( id->sinkv[i].dgram )
                     /* ICMP soft error: ignore and retry */
-                    send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 );
+                    send( id->sinkv[i].rtp_fd, out->p_buffer, out->i_buffer, 0 );
                 else
+                {
                     /* Broken connection */
                     deadv[deadc++] = id->sinkv[i].rtp_fd;
+                    break;
+                }
             }
         }
-        id->i_seq_sent_next = ntohs(((uint16_t *) out->p_buffer)[1]) + 1;
-        vlc_mutex_unlock( &id->lock_sink );
-        block_Release( out );
+    }
 
-        for( unsigned i = 0; i < deadc; i++ )
-        {
-            msg_Dbg( id->p_stream, "removing socket %d", deadv[i] );
-            rtp_del_sink( id, deadv[i] );
-        }
-        vlc_restorecancel (canc);
+    block_t *last = chain;
+    while( last->p_next != NULL )
+        last = last->p_next;
+    id->i_seq_sent_next = ntohs(((uint16_t *) last->p_buffer)[1]) + 1;
+    vlc_mutex_unlock( &id->lock_sink );
+    block_ChainRelease( chain );
+
+    for( unsigned i = 0; i < deadc; i++ )
+    {
+        msg_Dbg( id->p_stream, "removing socket %d", deadv[i] );
+        rtp_del_sink( id, deadv[i] );
     }
-    return NULL;
 }
 
 
@@ -1506,7 +1538,12 @@ static void *rtp_listen_thread( void *data )
 
 int rtp_add_sink( sout_stream_id_t *id, int fd, bool rtcp_mux, uint16_t *seq )
 {
-    rtp_sink_t sink = { fd, NULL };
+    rtp_sink_t sink = { fd, NULL, false };
+    int type;
+
+    if( getsockopt( fd, SOL_SOCKET, SO_TYPE, &type,
+                    &(socklen_t){ sizeof(type) } ) == 0 )
+        sink.dgram = type == SOCK_DGRAM;
     sink.rtcp = OpenRTCP( VLC_OBJECT( id->p_stream ), fd, IPPROTO_UDP,
                           rtcp_mux );
     if( sink.rtcp == NULL )
@@ -1522,7 +1559,7 @@ int rtp_add_sink( sout_stream_id_t *id, int fd, bool rtcp_mux, uint16_t *seq )
 
 void rtp_del_sink( sout_stream_id_t *id, int fd )
 {
-    rtp_sink_t sink = { fd, NULL };
+    rtp_sink_t sink = { fd, NULL, false };
 
     /* NOTE: must be safe to use if fd is not included */
     vlc_mutex_lock( &id->lock_sink );
@@ -1657,7 +1694,27 @@ void rtp_packetize_common( sout_stream_id_t *id, block_t *out,
 
 void rtp_packetize_send( sout_stream_id_t *id, block_t *out )
 {
-    block_FifoPut( id->p_fifo, out );
+#ifdef HAVE_SRTP
+    if( id->srtp )
+    {   /* FIXME: this is awfully inefficient */
+        size_t len = out->i_buffer;
+        out = block_Realloc( out, 0, len + 10 );
+        if( unlikely(out == NULL) )
+            return;
+        out->i_buffer = len;
+
+        int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
+        if( val )
+        {
+            errno = val;
+            msg_Dbg( id->p_stream, "SRTP sending error: %m" );
+            block_Release( out );
+            return;
+        }
+        out->i_buffer = len;
+    }
+#endif
+    rtp_queue_Put( id->queue, out, out->i_dts + id->i_caching );
 }
 
 /**
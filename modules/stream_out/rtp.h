@@ -62,6 +62,22 @@ size_t rtp_mtu (const sout_stream_id_t *id);
 int rtp_packetize_xiph_config( sout_stream_id_t *id, const char *fmtp,
                                int64_t i_pts );
 
+/* RTP sender pool */
+typedef struct rtp_queue_t rtp_queue_t;
+typedef struct rtp_queue_stats_t
+{
+    unsigned i_packets;      /* packets sent */
+    unsigned i_batches;      /* calls to the send callback */
+    unsigned i_late;         /* packets sent more than one tick late */
+    mtime_t  i_lateness;     /* total lateness (µs) */
+    mtime_t  i_lateness_max; /* worst lateness (µs) */
+} rtp_queue_stats_t;
+
+rtp_queue_t *rtp_queue_New (vlc_object_t *obj,
+                            void (*send) (void *, block_t *), void *opaque);
+void rtp_queue_Put (rtp_queue_t *queue, block_t *block, mtime_t deadline);
+void rtp_queue_Delete (rtp_queue_t *queue, rtp_queue_stats_t *stats);
+
 /* RTCP */
 typedef struct rtcp_sender_t rtcp_sender_t;
 rtcp_sender_t *OpenRTCP (vlc_object_t *obj, int rtp_fd, int proto,
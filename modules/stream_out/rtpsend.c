@@ -0,0 +1,405 @@
+/*****************************************************************************
+ * rtpsend.c: shared RTP sender thread pool
+ *****************************************************************************
+ * Copyright © 2013 VLC authors and VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_sout.h>
+#include "rtp.h"
+
+#include <assert.h>
+
+/*
+ * NOTE on the sender pool:
+ * - all RTP queues of the process share a small set of sender threads,
+ *   instead of one thread per elementary stream and session,
+ * - each queue has a single timer, armed at the deadline of its oldest
+ *   packet; timers are kept in a hashed timing wheel with one millisecond
+ *   ticks, so arming and expiring are O(1),
+ * - when a timer expires, every packet of the queue due within the tick is
+ *   handed over to the send callback at once, so that the callback can
+ *   batch them per socket,
+ * - a queue is never serviced by two threads at the same time, which keeps
+ *   packets in order.
+ */
+#define RTP_WHEEL_TICK  1000 /* µs */
+#define RTP_WHEEL_SIZE  1024 /* slots, must be a power of two */
+#define RTP_WHEEL_MASK  (RTP_WHEEL_SIZE - 1)
+#define RTP_BATCH_MAX   64   /* packets per send callback */
+
+typedef struct rtp_sender_t rtp_sender_t;
+
+struct rtp_queue_t
+{
+    rtp_sender_t *sender;
+    void        (*send) (void *, block_t *);
+    void         *opaque;
+
+    /* Protected by sender->lock */
+    block_t      *first;
+    block_t     **lastp;
+    rtp_queue_t  *next;  /* next timer in the same wheel slot */
+    mtime_t       tick;  /* wheel tick of the armed timer */
+    bool          armed;
+    bool          busy;  /* the send callback is running */
+    rtp_queue_stats_t stats;
+};
+
+struct rtp_sender_t
+{
+    vlc_mutex_t   lock;
+    vlc_cond_t    wait; /* a timer was armed */
+    vlc_cond_t    idle; /* a send callback returned */
+    unsigned      refs;
+
+    rtp_queue_t  *wheel[RTP_WHEEL_SIZE];
+    unsigned      armed;  /* number of armed timers */
+    mtime_t       tick;   /* first wheel tick not yet expired */
+    mtime_t       wakeup; /* deadline of the last sleeping thread */
+
+    unsigned      threadc;
+    vlc_thread_t  threadv[];
+};
+
+static vlc_mutex_t sender_lock = VLC_STATIC_MUTEX;
+static rtp_sender_t *sender = NULL;
+
+/* Must be called with the sender lock held */
+static void rtp_sender_Arm (rtp_sender_t *s, rtp_queue_t *q)
+{
+    mtime_t deadline = q->first->i_dts;
+    mtime_t tick = deadline / RTP_WHEEL_TICK;
+
+    assert (!q->armed && !q->busy);
+    if (tick < s->tick)
+        tick = s->tick; /* already late */
+
+    rtp_queue_t **pp = &s->wheel[tick & RTP_WHEEL_MASK];
+    q->tick = tick;
+    q->next = *pp;
+    *pp = q;
+    q->armed = true;
+    s->armed++;
+
+    if (deadline < s->wakeup)
+        vlc_cond_signal (&s->wait);
+}
+
+/* Must be called with the sender lock held */
+static void rtp_sender_Disarm (rtp_sender_t *s, rtp_queue_t *q)
+{
+    rtp_queue_t **pp = &s->wheel[q->tick & RTP_WHEEL_MASK];
+
+    while (*pp != q)
+        pp = &(*pp)->next;
+    *pp = q->next;
+    q->armed = false;
+    s->armed--;
+}
+
+/**
+ * Expires the next timer due at the given time.
+ * @return the queue of the expired timer, or NULL if no timers are due.
+ */
+static rtp_queue_t *rtp_sender_Expire (rtp_sender_t *s, mtime_t now)
+{
+    mtime_t tick = now / RTP_WHEEL_TICK;
+
+    if (s->armed == 0)
+    {
+        s->tick = tick + 1;
+        return NULL;
+    }
+
+    for (unsigned n = 0; s->tick <= tick; n++)
+    {
+        if (n >= RTP_WHEEL_SIZE)
+        {   /* The whole wheel was scanned */
+            s->tick = tick + 1;
+            break;
+        }
+
+        for (rtp_queue_t *q = s->wheel[s->tick & RTP_WHEEL_MASK];
+             q != NULL; q = q->next)
+            if (q->tick <= tick)
+            {
+                rtp_sender_Disarm (s, q);
+                return q;
+            }
+        s->tick++;
+    }
+    return NULL;
+}
+
+/**
+ * @return the time when the next timer is due, or INT64_MAX if none.
+ */
+static mtime_t rtp_sender_Next (const rtp_sender_t *s)
+{
+    mtime_t far = INT64_MAX;
+
+    if (s->armed == 0)
+        return INT64_MAX;
+
+    for (unsigned n = 0; n < RTP_WHEEL_SIZE; n++)
+    {
+        mtime_t next = INT64_MAX;
+
+        for (const rtp_queue_t *q = s->wheel[(s->tick + n) & RTP_WHEEL_MASK];
+             q != NULL; q = q->next)
+        {
+            /* Late timers expire at the beginning of the current tick */
+            mtime_t due = __MAX (q->first->i_dts, q->tick * RTP_WHEEL_TICK);
+
+            if (q->tick == s->tick + n)
+                next = __MIN (next, due);
+            else
+                far = __MIN (far, due);
+        }
+        if (next != INT64_MAX)
+            return next;
+    }
+    return far;
+}
+
+static void *rtp_sender_Thread (void *data)
+{
+    rtp_sender_t *s = data;
+
+    vlc_mutex_lock (&s->lock);
+    mutex_cleanup_push (&s->lock);
+    for (;;)
+    {
+        mtime_t now = mdate ();
+        rtp_queue_t *q = rtp_sender_Expire (s, now);
+
+        if (q == NULL)
+        {
+            s->wakeup = rtp_sender_Next (s);
+            if (s->wakeup == INT64_MAX)
+                vlc_cond_wait (&s->wait, &s->lock);
+            else
+                vlc_cond_timedwait (&s->wait, &s->lock, s->wakeup);
+            continue;
+        }
+
+        /* Dequeue the packets due within this tick */
+        mtime_t limit = (now / RTP_WHEEL_TICK + 1) * RTP_WHEEL_TICK;
+        block_t *chain = q->first, **pp = &chain;
+        unsigned count = 0;
+
+        while (*pp != NULL && (*pp)->i_dts < limit && count < RTP_BATCH_MAX)
+        {
+            mtime_t late = now - (*pp)->i_dts;
+
+            if (late > RTP_WHEEL_TICK)
+                q->stats.i_late++;
+            if (late > 0)
+            {
+                q->stats.i_lateness += late;
+                if (late > q->stats.i_lateness_max)
+                    q->stats.i_lateness_max = late;
+            }
+            pp = &(*pp)->p_next;
+            count++;
+        }
+
+        q->first = *pp;
+        if (q->first == NULL)
+            q->lastp = &q->first;
+        *pp = NULL;
+        q->stats.i_packets += count;
+        q->stats.i_batches++;
+        q->busy = true;
+        vlc_mutex_unlock (&s->lock);
+
+        int canc = vlc_savecancel ();
+        q->send (q->opaque, chain);
+        vlc_restorecancel (canc);
+
+        vlc_mutex_lock (&s->lock);
+        q->busy = false;
+        if (q->first != NULL)
+            rtp_sender_Arm (s, q);
+        vlc_cond_broadcast (&s->idle);
+    }
+    vlc_cleanup_pop ();
+    assert (0);
+}
+
+static rtp_sender_t *rtp_sender_Hold (vlc_object_t *obj)
+{
+    rtp_sender_t *s;
+
+    vlc_mutex_lock (&sender_lock);
+    s = sender;
+    if (s != NULL)
+    {
+        s->refs++;
+        goto out;
+    }
+
+    unsigned n = var_InheritInteger (obj, "sout-rtp-threads");
+    if (n == 0)
+        n = __MIN (vlc_GetCPUCount (), 4);
+    if (n == 0)
+        n = 1;
+
+    s = malloc (sizeof (*s) + n * sizeof (s->threadv[0]));
+    if (unlikely(s == NULL))
+        goto out;
+
+    vlc_mutex_init (&s->lock);
+    vlc_cond_init (&s->wait);
+    vlc_cond_init (&s->idle);
+    s->refs = 1;
+    for (unsigned i = 0; i < RTP_WHEEL_SIZE; i++)
+        s->wheel[i] = NULL;
+    s->armed = 0;
+    s->tick = mdate () / RTP_WHEEL_TICK;
+    s->wakeup = INT64_MAX;
+
+    for (s->threadc = 0; s->threadc < n; s->threadc++)
+        if (vlc_clone (s->threadv + s->threadc, rtp_sender_Thread, s,
+                       VLC_THREAD_PRIORITY_HIGHEST))
+            break;
+
+    if (s->threadc == 0)
+    {
+        vlc_cond_destroy (&s->idle);
+        vlc_cond_destroy (&s->wait);
+        vlc_mutex_destroy (&s->lock);
+        free (s);
+        s = NULL;
+        goto out;
+    }
+
+    msg_Dbg (obj, "RTP sender pool using %u thread(s)", s->threadc);
+    sender = s;
+out:
+    vlc_mutex_unlock (&sender_lock);
+    return s;
+}
+
+static void rtp_sender_Release (rtp_sender_t *s)
+{
+    vlc_mutex_lock (&sender_lock);
+    assert (s == sender);
+    if (--s->refs > 0)
+    {
+        vlc_mutex_unlock (&sender_lock);
+        return;
+    }
+    sender = NULL;
+    vlc_mutex_unlock (&sender_lock);
+
+    assert (s->armed == 0);
+    for (unsigned i = 0; i < s->threadc; i++)
+        vlc_cancel (s->threadv[i]);
+    for (unsigned i = 0; i < s->threadc; i++)
+        vlc_join (s->threadv[i], NULL);
+
+    vlc_cond_destroy (&s->idle);
+    vlc_cond_destroy (&s->wait);
+    vlc_mutex_destroy (&s->lock);
+    free (s);
+}
+
+/**
+ * Creates a packet queue serviced by the shared sender pool.
+ * @param send callback invoked with a chain of due packets; the callback
+ *             takes ownership of the chain.
+ */
+rtp_queue_t *rtp_queue_New (vlc_object_t *obj,
+                            void (*send) (void *, block_t *), void *opaque)
+{
+    rtp_queue_t *q = malloc (sizeof (*q));
+    if (unlikely(q == NULL))
+        return NULL;
+
+    q->sender = rtp_sender_Hold (obj);
+    if (q->sender == NULL)
+    {
+        free (q);
+        return NULL;
+    }
+
+    q->send = send;
+    q->opaque = opaque;
+    q->first = NULL;
+    q->lastp = &q->first;
+    q->armed = false;
+    q->busy = false;
+    memset (&q->stats, 0, sizeof (q->stats));
+    return q;
+}
+
+/**
+ * Queues one packet for sending at the given (absolute) deadline.
+ * Packets of a queue are sent in order.
+ */
+void rtp_queue_Put (rtp_queue_t *q, block_t *block, mtime_t deadline)
+{
+    rtp_sender_t *s = q->sender;
+
+    block->i_dts = deadline;
+    block->p_next = NULL;
+
+    vlc_mutex_lock (&s->lock);
+    *q->lastp = block;
+    q->lastp = &block->p_next;
+    if (!q->armed && !q->busy)
+        rtp_sender_Arm (s, q);
+    vlc_mutex_unlock (&s->lock);
+}
+
+/**
+ * Destroys a queue, dropping the packets not yet sent. When this function
+ * returns, the send callback is not running and will not be invoked anymore.
+ * @param stats where to store the queue statistics [OUT] (can be NULL)
+ */
+void rtp_queue_Delete (rtp_queue_t *q, rtp_queue_stats_t *stats)
+{
+    rtp_sender_t *s = q->sender;
+
+    vlc_mutex_lock (&s->lock);
+    for (;;)
+    {   /* The timer may be re-armed by a busy thread */
+        if (q->armed)
+            rtp_sender_Disarm (s, q);
+        if (!q->busy)
+            break;
+        vlc_cond_wait (&s->idle, &s->lock);
+    }
+    vlc_mutex_unlock (&s->lock);
+
+    block_ChainRelease (q->first);
+    if (stats != NULL)
+        *stats = q->stats;
+    rtp_sender_Release (s);
+    free (q);
+}
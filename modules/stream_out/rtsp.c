@@ -71,6 +71,8 @@ struct rtsp_stream_t
 
     int             timeout;
     vlc_timer_t     timer;
+
+    mtime_t         share_window; /* VoD only */
 };
 
 
@@ -81,6 +83,8 @@ static int  RtspCallbackId( httpd_callback_sys_t *p_args,
                             httpd_client_t *cl, httpd_message_t *answer,
                             const httpd_message_t *query );
 static void RtspClientDel( rtsp_stream_t *rtsp, rtsp_session_t *session );
+static void RtspClientDelAll( rtsp_stream_t *rtsp );
+static int64_t RtspGroupLeave( rtsp_stream_t *rtsp, rtsp_session_t *ses );
 
 static void RtspTimeOut( void *data );
 
@@ -106,6 +110,10 @@ rtsp_stream_t *RtspSetup( vlc_object_t *owner, vod_media_t *media,
     vlc_mutex_init( &rtsp->lock );
 
     rtsp->timeout = var_InheritInteger(owner, "rtsp-timeout");
+    rtsp->share_window = 0;
+    if (media != NULL)
+        rtsp->share_window = var_InheritInteger(owner, "rtsp-share-window")
+                             * (CLOCK_FREQ / 1000);
     if (rtsp->timeout > 0)
     {
         if (vlc_timer_create(&rtsp->timer, RtspTimeOut, rtsp))
@@ -154,8 +162,7 @@ void RtspUnsetup( rtsp_stream_t *rtsp )
     if( rtsp->host )
         httpd_HostDelete( rtsp->host );
 
-    while( rtsp->sessionc > 0 )
-        RtspClientDel( rtsp, rtsp->sessionv[0] );
+    RtspClientDelAll( rtsp );
 
     if (rtsp->timeout > 0)
         vlc_timer_destroy(rtsp->timer);
@@ -191,6 +198,15 @@ struct rtsp_session_t
     /* output (id-access) */
     int            trackc;
     rtsp_strack_t *trackv;
+
+    /* VoD shared instances: sessions starting from the beginning of the
+     * media at about the same time are attached to a hidden session, which
+     * owns the instance and whose RTP ids have a sink per member track. */
+    rtsp_session_t *group;   /* shared instance of a member session */
+    bool           shared;   /* hidden session owning a shared instance */
+    unsigned       members;  /* shared instance: number of member sessions */
+    mtime_t        start;    /* shared instance: creation date */
+    int64_t        resume;   /* NPT to resume at after leaving a group */
 };
 
 
@@ -315,6 +331,8 @@ static void RtspUpdateTimer( rtsp_stream_t *rtsp )
     mtime_t timeout = 0;
     for (int i = 0; i < rtsp->sessionc; i++)
     {
+        if (rtsp->sessionv[i]->shared)
+            continue;
         if (timeout == 0 || rtsp->sessionv[i]->last_seen < timeout)
             timeout = rtsp->sessionv[i]->last_seen;
     }
@@ -330,19 +348,24 @@ static void RtspTimeOut( void *data )
 
     vlc_mutex_lock(&rtsp->lock);
     mtime_t now = mdate();
-    for (int i = rtsp->sessionc - 1; i >= 0; i--)
+    /* Deleting the last member of a group also deletes the group, which
+     * moves the other sessions in the table: scan again from the top */
+    for (int i = 0; i < rtsp->sessionc; i++)
     {
-        if (rtsp->sessionv[i]->last_seen + rtsp->timeout * CLOCK_FREQ < now)
+        rtsp_session_t *ses = rtsp->sessionv[i];
+        if (ses->shared
+         || ses->last_seen + rtsp->timeout * CLOCK_FREQ >= now)
+            continue;
+
+        if (rtsp->vod_media != NULL)
         {
-            if (rtsp->vod_media != NULL)
-            {
-                char psz_sesbuf[17];
-                snprintf( psz_sesbuf, sizeof( psz_sesbuf ), "%"PRIx64,
-                          rtsp->sessionv[i]->id );
-                vod_stop(rtsp->vod_media, psz_sesbuf);
-            }
-            RtspClientDel(rtsp, rtsp->sessionv[i]);
+            char psz_sesbuf[17];
+            snprintf( psz_sesbuf, sizeof( psz_sesbuf ), "%"PRIx64,
+                      ses->id );
+            vod_stop(rtsp->vod_media, psz_sesbuf);
         }
+        RtspClientDel(rtsp, ses);
+        i = -1;
     }
     RtspUpdateTimer(rtsp);
     vlc_mutex_unlock(&rtsp->lock);
@@ -361,6 +384,11 @@ rtsp_session_t *RtspClientNew( rtsp_stream_t *rtsp )
     vlc_rand_bytes (&s->id, sizeof (s->id));
     s->trackc = 0;
     s->trackv = NULL;
+    s->group = NULL;
+    s->shared = false;
+    s->members = 0;
+    s->start = 0;
+    s->resume = -1;
 
     TAB_APPEND( rtsp->sessionc, rtsp->sessionv, s );
 
@@ -370,7 +398,7 @@ rtsp_session_t *RtspClientNew( rtsp_stream_t *rtsp )
 
 /** rtsp must be locked */
 static
-rtsp_session_t *RtspClientGet( rtsp_stream_t *rtsp, const char *name )
+rtsp_session_t *RtspSessionGet( rtsp_stream_t *rtsp, const char *name )
 {
     char *end;
     uint64_t id;
@@ -394,11 +422,25 @@ rtsp_session_t *RtspClientGet( rtsp_stream_t *rtsp, const char *name )
 }
 
 
+/** rtsp must be locked
+ * Same as RtspSessionGet(), but hides the shared instances from clients */
+static
+rtsp_session_t *RtspClientGet( rtsp_stream_t *rtsp, const char *name )
+{
+    rtsp_session_t *s = RtspSessionGet( rtsp, name );
+
+    return (s != NULL && !s->shared) ? s : NULL;
+}
+
+
 /** rtsp must be locked */
 static
 void RtspClientDel( rtsp_stream_t *rtsp, rtsp_session_t *session )
 {
     int i;
+
+    if( session->group != NULL )
+        RtspGroupLeave( rtsp, session );
     TAB_REMOVE( rtsp->sessionc, rtsp->sessionv, session );
 
     for( i = 0; i < session->trackc; i++ )
@@ -409,6 +451,16 @@ void RtspClientDel( rtsp_stream_t *rtsp, rtsp_session_t *session )
 }
 
 
+static void RtspClientDelAll( rtsp_stream_t *rtsp )
+{
+    /* The stream is going away: do not stop shared instances */
+    for( int i = 0; i < rtsp->sessionc; i++ )
+        rtsp->sessionv[i]->group = NULL;
+    while( rtsp->sessionc > 0 )
+        RtspClientDel( rtsp, rtsp->sessionv[0] );
+}
+
+
 /** rtsp must be locked */
 static void RtspClientAlive( rtsp_session_t *session )
 {
@@ -443,7 +495,7 @@ int RtspTrackAttach( rtsp_stream_t *rtsp, const char *name,
     rtsp_session_t *session;
 
     vlc_mutex_lock(&rtsp->lock);
-    session = RtspClientGet(rtsp, name);
+    session = RtspSessionGet(rtsp, name);
 
     if (session == NULL)
         goto out;
@@ -461,7 +513,8 @@ int RtspTrackAttach( rtsp_stream_t *rtsp, const char *name,
     if (tr != NULL)
     {
         tr->sout_id = sout_id;
-        tr->rtp_fd = dup_socket(tr->setup_fd);
+        if (tr->setup_fd != -1)
+            tr->rtp_fd = dup_socket(tr->setup_fd);
     }
     else
     {
@@ -489,6 +542,26 @@ int RtspTrackAttach( rtsp_stream_t *rtsp, const char *name,
         assert(tr->seq_init == seq);
     }
 
+    /* Feed the members of a shared instance */
+    if (session->shared)
+        for (int i = 0; i < rtsp->sessionc; i++)
+        {
+            rtsp_session_t *ses = rtsp->sessionv[i];
+            if (ses->group != session)
+                continue;
+            for (int j = 0; j < ses->trackc; j++)
+            {
+                rtsp_strack_t *mtr = ses->trackv + j;
+                if (mtr->id != id || mtr->setup_fd == -1
+                 || mtr->rtp_fd != -1)
+                    continue;
+                mtr->sout_id = sout_id;
+                mtr->rtp_fd = dup_socket(mtr->setup_fd);
+                if (mtr->rtp_fd != -1)
+                    rtp_add_sink(sout_id, mtr->rtp_fd, false, NULL);
+            }
+        }
+
     val = VLC_SUCCESS;
 out:
     vlc_mutex_unlock(&rtsp->lock);
@@ -503,11 +576,31 @@ void RtspTrackDetach( rtsp_stream_t *rtsp, const char *name,
     rtsp_session_t *session;
 
     vlc_mutex_lock(&rtsp->lock);
-    session = RtspClientGet(rtsp, name);
+    session = RtspSessionGet(rtsp, name);
 
     if (session == NULL)
         goto out;
 
+    if (session->shared)
+        for (int i = 0; i < rtsp->sessionc; i++)
+        {
+            rtsp_session_t *ses = rtsp->sessionv[i];
+            if (ses->group != session)
+                continue;
+            for (int j = 0; j < ses->trackc; j++)
+            {
+                rtsp_strack_t *mtr = ses->trackv + j;
+                if (mtr->sout_id != sout_id)
+                    continue;
+                if (mtr->rtp_fd != -1)
+                {
+                    rtp_del_sink(sout_id, mtr->rtp_fd);
+                    mtr->rtp_fd = -1;
+                }
+                mtr->sout_id = NULL;
+            }
+        }
+
     for (int i = 0; i < session->trackc; i++)
     {
         rtsp_strack_t *tr = session->trackv + i;
@@ -553,6 +646,137 @@ static void RtspTrackClose( rtsp_strack_t *tr )
 }
 
 
+/** rtsp must be locked
+ * @return whether the session has its own running VoD instance */
+static bool RtspSessionRunning( const rtsp_session_t *ses )
+{
+    if (ses->group != NULL)
+        return false;
+    for (int i = 0; i < ses->trackc; i++)
+        if (ses->trackv[i].sout_id != NULL)
+            return true;
+    return false;
+}
+
+
+/** rtsp must be locked
+ * Finds a shared instance which started recently enough to be joined,
+ * or creates a new one.
+ * @param created set if the instance must be started by the caller */
+static rtsp_session_t *RtspGroupGet( rtsp_stream_t *rtsp, bool *created )
+{
+    rtsp_session_t *group = NULL;
+    mtime_t now = mdate();
+
+    for (int i = 0; i < rtsp->sessionc; i++)
+    {
+        rtsp_session_t *s = rtsp->sessionv[i];
+        if (s->shared && now - s->start < rtsp->share_window
+         && (group == NULL || s->start > group->start))
+            group = s;
+    }
+
+    *created = group == NULL;
+    if (group == NULL)
+    {
+        group = RtspClientNew(rtsp);
+        if (group == NULL)
+            return NULL;
+        group->shared = true;
+        group->start = now;
+    }
+    return group;
+}
+
+
+/** rtsp must be locked
+ * Attaches the SETUP tracks of a member session to its shared instance:
+ * member tracks use the SSRC and initial sequence number of the
+ * instance, and get a sink on the RTP ids which are already running. */
+static void RtspGroupAttach( rtsp_session_t *ses )
+{
+    rtsp_session_t *group = ses->group;
+
+    for (int i = 0; i < ses->trackc; i++)
+    {
+        rtsp_strack_t *tr = ses->trackv + i;
+        if (tr->setup_fd == -1 || tr->rtp_fd != -1)
+            continue;
+
+        rtsp_strack_t *gtr = NULL;
+        for (int j = 0; j < group->trackc; j++)
+            if (group->trackv[j].id == tr->id)
+            {
+                gtr = group->trackv + j;
+                break;
+            }
+
+        if (gtr == NULL)
+        {
+            rtsp_strack_t track = { .id = tr->id, .sout_id = NULL,
+                                    .setup_fd = -1, .rtp_fd = -1 };
+            vlc_rand_bytes (&track.seq_init, sizeof (track.seq_init));
+            vlc_rand_bytes (&track.ssrc, sizeof (track.ssrc));
+            INSERT_ELEM(group->trackv, group->trackc, group->trackc, track);
+            gtr = group->trackv + group->trackc - 1;
+        }
+
+        tr->ssrc = gtr->ssrc;
+        tr->seq_init = gtr->seq_init;
+        tr->sout_id = gtr->sout_id;
+        if (tr->sout_id != NULL)
+        {
+            tr->rtp_fd = dup_socket(tr->setup_fd);
+            if (tr->rtp_fd != -1)
+                rtp_add_sink(tr->sout_id, tr->rtp_fd, false, NULL);
+        }
+    }
+}
+
+
+/** rtsp must be locked
+ * Detaches a member session from its shared instance, and stops the
+ * instance if it was the last member.
+ * @return the NPT the session was at */
+static int64_t RtspGroupLeave( rtsp_stream_t *rtsp, rtsp_session_t *ses )
+{
+    rtsp_session_t *group = ses->group;
+    int64_t npt = 0;
+    bool found = false;
+
+    for (int i = 0; i < ses->trackc; i++)
+    {
+        rtsp_strack_t *tr = ses->trackv + i;
+        if (tr->sout_id == NULL)
+            continue;
+        if (!found)
+        {
+            rtp_get_ts(NULL, tr->sout_id, NULL, NULL, &npt);
+            found = true;
+        }
+        if (tr->rtp_fd != -1)
+        {
+            rtp_del_sink(tr->sout_id, tr->rtp_fd);
+            tr->rtp_fd = -1;
+        }
+        tr->sout_id = NULL;
+    }
+    ses->group = NULL;
+
+    assert(group->members > 0);
+    if (--group->members == 0)
+    {
+        char psz_sesbuf[17];
+        snprintf( psz_sesbuf, sizeof( psz_sesbuf ), "%"PRIx64, group->id );
+        msg_Dbg( rtsp->owner, "RTSP: stopping shared instance %s",
+                 psz_sesbuf );
+        vod_stop(rtsp->vod_media, psz_sesbuf);
+        RtspClientDel(rtsp, group);
+    }
+    return npt;
+}
+
+
 /** Finds the next transport choice */
 static inline const char *transport_next( const char *str )
 {
@@ -938,6 +1162,8 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
         case HTTPD_MSG_PLAY:
         {
             rtsp_session_t *ses;
+            char psz_groupbuf[17];
+            bool b_group = false, b_group_new = false;
             answer->i_status = 200;
 
             psz_session = httpd_MsgGet( query, "Session" );
@@ -987,8 +1213,44 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
                           + sizeof("url=;seq=65535;rtptime=4294967295, ")
                                           - 1 ) + 1];
                 size_t infolen = 0;
+                const char *psz_ts_session = psz_session;
                 RtspClientAlive(ses);
 
+                if (vod && id == NULL)
+                {
+                    if (ses->group != NULL && start > 0)
+                        /* Seeking: the session gets its own instance */
+                        RtspGroupLeave(rtsp, ses);
+                    else if (ses->group == NULL && start < 0)
+                        /* Resume where the session left its group */
+                        start = ses->resume;
+                    ses->resume = -1;
+
+                    if (ses->group == NULL && start <= 0 && end < 0
+                     && rtsp->share_window > 0 && !RtspSessionRunning(ses))
+                    {
+                        rtsp_session_t *group = RtspGroupGet(rtsp,
+                                                             &b_group_new);
+                        if (group != NULL)
+                        {
+                            ses->group = group;
+                            group->members++;
+                            msg_Dbg(owner, "RTSP: session %s joins shared "
+                                    "instance %"PRIx64" (%u sessions)",
+                                    psz_session, group->id, group->members);
+                        }
+                    }
+
+                    if (ses->group != NULL)
+                    {
+                        RtspGroupAttach(ses);
+                        snprintf(psz_groupbuf, sizeof(psz_groupbuf),
+                                 "%"PRIx64, ses->group->id);
+                        psz_ts_session = psz_groupbuf;
+                        b_group = true;
+                    }
+                }
+
                 sout_stream_id_t *sout_id = NULL;
                 if (vod)
                 {
@@ -1002,8 +1264,9 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
                     }
                 }
                 int64_t ts = rtp_get_ts(vod ? NULL : (sout_stream_t *)owner,
-                                        sout_id, rtsp->vod_media, psz_session,
-                                        vod ? NULL : &npt);
+                                        sout_id, rtsp->vod_media,
+                                        psz_ts_session,
+                                        (vod && !b_group) ? NULL : &npt);
 
                 for( int i = 0; i < ses->trackc; i++ )
                 {
@@ -1056,7 +1319,12 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
 
             if (ses != NULL)
             {
-                if (vod)
+                if (vod && b_group_new)
+                {
+                    vod_play(rtsp->vod_media, psz_groupbuf, &start, end);
+                    npt = start;
+                }
+                else if (vod && !b_group)
                 {
                     vod_play(rtsp->vod_media, psz_session, &start, end);
                     npt = start;
@@ -1083,12 +1351,18 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
             }
 
             rtsp_session_t *ses;
+            int64_t npt = -1;
             answer->i_status = 200;
             psz_session = httpd_MsgGet( query, "Session" );
             vlc_mutex_lock( &rtsp->lock );
             ses = RtspClientGet( rtsp, psz_session );
             if (ses != NULL)
             {
+                if (id == NULL && ses->group != NULL)
+                    /* Shared instances cannot be paused: leave the group,
+                     * the session will resume with its own instance */
+                    ses->resume = npt = RtspGroupLeave(rtsp, ses);
+                else
                 if (id != NULL) /* "Mute" the selected track */
                 {
                     bool found = false;
@@ -1119,8 +1393,11 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
             if (ses != NULL && id == NULL)
             {
                 assert(vod);
-                int64_t npt = 0;
-                vod_pause(rtsp->vod_media, psz_session, &npt);
+                if (npt < 0)
+                {
+                    npt = 0;
+                    vod_pause(rtsp->vod_media, psz_session, &npt);
+                }
                 double f_npt = (double) npt / CLOCK_FREQ;
                 httpd_MsgAdd( answer, "Range", "npt=%f-", f_npt );
             }
@@ -35,6 +35,30 @@
 #include <vlc_meta.h>
 #include <vlc_modules.h>
 
+/* Default number of samples gathered before encoding on the thread */
+#define AUDIO_BATCH_SAMPLES 1024
+
+struct transcode_athread_t
+{
+    sout_stream_id_t *id;
+    vlc_thread_t    thread;
+    block_fifo_t    *p_fifo;        /* decoded audio, in batches */
+    vlc_mutex_t     lock;
+    vlc_cond_t      wait;
+    block_t         *p_buffers;     /* encoded audio */
+    unsigned        i_pending;      /* batches not encoded yet */
+
+    /* Batch being gathered on the decoder thread */
+    block_t         *p_batch;
+    block_t         **pp_batch_last;
+    unsigned        i_batch_samples;
+    unsigned        i_batch_max;
+    mtime_t         i_batch_end;
+
+    unsigned        i_blocks;
+    unsigned        i_batches;
+};
+
 static const int pi_channels_maps[6] =
 {
     0,
@@ -173,8 +197,178 @@ int transcode_audio_new( sout_stream_t *p_stream,
     return VLC_SUCCESS;
 }
 
+/* Runs the filters and the encoder on a decoded block */
+static block_t *transcode_audio_encode( sout_stream_id_t *id,
+                                        block_t *p_audio_buf )
+{
+    block_t *p_block;
+
+    p_audio_buf->i_dts = p_audio_buf->i_pts;
+
+    /* Run filter chain */
+    p_audio_buf = aout_FiltersPlay( id->p_af_chain, p_audio_buf,
+                                    INPUT_RATE_DEFAULT );
+    if( !p_audio_buf )
+        abort();
+
+    p_audio_buf->i_dts = p_audio_buf->i_pts;
+
+    p_block = id->p_encoder->pf_encode_audio( id->p_encoder, p_audio_buf );
+    block_Release( p_audio_buf );
+    return p_block;
+}
+
+static void *AudioThread( void *data )
+{
+    transcode_athread_t *p_th = data;
+
+    for( ;; )
+    {
+        block_t *p_audio_buf = block_FifoGet( p_th->p_fifo );
+        int canc = vlc_savecancel();
+
+        block_t *p_block = transcode_audio_encode( p_th->id, p_audio_buf );
+
+        vlc_mutex_lock( &p_th->lock );
+        block_ChainAppend( &p_th->p_buffers, p_block );
+        p_th->i_pending--;
+        vlc_cond_signal( &p_th->wait );
+        vlc_mutex_unlock( &p_th->lock );
+        vlc_restorecancel( canc );
+    }
+    return NULL;
+}
+
+static int transcode_audio_thread_start( sout_stream_t *p_stream,
+                                         sout_stream_id_t *id )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    transcode_athread_t *p_th = malloc( sizeof(*p_th) );
+    if( unlikely(p_th == NULL) )
+        return VLC_ENOMEM;
+
+    p_th->p_fifo = block_FifoNew();
+    if( unlikely(p_th->p_fifo == NULL) )
+    {
+        free( p_th );
+        return VLC_ENOMEM;
+    }
+    p_th->id = id;
+    vlc_mutex_init( &p_th->lock );
+    vlc_cond_init( &p_th->wait );
+    p_th->p_buffers = NULL;
+    p_th->i_pending = 0;
+    p_th->p_batch = NULL;
+    p_th->pp_batch_last = &p_th->p_batch;
+    p_th->i_batch_samples = 0;
+    p_th->i_batch_end = VLC_TS_INVALID;
+    p_th->i_blocks = p_th->i_batches = 0;
+
+    /* Gather whole encoder frames, at least AUDIO_BATCH_SAMPLES, counted
+     * in decoded samples */
+    unsigned i_frame = __MAX( id->p_encoder->fmt_in.audio.i_frame_length, 1 );
+    i_frame *= (AUDIO_BATCH_SAMPLES + i_frame - 1) / i_frame;
+    if( id->p_encoder->fmt_in.audio.i_rate )
+        i_frame = (uint64_t)i_frame * id->p_decoder->fmt_out.audio.i_rate
+                  / id->p_encoder->fmt_in.audio.i_rate;
+    p_th->i_batch_max = __MAX( i_frame, 1 );
+
+    if( vlc_clone( &p_th->thread, AudioThread, p_th,
+                   p_sys->b_high_priority ? VLC_THREAD_PRIORITY_OUTPUT
+                                          : VLC_THREAD_PRIORITY_AUDIO ) )
+    {
+        msg_Err( p_stream, "cannot spawn audio encoder thread" );
+        vlc_cond_destroy( &p_th->wait );
+        vlc_mutex_destroy( &p_th->lock );
+        block_FifoRelease( p_th->p_fifo );
+        free( p_th );
+        return VLC_EGENERIC;
+    }
+
+    msg_Dbg( p_stream, "audio encoder thread gathering %u samples",
+             p_th->i_batch_max );
+    id->p_athread = p_th;
+    return VLC_SUCCESS;
+}
+
+static void transcode_audio_thread_stop( sout_stream_id_t *id )
+{
+    transcode_athread_t *p_th = id->p_athread;
+
+    vlc_cancel( p_th->thread );
+    vlc_join( p_th->thread, NULL );
+
+    msg_Dbg( id->p_encoder, "encoded %u audio blocks in %u batches",
+             p_th->i_blocks, p_th->i_batches );
+
+    block_ChainRelease( p_th->p_batch );
+    block_ChainRelease( p_th->p_buffers );
+    block_FifoRelease( p_th->p_fifo );
+    vlc_cond_destroy( &p_th->wait );
+    vlc_mutex_destroy( &p_th->lock );
+    free( p_th );
+    id->p_athread = NULL;
+}
+
+/* Hands the gathered samples over to the encoder thread */
+static void transcode_audio_thread_queue( transcode_athread_t *p_th )
+{
+    block_t *p_batch = p_th->p_batch;
+    if( p_batch == NULL )
+        return;
+
+    unsigned i_samples = p_th->i_batch_samples;
+    p_batch = block_ChainGather( p_batch );
+    p_batch->i_nb_samples = i_samples;
+
+    p_th->p_batch = NULL;
+    p_th->pp_batch_last = &p_th->p_batch;
+    p_th->i_batch_samples = 0;
+    p_th->i_batches++;
+
+    vlc_mutex_lock( &p_th->lock );
+    p_th->i_pending++;
+    vlc_mutex_unlock( &p_th->lock );
+    block_FifoPut( p_th->p_fifo, p_batch );
+}
+
+static void transcode_audio_thread_put( transcode_athread_t *p_th,
+                                        block_t *p_audio_buf )
+{
+    /* Only contiguous samples can be encoded as one block */
+    if( p_th->p_batch != NULL
+     && ( (p_audio_buf->i_flags & BLOCK_FLAG_DISCONTINUITY)
+       || p_audio_buf->i_pts - p_th->i_batch_end > 1000
+       || p_th->i_batch_end - p_audio_buf->i_pts > 1000 ) )
+        transcode_audio_thread_queue( p_th );
+
+    block_ChainLastAppend( &p_th->pp_batch_last, p_audio_buf );
+    p_th->i_batch_samples += p_audio_buf->i_nb_samples;
+    p_th->i_batch_end = p_audio_buf->i_pts + p_audio_buf->i_length;
+    p_th->i_blocks++;
+
+    if( p_th->i_batch_samples >= p_th->i_batch_max )
+        transcode_audio_thread_queue( p_th );
+}
+
+/* Collects the blocks encoded by the thread, waiting for all of them when
+ * draining */
+static void transcode_audio_thread_get( transcode_athread_t *p_th,
+                                        block_t **out, bool b_drain )
+{
+    vlc_mutex_lock( &p_th->lock );
+    while( b_drain && p_th->i_pending > 0 )
+        vlc_cond_wait( &p_th->wait, &p_th->lock );
+    block_ChainAppend( out, p_th->p_buffers );
+    p_th->p_buffers = NULL;
+    vlc_mutex_unlock( &p_th->lock );
+}
+
 void transcode_audio_close( sout_stream_id_t *id )
 {
+    if( id->p_athread != NULL )
+        transcode_audio_thread_stop( id );
+
     /* Close decoder */
     if( id->p_decoder->p_module )
         module_unneed( id->p_decoder, id->p_decoder->p_module );
@@ -205,6 +399,14 @@ int transcode_audio_process( sout_stream_t *p_stream,
     if( unlikely( in == NULL ) )
     {
         block_t *p_block;
+
+        /* Let the thread encode the queued samples first */
+        if( id->p_athread != NULL )
+        {
+            transcode_audio_thread_queue( id->p_athread );
+            transcode_audio_thread_get( id->p_athread, out, true );
+        }
+
         do {
            p_block = id->p_encoder->pf_encode_audio(id->p_encoder, NULL );
            block_ChainAppend( out, p_block );
@@ -232,22 +434,19 @@ int transcode_audio_process( sout_stream_t *p_stream,
             p_audio_buf->i_pts = i_pts;
         }
 
-        p_audio_buf->i_dts = p_audio_buf->i_pts;
-
-        /* Run filter chain */
-        p_audio_buf = aout_FiltersPlay( id->p_af_chain, p_audio_buf,
-                                        INPUT_RATE_DEFAULT );
-        if( !p_audio_buf )
-            abort();
-
-        p_audio_buf->i_dts = p_audio_buf->i_pts;
-
-        p_block = id->p_encoder->pf_encode_audio( id->p_encoder, p_audio_buf );
+        if( id->p_athread != NULL )
+        {
+            transcode_audio_thread_put( id->p_athread, p_audio_buf );
+            continue;
+        }
 
+        p_block = transcode_audio_encode( id, p_audio_buf );
         block_ChainAppend( out, p_block );
-        block_Release( p_audio_buf );
     }
 
+    if( id->p_athread != NULL )
+        transcode_audio_thread_get( id->p_athread, out, false );
+
     return VLC_SUCCESS;
 }
 
@@ -306,5 +505,9 @@ bool transcode_audio_add( sout_stream_t *p_stream, es_format_t *p_fmt,
 
     date_Init( &id->interpolated_pts, p_fmt->audio.i_rate, 1 );
 
+    if( p_sys->b_audio_thread
+     && transcode_audio_thread_start( p_stream, id ) != VLC_SUCCESS )
+        msg_Warn( p_stream, "encoding audio on the input thread" );
+
     return true;
 }
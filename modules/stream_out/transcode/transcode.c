@@ -75,6 +75,14 @@
 #define MAXHEIGHT_TEXT N_("Maximum video height")
 #define MAXHEIGHT_LONGTEXT N_( \
     "Maximum output video height." )
+#define RENDITIONS_TEXT N_("Video renditions")
+#define RENDITIONS_LONGTEXT N_( \
+    "Comma-separated list of additional video renditions, as " \
+    "WIDTHxHEIGHT:KBPS (e.g. 640x360:800,0x180:300, where 0 keeps the " \
+    "aspect ratio and the bitrate is optional). The video is decoded " \
+    "and filtered once, then scaled and encoded again for each rendition, " \
+    "as separate streams. Use a fixed keyframe interval in the encoder " \
+    "options to align the keyframes of all renditions." )
 #define VFILTER_TEXT N_("Video filter")
 #define VFILTER_LONGTEXT N_( \
     "Video filters will be applied to the video streams (after overlays " \
@@ -99,6 +107,10 @@
 #define ACHANS_TEXT N_("Audio channels")
 #define ACHANS_LONGTEXT N_( \
     "Number of audio channels in the transcoded streams." )
+#define ATHREAD_TEXT N_("Audio encoder thread")
+#define ATHREAD_LONGTEXT N_( \
+    "Run the audio filters and encoder of each audio track on its own " \
+    "thread, so that several audio tracks are transcoded in parallel." )
 #define AFILTER_TEXT N_("Audio filter")
 #define AFILTER_LONGTEXT N_( \
     "Audio filters will be applied to the audio streams (after conversion " \
@@ -126,6 +138,13 @@
 #define THREADS_TEXT N_("Number of threads")
 #define THREADS_LONGTEXT N_( \
     "Number of threads used for the transcoding." )
+#define FTHREADS_TEXT N_("Number of filter threads")
+#define FTHREADS_LONGTEXT N_( \
+    "Number of threads running the video filters, scaling and overlays " \
+    "between the decoder and the encoder thread (0 to run them on the " \
+    "decoder thread). Only chroma conversion and scaling can use more than " \
+    "one thread." )
+#define FTHREADS_MAX 16
 #define HP_TEXT N_("High priority")
 #define HP_LONGTEXT N_( \
     "Runs the optional encoder thread at the OUTPUT priority instead of " \
@@ -185,6 +204,8 @@ vlc_module_begin ()
                  MAXWIDTH_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "maxheight", 0, MAXHEIGHT_TEXT,
                  MAXHEIGHT_LONGTEXT, true )
+    add_string( SOUT_CFG_PREFIX "renditions", NULL, RENDITIONS_TEXT,
+                RENDITIONS_LONGTEXT, true )
     add_module_list( SOUT_CFG_PREFIX "vfilter", "video filter2",
                      NULL, VFILTER_TEXT, VFILTER_LONGTEXT, false )
 
@@ -205,6 +226,8 @@ vlc_module_begin ()
               ASYNC_LONGTEXT, false )
     add_module_list( SOUT_CFG_PREFIX "afilter",  "audio filter",
                      NULL, AFILTER_TEXT, AFILTER_LONGTEXT, false )
+    add_bool( SOUT_CFG_PREFIX "audio-thread", false, ATHREAD_TEXT,
+              ATHREAD_LONGTEXT, true )
 
     set_section( N_("Overlays/Subtitles"), NULL )
     add_module( SOUT_CFG_PREFIX "senc", "encoder", NULL, SENC_TEXT,
@@ -223,6 +246,9 @@ vlc_module_begin ()
     set_section( N_("Miscellaneous"), NULL )
     add_integer( SOUT_CFG_PREFIX "threads", 0, THREADS_TEXT,
                  THREADS_LONGTEXT, true )
+    add_integer( SOUT_CFG_PREFIX "filter-threads", 0, FTHREADS_TEXT,
+                 FTHREADS_LONGTEXT, true )
+        change_integer_range( 0, FTHREADS_MAX )
     add_bool( SOUT_CFG_PREFIX "high-priority", false, HP_TEXT, HP_LONGTEXT,
               true )
 
@@ -231,9 +257,11 @@ vlc_module_end ()
 static const char *const ppsz_sout_options[] = {
     "venc", "vcodec", "vb",
     "scale", "fps", "width", "height", "vfilter", "deinterlace",
-    "deinterlace-module", "threads", "hurry-up", "aenc", "acodec", "ab", "alang",
-    "afilter", "samplerate", "channels", "senc", "scodec", "soverlay",
+    "deinterlace-module", "threads", "filter-threads", "hurry-up", "aenc",
+    "acodec", "ab", "alang",
+    "afilter", "audio-thread", "samplerate", "channels", "senc", "scodec", "soverlay",
     "sfilter", "osd", "audio-sync", "high-priority", "maxwidth", "maxheight",
+    "renditions",
     NULL
 };
 
@@ -318,6 +346,9 @@ static int Open( vlc_object_t *p_this )
         p_sys->psz_af = NULL;
     free( psz_string );
 
+    p_sys->b_audio_thread = var_GetBool( p_stream,
+                                         SOUT_CFG_PREFIX "audio-thread" );
+
     /* Video transcoding parameters */
     psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "venc" );
     p_sys->psz_venc = NULL;
@@ -365,6 +396,13 @@ static int Open( vlc_object_t *p_this )
         p_sys->psz_vf2 = NULL;
     free( psz_string );
 
+    psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "renditions" );
+    if( psz_string && *psz_string )
+        p_sys->psz_renditions = strdup( psz_string );
+    else
+        p_sys->psz_renditions = NULL;
+    free( psz_string );
+
     p_sys->b_deinterlace = var_GetBool( p_stream, SOUT_CFG_PREFIX "deinterlace" );
 
     psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "deinterlace-module" );
@@ -381,6 +419,16 @@ static int Open( vlc_object_t *p_this )
     free( psz_string );
 
     p_sys->i_threads = var_GetInteger( p_stream, SOUT_CFG_PREFIX "threads" );
+    int64_t i_filter_threads = var_GetInteger( p_stream,
+                                               SOUT_CFG_PREFIX "filter-threads" );
+    /* The chain options bypass the range of the module option */
+    if( i_filter_threads < 0 || i_filter_threads > FTHREADS_MAX )
+    {
+        msg_Warn( p_stream, "invalid number of filter threads %"PRId64,
+                  i_filter_threads );
+        i_filter_threads = VLC_CLIP( i_filter_threads, 0, FTHREADS_MAX );
+    }
+    p_sys->i_filter_threads = i_filter_threads;
     p_sys->b_high_priority = var_GetBool( p_stream, SOUT_CFG_PREFIX "high-priority" );
 
     if( p_sys->i_vcodec )
@@ -489,6 +537,7 @@ static void Close( vlc_object_t * p_this )
     free( p_sys->psz_alang );
 
     free( p_sys->psz_vf2 );
+    free( p_sys->psz_renditions );
 
     config_ChainDestroy( p_sys->p_video_cfg );
     free( p_sys->psz_venc );
@@ -651,6 +700,15 @@ static int Send( sout_stream_t *p_stream, sout_stream_id_t *id,
         return VLC_EGENERIC;
     }
 
+    /* Decoders may modify their input in place. NULL flushes the
+     * encoders when the stream is deleted. */
+    if( p_buffer != NULL )
+    {
+        p_buffer = block_Unshare( p_buffer );
+        if( p_buffer == NULL )
+            return VLC_ENOMEM;
+    }
+
     switch( id->p_decoder->fmt_in.i_cat )
     {
     case AUDIO_ES:
@@ -9,20 +9,64 @@
 #include <vlc_es.h>
 #include <vlc_codec.h>
 
-#include <vlc_picture_fifo.h>
-
 #define MASTER_SYNC_MAX_DRIFT 100000
 
+/* Video pipeline stages */
+enum
+{
+    TRANSCODE_STAGE_DECODE,
+    TRANSCODE_STAGE_FILTER,
+    TRANSCODE_STAGE_ENCODE,
+    TRANSCODE_STAGE_MAX
+};
+
+typedef struct
+{
+    unsigned        i_frames;
+    mtime_t         i_busy;     /* time spent processing */
+    mtime_t         i_busy_max;
+    mtime_t         i_queued;   /* time spent waiting for the stage */
+} transcode_stage_t;
+
+/* Picture on its way from the decoder to the encoder */
+typedef struct
+{
+    picture_t       *p_pic;
+    picture_t       *p_dup;     /* duplicate for the master sync */
+    mtime_t         i_dup_date; /* date of the duplicate to make, if any */
+    mtime_t         i_queued;   /* when the picture entered its queue */
+    bool            b_ready;    /* ready to be encoded */
+} transcode_frame_t;
+
+typedef struct transcode_worker_t transcode_worker_t;
+typedef struct transcode_athread_t transcode_athread_t;
+typedef struct transcode_rendition_t transcode_rendition_t;
+
 struct sout_stream_sys_t
 {
     sout_stream_id_t *id_video;
     block_t         *p_buffers;
     vlc_mutex_t     lock_out;
     vlc_cond_t      cond;
+    vlc_cond_t      cond_filter;
+    vlc_cond_t      cond_space;
     bool            b_abort;
-    picture_fifo_t *pp_pics;
     vlc_thread_t    thread;
 
+    /* Ring of pictures between the decoder, the filter threads and the
+     * encoder thread. Filter threads may complete out of order, the encoder
+     * always takes the pictures in decoding order. */
+    transcode_frame_t *p_frames;
+    unsigned        i_frames;
+    uint64_t        i_frame_in;     /* next picture from the decoder */
+    uint64_t        i_frame_filter; /* next picture to filter */
+    uint64_t        i_frame_out;    /* next picture to encode */
+    unsigned        i_filter_gen;   /* bumped when the filters are rebuilt */
+    transcode_worker_t *p_workers;
+    int             i_filter_threads;
+
+    transcode_stage_t stage[TRANSCODE_STAGE_MAX];
+
     /* Audio */
     vlc_fourcc_t    i_acodec;   /* codec audio (0 if not transcode) */
     char            *psz_aenc;
@@ -33,6 +77,7 @@ struct sout_stream_sys_t
     int             i_abitrate;
 
     char            *psz_af;
+    bool            b_audio_thread;
 
     /* Video */
     vlc_fourcc_t    i_vcodec;   /* codec video (0 if not transcode) */
@@ -52,6 +97,7 @@ struct sout_stream_sys_t
     bool            b_hurry_up;
 
     char            *psz_vf2;
+    char            *psz_renditions;
 
     /* SPU */
     vlc_fourcc_t    i_scodec;   /* codec spu (0 if not transcode) */
@@ -97,6 +143,13 @@ struct sout_stream_id_t
     /* Encoder */
     encoder_t       *p_encoder;
 
+    /* Audio encoder thread, if any */
+    transcode_athread_t *p_athread;
+
+    /* Additional video renditions */
+    transcode_rendition_t *p_renditions;
+    int             i_renditions;
+
     /* Sync */
     date_t          interpolated_pts;
 };
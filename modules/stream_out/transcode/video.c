@@ -97,37 +97,483 @@ static void transcode_video_filter_allocation_clear( filter_t *p_filter )
     VLC_UNUSED(p_filter);
 }
 
+struct transcode_worker_t
+{
+    sout_stream_t   *p_stream;
+    vlc_thread_t    thread;
+    filter_chain_t  *p_chain; /* private conversion chain */
+    unsigned        i_gen;
+};
+
+static inline bool transcode_video_threaded( const sout_stream_sys_t *p_sys )
+{
+    return p_sys->i_threads >= 1 || p_sys->i_filter_threads >= 1;
+}
+
+struct transcode_rendition_t
+{
+    encoder_t       *p_encoder;
+    filter_chain_t  *p_f_chain; /* scaling from the main encoder input */
+    void            *id;        /* output stream */
+    block_t         *p_blocks;  /* encoded, owned by the encoding thread */
+    block_t         *p_buffers; /* encoded, waiting to be sent */
+};
+
+/* (Re)builds the scaling from the main encoder input to a rendition */
+static int transcode_video_rendition_chain( sout_stream_id_t *id,
+                                            transcode_rendition_t *p_rend )
+{
+    filter_chain_Reset( p_rend->p_f_chain, &id->p_encoder->fmt_in,
+                        &p_rend->p_encoder->fmt_in );
+    if( video_format_IsSimilar( &id->p_encoder->fmt_in.video,
+                                &p_rend->p_encoder->fmt_in.video ) )
+        return VLC_SUCCESS;
+    if( filter_chain_AppendFilter( p_rend->p_f_chain, NULL, NULL,
+                                   &id->p_encoder->fmt_in,
+                                   &p_rend->p_encoder->fmt_in ) == NULL )
+        return VLC_EGENERIC;
+    return VLC_SUCCESS;
+}
+
+static void transcode_video_rendition_close( sout_stream_t *p_stream,
+                                             transcode_rendition_t *p_rend )
+{
+    sout_StreamIdDel( p_stream->p_next, p_rend->id );
+    filter_chain_Delete( p_rend->p_f_chain );
+    module_unneed( p_rend->p_encoder, p_rend->p_encoder->p_module );
+    es_format_Clean( &p_rend->p_encoder->fmt_out );
+    vlc_object_release( p_rend->p_encoder );
+    block_ChainRelease( p_rend->p_blocks );
+    block_ChainRelease( p_rend->p_buffers );
+}
+
+static int transcode_video_rendition_open( sout_stream_t *p_stream,
+                                           sout_stream_id_t *id,
+                                           transcode_rendition_t *p_rend,
+                                           unsigned i_width,
+                                           unsigned i_height, int i_bitrate )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    const video_format_t *p_main = &id->p_encoder->fmt_out.video;
+    encoder_t *p_enc = sout_EncoderCreate( p_stream );
+    if( !p_enc )
+        return VLC_ENOMEM;
+
+    es_format_Init( &p_enc->fmt_in, VIDEO_ES, id->p_encoder->fmt_in.i_codec );
+    p_enc->fmt_in.video = id->p_encoder->fmt_in.video;
+    p_enc->fmt_in.video.p_palette = NULL;
+    p_enc->fmt_in.video.i_width =
+    p_enc->fmt_in.video.i_visible_width = i_width;
+    p_enc->fmt_in.video.i_height =
+    p_enc->fmt_in.video.i_visible_height = i_height;
+    p_enc->fmt_in.video.i_x_offset = p_enc->fmt_in.video.i_y_offset = 0;
+
+    /* Keep the display aspect ratio of the main output */
+    vlc_ureduce( &p_enc->fmt_in.video.i_sar_num,
+                 &p_enc->fmt_in.video.i_sar_den,
+                 (uint64_t)p_main->i_sar_num * p_main->i_width * i_height,
+                 (uint64_t)p_main->i_sar_den * p_main->i_height * i_width, 0 );
+
+    es_format_Init( &p_enc->fmt_out, VIDEO_ES, p_sys->i_vcodec );
+    p_enc->fmt_out.video = p_enc->fmt_in.video;
+    p_enc->fmt_out.video.i_chroma = 0;
+    /* The ES id is left unset (-1): each rendition is an ES of its own,
+     * and muxers mapping ids to stream numbers must not see it twice */
+    p_enc->fmt_out.i_group = id->p_encoder->fmt_out.i_group;
+    if( i_bitrate > 0 )
+        p_enc->fmt_out.i_bitrate = i_bitrate;
+    else
+        p_enc->fmt_out.i_bitrate = (uint64_t)id->p_encoder->fmt_out.i_bitrate
+                                   * i_width * i_height
+                                   / (p_main->i_width * p_main->i_height);
+
+    p_enc->i_threads = p_sys->i_threads;
+    p_enc->p_cfg = p_sys->p_video_cfg;
+    p_enc->p_module = module_need( p_enc, "encoder", p_sys->psz_venc, true );
+    if( !p_enc->p_module )
+    {
+        msg_Err( p_stream, "cannot find video encoder for the %ux%u rendition",
+                 i_width, i_height );
+        es_format_Clean( &p_enc->fmt_out );
+        vlc_object_release( p_enc );
+        return VLC_EGENERIC;
+    }
+    p_enc->fmt_in.video.i_chroma = p_enc->fmt_in.i_codec;
+    p_enc->fmt_out.i_codec = vlc_fourcc_GetCodec( VIDEO_ES,
+                                                  p_enc->fmt_out.i_codec );
+
+    p_rend->p_encoder = p_enc;
+    p_rend->p_blocks = p_rend->p_buffers = NULL;
+    p_rend->p_f_chain = filter_chain_New( p_stream, "video filter2", false,
+                                   transcode_video_filter_allocation_init,
+                                   transcode_video_filter_allocation_clear,
+                                   p_sys );
+    p_rend->id = NULL;
+    if( p_rend->p_f_chain == NULL
+     || transcode_video_rendition_chain( id, p_rend )
+     || (p_rend->id = sout_StreamIdAdd( p_stream->p_next,
+                                        &p_enc->fmt_out )) == NULL )
+    {
+        msg_Err( p_stream, "cannot add the %ux%u rendition",
+                 i_width, i_height );
+        if( p_rend->p_f_chain )
+            filter_chain_Delete( p_rend->p_f_chain );
+        module_unneed( p_enc, p_enc->p_module );
+        es_format_Clean( &p_enc->fmt_out );
+        vlc_object_release( p_enc );
+        return VLC_EGENERIC;
+    }
+
+    msg_Dbg( p_stream, "video rendition %ux%u at %u kb/s", i_width, i_height,
+             p_enc->fmt_out.i_bitrate / 1000 );
+    return VLC_SUCCESS;
+}
+
+/* Opens the renditions listed in the renditions option, once the main
+ * encoder knows its formats */
+static void transcode_video_renditions_open( sout_stream_t *p_stream,
+                                             sout_stream_id_t *id )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    const video_format_t *p_main = &id->p_encoder->fmt_out.video;
+    char *psz_list, *psz_tok, *psz_state;
+    int i_max = 1;
+
+    if( p_sys->psz_renditions == NULL )
+        return;
+    for( const char *psz = p_sys->psz_renditions; *psz; psz++ )
+        if( *psz == ',' )
+            i_max++;
+
+    psz_list = strdup( p_sys->psz_renditions );
+    id->p_renditions = calloc( i_max, sizeof(*id->p_renditions) );
+    if( psz_list == NULL || id->p_renditions == NULL )
+    {
+        free( psz_list );
+        return;
+    }
+
+    for( psz_tok = strtok_r( psz_list, ",", &psz_state ); psz_tok != NULL;
+         psz_tok = strtok_r( NULL, ",", &psz_state ) )
+    {
+        unsigned i_width = 0, i_height = 0, i_kbps = 0;
+
+        if( sscanf( psz_tok, "%ux%u:%u", &i_width, &i_height, &i_kbps ) < 2
+         || ( i_width == 0 && i_height == 0 ) )
+        {
+            msg_Err( p_stream, "invalid rendition `%s'", psz_tok );
+            continue;
+        }
+        /* 0 keeps the aspect ratio of the main output */
+        if( i_width == 0 )
+            i_width = p_main->i_width * i_height / p_main->i_height;
+        if( i_height == 0 )
+            i_height = p_main->i_height * i_width / p_main->i_width;
+        i_width = __MAX( i_width & ~1, 2 );
+        i_height = __MAX( i_height & ~1, 2 );
+
+        if( transcode_video_rendition_open( p_stream, id,
+                        &id->p_renditions[id->i_renditions],
+                        i_width, i_height, i_kbps * 1000 ) == VLC_SUCCESS )
+            id->i_renditions++;
+    }
+    free( psz_list );
+}
+
+/* Sends what the renditions encoded to their own output streams */
+static void transcode_video_renditions_send( sout_stream_t *p_stream,
+                                             sout_stream_id_t *id )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    for( int i = 0; i < id->i_renditions; i++ )
+    {
+        transcode_rendition_t *p_rend = &id->p_renditions[i];
+        block_t *p_out;
+
+        if( transcode_video_threaded( p_sys ) )
+        {
+            vlc_mutex_lock( &p_sys->lock_out );
+            p_out = p_rend->p_buffers;
+            p_rend->p_buffers = NULL;
+            vlc_mutex_unlock( &p_sys->lock_out );
+        }
+        else
+        {
+            p_out = p_rend->p_blocks;
+            p_rend->p_blocks = NULL;
+        }
+
+        if( p_out != NULL )
+            sout_StreamIdSend( p_stream->p_next, p_rend->id, p_out );
+    }
+}
+
+static void transcode_stage_account( transcode_stage_t *p_stage,
+                                     mtime_t i_busy, mtime_t i_queued )
+{
+    p_stage->i_frames++;
+    p_stage->i_busy += i_busy;
+    if( i_busy > p_stage->i_busy_max )
+        p_stage->i_busy_max = i_busy;
+    p_stage->i_queued += i_queued;
+}
+
+static void transcode_video_stats( sout_stream_t *p_stream )
+{
+    static const char ppsz_stages[TRANSCODE_STAGE_MAX][7] = {
+        "decode", "filter", "encode"
+    };
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    for( int i = 0; i < TRANSCODE_STAGE_MAX; i++ )
+    {
+        const transcode_stage_t *p_stage = &p_sys->stage[i];
+
+        if( p_stage->i_frames == 0 )
+            continue;
+        msg_Dbg( p_stream, "video %s: %u pictures, %.1f pictures/s, "
+                 "busy avg %"PRId64" max %"PRId64" us, queued avg %"PRId64
+                 " us", ppsz_stages[i], p_stage->i_frames,
+                 p_stage->i_busy > 0 ? (double)p_stage->i_frames * CLOCK_FREQ
+                                       / p_stage->i_busy : 0.,
+                 p_stage->i_busy / p_stage->i_frames, p_stage->i_busy_max,
+                 p_stage->i_queued / p_stage->i_frames );
+    }
+}
+
+static picture_t *transcode_video_decode( sout_stream_sys_t *p_sys,
+                                          sout_stream_id_t *id,
+                                          block_t **pp_block )
+{
+    mtime_t i_start = mdate();
+    picture_t *p_pic = id->p_decoder->pf_decode_video( id->p_decoder,
+                                                       pp_block );
+    if( p_pic != NULL )
+        transcode_stage_account( &p_sys->stage[TRANSCODE_STAGE_DECODE],
+                                 mdate() - i_start, 0 );
+    return p_pic;
+}
+
+static block_t *transcode_video_encode( sout_stream_sys_t *p_sys,
+                                        sout_stream_id_t *id,
+                                        picture_t *p_pic, mtime_t i_queued )
+{
+    mtime_t i_start = mdate();
+    block_t *p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
+
+    /* Scale the same picture for each rendition */
+    for( int i = 0; i < id->i_renditions; i++ )
+    {
+        transcode_rendition_t *p_rend = &id->p_renditions[i];
+        picture_t *p_scaled;
+
+        picture_Hold( p_pic );
+        p_scaled = filter_chain_VideoFilter( p_rend->p_f_chain, p_pic );
+        if( p_scaled == NULL )
+            continue;
+        block_ChainAppend( &p_rend->p_blocks,
+            p_rend->p_encoder->pf_encode_video( p_rend->p_encoder, p_scaled ) );
+        picture_Release( p_scaled );
+    }
+
+    transcode_stage_account( &p_sys->stage[TRANSCODE_STAGE_ENCODE],
+                             mdate() - i_start, i_queued );
+    return p_block;
+}
+
+static picture_t *transcode_video_duplicate( sout_stream_id_t *id,
+                                             picture_t *p_pic, mtime_t i_date )
+{
+    /* We can't modify the picture, we need to duplicate it */
+    picture_t *p_dup = video_new_buffer_encoder( id->p_encoder );
+    if( likely( p_dup != NULL ) )
+    {
+        picture_Copy( p_dup, p_pic );
+        p_dup->date = i_date;
+    }
+    return p_dup;
+}
+
+/* Runs the filter chains and the subpicture overlay on a decoded picture */
+static picture_t *transcode_video_filter( sout_stream_sys_t *p_sys,
+                                          sout_stream_id_t *id,
+                                          filter_chain_t *p_f_chain,
+                                          filter_chain_t *p_uf_chain,
+                                          picture_t *p_pic )
+{
+    bool b_filtered = p_f_chain && filter_chain_GetLength( p_f_chain ) > 0;
+
+    /* Run filter chain */
+    if( p_f_chain )
+        p_pic = filter_chain_VideoFilter( p_f_chain, p_pic );
+    if( !p_pic )
+        return NULL;
+
+    /* Run user specified filter chain */
+    if( p_uf_chain )
+        p_pic = filter_chain_VideoFilter( p_uf_chain, p_pic );
+    if( !p_pic )
+        return NULL;
+
+    /* Check if we have a subpicture to overlay */
+    if( p_sys->p_spu )
+    {
+        video_format_t fmt = id->p_encoder->fmt_in.video;
+        if( fmt.i_visible_width <= 0 || fmt.i_visible_height <= 0 )
+        {
+            fmt.i_visible_width  = fmt.i_width;
+            fmt.i_visible_height = fmt.i_height;
+            fmt.i_x_offset       = 0;
+            fmt.i_y_offset       = 0;
+        }
+
+        subpicture_t *p_subpic = spu_Render( p_sys->p_spu, NULL, &fmt, &fmt,
+                                             p_pic->date, p_pic->date, false );
+
+        /* Overlay subpicture */
+        if( p_subpic )
+        {
+            if( picture_IsReferenced( p_pic ) && !b_filtered )
+            {
+                /* We can't modify the picture, we need to duplicate it,
+                 * in this point the picture is already p_encoder->fmt.in format*/
+                picture_t *p_tmp = video_new_buffer_encoder( id->p_encoder );
+                if( likely( p_tmp ) )
+                {
+                    picture_Copy( p_tmp, p_pic );
+                    picture_Release( p_pic );
+                    p_pic = p_tmp;
+                }
+            }
+            if( unlikely( !p_sys->p_spu_blend ) )
+                p_sys->p_spu_blend = filter_NewBlend( VLC_OBJECT( p_sys->p_spu ), &fmt );
+            if( likely( p_sys->p_spu_blend ) )
+                picture_BlendSubpicture( p_pic, p_sys->p_spu_blend, p_subpic );
+            subpicture_Delete( p_subpic );
+        }
+    }
+    return p_pic;
+}
+
+static filter_chain_t *transcode_video_convert_new( sout_stream_t *p_stream,
+                                                    sout_stream_id_t *id );
+
+static void* FilterThread( void *obj )
+{
+    transcode_worker_t *p_worker = obj;
+    sout_stream_t *p_stream = p_worker->p_stream;
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    sout_stream_id_t *id = p_sys->id_video;
+    int canc = vlc_savecancel ();
+
+    vlc_mutex_lock( &p_sys->lock_out );
+    for( ;; )
+    {
+        while( !p_sys->b_abort && p_sys->i_frame_filter == p_sys->i_frame_in )
+            vlc_cond_wait( &p_sys->cond_filter, &p_sys->lock_out );
+        if( p_sys->b_abort )
+            break;
+
+        transcode_frame_t *p_frame =
+            &p_sys->p_frames[p_sys->i_frame_filter++ % p_sys->i_frames];
+        picture_t *p_pic = p_frame->p_pic, *p_dup = NULL;
+        mtime_t i_start = mdate();
+        mtime_t i_queued = i_start - p_frame->i_queued;
+        unsigned i_gen = p_sys->i_filter_gen;
+        vlc_mutex_unlock( &p_sys->lock_out );
+
+        filter_chain_t *p_f_chain = id->p_f_chain;
+        filter_chain_t *p_uf_chain = id->p_uf_chain;
+        if( p_sys->i_filter_threads > 1 )
+        {
+            /* Conversions have no state: each thread has its own chain */
+            if( p_worker->p_chain == NULL || p_worker->i_gen != i_gen )
+            {
+                if( p_worker->p_chain != NULL )
+                    filter_chain_Delete( p_worker->p_chain );
+                p_worker->p_chain = transcode_video_convert_new( p_stream, id );
+                p_worker->i_gen = i_gen;
+            }
+            p_f_chain = p_worker->p_chain;
+            p_uf_chain = NULL;
+        }
+
+        p_pic = transcode_video_filter( p_sys, id, p_f_chain, p_uf_chain,
+                                        p_pic );
+        if( p_pic != NULL && p_frame->i_dup_date > VLC_TS_INVALID )
+            p_dup = transcode_video_duplicate( id, p_pic, p_frame->i_dup_date );
+        mtime_t i_end = mdate();
+
+        vlc_mutex_lock( &p_sys->lock_out );
+        transcode_stage_account( &p_sys->stage[TRANSCODE_STAGE_FILTER],
+                                 i_end - i_start, i_queued );
+        p_frame->p_pic = p_pic;
+        p_frame->p_dup = p_dup;
+        p_frame->i_queued = i_end;
+        p_frame->b_ready = true;
+        vlc_cond_signal( &p_sys->cond );
+    }
+    vlc_mutex_unlock( &p_sys->lock_out );
+
+    if( p_worker->p_chain != NULL )
+        filter_chain_Delete( p_worker->p_chain );
+
+    vlc_restorecancel (canc);
+    return NULL;
+}
+
 static void* EncoderThread( void *obj )
 {
     sout_stream_sys_t *p_sys = (sout_stream_sys_t*)obj;
     sout_stream_id_t *id = p_sys->id_video;
-    picture_t *p_pic;
     int canc = vlc_savecancel ();
 
+    vlc_mutex_lock( &p_sys->lock_out );
     for( ;; )
     {
-        block_t *p_block;
+        /* Pictures are encoded in decoding order, whichever filter thread
+         * finished them first */
+        transcode_frame_t *p_frame =
+            &p_sys->p_frames[p_sys->i_frame_out % p_sys->i_frames];
 
-        vlc_mutex_lock( &p_sys->lock_out );
-        while( !p_sys->b_abort &&
-               (p_pic = picture_fifo_Pop( p_sys->pp_pics )) == NULL )
+        while( !p_sys->b_abort && !p_frame->b_ready )
             vlc_cond_wait( &p_sys->cond, &p_sys->lock_out );
-
         if( p_sys->b_abort )
-        {
-            vlc_mutex_unlock( &p_sys->lock_out );
             break;
-        }
+
+        picture_t *p_pic = p_frame->p_pic, *p_dup = p_frame->p_dup;
+        mtime_t i_queued = mdate() - p_frame->i_queued;
+        p_frame->p_pic = p_frame->p_dup = NULL;
+        p_frame->b_ready = false;
         vlc_mutex_unlock( &p_sys->lock_out );
 
-        p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
+        block_t *p_block = NULL;
+        if( p_pic != NULL )
+        {
+            block_ChainAppend( &p_block,
+                transcode_video_encode( p_sys, id, p_pic, i_queued ) );
+            picture_Release( p_pic );
+        }
+        if( p_dup != NULL )
+        {
+            block_ChainAppend( &p_block,
+                transcode_video_encode( p_sys, id, p_dup, i_queued ) );
+            picture_Release( p_dup );
+        }
 
         vlc_mutex_lock( &p_sys->lock_out );
         block_ChainAppend( &p_sys->p_buffers, p_block );
-
-        vlc_mutex_unlock( &p_sys->lock_out );
-        picture_Release( p_pic );
+        for( int i = 0; i < id->i_renditions; i++ )
+        {
+            transcode_rendition_t *p_rend = &id->p_renditions[i];
+            block_ChainAppend( &p_rend->p_buffers, p_rend->p_blocks );
+            p_rend->p_blocks = NULL;
+        }
+        p_sys->i_frame_out++;
+        vlc_cond_signal( &p_sys->cond_space );
     }
+    vlc_mutex_unlock( &p_sys->lock_out );
 
     block_ChainRelease( p_sys->p_buffers );
 
@@ -135,6 +581,156 @@ static void* EncoderThread( void *obj )
     return NULL;
 }
 
+static void transcode_video_threads_stop( sout_stream_sys_t *p_sys,
+                                          int i_workers )
+{
+    vlc_mutex_lock( &p_sys->lock_out );
+    p_sys->b_abort = true;
+    vlc_cond_signal( &p_sys->cond );
+    vlc_cond_broadcast( &p_sys->cond_filter );
+    vlc_mutex_unlock( &p_sys->lock_out );
+
+    vlc_join( p_sys->thread, NULL );
+    for( int i = 0; i < i_workers; i++ )
+        vlc_join( p_sys->p_workers[i].thread, NULL );
+
+    vlc_mutex_destroy( &p_sys->lock_out );
+    vlc_cond_destroy( &p_sys->cond );
+    vlc_cond_destroy( &p_sys->cond_filter );
+    vlc_cond_destroy( &p_sys->cond_space );
+
+    for( unsigned i = 0; i < p_sys->i_frames; i++ )
+    {
+        if( p_sys->p_frames[i].p_pic != NULL )
+            picture_Release( p_sys->p_frames[i].p_pic );
+        if( p_sys->p_frames[i].p_dup != NULL )
+            picture_Release( p_sys->p_frames[i].p_dup );
+    }
+    free( p_sys->p_frames );
+    p_sys->p_frames = NULL;
+    free( p_sys->p_workers );
+    p_sys->p_workers = NULL;
+}
+
+static int transcode_video_threads_start( sout_stream_t *p_stream,
+                                          sout_stream_id_t *id )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    int i_priority = p_sys->b_high_priority ? VLC_THREAD_PRIORITY_OUTPUT :
+                       VLC_THREAD_PRIORITY_VIDEO;
+
+    /* Deinterlacing, user filters and overlays depend on the previous
+     * pictures, they cannot be spread over several threads */
+    if( p_sys->i_filter_threads > 1
+     && ( p_sys->b_deinterlace || p_sys->psz_vf2 || p_sys->p_spu
+       || p_sys->b_soverlay || p_sys->i_osdcodec || p_sys->psz_osdenc ) )
+    {
+        msg_Dbg( p_stream, "video filters are not independent, "
+                 "using one filter thread" );
+        p_sys->i_filter_threads = 1;
+    }
+
+    p_sys->i_frames = 4 * (1 + p_sys->i_filter_threads);
+    p_sys->p_frames = calloc( p_sys->i_frames, sizeof(*p_sys->p_frames) );
+    p_sys->p_workers = calloc( p_sys->i_filter_threads + 1,
+                               sizeof(*p_sys->p_workers) );
+    if( p_sys->p_frames == NULL || p_sys->p_workers == NULL )
+    {
+        free( p_sys->p_frames );
+        p_sys->p_frames = NULL;
+        free( p_sys->p_workers );
+        p_sys->p_workers = NULL;
+        return VLC_ENOMEM;
+    }
+
+    p_sys->id_video = id;
+    vlc_mutex_init( &p_sys->lock_out );
+    vlc_cond_init( &p_sys->cond );
+    vlc_cond_init( &p_sys->cond_filter );
+    vlc_cond_init( &p_sys->cond_space );
+    p_sys->p_buffers = NULL;
+    p_sys->b_abort = false;
+    p_sys->i_frame_in = p_sys->i_frame_filter = p_sys->i_frame_out = 0;
+    p_sys->i_filter_gen = 0;
+
+    if( vlc_clone( &p_sys->thread, EncoderThread, p_sys, i_priority ) )
+    {
+        msg_Err( p_stream, "cannot spawn encoder thread" );
+        vlc_mutex_destroy( &p_sys->lock_out );
+        vlc_cond_destroy( &p_sys->cond );
+        vlc_cond_destroy( &p_sys->cond_filter );
+        vlc_cond_destroy( &p_sys->cond_space );
+        free( p_sys->p_frames );
+        p_sys->p_frames = NULL;
+        free( p_sys->p_workers );
+        p_sys->p_workers = NULL;
+        return VLC_EGENERIC;
+    }
+
+    for( int i = 0; i < p_sys->i_filter_threads; i++ )
+    {
+        transcode_worker_t *p_worker = &p_sys->p_workers[i];
+
+        p_worker->p_stream = p_stream;
+        if( vlc_clone( &p_worker->thread, FilterThread, p_worker,
+                       i_priority ) )
+        {
+            msg_Err( p_stream, "cannot spawn filter thread" );
+            transcode_video_threads_stop( p_sys, i );
+            return VLC_EGENERIC;
+        }
+    }
+
+    if( p_sys->i_filter_threads > 0 )
+        msg_Dbg( p_stream, "video pipeline using %d filter thread(s)",
+                 p_sys->i_filter_threads );
+    return VLC_SUCCESS;
+}
+
+/* Queues a picture for the filter or the encoder thread, waiting for room
+ * in the ring, and collects the blocks encoded meanwhile */
+static void transcode_video_push( sout_stream_sys_t *p_sys, picture_t *p_pic,
+                                  picture_t *p_dup, mtime_t i_dup_date,
+                                  block_t **out )
+{
+    vlc_mutex_lock( &p_sys->lock_out );
+    while( p_sys->i_frame_in - p_sys->i_frame_out >= p_sys->i_frames )
+        vlc_cond_wait( &p_sys->cond_space, &p_sys->lock_out );
+
+    transcode_frame_t *p_frame =
+        &p_sys->p_frames[p_sys->i_frame_in++ % p_sys->i_frames];
+    p_frame->p_pic = p_pic;
+    p_frame->p_dup = p_dup;
+    p_frame->i_dup_date = i_dup_date;
+    p_frame->i_queued = mdate();
+    if( p_sys->i_filter_threads >= 1 )
+    {
+        p_frame->b_ready = false;
+        vlc_cond_signal( &p_sys->cond_filter );
+    }
+    else
+    {
+        p_frame->b_ready = true;
+        vlc_cond_signal( &p_sys->cond );
+    }
+
+    block_ChainAppend( out, p_sys->p_buffers );
+    p_sys->p_buffers = NULL;
+    vlc_mutex_unlock( &p_sys->lock_out );
+}
+
+/* Waits until all queued pictures are encoded */
+static void transcode_video_drain( sout_stream_sys_t *p_sys, block_t **out )
+{
+    vlc_mutex_lock( &p_sys->lock_out );
+    while( p_sys->i_frame_out != p_sys->i_frame_in )
+        vlc_cond_wait( &p_sys->cond_space, &p_sys->lock_out );
+
+    block_ChainAppend( out, p_sys->p_buffers );
+    p_sys->p_buffers = NULL;
+    vlc_mutex_unlock( &p_sys->lock_out );
+}
+
 int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_t *id )
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
@@ -223,41 +819,48 @@ int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_t *id )
     }
     id->p_encoder->p_module = NULL;
 
-    if( p_sys->i_threads >= 1 )
+    if( transcode_video_threaded( p_sys )
+     && transcode_video_threads_start( p_stream, id ) )
     {
-        int i_priority = p_sys->b_high_priority ? VLC_THREAD_PRIORITY_OUTPUT :
-                           VLC_THREAD_PRIORITY_VIDEO;
-        p_sys->id_video = id;
-        vlc_mutex_init( &p_sys->lock_out );
-        vlc_cond_init( &p_sys->cond );
-        p_sys->pp_pics = picture_fifo_New();
-        if( p_sys->pp_pics == NULL )
-        {
-            msg_Err( p_stream, "cannot create picture fifo" );
-            vlc_mutex_destroy( &p_sys->lock_out );
-            vlc_cond_destroy( &p_sys->cond );
-            module_unneed( id->p_decoder, id->p_decoder->p_module );
-            id->p_decoder->p_module = NULL;
-            free( id->p_decoder->p_owner );
-            return VLC_ENOMEM;
-        }
-        p_sys->p_buffers = NULL;
-        p_sys->b_abort = false;
-        if( vlc_clone( &p_sys->thread, EncoderThread, p_sys, i_priority ) )
-        {
-            msg_Err( p_stream, "cannot spawn encoder thread" );
-            vlc_mutex_destroy( &p_sys->lock_out );
-            vlc_cond_destroy( &p_sys->cond );
-            picture_fifo_Delete( p_sys->pp_pics );
-            module_unneed( id->p_decoder, id->p_decoder->p_module );
-            id->p_decoder->p_module = NULL;
-            free( id->p_decoder->p_owner );
-            return VLC_EGENERIC;
-        }
+        module_unneed( id->p_decoder, id->p_decoder->p_module );
+        id->p_decoder->p_module = NULL;
+        free( id->p_decoder->p_owner );
+        return VLC_EGENERIC;
     }
     return VLC_SUCCESS;
 }
 
+static void transcode_video_convert_append( filter_chain_t *p_chain,
+                                            sout_stream_id_t *id )
+{
+    /* Take care of the scaling and chroma conversions */
+    if( ( id->p_decoder->fmt_out.video.i_chroma !=
+          id->p_encoder->fmt_in.video.i_chroma ) ||
+        ( id->p_decoder->fmt_out.video.i_width !=
+          id->p_encoder->fmt_in.video.i_width ) ||
+        ( id->p_decoder->fmt_out.video.i_height !=
+          id->p_encoder->fmt_in.video.i_height ) )
+    {
+       filter_chain_AppendFilter( p_chain,
+                                  NULL, NULL,
+                                  &id->p_decoder->fmt_out,
+                                  &id->p_encoder->fmt_in );
+    }
+}
+
+static filter_chain_t *transcode_video_convert_new( sout_stream_t *p_stream,
+                                                    sout_stream_id_t *id )
+{
+    filter_chain_t *p_chain = filter_chain_New( p_stream, "video filter2",
+                                     false,
+                                     transcode_video_filter_allocation_init,
+                                     transcode_video_filter_allocation_clear,
+                                     p_stream->p_sys );
+    if( p_chain != NULL )
+        transcode_video_convert_append( p_chain, id );
+    return p_chain;
+}
+
 static void transcode_video_filter_init( sout_stream_t *p_stream,
                                          sout_stream_id_t *id )
 {
@@ -277,19 +880,7 @@ static void transcode_video_filter_init( sout_stream_t *p_stream,
                                   &id->p_decoder->fmt_out );
     }
 
-    /* Take care of the scaling and chroma conversions */
-    if( ( id->p_decoder->fmt_out.video.i_chroma !=
-          id->p_encoder->fmt_in.video.i_chroma ) ||
-        ( id->p_decoder->fmt_out.video.i_width !=
-          id->p_encoder->fmt_in.video.i_width ) ||
-        ( id->p_decoder->fmt_out.video.i_height !=
-          id->p_encoder->fmt_in.video.i_height ) )
-    {
-       filter_chain_AppendFilter( id->p_f_chain,
-                                  NULL, NULL,
-                                  &id->p_decoder->fmt_out,
-                                  &id->p_encoder->fmt_in );
-    }
+    transcode_video_convert_append( id->p_f_chain, id );
 
     if( p_stream->p_sys->psz_vf2 )
     {
@@ -532,20 +1123,17 @@ static int transcode_video_encoder_open( sout_stream_t *p_stream,
 void transcode_video_close( sout_stream_t *p_stream,
                                    sout_stream_id_t *id )
 {
-    if( p_stream->p_sys->i_threads >= 1 )
-    {
-        vlc_mutex_lock( &p_stream->p_sys->lock_out );
-        p_stream->p_sys->b_abort = true;
-        vlc_cond_signal( &p_stream->p_sys->cond );
-        vlc_mutex_unlock( &p_stream->p_sys->lock_out );
-
-        vlc_join( p_stream->p_sys->thread, NULL );
-        vlc_mutex_destroy( &p_stream->p_sys->lock_out );
-        vlc_cond_destroy( &p_stream->p_sys->cond );
-
-        picture_fifo_Delete( p_stream->p_sys->pp_pics );
-        p_stream->p_sys->pp_pics = NULL;
-    }
+    if( transcode_video_threaded( p_stream->p_sys ) )
+        transcode_video_threads_stop( p_stream->p_sys,
+                                      p_stream->p_sys->i_filter_threads );
+    transcode_video_stats( p_stream );
+
+    /* Close renditions */
+    for( int i = 0; i < id->i_renditions; i++ )
+        transcode_video_rendition_close( p_stream, &id->p_renditions[i] );
+    free( id->p_renditions );
+    id->p_renditions = NULL;
+    id->i_renditions = 0;
 
     /* Close decoder */
     if( id->p_decoder->p_module )
@@ -566,17 +1154,41 @@ void transcode_video_close( sout_stream_t *p_stream,
         filter_chain_Delete( id->p_uf_chain );
 }
 
+/* Advances the master sync clock past an encoded picture, and returns the
+ * date for a duplicate of that picture */
+static mtime_t transcode_video_sync_next( sout_stream_t *p_stream,
+                                          sout_stream_id_t *id, mtime_t i_date )
+{
+    mtime_t i_pts = date_Get( &id->interpolated_pts ) + 1;
+    mtime_t i_video_drift = i_date - i_pts;
+    if (unlikely ( i_video_drift  > MASTER_SYNC_MAX_DRIFT
+          || i_video_drift < -MASTER_SYNC_MAX_DRIFT ) )
+    {
+        msg_Dbg( p_stream,
+            "drift is too high (%"PRId64"), resetting master sync",
+            i_video_drift );
+        date_Set( &id->interpolated_pts, i_date );
+        i_pts = i_date + 1;
+    }
+    date_Increment( &id->interpolated_pts, 1 );
+    return i_pts;
+}
+
 int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_t *id,
                                     block_t *in, block_t **out )
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
     bool b_need_duplicate = false;
-    picture_t *p_pic, *p_pic2 = NULL;
+    picture_t *p_pic;
     *out = NULL;
 
     if( unlikely( in == NULL ) )
     {
-        if( p_sys->i_threads == 0 )
+        /* Let the threads encode the queued pictures first */
+        if( transcode_video_threaded( p_sys ) )
+            transcode_video_drain( p_sys, out );
+
+        if( id->p_encoder->p_module )
         {
             block_t *p_block;
             do {
@@ -584,19 +1196,27 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_t *id,
                 block_ChainAppend( out, p_block );
             } while( p_block );
         }
-        else
+
+        transcode_video_renditions_send( p_stream, id );
+        for( int i = 0; i < id->i_renditions; i++ )
         {
-            /*
-             * FIXME: we need EncoderThread() to flush buffers and signal us
-             * when it's done so we can send the last frames to the chain
-             */
+            transcode_rendition_t *p_rend = &id->p_renditions[i];
+            block_t *p_block, *p_out = NULL;
+            do {
+                p_block = p_rend->p_encoder->pf_encode_video(
+                                                p_rend->p_encoder, NULL );
+                block_ChainAppend( &p_out, p_block );
+            } while( p_block );
+            if( p_out != NULL )
+                sout_StreamIdSend( p_stream->p_next, p_rend->id, p_out );
         }
         return VLC_SUCCESS;
     }
 
 
-    while( (p_pic = id->p_decoder->pf_decode_video( id->p_decoder, &in )) )
+    while( (p_pic = transcode_video_decode( p_sys, id, &in )) )
     {
+        picture_t *p_dup = NULL;
 
         if( p_stream->p_sout->i_out_pace_nocontrol && p_sys->b_hurry_up )
         {
@@ -659,6 +1279,10 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_t *id,
                         p_sys->fmt_input_video.i_sar_num, id->p_decoder->fmt_out.video.i_sar_num,
                         p_sys->fmt_input_video.i_sar_den, id->p_decoder->fmt_out.video.i_sar_den
                     );
+            /* Let the threads finish with the current filters */
+            if( transcode_video_threaded( p_sys ) )
+                transcode_video_drain( p_sys, out );
+
             /* Close filters */
             if( id->p_f_chain )
                 filter_chain_Delete( id->p_f_chain );
@@ -675,6 +1299,18 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_t *id,
             transcode_video_encoder_init( p_stream, id );
             transcode_video_filter_init( p_stream, id );
             memcpy( &p_sys->fmt_input_video, &id->p_decoder->fmt_out.video, sizeof(video_format_t));
+
+            for( int i = 0; i < id->i_renditions; i++ )
+                if( transcode_video_rendition_chain( id,
+                                                 &id->p_renditions[i] ) )
+                    msg_Err( p_stream, "cannot scale rendition %d", i );
+
+            if( transcode_video_threaded( p_sys ) )
+            {
+                vlc_mutex_lock( &p_sys->lock_out );
+                p_sys->i_filter_gen++;
+                vlc_mutex_unlock( &p_sys->lock_out );
+            }
         }
 
 
@@ -692,17 +1328,31 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_t *id,
                 id->b_transcode = false;
                 return VLC_EGENERIC;
             }
+            transcode_video_renditions_open( p_stream, id );
         }
 
-        /* Run filter chain */
-        if( id->p_f_chain )
-            p_pic = filter_chain_VideoFilter( id->p_f_chain, p_pic );
-        if( !p_pic )
+        if( p_sys->i_filter_threads >= 1 )
+        {
+            /* The filter threads make the duplicate, only keep the master
+             * sync clock here */
+            mtime_t i_dup_date = VLC_TS_INVALID;
+
+            if( p_sys->b_master_sync )
+            {
+                mtime_t i_pts = transcode_video_sync_next( p_stream, id,
+                                                           p_pic->date );
+                if( unlikely( b_need_duplicate ) )
+                    i_dup_date = i_pts;
+            }
+            transcode_video_push( p_sys, p_pic, NULL, i_dup_date, out );
             continue;
+        }
 
-        /* Run user specified filter chain */
-        if( id->p_uf_chain )
-            p_pic = filter_chain_VideoFilter( id->p_uf_chain, p_pic );
+        mtime_t i_start = mdate();
+        p_pic = transcode_video_filter( p_sys, id, id->p_f_chain,
+                                        id->p_uf_chain, p_pic );
+        transcode_stage_account( &p_sys->stage[TRANSCODE_STAGE_FILTER],
+                                 mdate() - i_start, 0 );
         if( !p_pic )
             continue;
 
@@ -710,85 +1360,31 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_t *id,
          * Encoding
          */
 
-        /* Check if we have a subpicture to overlay */
-        if( p_sys->p_spu )
-        {
-            video_format_t fmt = id->p_encoder->fmt_in.video;
-            if( fmt.i_visible_width <= 0 || fmt.i_visible_height <= 0 )
-            {
-                fmt.i_visible_width  = fmt.i_width;
-                fmt.i_visible_height = fmt.i_height;
-                fmt.i_x_offset       = 0;
-                fmt.i_y_offset       = 0;
-            }
-
-            subpicture_t *p_subpic = spu_Render( p_sys->p_spu, NULL, &fmt, &fmt,
-                                                 p_pic->date, p_pic->date, false );
-
-            /* Overlay subpicture */
-            if( p_subpic )
-            {
-                if( picture_IsReferenced( p_pic ) && !filter_chain_GetLength( id->p_f_chain ) )
-                {
-                    /* We can't modify the picture, we need to duplicate it,
-                     * in this point the picture is already p_encoder->fmt.in format*/
-                    picture_t *p_tmp = video_new_buffer_encoder( id->p_encoder );
-                    if( likely( p_tmp ) )
-                    {
-                        picture_Copy( p_tmp, p_pic );
-                        picture_Release( p_pic );
-                        p_pic = p_tmp;
-                    }
-                }
-                if( unlikely( !p_sys->p_spu_blend ) )
-                    p_sys->p_spu_blend = filter_NewBlend( VLC_OBJECT( p_sys->p_spu ), &fmt );
-                if( likely( p_sys->p_spu_blend ) )
-                    picture_BlendSubpicture( p_pic, p_sys->p_spu_blend, p_subpic );
-                subpicture_Delete( p_subpic );
-            }
-        }
-
         if( p_sys->i_threads == 0 )
         {
             block_t *p_block;
 
-            p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
+            p_block = transcode_video_encode( p_sys, id, p_pic, 0 );
             block_ChainAppend( out, p_block );
         }
 
         if( p_sys->b_master_sync )
         {
-            mtime_t i_pts = date_Get( &id->interpolated_pts ) + 1;
-            mtime_t i_video_drift = p_pic->date - i_pts;
-            if (unlikely ( i_video_drift  > MASTER_SYNC_MAX_DRIFT
-                  || i_video_drift < -MASTER_SYNC_MAX_DRIFT ) )
-            {
-                msg_Dbg( p_stream,
-                    "drift is too high (%"PRId64"), resetting master sync",
-                    i_video_drift );
-                date_Set( &id->interpolated_pts, p_pic->date );
-                i_pts = p_pic->date + 1;
-            }
-            date_Increment( &id->interpolated_pts, 1 );
+            mtime_t i_pts = transcode_video_sync_next( p_stream, id,
+                                                       p_pic->date );
 
             if( unlikely( b_need_duplicate ) )
             {
 
                if( p_sys->i_threads >= 1 )
                {
-                   /* We can't modify the picture, we need to duplicate it */
-                   p_pic2 = video_new_buffer_encoder( id->p_encoder );
-                   if( likely( p_pic2 != NULL ) )
-                   {
-                       picture_Copy( p_pic2, p_pic );
-                       p_pic2->date = i_pts;
-                   }
+                   p_dup = transcode_video_duplicate( id, p_pic, i_pts );
                }
                else
                {
                    block_t *p_block;
                    p_pic->date = i_pts;
-                   p_block = id->p_encoder->pf_encode_video(id->p_encoder, p_pic);
+                   p_block = transcode_video_encode( p_sys, id, p_pic, 0 );
                    block_ChainAppend( out, p_block );
                }
            }
@@ -800,19 +1396,11 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_t *id,
         }
         else
         {
-            vlc_mutex_lock( &p_sys->lock_out );
-            picture_fifo_Push( p_sys->pp_pics, p_pic );
-            *out = p_sys->p_buffers;
-            p_sys->p_buffers = NULL;
-            if( p_pic2 != NULL )
-            {
-                picture_fifo_Push( p_sys->pp_pics, p_pic2 );
-            }
-            vlc_cond_signal( &p_sys->cond );
-            vlc_mutex_unlock( &p_sys->lock_out );
+            transcode_video_push( p_sys, p_pic, p_dup, VLC_TS_INVALID, out );
         }
     }
 
+    transcode_video_renditions_send( p_stream, id );
     return VLC_SUCCESS;
 }
 
@@ -0,0 +1,535 @@
+/*****************************************************************************
+ * yuv_rgb.c: SSSE3/AVX2 YUV to RGB conversions with colour matrix support
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#if defined(HAVE_SSSE3_INTRINSICS) && (defined(__i386__) || defined(__x86_64__))
+#   include <tmmintrin.h>
+#   define CAN_COMPILE_SSSE3_INTRINSICS 1
+#endif
+#if defined(HAVE_AVX2_INTRINSICS) && defined(VLC_CPU_AVX2)
+#   include <immintrin.h>
+#   define CAN_COMPILE_AVX2 1
+#endif
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+static int  Activate  ( vlc_object_t * );
+static void Deactivate( vlc_object_t * );
+
+#define MATRIX_TEXT N_("YUV to RGB matrix")
+#define MATRIX_LONGTEXT N_( \
+    "Colour matrix of the YUV pictures. Automatic uses ITU-R BT.709 for " \
+    "high definition pictures and BT.601 otherwise.")
+
+static const int pi_matrix_values[] = { 0, 601, 709 };
+static const char *const ppsz_matrix_descriptions[] =
+    { N_("Automatic"), N_("ITU-R BT.601"), N_("ITU-R BT.709") };
+
+vlc_module_begin ()
+    set_description( N_("SSSE3/AVX2 I420,YV12,J420,I422,J422,NV12 to "
+                        "RV15,RV16,RV24,RV32 conversions") )
+    set_capability( "video filter2", 130 )
+    set_category( CAT_VIDEO )
+    set_subcategory( SUBCAT_VIDEO_VFILTER )
+    add_integer( "yuv-rgb-matrix", 0, MATRIX_TEXT, MATRIX_LONGTEXT, true )
+        change_integer_list( pi_matrix_values, ppsz_matrix_descriptions )
+    set_callbacks( Activate, Deactivate )
+vlc_module_end ()
+
+/*****************************************************************************
+ * Conversion
+ *****************************************************************************
+ * All computations fit in 16 bits, with the semantics of the vector
+ * instructions:
+ *  Y' = (((Y << 8) * y_gain) >> 16) + y_offset             (unsigned)
+ *  U' = (U - 128) << 8, V' = (V - 128) << 8
+ *  R  = sat16(Y' + mulhrs(V', r_v)) >> 6
+ *  G  = sat16(Y' + mulhrs(U', g_u) + mulhrs(V', g_v)) >> 6
+ *  B  = sat16(Y' + mulhrs(U', b_u)) >> 6
+ * where mulhrs(a, b) = (a * b + (1 << 14)) >> 15. The gains have 14 (luma)
+ * and 13 (chroma) bits of fraction, Y' and the sums 6. y_offset holds the
+ * black level and the final rounding.
+ *****************************************************************************/
+typedef struct
+{
+    int16_t  i_y_gain;
+    int16_t  i_y_offset;
+    int16_t  i_r_v, i_g_u, i_g_v, i_b_u;
+
+    /* Packing of the R, G and B components into pixels */
+    uint8_t  pi_rshift[3];      /* bits dropped from each component */
+    uint8_t  pi_lshift[3];      /* position in the pixel */
+    uint32_t i_alpha;           /* bits set in all pixels */
+} yuv_rgb_t;
+
+typedef void (*yuv_rgb_line_t)( uint8_t *, const uint8_t *, const uint8_t *,
+                                const uint8_t *, unsigned, const yuv_rgb_t * );
+
+static inline int Sat16( int i )
+{
+    return VLC_CLIP( i, INT16_MIN, INT16_MAX );
+}
+
+static inline int MulHrs( int a, int b )
+{
+    return ( a * b + ( 1 << 14 ) ) >> 15;
+}
+
+static inline uint32_t YuvToPixel( const yuv_rgb_t *p, int y, int u, int v )
+{
+    const int i_y = ( ( y << 8 ) * (uint16_t)p->i_y_gain >> 16 )
+                  + p->i_y_offset;
+    const int i_u = ( u - 128 ) << 8, i_v = ( v - 128 ) << 8;
+    const int pi_rgb[3] = {
+        Sat16( i_y + MulHrs( i_v, p->i_r_v ) ) >> 6,
+        Sat16( i_y + MulHrs( i_u, p->i_g_u ) + MulHrs( i_v, p->i_g_v ) ) >> 6,
+        Sat16( i_y + MulHrs( i_u, p->i_b_u ) ) >> 6,
+    };
+    uint32_t i_pixel = p->i_alpha;
+
+    for( int i = 0; i < 3; i++ )
+        i_pixel |= (uint32_t)( clip_uint8_vlc( pi_rgb[i] ) >> p->pi_rshift[i] )
+                   << p->pi_lshift[i];
+    return i_pixel;
+}
+
+/* Converts a line of i_width pixels. Chroma is subsampled horizontally,
+ * either in two planes or interleaved in p_u. */
+static inline void LineC( uint8_t *p_dst, const uint8_t *p_y,
+                          const uint8_t *p_u, const uint8_t *p_v,
+                          unsigned i_width, const yuv_rgb_t *p,
+                          bool b_interleaved, unsigned i_pixel_size )
+{
+    for( unsigned x = 0; x < i_width; x++ )
+    {
+        const int u = b_interleaved ? p_u[x & ~1] : p_u[x / 2];
+        const int v = b_interleaved ? p_u[x | 1] : p_v[x / 2];
+        const uint32_t i_pixel = YuvToPixel( p, p_y[x], u, v );
+
+        switch( i_pixel_size )
+        {
+        case 2:
+            ((uint16_t *)p_dst)[x] = i_pixel;
+            break;
+        case 3:
+            p_dst[3 * x]     = i_pixel;
+            p_dst[3 * x + 1] = i_pixel >> 8;
+            p_dst[3 * x + 2] = i_pixel >> 16;
+            break;
+        default:
+            ((uint32_t *)p_dst)[x] = i_pixel;
+            break;
+        }
+    }
+}
+
+#ifdef CAN_COMPILE_SSSE3_INTRINSICS
+# define RENAME(a) a ## SSSE3
+# define VLC_TARGET VLC_SSSE3
+# define STEP 8
+# define vec_t __m128i
+# define VLOAD_Y(p)   _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(p)), \
+                                        _mm_setzero_si128())
+# define VLOAD_C(p)   LoadChromaSSSE3(p)
+# define VLOAD_CC(p)  VLOAD_Y(p)
+# define VSTORE16(p, v) _mm_storeu_si128((__m128i *)(p), v)
+# define VSTORE32(p, lo, hi) do { \
+    _mm_storeu_si128((__m128i *)(p), _mm_unpacklo_epi16(lo, hi)); \
+    _mm_storeu_si128((__m128i *)(p) + 1, _mm_unpackhi_epi16(lo, hi)); \
+} while (0)
+# define VSTORE24(p, lo, hi) do { \
+    const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, \
+                                       12, 13, 14, -1, -1, -1, -1); \
+    _mm_storeu_si128((__m128i *)(p), \
+                     _mm_shuffle_epi8(_mm_unpacklo_epi16(lo, hi), pack)); \
+    _mm_storeu_si128((__m128i *)((p) + 12), \
+                     _mm_shuffle_epi8(_mm_unpackhi_epi16(lo, hi), pack)); \
+} while (0)
+# define VSET16     _mm_set1_epi16
+# define VSET32     _mm_set1_epi32
+# define VADD16     _mm_add_epi16
+# define VSUB16     _mm_sub_epi16
+# define VADDS16    _mm_adds_epi16
+# define VAND       _mm_and_si128
+# define VOR        _mm_or_si128
+# define VSLLI16    _mm_slli_epi16
+# define VSRAI16    _mm_srai_epi16
+# define VSLLI32    _mm_slli_epi32
+# define VSRLI32    _mm_srli_epi32
+# define VSLL16     _mm_sll_epi16
+# define VSRL16     _mm_srl_epi16
+# define VMULHI_U16 _mm_mulhi_epu16
+# define VMULHRS16  _mm_mulhrs_epi16
+# define VMIN16     _mm_min_epi16
+# define VMAX16     _mm_max_epi16
+
+VLC_TARGET
+static inline __m128i LoadChromaSSSE3( const uint8_t *p )
+{
+    uint32_t i_chroma;
+
+    memcpy( &i_chroma, p, 4 );
+    return _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( i_chroma ),
+                                                  _mm_setzero_si128() ),
+                               _mm_setzero_si128() );
+}
+
+# include "yuv_rgb_simd.h"
+# undef VMAX16
+# undef VMIN16
+# undef VMULHRS16
+# undef VMULHI_U16
+# undef VSRL16
+# undef VSLL16
+# undef VSRLI32
+# undef VSLLI32
+# undef VSRAI16
+# undef VSLLI16
+# undef VOR
+# undef VAND
+# undef VADDS16
+# undef VSUB16
+# undef VADD16
+# undef VSET32
+# undef VSET16
+# undef VSTORE24
+# undef VSTORE32
+# undef VSTORE16
+# undef VLOAD_CC
+# undef VLOAD_C
+# undef VLOAD_Y
+# undef vec_t
+# undef STEP
+# undef VLC_TARGET
+# undef RENAME
+#endif
+
+#ifdef CAN_COMPILE_AVX2
+# define RENAME(a) a ## AVX2
+# define VLC_TARGET VLC_AVX2
+# define STEP 16
+# define vec_t __m256i
+# define VLOAD_Y(p)   _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(p)))
+# define VLOAD_C(p)   _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(p)))
+# define VLOAD_CC(p)  VLOAD_Y(p)
+/* The unpacks work within 128 bits lanes, which hold pixels 0-7 and 8-15 */
+# define VSTORE16(p, v) _mm256_storeu_si256((__m256i *)(p), v)
+# define VSTORE32(p, lo, hi) do { \
+    const __m256i a = _mm256_unpacklo_epi16(lo, hi); \
+    const __m256i b = _mm256_unpackhi_epi16(lo, hi); \
+    _mm256_storeu_si256((__m256i *)(p), _mm256_permute2x128_si256(a, b, 0x20)); \
+    _mm256_storeu_si256((__m256i *)(p) + 1, _mm256_permute2x128_si256(a, b, 0x31)); \
+} while (0)
+# define VSTORE24(p, lo, hi) do { \
+    const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, \
+                                          12, 13, 14, -1, -1, -1, -1, \
+                                          0, 1, 2, 4, 5, 6, 8, 9, 10, \
+                                          12, 13, 14, -1, -1, -1, -1); \
+    const __m256i a = _mm256_shuffle_epi8(_mm256_unpacklo_epi16(lo, hi), pack); \
+    const __m256i b = _mm256_shuffle_epi8(_mm256_unpackhi_epi16(lo, hi), pack); \
+    _mm_storeu_si128((__m128i *)(p), _mm256_castsi256_si128(a)); \
+    _mm_storeu_si128((__m128i *)((p) + 12), _mm256_castsi256_si128(b)); \
+    _mm_storeu_si128((__m128i *)((p) + 24), _mm256_extracti128_si256(a, 1)); \
+    _mm_storeu_si128((__m128i *)((p) + 36), _mm256_extracti128_si256(b, 1)); \
+} while (0)
+# define VSET16     _mm256_set1_epi16
+# define VSET32     _mm256_set1_epi32
+# define VADD16     _mm256_add_epi16
+# define VSUB16     _mm256_sub_epi16
+# define VADDS16    _mm256_adds_epi16
+# define VAND       _mm256_and_si256
+# define VOR        _mm256_or_si256
+# define VSLLI16    _mm256_slli_epi16
+# define VSRAI16    _mm256_srai_epi16
+# define VSLLI32    _mm256_slli_epi32
+# define VSRLI32    _mm256_srli_epi32
+# define VSLL16     _mm256_sll_epi16
+# define VSRL16     _mm256_srl_epi16
+# define VMULHI_U16 _mm256_mulhi_epu16
+# define VMULHRS16  _mm256_mulhrs_epi16
+# define VMIN16     _mm256_min_epi16
+# define VMAX16     _mm256_max_epi16
+# include "yuv_rgb_simd.h"
+# undef VMAX16
+# undef VMIN16
+# undef VMULHRS16
+# undef VMULHI_U16
+# undef VSRL16
+# undef VSLL16
+# undef VSRLI32
+# undef VSLLI32
+# undef VSRAI16
+# undef VSLLI16
+# undef VOR
+# undef VAND
+# undef VADDS16
+# undef VSUB16
+# undef VADD16
+# undef VSET32
+# undef VSET16
+# undef VSTORE24
+# undef VSTORE32
+# undef VSTORE16
+# undef VLOAD_CC
+# undef VLOAD_C
+# undef VLOAD_Y
+# undef vec_t
+# undef STEP
+# undef VLC_TARGET
+# undef RENAME
+#endif
+
+static int Fixed( double f, int i_bits )
+{
+    f *= 1 << i_bits;
+    return f < 0. ? (int)( f - .5 ) : (int)( f + .5 );
+}
+
+/* Sets the conversion coefficients of a colour matrix and range */
+static void SetMatrix( yuv_rgb_t *p, bool b_bt709, bool b_full_range )
+{
+    const double kr = b_bt709 ? .2126 : .299;
+    const double kb = b_bt709 ? .0722 : .114;
+    const double kg = 1. - kr - kb;
+    const double y_gain = b_full_range ? 1. : 255. / 219.;
+    const double c_gain = b_full_range ? 1. : 255. / 224.;
+    const int i_black = b_full_range ? 0 : 16;
+
+    p->i_y_gain   = Fixed( y_gain, 14 );
+    p->i_y_offset = 32 - Fixed( i_black * y_gain, 6 );
+    p->i_r_v = Fixed( 2. * ( 1. - kr ) * c_gain, 13 );
+    p->i_g_u = Fixed( -2. * ( 1. - kb ) * kb / kg * c_gain, 13 );
+    p->i_g_v = Fixed( -2. * ( 1. - kr ) * kr / kg * c_gain, 13 );
+    p->i_b_u = Fixed( 2. * ( 1. - kb ) * c_gain, 13 );
+}
+
+/* Sets the packing of the pixels from the RGB masks, which must not have
+ * more than 8 bits each. The alpha bits of 32 bits pixels are set. */
+static int SetPacking( yuv_rgb_t *p, const video_format_t *p_fmt,
+                       unsigned i_pixel_size )
+{
+    video_format_t fmt = *p_fmt;
+    video_format_FixRgb( &fmt );
+
+    const uint32_t pi_mask[3] = { fmt.i_rmask, fmt.i_gmask, fmt.i_bmask };
+    const int pi_rshift[3] = { fmt.i_rrshift, fmt.i_rgshift, fmt.i_rbshift };
+    const int pi_lshift[3] = { fmt.i_lrshift, fmt.i_lgshift, fmt.i_lbshift };
+
+    p->i_alpha = i_pixel_size == 4 ? 0xffffffff : 0;
+    for( int i = 0; i < 3; i++ )
+    {
+        if( pi_mask[i] == 0 || pi_rshift[i] < 0 || pi_rshift[i] > 7 ||
+            pi_lshift[i] + 8 - pi_rshift[i] > 8 * (int)i_pixel_size )
+            return VLC_EGENERIC;
+        p->pi_rshift[i] = pi_rshift[i];
+        p->pi_lshift[i] = pi_lshift[i];
+        p->i_alpha &= ~pi_mask[i];
+    }
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Filter
+ *****************************************************************************/
+struct filter_sys_t
+{
+    yuv_rgb_t      conv;
+    yuv_rgb_line_t pf_line;
+    unsigned       i_pixel_size;
+    int            i_u_plane, i_v_plane;
+    unsigned       i_chroma_shift;  /* vertical chroma subsampling */
+};
+
+typedef struct
+{
+    const picture_t *p_src;
+    picture_t       *p_dst;
+} yuv_rgb_slice_t;
+
+static void ConvertSlice( filter_t *p_filter, void *p_data,
+                          unsigned i_slice, unsigned i_slices )
+{
+    const filter_sys_t *p_sys = p_filter->p_sys;
+    const yuv_rgb_slice_t *p_slice = p_data;
+    const unsigned i_width = p_filter->fmt_in.video.i_width;
+    const unsigned i_height = p_filter->fmt_in.video.i_height;
+    /* Bands hold pairs of lines, which share a chroma line in 4:2:0 */
+    const unsigned i_pairs = ( i_height + 1 ) / 2;
+    const unsigned i_end = __MIN( i_height, 2 * filter_SliceRow( i_slice + 1,
+                                                                  i_slices,
+                                                                  i_pairs ) );
+    const plane_t *p_y = &p_slice->p_src->p[Y_PLANE];
+    const plane_t *p_u = &p_slice->p_src->p[p_sys->i_u_plane];
+    const plane_t *p_v = &p_slice->p_src->p[p_sys->i_v_plane];
+    const plane_t *p_out = &p_slice->p_dst->p[0];
+
+    for( unsigned y = 2 * filter_SliceRow( i_slice, i_slices, i_pairs );
+         y < i_end; y++ )
+    {
+        const unsigned i_cy = y >> p_sys->i_chroma_shift;
+
+        p_sys->pf_line( &p_out->p_pixels[y * p_out->i_pitch],
+                        &p_y->p_pixels[y * p_y->i_pitch],
+                        &p_u->p_pixels[i_cy * p_u->i_pitch],
+                        &p_v->p_pixels[i_cy * p_v->i_pitch],
+                        i_width, &p_sys->conv );
+    }
+}
+
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+
+    if( !p_pic )
+        return NULL;
+
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    yuv_rgb_slice_t slice = { .p_src = p_pic, .p_dst = p_outpic };
+    filter_RunSlices( p_filter, p_filter->fmt_in.video.i_height / 16,
+                      ConvertSlice, &slice );
+
+    picture_CopyProperties( p_outpic, p_pic );
+    picture_Release( p_pic );
+    return p_outpic;
+}
+
+/*****************************************************************************
+ * Activate: allocate a chroma function
+ *****************************************************************************/
+static int Activate( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    const video_format_t *p_in = &p_filter->fmt_in.video;
+    const video_format_t *p_out = &p_filter->fmt_out.video;
+    const yuv_rgb_line_t (*lines)[3];
+    filter_sys_t *p_sys;
+
+#if defined(CAN_COMPILE_AVX2)
+    if( vlc_CPU_AVX2() )
+        lines = linesAVX2;
+    else
+#endif
+#if defined(CAN_COMPILE_SSSE3_INTRINSICS)
+    if( vlc_CPU_SSSE3() )
+        lines = linesSSSE3;
+    else
+#endif
+        return VLC_EGENERIC; /* the i420_rgb modules cover the others */
+
+    if( p_in->i_width != p_out->i_width ||
+        p_in->i_height != p_out->i_height )
+        return VLC_EGENERIC;
+
+    p_sys = malloc( sizeof(*p_sys) );
+    if( !p_sys )
+        return VLC_ENOMEM;
+
+    bool b_full_range = false, b_interleaved = false;
+    p_sys->i_u_plane = U_PLANE;
+    p_sys->i_v_plane = V_PLANE;
+    p_sys->i_chroma_shift = 1;
+
+    switch( p_in->i_chroma )
+    {
+        case VLC_CODEC_J420:
+            b_full_range = true;
+            /* fall through */
+        case VLC_CODEC_I420:
+            break;
+        case VLC_CODEC_YV12:
+            p_sys->i_u_plane = V_PLANE;
+            p_sys->i_v_plane = U_PLANE;
+            break;
+        case VLC_CODEC_J422:
+            b_full_range = true;
+            /* fall through */
+        case VLC_CODEC_I422:
+            p_sys->i_chroma_shift = 0;
+            break;
+        case VLC_CODEC_NV12:
+            p_sys->i_u_plane = p_sys->i_v_plane = 1;
+            b_interleaved = true;
+            break;
+        default:
+            goto error;
+    }
+
+    switch( p_out->i_chroma )
+    {
+        case VLC_CODEC_RGB15:
+        case VLC_CODEC_RGB16:
+            p_sys->i_pixel_size = 2;
+            break;
+        case VLC_CODEC_RGB24:
+            p_sys->i_pixel_size = 3;
+            break;
+        case VLC_CODEC_RGB32:
+            p_sys->i_pixel_size = 4;
+            break;
+        default:
+            goto error;
+    }
+    if( SetPacking( &p_sys->conv, p_out, p_sys->i_pixel_size ) )
+        goto error;
+
+    int i_matrix = var_InheritInteger( p_filter, "yuv-rgb-matrix" );
+    if( i_matrix != 601 && i_matrix != 709 )
+        i_matrix = p_in->i_height > 576 ? 709 : 601;
+    SetMatrix( &p_sys->conv, i_matrix == 709, b_full_range );
+
+    p_sys->pf_line = lines[b_interleaved][p_sys->i_pixel_size - 2];
+    p_filter->p_sys = p_sys;
+    p_filter->pf_video_filter = Filter;
+
+    msg_Dbg( p_filter, "%4.4s to %4.4s, BT.%d %s range",
+             (const char *)&p_in->i_chroma, (const char *)&p_out->i_chroma,
+             i_matrix, b_full_range ? "full" : "limited" );
+    return VLC_SUCCESS;
+
+error:
+    free( p_sys );
+    return VLC_EGENERIC;
+}
+
+static void Deactivate( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    free( p_filter->p_sys );
+}
@@ -0,0 +1,132 @@
+/*****************************************************************************
+ * yuv_rgb_simd.h: YUV to RGB line conversions on vector intrinsics
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* The LineC() conversion of yuv_rgb.c, written once for any vector unit.
+ * Every operation has the 16 bits lanes semantics that LineC() emulates,
+ * so results are bit-exact with the C code.
+ *
+ * The including file defines:
+ *  RENAME(a), VLC_TARGET, STEP (pixels per vector), vec_t,
+ *  VLOAD_Y(p) (STEP luma bytes, as words), VLOAD_C(p) (STEP / 2 chroma
+ *  bytes, as dwords), VLOAD_CC(p) (STEP / 2 interleaved chroma pairs, as
+ *  dwords), VSTORE16(p, v), VSTORE32(p, lo, hi) and VSTORE24(p, lo, hi)
+ *  (pixels from their low and high words, the latter writing 4 bytes past
+ *  the last one), VSET16, VSET32, and the VADD16, VSUB16, VADDS16, VAND,
+ *  VOR, VSLLI16, VSRAI16, VSLLI32, VSRLI32, VSLL16, VSRL16 (by a count
+ *  vector), VMULHI_U16, VMULHRS16, VMIN16 and VMAX16 operations. */
+
+VLC_TARGET
+static inline void RENAME(Line)(uint8_t *p_dst, const uint8_t *p_y,
+                                const uint8_t *p_u, const uint8_t *p_v,
+                                unsigned i_width, const yuv_rgb_t *p,
+                                bool b_interleaved, unsigned i_pixel_size)
+{
+    const vec_t y_gain   = VSET16(p->i_y_gain);
+    const vec_t y_offset = VSET16(p->i_y_offset);
+    const vec_t r_v = VSET16(p->i_r_v), g_u = VSET16(p->i_g_u);
+    const vec_t g_v = VSET16(p->i_g_v), b_u = VSET16(p->i_b_u);
+    const vec_t c128 = VSET16(128), zero = VSET16(0), max = VSET16(255);
+    const vec_t alpha_lo = VSET16(p->i_alpha & 0xffff);
+    const vec_t alpha_hi = VSET16(p->i_alpha >> 16);
+    __m128i rshift[3], lshift_lo[3], lshift_hi[3];
+
+    /* Shifting words by 16 or more clears them */
+    for (int i = 0; i < 3; i++) {
+        rshift[i]    = _mm_cvtsi32_si128(p->pi_rshift[i]);
+        lshift_lo[i] = _mm_cvtsi32_si128(p->pi_lshift[i] < 16
+                                         ? p->pi_lshift[i] : 16);
+        lshift_hi[i] = _mm_cvtsi32_si128(p->pi_lshift[i] >= 16
+                                         ? p->pi_lshift[i] - 16 : 16);
+    }
+
+    /* The 24 bits stores overwrite 4 bytes after the STEP pixels */
+    const unsigned i_end = i_pixel_size != 3 ? i_width
+                         : i_width > 2 ? i_width - 2 : 0;
+    unsigned x;
+
+    for (x = 0; x + STEP <= i_end; x += STEP) {
+        vec_t u, v;
+
+        if (b_interleaved) {
+            const vec_t uv = VLOAD_CC(&p_u[x]);
+            u = VAND(uv, VSET32(0xffff));
+            v = VSRLI32(uv, 16);
+        } else {
+            u = VLOAD_C(&p_u[x / 2]);
+            v = VLOAD_C(&p_v[x / 2]);
+        }
+        /* Each chroma sample covers two pixels */
+        u = VSLLI16(VSUB16(VOR(u, VSLLI32(u, 16)), c128), 8);
+        v = VSLLI16(VSUB16(VOR(v, VSLLI32(v, 16)), c128), 8);
+
+        const vec_t y = VADD16(VMULHI_U16(VSLLI16(VLOAD_Y(&p_y[x]), 8),
+                                          y_gain), y_offset);
+        vec_t r = VSRAI16(VADDS16(y, VMULHRS16(v, r_v)), 6);
+        vec_t g = VSRAI16(VADDS16(y, VADD16(VMULHRS16(u, g_u),
+                                            VMULHRS16(v, g_v))), 6);
+        vec_t b = VSRAI16(VADDS16(y, VMULHRS16(u, b_u)), 6);
+
+        r = VSRL16(VMIN16(VMAX16(r, zero), max), rshift[0]);
+        g = VSRL16(VMIN16(VMAX16(g, zero), max), rshift[1]);
+        b = VSRL16(VMIN16(VMAX16(b, zero), max), rshift[2]);
+
+        const vec_t lo = VOR(VOR(VSLL16(r, lshift_lo[0]),
+                                 VSLL16(g, lshift_lo[1])),
+                             VOR(VSLL16(b, lshift_lo[2]), alpha_lo));
+        if (i_pixel_size == 2) {
+            VSTORE16(&p_dst[2 * x], lo);
+            continue;
+        }
+
+        const vec_t hi = VOR(VOR(VSLL16(r, lshift_hi[0]),
+                                 VSLL16(g, lshift_hi[1])),
+                             VOR(VSLL16(b, lshift_hi[2]), alpha_hi));
+        if (i_pixel_size == 4)
+            VSTORE32(&p_dst[4 * x], lo, hi);
+        else
+            VSTORE24(&p_dst[3 * x], lo, hi);
+    }
+
+    if (x < i_width)
+        LineC(&p_dst[x * i_pixel_size], &p_y[x],
+              &p_u[b_interleaved ? x : x / 2], &p_v[x / 2],
+              i_width - x, p, b_interleaved, i_pixel_size);
+}
+
+#define LINE(name, interleaved, size) \
+VLC_TARGET \
+static void RENAME(name)(uint8_t *p_dst, const uint8_t *p_y, \
+                         const uint8_t *p_u, const uint8_t *p_v, \
+                         unsigned i_width, const yuv_rgb_t *p) \
+{ \
+    RENAME(Line)(p_dst, p_y, p_u, p_v, i_width, p, interleaved, size); \
+}
+LINE(Planar16, false, 2)
+LINE(Planar24, false, 3)
+LINE(Planar32, false, 4)
+LINE(SemiPlanar16, true, 2)
+LINE(SemiPlanar24, true, 3)
+LINE(SemiPlanar32, true, 4)
+#undef LINE
+
+static const yuv_rgb_line_t RENAME(lines)[2][3] = {
+    { RENAME(Planar16), RENAME(Planar24), RENAME(Planar32) },
+    { RENAME(SemiPlanar16), RENAME(SemiPlanar24), RENAME(SemiPlanar32) },
+};
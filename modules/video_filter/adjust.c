@@ -175,6 +175,14 @@ static int Create( vlc_object_t *p_this )
             p_sys->pf_process_sat_hue = planar_sat_hue_C;
             break;
 
+        case VLC_CODEC_NV12:
+        case VLC_CODEC_NV21:
+            /* Semi-planar YUV 4:2:0, as output by hardware decoders */
+            p_filter->pf_video_filter = FilterPlanar;
+            p_sys->pf_process_sat_hue_clip = semiplanar_sat_hue_clip_C;
+            p_sys->pf_process_sat_hue = semiplanar_sat_hue_C;
+            break;
+
         CASE_PACKED_YUV_422
             /* Packed YUV 4:2:2 */
             p_filter->pf_video_filter = FilterPacked;
@@ -223,20 +231,114 @@ static void Destroy( vlc_object_t *p_this )
 /*****************************************************************************
  * Run the filter on a Planar YUV picture
  *****************************************************************************/
+typedef struct
+{
+    picture_t *p_pic;
+    picture_t *p_outpic;
+    const int *pi_luma;
+    int i_sin, i_cos, i_sat, i_x, i_y;
+} adjust_slice_t;
+
+/* Narrows the planes of a picture down to a band of rows */
+static void SlicePicture( picture_t *p_view, const picture_t *p_pic,
+                          unsigned i_slice, unsigned i_slices )
+{
+    *p_view = *p_pic;
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        plane_t *p = &p_view->p[i];
+        const unsigned i_first = filter_SliceRow( i_slice, i_slices,
+                                                  p->i_visible_lines );
+        const unsigned i_last = filter_SliceRow( i_slice + 1, i_slices,
+                                                 p->i_visible_lines );
+        p->p_pixels += i_first * p->i_pitch;
+        p->i_lines = p->i_visible_lines = i_last - i_first;
+    }
+}
+
+static void FilterPlanarSlice( filter_t *p_filter, void *p_data,
+                               unsigned i_slice, unsigned i_slices )
+{
+    const adjust_slice_t *p_slice = p_data;
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const int *pi_luma = p_slice->pi_luma;
+    picture_t pic, outpic;
+    uint8_t *p_in, *p_in_end, *p_line_end;
+    uint8_t *p_out;
+
+    SlicePicture( &pic, p_slice->p_pic, i_slice, i_slices );
+    SlicePicture( &outpic, p_slice->p_outpic, i_slice, i_slices );
+
+    /*
+     * Do the Y plane
+     */
+
+    p_in = pic.p[Y_PLANE].p_pixels;
+    p_in_end = p_in + pic.p[Y_PLANE].i_visible_lines
+                      * pic.p[Y_PLANE].i_pitch - 8;
+
+    p_out = outpic.p[Y_PLANE].p_pixels;
+
+    for( ; p_in < p_in_end ; )
+    {
+        p_line_end = p_in + pic.p[Y_PLANE].i_visible_pitch - 8;
+
+        for( ; p_in < p_line_end ; )
+        {
+            /* Do 8 pixels at a time */
+            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+        }
+
+        p_line_end += 8;
+
+        for( ; p_in < p_line_end ; )
+        {
+            *p_out++ = pi_luma[ *p_in++ ];
+        }
+
+        p_in += pic.p[Y_PLANE].i_pitch
+              - pic.p[Y_PLANE].i_visible_pitch;
+        p_out += outpic.p[Y_PLANE].i_pitch
+               - outpic.p[Y_PLANE].i_visible_pitch;
+    }
+
+    /*
+     * Do the U and V planes
+     */
+
+    if ( p_slice->i_sat > 256 )
+    {
+        /* Currently no errors are implemented in the function, if any are added
+         * check them here */
+        p_sys->pf_process_sat_hue_clip( &pic, &outpic, p_slice->i_sin,
+                                        p_slice->i_cos, p_slice->i_sat,
+                                        p_slice->i_x, p_slice->i_y );
+    }
+    else
+    {
+        /* Currently no errors are implemented in the function, if any are added
+         * check them here */
+        p_sys->pf_process_sat_hue( &pic, &outpic, p_slice->i_sin,
+                                   p_slice->i_cos, p_slice->i_sat,
+                                   p_slice->i_x, p_slice->i_y );
+    }
+}
+
 static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
 {
     int pi_luma[256];
     int pi_gamma[256];
 
     picture_t *p_outpic;
-    uint8_t *p_in, *p_in_end, *p_line_end;
-    uint8_t *p_out;
 
     bool b_thres;
     double  f_hue;
     double  f_gamma;
     int32_t i_cont, i_lum;
-    int i_sat, i_sin, i_cos, i_x, i_y;
+    int i_sat;
     int i;
 
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -299,66 +401,19 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
         i_sat = 0;
     }
 
-    /*
-     * Do the Y plane
-     */
-
-    p_in = p_pic->p[Y_PLANE].p_pixels;
-    p_in_end = p_in + p_pic->p[Y_PLANE].i_visible_lines
-                      * p_pic->p[Y_PLANE].i_pitch - 8;
-
-    p_out = p_outpic->p[Y_PLANE].p_pixels;
-
-    for( ; p_in < p_in_end ; )
-    {
-        p_line_end = p_in + p_pic->p[Y_PLANE].i_visible_pitch - 8;
-
-        for( ; p_in < p_line_end ; )
-        {
-            /* Do 8 pixels at a time */
-            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-        }
-
-        p_line_end += 8;
-
-        for( ; p_in < p_line_end ; )
-        {
-            *p_out++ = pi_luma[ *p_in++ ];
-        }
-
-        p_in += p_pic->p[Y_PLANE].i_pitch
-              - p_pic->p[Y_PLANE].i_visible_pitch;
-        p_out += p_outpic->p[Y_PLANE].i_pitch
-               - p_outpic->p[Y_PLANE].i_visible_pitch;
-    }
-
-    /*
-     * Do the U and V planes
-     */
-
-    i_sin = sin(f_hue) * 256;
-    i_cos = cos(f_hue) * 256;
-
-    i_x = ( cos(f_hue) + sin(f_hue) ) * 32768;
-    i_y = ( cos(f_hue) - sin(f_hue) ) * 32768;
-
-    if ( i_sat > 256 )
-    {
-        /* Currently no errors are implemented in the function, if any are added
-         * check them here */
-        p_sys->pf_process_sat_hue_clip( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y );
-    }
-    else
-    {
-        /* Currently no errors are implemented in the function, if any are added
-         * check them here */
-        p_sys->pf_process_sat_hue( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y );
-    }
+    adjust_slice_t slice = {
+        .p_pic = p_pic,
+        .p_outpic = p_outpic,
+        .pi_luma = pi_luma,
+        .i_sin = sin(f_hue) * 256,
+        .i_cos = cos(f_hue) * 256,
+        .i_sat = i_sat,
+        .i_x = ( cos(f_hue) + sin(f_hue) ) * 32768,
+        .i_y = ( cos(f_hue) - sin(f_hue) ) * 32768,
+    };
+
+    filter_RunSlices( p_filter, p_pic->p[U_PLANE].i_visible_lines / 8,
+                      FilterPlanarSlice, &slice );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
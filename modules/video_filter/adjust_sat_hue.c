@@ -62,6 +62,24 @@
                        * i_sat) >> 8) + 128; \
     p_out_v += 4
 
+#define SEMIPLANAR_WRITE_UV_CLIP() \
+    i_u = *p_in; p_in += 2; i_v = *p_in_v; p_in_v += 2; \
+    *p_out = clip_uint8_vlc( (( ((i_u * i_cos + i_v * i_sin - i_x) >> 8) \
+                           * i_sat) >> 8) + 128); \
+    p_out += 2; \
+    *p_out_v = clip_uint8_vlc( (( ((i_v * i_cos - i_u * i_sin - i_y) >> 8) \
+                           * i_sat) >> 8) + 128); \
+    p_out_v += 2
+
+#define SEMIPLANAR_WRITE_UV() \
+    i_u = *p_in; p_in += 2; i_v = *p_in_v; p_in_v += 2; \
+    *p_out = (( ((i_u * i_cos + i_v * i_sin - i_x) >> 8) \
+                       * i_sat) >> 8) + 128; \
+    p_out += 2; \
+    *p_out_v = (( ((i_v * i_cos - i_u * i_sin - i_y) >> 8) \
+                       * i_sat) >> 8) + 128; \
+    p_out_v += 2
+
 #define ADJUST_2_TIMES(x) x; x
 #define ADJUST_4_TIMES(x) x; x; x; x
 #define ADJUST_8_TIMES(x) x; x; x; x; x; x; x; x
@@ -162,6 +180,102 @@ int planar_sat_hue_C( picture_t * p_pic, picture_t * p_outpic, int i_sin, int i_
     return VLC_SUCCESS;
 }
 
+int semiplanar_sat_hue_clip_C( picture_t * p_pic, picture_t * p_outpic,
+                               int i_sin, int i_cos, int i_sat, int i_x,
+                               int i_y )
+{
+    uint8_t *p_in, *p_in_v, *p_in_end, *p_line_end;
+    uint8_t *p_out, *p_out_v;
+
+    /* U and V alternate in the second plane, V first for NV21 */
+    const int i_u_offset = p_pic->format.i_chroma == VLC_CODEC_NV21;
+    const int i_v_offset = 1 - i_u_offset;
+    const plane_t *p_plane = &p_pic->p[1];
+    const plane_t *p_outplane = &p_outpic->p[1];
+
+    p_in = p_plane->p_pixels + i_u_offset;
+    p_in_v = p_plane->p_pixels + i_v_offset;
+    p_in_end = p_in + p_plane->i_visible_lines * p_plane->i_pitch - 8 * 2;
+
+    p_out = p_outplane->p_pixels + i_u_offset;
+    p_out_v = p_outplane->p_pixels + i_v_offset;
+
+    uint8_t i_u, i_v;
+
+    for( ; p_in < p_in_end ; )
+    {
+        p_line_end = p_in + p_plane->i_visible_pitch - 8 * 2;
+
+        for( ; p_in < p_line_end ; )
+        {
+            /* Do 8 pixels at a time */
+            ADJUST_8_TIMES( SEMIPLANAR_WRITE_UV_CLIP() );
+        }
+
+        p_line_end += 8 * 2;
+
+        for( ; p_in < p_line_end ; )
+        {
+            SEMIPLANAR_WRITE_UV_CLIP();
+        }
+
+        p_in += p_plane->i_pitch - p_plane->i_visible_pitch;
+        p_in_v += p_plane->i_pitch - p_plane->i_visible_pitch;
+        p_out += p_outplane->i_pitch - p_outplane->i_visible_pitch;
+        p_out_v += p_outplane->i_pitch - p_outplane->i_visible_pitch;
+    }
+
+    return VLC_SUCCESS;
+}
+
+int semiplanar_sat_hue_C( picture_t * p_pic, picture_t * p_outpic,
+                          int i_sin, int i_cos, int i_sat, int i_x,
+                          int i_y )
+{
+    uint8_t *p_in, *p_in_v, *p_in_end, *p_line_end;
+    uint8_t *p_out, *p_out_v;
+
+    /* U and V alternate in the second plane, V first for NV21 */
+    const int i_u_offset = p_pic->format.i_chroma == VLC_CODEC_NV21;
+    const int i_v_offset = 1 - i_u_offset;
+    const plane_t *p_plane = &p_pic->p[1];
+    const plane_t *p_outplane = &p_outpic->p[1];
+
+    p_in = p_plane->p_pixels + i_u_offset;
+    p_in_v = p_plane->p_pixels + i_v_offset;
+    p_in_end = p_in + p_plane->i_visible_lines * p_plane->i_pitch - 8 * 2;
+
+    p_out = p_outplane->p_pixels + i_u_offset;
+    p_out_v = p_outplane->p_pixels + i_v_offset;
+
+    uint8_t i_u, i_v;
+
+    for( ; p_in < p_in_end ; )
+    {
+        p_line_end = p_in + p_plane->i_visible_pitch - 8 * 2;
+
+        for( ; p_in < p_line_end ; )
+        {
+            /* Do 8 pixels at a time */
+            ADJUST_8_TIMES( SEMIPLANAR_WRITE_UV() );
+        }
+
+        p_line_end += 8 * 2;
+
+        for( ; p_in < p_line_end ; )
+        {
+            SEMIPLANAR_WRITE_UV();
+        }
+
+        p_in += p_plane->i_pitch - p_plane->i_visible_pitch;
+        p_in_v += p_plane->i_pitch - p_plane->i_visible_pitch;
+        p_out += p_outplane->i_pitch - p_outplane->i_visible_pitch;
+        p_out_v += p_outplane->i_pitch - p_outplane->i_visible_pitch;
+    }
+
+    return VLC_SUCCESS;
+}
+
 int packed_sat_hue_clip_C( picture_t * p_pic, picture_t * p_outpic, int i_sin, int i_cos,
                          int i_sat, int i_x, int i_y )
 {
@@ -50,6 +50,21 @@ int planar_sat_hue_clip_C( picture_t * p_pic, picture_t * p_outpic,
 int planar_sat_hue_C( picture_t * p_pic, picture_t * p_outpic,
                       int i_sin, int i_cos, int i_sat, int i_x, int i_y );
 
+/**
+ * Basic C compiler generated function for semi-planar format (NV12, NV21),
+ * i_sat > 256
+ */
+int semiplanar_sat_hue_clip_C( picture_t * p_pic, picture_t * p_outpic,
+                               int i_sin, int i_cos, int i_sat, int i_x,
+                               int i_y );
+
+/**
+ * Basic C compiler generated function for semi-planar format (NV12, NV21),
+ * i_sat <= 256
+ */
+int semiplanar_sat_hue_C( picture_t * p_pic, picture_t * p_outpic,
+                          int i_sin, int i_cos, int i_sat, int i_x, int i_y );
+
 /**
  * Basic C compiler generated function for packed format, i_sat > 256
  */
@@ -32,8 +32,19 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
 
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+#if defined(HAVE_AVX2_INTRINSICS) && defined(VLC_CPU_AVX2)
+# include <immintrin.h>
+#endif
+#if defined(__arm__) && defined(__ARM_NEON__)
+# include <arm_neon.h>
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -79,6 +90,18 @@ public:
     {
         return fmt;
     }
+    const picture_t *getPicture() const
+    {
+        return picture;
+    }
+    unsigned getX() const
+    {
+        return x;
+    }
+    unsigned getY() const
+    {
+        return y;
+    }
     bool isFull(unsigned) const
     {
         return true;
@@ -523,6 +546,326 @@ void Blend(const CPicture &dst_data, const CPicture &src_data,
 typedef void (*blend_function_t)(const CPicture &dst_data, const CPicture &src_data,
                                  unsigned width, unsigned height, int alpha);
 
+/* Line routines of the YUVA blending below, all 8 bits. The alpha of
+ * sample i is div255(alpha * a[i]), as in Blend().
+ *  - line: dst[i] from src[i],
+ *  - sub: dst[i] from src[2 * i], for horizontally subsampled chroma,
+ *  - pairs: dst[2 * i] and dst[2 * i + 1] from u[2 * i] and v[2 * i],
+ *    for interleaved chroma. */
+struct CBlendC {
+    static void line(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                     unsigned alpha, unsigned n)
+    {
+        for (unsigned i = 0; i < n; i++)
+            ::merge(&dst[i], src[i], div255(alpha * a[i]));
+    }
+    static void sub(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                    unsigned alpha, unsigned n)
+    {
+        for (unsigned i = 0; i < n; i++)
+            ::merge(&dst[i], src[2 * i], div255(alpha * a[2 * i]));
+    }
+    static void pairs(uint8_t *dst, const uint8_t *u, const uint8_t *v,
+                      const uint8_t *a, unsigned alpha, unsigned n)
+    {
+        for (unsigned i = 0; i < n; i++) {
+            unsigned f = div255(alpha * a[2 * i]);
+            ::merge(&dst[2 * i],     u[2 * i], f);
+            ::merge(&dst[2 * i + 1], v[2 * i], f);
+        }
+    }
+};
+
+#ifdef __SSE2__
+# define RENAME(a) a ## SSE2
+# define VLC_TARGET
+# define STEP 8
+# define vec_t __m128i
+# define VLOAD(p) _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(p)), \
+                                    _mm_setzero_si128())
+# define VLOAD_EVEN(p) _mm_and_si128(_mm_loadu_si128((const __m128i *)(p)), \
+                                     _mm_set1_epi16(0xff))
+# define VLOAD_PAIRS(p, q) _mm_unpacklo_epi8( \
+    _mm_or_si128(_mm_and_si128(_mm_loadl_epi64((const __m128i *)(p)), \
+                               _mm_set1_epi16(0xff)), \
+                 _mm_slli_epi16(_mm_loadl_epi64((const __m128i *)(q)), 8)), \
+    _mm_setzero_si128())
+# define VSTORE(p, v) _mm_storel_epi64((__m128i *)(p), _mm_packus_epi16(v, v))
+# define VADD _mm_add_epi16
+# define VSUB _mm_sub_epi16
+# define VMUL _mm_mullo_epi16
+# define VSHR8(v) _mm_srli_epi16(v, 8)
+# define VSET1 _mm_set1_epi16
+# include "blend_simd.h"
+# undef RENAME
+# undef VLC_TARGET
+# undef STEP
+# undef vec_t
+# undef VLOAD
+# undef VLOAD_EVEN
+# undef VLOAD_PAIRS
+# undef VSTORE
+# undef VADD
+# undef VSUB
+# undef VMUL
+# undef VSHR8
+# undef VSET1
+#endif
+
+#if defined(HAVE_AVX2_INTRINSICS) && defined(VLC_CPU_AVX2)
+# define CAN_COMPILE_AVX2 1
+# define RENAME(a) a ## AVX2
+# define VLC_TARGET VLC_AVX2
+# define STEP 16
+# define vec_t __m256i
+# define VLOAD(p) _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(p)))
+# define VLOAD_EVEN(p) \
+    _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(p)), \
+                     _mm256_set1_epi16(0xff))
+# define VLOAD_PAIRS(p, q) _mm256_cvtepu8_epi16( \
+    _mm_or_si128(_mm_and_si128(_mm_loadu_si128((const __m128i *)(p)), \
+                               _mm_set1_epi16(0xff)), \
+                 _mm_slli_epi16(_mm_loadu_si128((const __m128i *)(q)), 8)))
+/* packus works within 128 bits lanes, the permutation gathers the two
+ * halves of the result */
+# define VSTORE(p, v) _mm_storeu_si128((__m128i *)(p), \
+    _mm256_castsi256_si128(_mm256_permute4x64_epi64( \
+        _mm256_packus_epi16(v, v), 0x08)))
+# define VADD _mm256_add_epi16
+# define VSUB _mm256_sub_epi16
+# define VMUL _mm256_mullo_epi16
+# define VSHR8(v) _mm256_srli_epi16(v, 8)
+# define VSET1 _mm256_set1_epi16
+# include "blend_simd.h"
+# undef RENAME
+# undef VLC_TARGET
+# undef STEP
+# undef vec_t
+# undef VLOAD
+# undef VLOAD_EVEN
+# undef VLOAD_PAIRS
+# undef VSTORE
+# undef VADD
+# undef VSUB
+# undef VMUL
+# undef VSHR8
+# undef VSET1
+#endif
+
+#if defined(__arm__) && defined(__ARM_NEON__)
+# define CAN_COMPILE_NEON 1
+# define RENAME(a) a ## NEON
+# define VLC_TARGET
+# define STEP 8
+# define vec_t uint16x8_t
+# define VLOAD(p) vmovl_u8(vld1_u8(p))
+# define VLOAD_EVEN(p) vmovl_u8(vld2_u8(p).val[0])
+# define VLOAD_PAIRS(p, q) vmovl_u8(vreinterpret_u8_u16( \
+    vorr_u16(vand_u16(vreinterpret_u16_u8(vld1_u8(p)), vdup_n_u16(0xff)), \
+             vshl_n_u16(vreinterpret_u16_u8(vld1_u8(q)), 8))))
+# define VSTORE(p, v) vst1_u8(p, vmovn_u16(v))
+# define VADD vaddq_u16
+# define VSUB vsubq_u16
+# define VMUL vmulq_u16
+# define VSHR8(v) vshrq_n_u16(v, 8)
+# define VSET1 vdupq_n_u16
+# include "blend_simd.h"
+# undef RENAME
+# undef VLC_TARGET
+# undef STEP
+# undef vec_t
+# undef VLOAD
+# undef VLOAD_EVEN
+# undef VLOAD_PAIRS
+# undef VSTORE
+# undef VADD
+# undef VSUB
+# undef VMUL
+# undef VSHR8
+# undef VSET1
+#endif
+
+/* Finds the first and last pixels of a line with a non-zero alpha.
+ * Returns false if the whole line is transparent. */
+static bool GetOpaqueSpan(const uint8_t *a, unsigned width,
+                          unsigned *first, unsigned *last)
+{
+    unsigned start = 0;
+    while (start + 8 <= width && U64_AT(&a[start]) == 0)
+        start += 8;
+    while (start < width && a[start] == 0)
+        start++;
+    if (start >= width)
+        return false;
+
+    unsigned end = width;
+    while (end >= start + 8 && U64_AT(&a[end - 8]) == 0)
+        end -= 8;
+    while (a[end - 1] == 0)
+        end--;
+
+    *first = start;
+    *last  = end - 1;
+    return true;
+}
+
+/* The first pixel from first on, on an even column of the destination,
+ * which carries the subsampled chroma. Returns false if there is none up
+ * to last. */
+static bool GetChromaStart(unsigned x, unsigned first, unsigned last,
+                           unsigned *start, unsigned *count)
+{
+    *start = first + ((x + first) & 1);
+    if (*start > last)
+        return false;
+    *count = (last - *start) / 2 + 1;
+    return true;
+}
+
+#define LINE(pic, plane, x, y) \
+    (&(pic)->p[plane].p_pixels[(y) * (pic)->p[plane].i_pitch + (x)])
+
+/* YUVA onto 4:2:0 pictures, with the transparent parts of each line
+ * skipped. It gives the same result as the generic Blend(). */
+template <class K, bool swap_uv>
+void BlendYuvaToI420(const CPicture &dst_data, const CPicture &src_data,
+                     unsigned width, unsigned height, int alpha)
+{
+    const picture_t *dst = dst_data.getPicture();
+    const picture_t *src = src_data.getPicture();
+    const unsigned dx = dst_data.getX(), dy = dst_data.getY();
+    const unsigned sx = src_data.getX(), sy = src_data.getY();
+    const int du = swap_uv ? V_PLANE : U_PLANE;
+    const int dv = swap_uv ? U_PLANE : V_PLANE;
+
+    for (unsigned y = 0; y < height; y++) {
+        const uint8_t *a = LINE(src, A_PLANE, sx, sy + y);
+        unsigned first, last, c, n;
+
+        if (!GetOpaqueSpan(a, width, &first, &last))
+            continue;
+
+        K::line(LINE(dst, Y_PLANE, dx + first, dy + y),
+                LINE(src, Y_PLANE, sx + first, sy + y), &a[first],
+                alpha, last - first + 1);
+
+        if (((dy + y) % 2) != 0 || !GetChromaStart(dx, first, last, &c, &n))
+            continue;
+        K::sub(LINE(dst, du, (dx + c) / 2, (dy + y) / 2),
+               LINE(src, U_PLANE, sx + c, sy + y), &a[c], alpha, n);
+        K::sub(LINE(dst, dv, (dx + c) / 2, (dy + y) / 2),
+               LINE(src, V_PLANE, sx + c, sy + y), &a[c], alpha, n);
+    }
+}
+
+/* YUVA onto NV12 (or NV21) pictures */
+template <class K, bool swap_uv>
+void BlendYuvaToNV12(const CPicture &dst_data, const CPicture &src_data,
+                     unsigned width, unsigned height, int alpha)
+{
+    const picture_t *dst = dst_data.getPicture();
+    const picture_t *src = src_data.getPicture();
+    const unsigned dx = dst_data.getX(), dy = dst_data.getY();
+    const unsigned sx = src_data.getX(), sy = src_data.getY();
+
+    for (unsigned y = 0; y < height; y++) {
+        const uint8_t *a = LINE(src, A_PLANE, sx, sy + y);
+        unsigned first, last, c, n;
+
+        if (!GetOpaqueSpan(a, width, &first, &last))
+            continue;
+
+        K::line(LINE(dst, Y_PLANE, dx + first, dy + y),
+                LINE(src, Y_PLANE, sx + first, sy + y), &a[first],
+                alpha, last - first + 1);
+
+        if (((dy + y) % 2) != 0 || !GetChromaStart(dx, first, last, &c, &n))
+            continue;
+        const uint8_t *u = LINE(src, U_PLANE, sx + c, sy + y);
+        const uint8_t *v = LINE(src, V_PLANE, sx + c, sy + y);
+        K::pairs(LINE(dst, 1, (dx + c) / 2 * 2, (dy + y) / 2),
+                 swap_uv ? v : u, swap_uv ? u : v, &a[c], alpha, n);
+    }
+}
+
+/* YUVA onto RV32 pictures. The RGB values of each chunk are converted in
+ * the layout of the destination, whose padding byte is blended with
+ * itself, so that a single line routine blends all the bytes. */
+template <class K>
+void BlendYuvaToRgb32(const CPicture &dst_data, const CPicture &src_data,
+                      unsigned width, unsigned height, int alpha)
+{
+    const picture_t *dst = dst_data.getPicture();
+    const picture_t *src = src_data.getPicture();
+    const video_format_t *fmt = dst_data.getFormat();
+    const unsigned dx = dst_data.getX(), dy = dst_data.getY();
+    const unsigned sx = src_data.getX(), sy = src_data.getY();
+#ifdef WORDS_BIGENDIAN
+    const unsigned offset_r = (32 - fmt->i_lrshift) / 8;
+    const unsigned offset_g = (32 - fmt->i_lgshift) / 8;
+    const unsigned offset_b = (32 - fmt->i_lbshift) / 8;
+#else
+    const unsigned offset_r = fmt->i_lrshift / 8;
+    const unsigned offset_g = fmt->i_lgshift / 8;
+    const unsigned offset_b = fmt->i_lbshift / 8;
+#endif
+    const unsigned offset_x = 6 - offset_r - offset_g - offset_b;
+    enum { CHUNK = 256 };
+    uint8_t rgb[4 * CHUNK], a4[4 * CHUNK];
+
+    for (unsigned y = 0; y < height; y++) {
+        const uint8_t *a = LINE(src, A_PLANE, sx, sy + y);
+        const uint8_t *py = LINE(src, Y_PLANE, sx, sy + y);
+        const uint8_t *pu = LINE(src, U_PLANE, sx, sy + y);
+        const uint8_t *pv = LINE(src, V_PLANE, sx, sy + y);
+        unsigned first, last;
+
+        if (!GetOpaqueSpan(a, width, &first, &last))
+            continue;
+
+        for (unsigned x = first; x <= last; x += CHUNK) {
+            const unsigned n = __MIN(last + 1 - x, (unsigned)CHUNK);
+            uint8_t *d = LINE(dst, 0, (dx + x) * 4, dy + y);
+
+            for (unsigned i = 0; i < n; i++) {
+                if (a[x + i] != 0) {
+                    int r, g, b;
+                    yuv_to_rgb(&r, &g, &b, py[x + i], pu[x + i], pv[x + i]);
+                    rgb[4 * i + offset_r] = r;
+                    rgb[4 * i + offset_g] = g;
+                    rgb[4 * i + offset_b] = b;
+                    rgb[4 * i + offset_x] = d[4 * i + offset_x];
+                } else
+                    memcpy(&rgb[4 * i], &d[4 * i], 4);
+                memset(&a4[4 * i], a[x + i], 4);
+            }
+            K::line(d, rgb, a4, alpha, 4 * n);
+        }
+    }
+}
+#undef LINE
+
+/* Returns the YUVA blending routine for a destination chroma, if any */
+template <class K>
+static blend_function_t GetYuvaBlend(vlc_fourcc_t dst)
+{
+    switch (dst) {
+    case VLC_CODEC_I420:
+    case VLC_CODEC_J420:
+        return BlendYuvaToI420<K, false>;
+    case VLC_CODEC_YV12:
+        return BlendYuvaToI420<K, true>;
+    case VLC_CODEC_NV12:
+        return BlendYuvaToNV12<K, false>;
+    case VLC_CODEC_NV21:
+        return BlendYuvaToNV12<K, true>;
+    case VLC_CODEC_RGB32:
+        return BlendYuvaToRgb32<K>;
+    default:
+        return NULL;
+    }
+}
+
 static const struct {
     vlc_fourcc_t     dst;
     vlc_fourcc_t     src;
@@ -644,6 +987,29 @@ static int Open(vlc_object_t *object)
             sys->blend = blends[i].blend;
     }
 
+    /* Faster routines for the common YUVA subpictures */
+    if (src == VLC_CODEC_YUVA) {
+        blend_function_t blend;
+#ifdef CAN_COMPILE_AVX2
+        if (vlc_CPU_AVX2())
+            blend = GetYuvaBlend<CBlendAVX2>(dst);
+        else
+#endif
+#ifdef __SSE2__
+        if (vlc_CPU_SSE2())
+            blend = GetYuvaBlend<CBlendSSE2>(dst);
+        else
+#endif
+#ifdef CAN_COMPILE_NEON
+        if (vlc_CPU_ARM_NEON())
+            blend = GetYuvaBlend<CBlendNEON>(dst);
+        else
+#endif
+            blend = GetYuvaBlend<CBlendC>(dst);
+        if (blend)
+            sys->blend = blend;
+    }
+
     if (!sys->blend) {
        msg_Err(filter, "no matching alpha blending routine (chroma: %4.4s -> %4.4s)",
                (char *)&src, (char *)&dst);
@@ -0,0 +1,87 @@
+/*****************************************************************************
+ * blend_simd.h: YUVA blending line routines on vector intrinsics
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* The CBlendC line routines of blend.cpp, written once for any vector unit.
+ * Samples are widened to 16 bits lanes, where the products of two 8 bits
+ * values and div255() cannot overflow, so results are bit-exact with the
+ * C code.
+ *
+ * The including file defines:
+ *  RENAME(a), VLC_TARGET, STEP (samples per vector), vec_t,
+ *  VLOAD(p) (STEP bytes, widened), VLOAD_EVEN(p) (the even bytes of
+ *  2 * STEP bytes), VLOAD_PAIRS(p, q) (p[0], q[0], p[2], q[2]...),
+ *  VSTORE(p, v) (narrowing store), VADD, VSUB, VMUL, VSHR8 and VSET1.
+ *
+ * VLOAD_EVEN and VLOAD_PAIRS may read one byte past the last one used, so
+ * their loops stop one vector earlier. */
+
+#define DIV255(v) VSHR8(VADD(VADD(VSHR8(v), v), VSET1(1)))
+#define MERGE(d, s, a) \
+    DIV255(VADD(VMUL(VSUB(VSET1(255), a), d), VMUL(s, a)))
+
+struct RENAME(CBlend) {
+    VLC_TARGET
+    static void line(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                     unsigned alpha, unsigned n)
+    {
+        const vec_t va = VSET1(alpha);
+        unsigned i;
+
+        for (i = 0; i + STEP <= n; i += STEP) {
+            vec_t f = DIV255(VMUL(va, VLOAD(&a[i])));
+            VSTORE(&dst[i], MERGE(VLOAD(&dst[i]), VLOAD(&src[i]), f));
+        }
+        CBlendC::line(&dst[i], &src[i], &a[i], alpha, n - i);
+    }
+
+    VLC_TARGET
+    static void sub(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                    unsigned alpha, unsigned n)
+    {
+        const vec_t va = VSET1(alpha);
+        unsigned i;
+
+        for (i = 0; i + STEP < n; i += STEP) {
+            vec_t f = DIV255(VMUL(va, VLOAD_EVEN(&a[2 * i])));
+            VSTORE(&dst[i], MERGE(VLOAD(&dst[i]), VLOAD_EVEN(&src[2 * i]), f));
+        }
+        CBlendC::sub(&dst[i], &src[2 * i], &a[2 * i], alpha, n - i);
+    }
+
+    VLC_TARGET
+    static void pairs(uint8_t *dst, const uint8_t *u, const uint8_t *v,
+                      const uint8_t *a, unsigned alpha, unsigned n)
+    {
+        const vec_t va = VSET1(alpha);
+        unsigned i;
+
+        /* STEP bytes of dst hold STEP / 2 pairs */
+        for (i = 0; i + STEP / 2 < n; i += STEP / 2) {
+            vec_t f = DIV255(VMUL(va, VLOAD_PAIRS(&a[2 * i], &a[2 * i])));
+            VSTORE(&dst[2 * i], MERGE(VLOAD(&dst[2 * i]),
+                                      VLOAD_PAIRS(&u[2 * i], &v[2 * i]), f));
+        }
+        CBlendC::pairs(&dst[2 * i], &u[2 * i], &v[2 * i], &a[2 * i],
+                       alpha, n - i);
+    }
+};
+
+#undef MERGE
+#undef DIV255
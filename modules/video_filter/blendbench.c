@@ -58,8 +58,10 @@ static picture_t *Filter( filter_t *, picture_t * );
 #define BASE_IMAGE_TEXT N_("Image to be blended onto")
 #define BASE_IMAGE_LONGTEXT N_("The image which will be used to blend onto")
 
-#define BASE_CHROMA_TEXT N_("Chroma for the base image")
-#define BASE_CHROMA_LONGTEXT N_("Chroma which the base image will be loaded in")
+#define BASE_CHROMA_TEXT N_("Chromas for the base image")
+#define BASE_CHROMA_LONGTEXT N_("Comma-separated chromas which the base " \
+                                "image will be loaded in, one benchmark " \
+                                "is run for each")
 
 #define BLEND_IMAGE_TEXT N_("Image which will be blended")
 #define BLEND_IMAGE_LONGTEXT N_("The image blended onto the base image")
@@ -106,15 +108,17 @@ static const char *const ppsz_filter_options[] = {
 /*****************************************************************************
  * filter_sys_t: filter method descriptor
  *****************************************************************************/
+#define MAX_BASE_CHROMAS 16
+
 struct filter_sys_t
 {
     bool b_done;
     int i_loops, i_alpha;
 
-    picture_t *p_base_image;
+    int i_base_images;
+    picture_t *pp_base_images[MAX_BASE_CHROMAS];
     picture_t *p_blend_image;
 
-    vlc_fourcc_t i_base_chroma;
     vlc_fourcc_t i_blend_chroma;
 };
 
@@ -152,8 +156,8 @@ static int Create( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys;
-    char *psz_temp, *psz_cmd;
-    int i_ret;
+    char *psz_temp, *psz_cmd, *psz_chroma, *psz_next;
+    int i_ret = VLC_SUCCESS;
 
     /* Allocate structure */
     p_filter->p_sys = malloc( sizeof( filter_sys_t ) );
@@ -176,17 +180,35 @@ static int Create( vlc_object_t *p_this )
                                                   CFG_PREFIX "alpha" );
 
     psz_temp = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-chroma" );
-    p_sys->i_base_chroma = VLC_FOURCC( psz_temp[0], psz_temp[1],
-                                       psz_temp[2], psz_temp[3] );
     psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-image" );
-    i_ret = blendbench_LoadImage( p_this, &p_sys->p_base_image,
-                                  p_sys->i_base_chroma, psz_cmd, "Base" );
+    p_sys->i_base_images = 0;
+    for( psz_chroma = strtok_r( psz_temp, ",", &psz_next );
+         psz_chroma != NULL && p_sys->i_base_images < MAX_BASE_CHROMAS;
+         psz_chroma = strtok_r( NULL, ",", &psz_next ) )
+    {
+        vlc_fourcc_t i_chroma = vlc_fourcc_GetCodecFromString( VIDEO_ES,
+                                                               psz_chroma );
+        if( i_chroma == 0 )
+        {
+            msg_Err( p_filter, "Unknown base chroma %s", psz_chroma );
+            i_ret = VLC_EGENERIC;
+            break;
+        }
+        i_ret = blendbench_LoadImage( p_this,
+                            &p_sys->pp_base_images[p_sys->i_base_images],
+                            i_chroma, psz_cmd, "Base" );
+        if( i_ret != VLC_SUCCESS )
+            break;
+        p_sys->i_base_images++;
+    }
     free( psz_temp );
     free( psz_cmd );
-    if( i_ret != VLC_SUCCESS )
+    if( i_ret != VLC_SUCCESS || p_sys->i_base_images == 0 )
     {
+        for( int i = 0; i < p_sys->i_base_images; i++ )
+            picture_Release( p_sys->pp_base_images[i] );
         free( p_sys );
-        return i_ret;
+        return VLC_EGENERIC;
     }
 
     psz_temp = var_CreateGetStringCommand( p_filter,
@@ -210,57 +232,79 @@ static void Destroy( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    picture_Release( p_sys->p_base_image );
+    for( int i = 0; i < p_sys->i_base_images; i++ )
+        picture_Release( p_sys->pp_base_images[i] );
     picture_Release( p_sys->p_blend_image );
+    free( p_sys );
 }
 
 /*****************************************************************************
- * Render: displays previously rendered output
+ * Bench: blends the blend image onto one base image, reports the speed
  *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static int Bench( filter_t *p_filter, picture_t *p_base )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
+    picture_t *p_blend_image = p_sys->p_blend_image;
     filter_t *p_blend;
 
-    if( p_sys->b_done )
-        return p_pic;
-
     p_blend = vlc_object_create( p_filter, sizeof(filter_t) );
     if( !p_blend )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
-    p_blend->fmt_out.video = p_sys->p_base_image->format;
-    p_blend->fmt_in.video = p_sys->p_blend_image->format;
+        return VLC_ENOMEM;
+    p_blend->fmt_out.video = p_base->format;
+    p_blend->fmt_in.video = p_blend_image->format;
     p_blend->p_module = module_need( p_blend, "video blending", NULL, false );
     if( !p_blend->p_module )
     {
-        picture_Release( p_pic );
         vlc_object_release( p_blend );
-        return NULL;
+        return VLC_EGENERIC;
     }
 
     mtime_t time = mdate();
     for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
     {
-        p_blend->pf_video_blend( p_blend,
-                                 p_sys->p_base_image, p_sys->p_blend_image,
+        p_blend->pf_video_blend( p_blend, p_base, p_blend_image,
                                  0, 0, p_sys->i_alpha );
     }
     time = mdate() - time;
 
-    msg_Info( p_filter, "Blended %d images in %f sec", p_sys->i_loops,
-              time / 1000000.0f );
-    msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second",
+    /* Pixels of the blended image actually covering the base image */
+    int i_width = __MIN( p_blend_image->format.i_visible_width,
+                         p_base->format.i_visible_width );
+    int i_height = __MIN( p_blend_image->format.i_visible_height,
+                          p_base->format.i_visible_height );
+    double f_mpixels = (double)p_sys->i_loops * i_width * i_height / 1e6;
+
+    msg_Info( p_filter, "%4.4s -> %4.4s: blended %d images in %f sec",
+              (const char *)&p_blend_image->format.i_chroma,
+              (const char *)&p_base->format.i_chroma,
+              p_sys->i_loops, time / 1000000.0f );
+    msg_Info( p_filter, "%4.4s -> %4.4s: %f images/second, "
+              "%.1f Mpixels/second",
+              (const char *)&p_blend_image->format.i_chroma,
+              (const char *)&p_base->format.i_chroma,
               (float) p_sys->i_loops / time * 1000000,
-              (float) p_sys->i_loops / time * 1000000 *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_pitch *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_lines );
+              f_mpixels / time * 1000000 );
 
     module_unneed( p_blend, p_blend->p_module );
-
     vlc_object_release( p_blend );
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Render: displays previously rendered output
+ *****************************************************************************/
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->b_done )
+        return p_pic;
+
+    for( int i = 0; i < p_sys->i_base_images; i++ )
+        if( Bench( p_filter, p_sys->pp_base_images[i] ) != VLC_SUCCESS )
+            msg_Err( p_filter, "Cannot blend %4.4s onto %4.4s",
+                     (const char *)&p_sys->p_blend_image->format.i_chroma,
+                     (const char *)&p_sys->pp_base_images[i]->format.i_chroma );
 
     p_sys->b_done = true;
     return p_pic;
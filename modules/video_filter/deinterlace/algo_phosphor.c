@@ -28,6 +28,17 @@
 #ifdef CAN_COMPILE_MMXEXT
 #   include "mmx.h"
 #endif
+#ifdef __SSE2__
+#   include <emmintrin.h>
+#endif
+#if defined(HAVE_AVX2_INTRINSICS) && defined(VLC_CPU_AVX2)
+#   include <immintrin.h>
+#   define CAN_COMPILE_AVX2 1
+#endif
+#if defined(__arm__) && defined(__ARM_NEON__)
+#   include <arm_neon.h>
+#   define CAN_COMPILE_NEON 1
+#endif
 
 #include <stdint.h>
 #include <assert.h>
@@ -268,6 +279,165 @@ static void DarkenFieldMMX( picture_t *p_dst,
 }
 #endif
 
+/* Line routines for DarkenFieldLines(): each darkens w pixels in place.
+   The vector versions give the same results as DarkenField(). */
+typedef void (*darken_line_t)( uint8_t *, int, int );
+
+static void DarkenLumaLine( uint8_t *p, int w, int i_strength )
+{
+    const uint8_t remove_high_u8 = 0xFF >> i_strength;
+
+    for( int x = 0; x < w; ++x )
+        p[x] = ( (p[x] >> i_strength) & remove_high_u8 );
+}
+
+static void DarkenChromaLine( uint8_t *p, int w, int i_strength )
+{
+    for( int x = 0; x < w; ++x )
+        p[x] = 128 + ( (p[x] - 128) / (1 << i_strength) );
+}
+
+#ifdef __SSE2__
+static void DarkenLumaLineSSE2( uint8_t *p, int w, int i_strength )
+{
+    const __m128i shift = _mm_cvtsi32_si128( i_strength );
+    const __m128i remove_high = _mm_set1_epi8( 0xFF >> i_strength );
+    int x;
+
+    for( x = 0; x + 16 <= w; x += 16 )
+    {
+        __m128i v = _mm_loadu_si128( (__m128i *)&p[x] );
+        v = _mm_and_si128( _mm_srl_epi16( v, shift ), remove_high );
+        _mm_storeu_si128( (__m128i *)&p[x], v );
+    }
+    DarkenLumaLine( p + x, w - x, i_strength );
+}
+
+static void DarkenChromaLineSSE2( uint8_t *p, int w, int i_strength )
+{
+    const __m128i shift = _mm_cvtsi32_si128( i_strength );
+    const __m128i remove_high = _mm_set1_epi8( 0xFF >> i_strength );
+    const __m128i b128 = _mm_set1_epi8( (char)0x80 );
+    int x;
+
+    /* Same as the MMX version: the distances to 128 on either side are
+       shifted separately, which rounds towards 128 as the C division. */
+    for( x = 0; x + 16 <= w; x += 16 )
+    {
+        __m128i v = _mm_loadu_si128( (__m128i *)&p[x] );
+        __m128i pos = _mm_and_si128( _mm_srl_epi16( _mm_subs_epu8( v, b128 ),
+                                                    shift ), remove_high );
+        __m128i neg = _mm_and_si128( _mm_srl_epi16( _mm_subs_epu8( b128, v ),
+                                                    shift ), remove_high );
+        v = _mm_add_epi8( _mm_sub_epi8( pos, neg ), b128 );
+        _mm_storeu_si128( (__m128i *)&p[x], v );
+    }
+    DarkenChromaLine( p + x, w - x, i_strength );
+}
+#endif
+
+#ifdef CAN_COMPILE_AVX2
+VLC_AVX2
+static void DarkenLumaLineAVX2( uint8_t *p, int w, int i_strength )
+{
+    const __m128i shift = _mm_cvtsi32_si128( i_strength );
+    const __m256i remove_high = _mm256_set1_epi8( 0xFF >> i_strength );
+    int x;
+
+    for( x = 0; x + 32 <= w; x += 32 )
+    {
+        __m256i v = _mm256_loadu_si256( (__m256i *)&p[x] );
+        v = _mm256_and_si256( _mm256_srl_epi16( v, shift ), remove_high );
+        _mm256_storeu_si256( (__m256i *)&p[x], v );
+    }
+    DarkenLumaLine( p + x, w - x, i_strength );
+}
+
+VLC_AVX2
+static void DarkenChromaLineAVX2( uint8_t *p, int w, int i_strength )
+{
+    const __m128i shift = _mm_cvtsi32_si128( i_strength );
+    const __m256i remove_high = _mm256_set1_epi8( 0xFF >> i_strength );
+    const __m256i b128 = _mm256_set1_epi8( (char)0x80 );
+    int x;
+
+    for( x = 0; x + 32 <= w; x += 32 )
+    {
+        __m256i v = _mm256_loadu_si256( (__m256i *)&p[x] );
+        __m256i pos = _mm256_and_si256(
+            _mm256_srl_epi16( _mm256_subs_epu8( v, b128 ), shift ),
+            remove_high );
+        __m256i neg = _mm256_and_si256(
+            _mm256_srl_epi16( _mm256_subs_epu8( b128, v ), shift ),
+            remove_high );
+        v = _mm256_add_epi8( _mm256_sub_epi8( pos, neg ), b128 );
+        _mm256_storeu_si256( (__m256i *)&p[x], v );
+    }
+    DarkenChromaLine( p + x, w - x, i_strength );
+}
+#endif
+
+#ifdef CAN_COMPILE_NEON
+static void DarkenLumaLineNEON( uint8_t *p, int w, int i_strength )
+{
+    const int8x16_t shift = vdupq_n_s8( -i_strength );
+    int x;
+
+    for( x = 0; x + 16 <= w; x += 16 )
+        vst1q_u8( &p[x], vshlq_u8( vld1q_u8( &p[x] ), shift ) );
+    DarkenLumaLine( p + x, w - x, i_strength );
+}
+
+static void DarkenChromaLineNEON( uint8_t *p, int w, int i_strength )
+{
+    const int8x16_t shift = vdupq_n_s8( -i_strength );
+    const uint8x16_t b128 = vdupq_n_u8( 128 );
+    int x;
+
+    for( x = 0; x + 16 <= w; x += 16 )
+    {
+        uint8x16_t v = vld1q_u8( &p[x] );
+        uint8x16_t pos = vshlq_u8( vqsubq_u8( v, b128 ), shift );
+        uint8x16_t neg = vshlq_u8( vqsubq_u8( b128, v ), shift );
+        vst1q_u8( &p[x], vaddq_u8( vsubq_u8( pos, neg ), b128 ) );
+    }
+    DarkenChromaLine( p + x, w - x, i_strength );
+}
+#endif
+
+/**
+ * Internal helper function: DarkenField() on the given line routines.
+ *
+ * @param p_dst Input/output picture. Will be modified in-place.
+ * @param i_field Darken which field? 0 = top, 1 = bottom.
+ * @param i_strength Strength of effect: 1, 2 or 3 (division by 2, 4 or 8).
+ * @param process_chroma Whether to darken the chroma planes too
+ * @param pf_luma Routine for the luma lines
+ * @param pf_chroma Routine for the chroma lines
+ * @see DarkenField()
+ */
+static void DarkenFieldLines( picture_t *p_dst,
+                              const int i_field, const int i_strength,
+                              bool process_chroma,
+                              darken_line_t pf_luma, darken_line_t pf_chroma )
+{
+    assert( p_dst != NULL );
+    assert( i_field == 0 || i_field == 1 );
+    assert( i_strength >= 1 && i_strength <= 3 );
+
+    const int i_planes = process_chroma ? p_dst->i_planes : 1;
+    for( int i_plane = Y_PLANE; i_plane < i_planes; i_plane++ )
+    {
+        const plane_t *p = &p_dst->p[i_plane];
+        darken_line_t pf_line = ( i_plane == Y_PLANE ) ? pf_luma : pf_chroma;
+
+        /* i_field is also the first line of the field */
+        for( int y = i_field; y < p->i_visible_lines; y += 2 )
+            pf_line( &p->p_pixels[y * p->i_pitch], p->i_visible_pitch,
+                     i_strength );
+    }
+}
+
 /*****************************************************************************
  * Public functions
  *****************************************************************************/
@@ -353,16 +523,35 @@ int RenderPhosphor( filter_t *p_filter,
     */
     if( p_sys->phosphor.i_dimmer_strength > 0 )
     {
+        const int i_strength = p_sys->phosphor.i_dimmer_strength;
+        const bool b_chroma =
+            p_sys->chroma->p[1].h.num == p_sys->chroma->p[1].h.den &&
+            p_sys->chroma->p[2].h.num == p_sys->chroma->p[2].h.den;
+
+#ifdef CAN_COMPILE_AVX2
+        if( vlc_CPU_AVX2() )
+            DarkenFieldLines( p_dst, !i_field, i_strength, b_chroma,
+                              DarkenLumaLineAVX2, DarkenChromaLineAVX2 );
+        else
+#endif
+#ifdef __SSE2__
+        if( vlc_CPU_SSE2() )
+            DarkenFieldLines( p_dst, !i_field, i_strength, b_chroma,
+                              DarkenLumaLineSSE2, DarkenChromaLineSSE2 );
+        else
+#endif
 #ifdef CAN_COMPILE_MMXEXT
         if( vlc_CPU_MMXEXT() )
-            DarkenFieldMMX( p_dst, !i_field, p_sys->phosphor.i_dimmer_strength,
-                p_sys->chroma->p[1].h.num == p_sys->chroma->p[1].h.den &&
-                p_sys->chroma->p[2].h.num == p_sys->chroma->p[2].h.den );
+            DarkenFieldMMX( p_dst, !i_field, i_strength, b_chroma );
+        else
+#endif
+#ifdef CAN_COMPILE_NEON
+        if( vlc_CPU_ARM_NEON() )
+            DarkenFieldLines( p_dst, !i_field, i_strength, b_chroma,
+                              DarkenLumaLineNEON, DarkenChromaLineNEON );
         else
 #endif
-            DarkenField( p_dst, !i_field, p_sys->phosphor.i_dimmer_strength,
-                p_sys->chroma->p[1].h.num == p_sys->chroma->p[1].h.den &&
-                p_sys->chroma->p[2].h.num == p_sys->chroma->p[2].h.den );
+            DarkenField( p_dst, !i_field, i_strength, b_chroma );
     }
     return VLC_SUCCESS;
 }
@@ -47,6 +47,85 @@
    Necessary preprocessor macros are defined in common.h. */
 #include "yadif.h"
 
+typedef void (*yadif_filter_line_t)( uint8_t *dst, uint8_t *prev, uint8_t *cur,
+                                     uint8_t *next, int w, int prefs,
+                                     int mrefs, int parity, int mode );
+
+typedef struct
+{
+    picture_t *p_dst;
+    const picture_t *p_prev, *p_cur, *p_next;
+    yadif_filter_line_t filter;
+    yadif_filter_line_t filter_interleaved; /* for the U/V plane of NV12 */
+    int i_field;
+    int i_parity;
+} yadif_slice_t;
+
+/* Lines only depend on the input pictures, so each slice renders a band of
+ * lines of every plane. */
+static void RenderYadifSlice( filter_t *p_filter, void *p_data,
+                              unsigned i_slice, unsigned i_slices )
+{
+    const yadif_slice_t *p_slice = p_data;
+    const vlc_chroma_description_t *p_chroma = p_filter->p_sys->chroma;
+    const int i_pixel_size = p_chroma->pixel_size;
+    const int yadif_parity = p_slice->i_parity;
+    const int i_field = p_slice->i_field;
+    picture_t *p_dst = p_slice->p_dst;
+
+    for( int n = 0; n < p_dst->i_planes; n++ )
+    {
+        const plane_t *prevp = &p_slice->p_prev->p[n];
+        const plane_t *curp  = &p_slice->p_cur->p[n];
+        const plane_t *nextp = &p_slice->p_next->p[n];
+        plane_t *dstp        = &p_dst->p[n];
+        const yadif_filter_line_t filter = p_chroma->plane_count == 2 && n == 1
+                                         ? p_slice->filter_interleaved
+                                         : p_slice->filter;
+        const int i_lines = dstp->i_visible_lines;
+        const int i_first = __MAX( (int)filter_SliceRow( i_slice, i_slices,
+                                                         i_lines ), 1 );
+        const int i_last = __MIN( (int)filter_SliceRow( i_slice + 1, i_slices,
+                                                        i_lines ), i_lines - 1 );
+
+        for( int y = i_first; y < i_last; y++ )
+        {
+            if( (y % 2) == i_field  ||  yadif_parity == 2 )
+            {
+                memcpy( &dstp->p_pixels[y * dstp->i_pitch],
+                            &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
+            }
+            else
+            {
+                int mode;
+                /* Spatial checks only when enough data */
+                mode = (y >= 2 && y < i_lines - 2) ? 0 : 2;
+
+                assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
+                filter( &dstp->p_pixels[y * dstp->i_pitch],
+                                 &prevp->p_pixels[y * prevp->i_pitch],
+                                 &curp->p_pixels[y * curp->i_pitch],
+                                 &nextp->p_pixels[y * nextp->i_pitch],
+                                 dstp->i_visible_pitch / i_pixel_size,
+                                 y < i_lines - 2  ? curp->i_pitch : -curp->i_pitch,
+                                 y  - 1  ?  -curp->i_pitch : curp->i_pitch,
+                                 yadif_parity,
+                                 mode );
+            }
+
+            /* We duplicate the first and last lines */
+            if( y == 1 )
+                memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
+                           &dstp->p_pixels[ y    * dstp->i_pitch],
+                           dstp->i_pitch);
+            else if( y == i_lines - 2 )
+                memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
+                           &dstp->p_pixels[ y    * dstp->i_pitch],
+                           dstp->i_pitch);
+        }
+    }
+}
+
 int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
                  int i_order, int i_field )
 {
@@ -104,74 +183,88 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
     /* Filter if we have all the pictures we need */
     if( p_prev && p_cur && p_next )
     {
-        /* */
-        void (*filter)(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next,
-                       int w, int prefs, int mrefs, int parity, int mode);
+        yadif_filter_line_t filter, filter_interleaved;
 
-#if defined(HAVE_YADIF_SSSE3)
-        if( vlc_CPU_SSSE3() )
-            filter = yadif_filter_line_ssse3;
+        if( p_sys->chroma->pixel_size == 2 )
+        {
+#if defined(HAVE_YADIF_AVX2)
+            if( vlc_CPU_AVX2() )
+            {
+                filter = yadif_filter_line_avx2_16bit;
+                filter_interleaved = yadif_filter_line_interleaved_avx2_16bit;
+            }
+            else
+#endif
+#if defined(HAVE_YADIF_NEON)
+            if( vlc_CPU_ARM_NEON() )
+            {
+                filter = yadif_filter_line_neon_16bit;
+                filter_interleaved = yadif_filter_line_interleaved_neon_16bit;
+            }
+            else
+#endif
+            {
+                filter = (yadif_filter_line_t)yadif_filter_line_c_16bit;
+                filter_interleaved =
+                    (yadif_filter_line_t)yadif_filter_line_c_16bit_interleaved;
+            }
+        }
         else
+        {
+            /* Only the intrinsics versions handle interleaved U/V */
+#if defined(HAVE_YADIF_AVX2)
+            if( vlc_CPU_AVX2() )
+                filter_interleaved = yadif_filter_line_interleaved_avx2;
+            else
+#endif
+#if defined(HAVE_YADIF_NEON)
+            if( vlc_CPU_ARM_NEON() )
+                filter_interleaved = yadif_filter_line_interleaved_neon;
+            else
+#endif
+                filter_interleaved = yadif_filter_line_c_interleaved;
+
+#if defined(HAVE_YADIF_AVX2)
+            if( vlc_CPU_AVX2() )
+                filter = yadif_filter_line_avx2;
+            else
+#endif
+#if defined(HAVE_YADIF_SSSE3)
+            if( vlc_CPU_SSSE3() )
+                filter = yadif_filter_line_ssse3;
+            else
 #endif
 #if defined(HAVE_YADIF_SSE2)
-        if( vlc_CPU_SSE2() )
-            filter = yadif_filter_line_sse2;
-        else
+            if( vlc_CPU_SSE2() )
+                filter = yadif_filter_line_sse2;
+            else
 #endif
 #if defined(HAVE_YADIF_MMX)
-        if( vlc_CPU_MMX() )
-            filter = yadif_filter_line_mmx;
-        else
+            if( vlc_CPU_MMX() )
+                filter = yadif_filter_line_mmx;
+            else
 #endif
-            filter = yadif_filter_line_c;
-
-        if( p_sys->chroma->pixel_size == 2 )
-            filter = yadif_filter_line_c_16bit;
-
-        for( int n = 0; n < p_dst->i_planes; n++ )
-        {
-            const plane_t *prevp = &p_prev->p[n];
-            const plane_t *curp  = &p_cur->p[n];
-            const plane_t *nextp = &p_next->p[n];
-            plane_t *dstp        = &p_dst->p[n];
-
-            for( int y = 1; y < dstp->i_visible_lines - 1; y++ )
-            {
-                if( (y % 2) == i_field  ||  yadif_parity == 2 )
-                {
-                    memcpy( &dstp->p_pixels[y * dstp->i_pitch],
-                                &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
-                }
-                else
-                {
-                    int mode;
-                    /* Spatial checks only when enough data */
-                    mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
-
-                    assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
-                    filter( &dstp->p_pixels[y * dstp->i_pitch],
-                            &prevp->p_pixels[y * prevp->i_pitch],
-                            &curp->p_pixels[y * curp->i_pitch],
-                            &nextp->p_pixels[y * nextp->i_pitch],
-                            dstp->i_visible_pitch,
-                            y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
-                            y  - 1  ?  -curp->i_pitch : curp->i_pitch,
-                            yadif_parity,
-                            mode );
-                }
-
-                /* We duplicate the first and last lines */
-                if( y == 1 )
-                    memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-                else if( y == dstp->i_visible_lines - 2 )
-                    memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-            }
+#if defined(HAVE_YADIF_NEON)
+            if( vlc_CPU_ARM_NEON() )
+                filter = yadif_filter_line_neon;
+            else
+#endif
+                filter = yadif_filter_line_c;
         }
 
+        yadif_slice_t slice = {
+            .p_dst = p_dst,
+            .p_prev = p_prev,
+            .p_cur = p_cur,
+            .p_next = p_next,
+            .filter = filter,
+            .filter_interleaved = filter_interleaved,
+            .i_field = i_field,
+            .i_parity = yadif_parity,
+        };
+        filter_RunSlices( p_filter, p_dst->p[0].i_visible_lines / 16,
+                          RenderYadifSlice, &slice );
+
         p_sys->i_frame_offset = 1; /* p_cur will be rendered at next frame, too */
 
         return VLC_SUCCESS;
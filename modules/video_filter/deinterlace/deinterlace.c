@@ -137,6 +137,10 @@ static const char *const ppsz_filter_options[] = {
 void SetFilterMethod( filter_t *p_filter, const char *psz_method )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
+    /* X, Phosphor and IVTC handle 8-bit samples and separate U and V
+     * planes only, not the interleaved chroma plane of NV12 */
+    const bool b_planar_8bit = p_sys->chroma->pixel_size == 1 &&
+                               p_sys->chroma->plane_count == 3;
 
     if( !psz_method )
         psz_method = "";
@@ -163,7 +167,7 @@ void SetFilterMethod( filter_t *p_filter, const char *psz_method )
         p_sys->b_half_height = false;
         p_sys->b_use_frame_history = false;
     }
-    else if( !strcmp( psz_method, "x" ) && p_sys->chroma->pixel_size == 1 )
+    else if( !strcmp( psz_method, "x" ) && b_planar_8bit )
     {
         p_sys->i_mode = DEINTERLACE_X;
         p_sys->b_double_rate = false;
@@ -184,14 +188,14 @@ void SetFilterMethod( filter_t *p_filter, const char *psz_method )
         p_sys->b_half_height = false;
         p_sys->b_use_frame_history = true;
     }
-    else if( !strcmp( psz_method, "phosphor" ) && p_sys->chroma->pixel_size == 1 )
+    else if( !strcmp( psz_method, "phosphor" ) && b_planar_8bit )
     {
         p_sys->i_mode = DEINTERLACE_PHOSPHOR;
         p_sys->b_double_rate = true;
         p_sys->b_half_height = false;
         p_sys->b_use_frame_history = true;
     }
-    else if( !strcmp( psz_method, "ivtc" ) && p_sys->chroma->pixel_size == 1 )
+    else if( !strcmp( psz_method, "ivtc" ) && b_planar_8bit )
     {
         p_sys->i_mode = DEINTERLACE_IVTC;
         p_sys->b_double_rate = false;
@@ -597,7 +601,8 @@ int Open( vlc_object_t *p_this )
     const vlc_fourcc_t fourcc = p_filter->fmt_in.video.i_chroma;
     const vlc_chroma_description_t *chroma = vlc_fourcc_GetChromaDescription( fourcc );
     if( !vlc_fourcc_IsYUV( fourcc ) ||
-        !chroma || chroma->plane_count != 3 || chroma->pixel_size > 2 )
+        !chroma || chroma->plane_count < 2 || chroma->plane_count > 3 ||
+        chroma->pixel_size > 2 )
     {
         msg_Err( p_filter, "Unsupported chroma (%4.4s)", (char*)&fourcc );
         return VLC_EGENERIC;
@@ -631,6 +636,14 @@ int Open( vlc_object_t *p_this )
         p_sys->pf_merge = MergeAltivec;
     else
 #endif
+#if defined(HAVE_AVX2_INTRINSICS) && defined(VLC_CPU_AVX2)
+    if( vlc_CPU_AVX2() )
+    {
+        p_sys->pf_merge = chroma->pixel_size == 1 ? Merge8BitAVX2 : Merge16BitAVX2;
+        p_sys->pf_end_merge = NULL;
+    }
+    else
+#endif
 #if defined(CAN_COMPILE_SSE2)
     if( vlc_CPU_SSE2() )
     {
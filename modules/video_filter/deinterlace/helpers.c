@@ -28,6 +28,17 @@
 #ifdef CAN_COMPILE_MMXEXT
 #   include "mmx.h"
 #endif
+#ifdef __SSE2__
+#   include <emmintrin.h>
+#endif
+#if defined(HAVE_AVX2_INTRINSICS) && defined(VLC_CPU_AVX2)
+#   include <immintrin.h>
+#   define CAN_COMPILE_AVX2 1
+#endif
+#if defined(__arm__) && defined(__ARM_NEON__)
+#   include <arm_neon.h>
+#   define CAN_COMPILE_NEON 1
+#endif
 
 #include <stdint.h>
 #include <assert.h>
@@ -245,6 +256,77 @@ static int TestForMotionInBlockMMX( uint8_t *p_pix_p, uint8_t *p_pix_c,
     return (i_motion >= 8);
 }
 #endif
+
+#ifdef __SSE2__
+static int TestForMotionInBlockSSE2( uint8_t *p_pix_p, uint8_t *p_pix_c,
+                                     int i_pitch_prev, int i_pitch_curr,
+                                     int* pi_top, int* pi_bot )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bT1  = _mm_set1_epi8( T + 1 );
+    __m128i score = zero; /* per byte counts, top field in the low half */
+
+    for( int y = 0; y < 8; y += 2 )
+    {
+        __m128i c = _mm_unpacklo_epi64(
+            _mm_loadl_epi64( (const __m128i *)p_pix_c ),
+            _mm_loadl_epi64( (const __m128i *)(p_pix_c + i_pitch_curr) ) );
+        __m128i p = _mm_unpacklo_epi64(
+            _mm_loadl_epi64( (const __m128i *)p_pix_p ),
+            _mm_loadl_epi64( (const __m128i *)(p_pix_p + i_pitch_prev) ) );
+        __m128i d = _mm_or_si128( _mm_subs_epu8( c, p ),
+                                  _mm_subs_epu8( p, c ) );
+
+        /* d > T, unsigned: the mask is -1, so subtracting it counts */
+        score = _mm_sub_epi8( score,
+                              _mm_cmpeq_epi8( _mm_max_epu8( d, bT1 ), d ) );
+
+        p_pix_c += 2 * i_pitch_curr;
+        p_pix_p += 2 * i_pitch_prev;
+    }
+
+    __m128i sum = _mm_sad_epu8( score, zero );
+    int i_top_motion = _mm_cvtsi128_si32( sum );
+    int i_bot_motion = _mm_cvtsi128_si32( _mm_srli_si128( sum, 8 ) );
+
+    (*pi_top) = ( i_top_motion >= 8 );
+    (*pi_bot) = ( i_bot_motion >= 8 );
+    return (i_top_motion + i_bot_motion >= 8);
+}
+#endif
+
+#ifdef CAN_COMPILE_NEON
+static int TestForMotionInBlockNEON( uint8_t *p_pix_p, uint8_t *p_pix_c,
+                                     int i_pitch_prev, int i_pitch_curr,
+                                     int* pi_top, int* pi_bot )
+{
+    const uint8x8_t bT = vdup_n_u8( T );
+    uint8x8_t top = vdup_n_u8( 0 );
+    uint8x8_t bot = vdup_n_u8( 0 );
+
+    for( int y = 0; y < 8; y += 2 )
+    {
+        uint8x8_t d = vabd_u8( vld1_u8( p_pix_c ), vld1_u8( p_pix_p ) );
+        top = vsub_u8( top, vcgt_u8( d, bT ) );
+        p_pix_c += i_pitch_curr;
+        p_pix_p += i_pitch_prev;
+
+        d = vabd_u8( vld1_u8( p_pix_c ), vld1_u8( p_pix_p ) );
+        bot = vsub_u8( bot, vcgt_u8( d, bT ) );
+        p_pix_c += i_pitch_curr;
+        p_pix_p += i_pitch_prev;
+    }
+
+    uint64x1_t sum_top = vpaddl_u32( vpaddl_u16( vpaddl_u8( top ) ) );
+    uint64x1_t sum_bot = vpaddl_u32( vpaddl_u16( vpaddl_u8( bot ) ) );
+    int i_top_motion = vget_lane_u64( sum_top, 0 );
+    int i_bot_motion = vget_lane_u64( sum_bot, 0 );
+
+    (*pi_top) = ( i_top_motion >= 8 );
+    (*pi_bot) = ( i_bot_motion >= 8 );
+    return (i_top_motion + i_bot_motion >= 8);
+}
+#endif
 #undef T
 
 /*****************************************************************************
@@ -392,13 +474,24 @@ int EstimateNumBlocksWithMotion( const picture_t* p_prev,
     if( p_prev->i_planes != p_curr->i_planes )
         return -1;
 
-    int (*motion_in_block)(uint8_t *, uint8_t *, int , int, int *, int *) =
-        TestForMotionInBlock;
-    /* We must tell our inline helper whether to use MMX acceleration. */
+    int (*motion_in_block)(uint8_t *, uint8_t *, int , int, int *, int *);
+    /* We must tell our inline helper whether to use SIMD acceleration. */
+#ifdef __SSE2__
+    if (vlc_CPU_SSE2())
+        motion_in_block = TestForMotionInBlockSSE2;
+    else
+#endif
 #ifdef CAN_COMPILE_MMXEXT
     if (vlc_CPU_MMXEXT())
         motion_in_block = TestForMotionInBlockMMX;
+    else
 #endif
+#ifdef CAN_COMPILE_NEON
+    if (vlc_CPU_ARM_NEON())
+        motion_in_block = TestForMotionInBlockNEON;
+    else
+#endif
+        motion_in_block = TestForMotionInBlock;
 
     int i_score = 0;
     for( int i_plane = 0 ; i_plane < p_prev->i_planes ; i_plane++ )
@@ -449,6 +542,158 @@ int EstimateNumBlocksWithMotion( const picture_t* p_prev,
 /* Threshold (value from Transcode 1.1.5) */
 #define T 100
 
+/**
+ * Internal helper function for CalculateInterlaceScore():
+ * counts the combed pixels of one line, given the lines above and below
+ * it in the other field.
+ *
+ * @param p_c Current line
+ * @param p_p Previous line (other field)
+ * @param p_n Next line (other field)
+ * @param w Number of pixels
+ * @return Number of pixels above the comb threshold
+ */
+static int CombLine( const uint8_t *p_c, const uint8_t *p_p,
+                     const uint8_t *p_n, int w )
+{
+    int i_score = 0;
+
+    for( int x = 0; x < w; ++x )
+    {
+        /* Worst case: need 17 bits for "comb". */
+        int_fast32_t C = *p_c;
+        int_fast32_t P = *p_p;
+        int_fast32_t N = *p_n;
+
+        /* Comments in Transcode's filter_ivtc.c attribute this
+           combing metric to Gunnar Thalin.
+
+            The idea is that if the picture is interlaced, both
+            expressions will have the same sign, and this comes
+            up positive. The value T = 100 has been chosen such
+            that a pixel difference of 10 (on average) will
+            trigger the detector.
+        */
+        int_fast32_t comb = (P - C) * (N - C);
+        if( comb > T )
+            ++i_score;
+
+        ++p_c;
+        ++p_p;
+        ++p_n;
+    }
+    return i_score;
+}
+
+/* The vector versions below compute the same full 32-bit products as
+   CombLine(), so that the score does not depend on the CPU. */
+#ifdef __SSE2__
+/* Adds 1 to the counters of acc where the products of a and b exceed T */
+static inline __m128i CombCountSSE2( __m128i acc, __m128i a, __m128i b )
+{
+    const __m128i t = _mm_set1_epi32( T );
+    __m128i lo = _mm_mullo_epi16( a, b );
+    __m128i hi = _mm_mulhi_epi16( a, b );
+
+    acc = _mm_sub_epi32( acc, _mm_cmpgt_epi32( _mm_unpacklo_epi16( lo, hi ),
+                                               t ) );
+    return _mm_sub_epi32( acc, _mm_cmpgt_epi32( _mm_unpackhi_epi16( lo, hi ),
+                                                t ) );
+}
+
+static int CombLineSSE2( const uint8_t *p_c, const uint8_t *p_p,
+                         const uint8_t *p_n, int w )
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    int x;
+
+    for( x = 0; x + 16 <= w; x += 16 )
+    {
+        __m128i c = _mm_loadu_si128( (const __m128i *)&p_c[x] );
+        __m128i p = _mm_loadu_si128( (const __m128i *)&p_p[x] );
+        __m128i n = _mm_loadu_si128( (const __m128i *)&p_n[x] );
+        __m128i cl = _mm_unpacklo_epi8( c, zero );
+        __m128i ch = _mm_unpackhi_epi8( c, zero );
+
+        acc = CombCountSSE2( acc,
+                             _mm_sub_epi16( _mm_unpacklo_epi8( p, zero ), cl ),
+                             _mm_sub_epi16( _mm_unpacklo_epi8( n, zero ), cl ) );
+        acc = CombCountSSE2( acc,
+                             _mm_sub_epi16( _mm_unpackhi_epi8( p, zero ), ch ),
+                             _mm_sub_epi16( _mm_unpackhi_epi8( n, zero ), ch ) );
+    }
+
+    acc = _mm_add_epi32( acc, _mm_srli_si128( acc, 8 ) );
+    acc = _mm_add_epi32( acc, _mm_srli_si128( acc, 4 ) );
+    return _mm_cvtsi128_si32( acc )
+         + CombLine( p_c + x, p_p + x, p_n + x, w - x );
+}
+#endif
+
+#ifdef CAN_COMPILE_AVX2
+VLC_AVX2
+static int CombLineAVX2( const uint8_t *p_c, const uint8_t *p_p,
+                         const uint8_t *p_n, int w )
+{
+    const __m256i t = _mm256_set1_epi32( T );
+    __m256i acc = _mm256_setzero_si256();
+    int x;
+
+    for( x = 0; x + 16 <= w; x += 16 )
+    {
+        __m256i c = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128( (const __m128i *)&p_c[x] ) );
+        __m256i a = _mm256_sub_epi16( _mm256_cvtepu8_epi16(
+            _mm_loadu_si128( (const __m128i *)&p_p[x] ) ), c );
+        __m256i b = _mm256_sub_epi16( _mm256_cvtepu8_epi16(
+            _mm_loadu_si128( (const __m128i *)&p_n[x] ) ), c );
+        __m256i lo = _mm256_mullo_epi16( a, b );
+        __m256i hi = _mm256_mulhi_epi16( a, b );
+
+        /* The unpacks work within 128-bit lanes, which does not matter
+           for counting */
+        acc = _mm256_sub_epi32( acc, _mm256_cmpgt_epi32(
+                                    _mm256_unpacklo_epi16( lo, hi ), t ) );
+        acc = _mm256_sub_epi32( acc, _mm256_cmpgt_epi32(
+                                    _mm256_unpackhi_epi16( lo, hi ), t ) );
+    }
+
+    __m128i sum = _mm_add_epi32( _mm256_castsi256_si128( acc ),
+                                 _mm256_extracti128_si256( acc, 1 ) );
+    sum = _mm_add_epi32( sum, _mm_srli_si128( sum, 8 ) );
+    sum = _mm_add_epi32( sum, _mm_srli_si128( sum, 4 ) );
+    return _mm_cvtsi128_si32( sum )
+         + CombLine( p_c + x, p_p + x, p_n + x, w - x );
+}
+#endif
+
+#ifdef CAN_COMPILE_NEON
+static int CombLineNEON( const uint8_t *p_c, const uint8_t *p_p,
+                         const uint8_t *p_n, int w )
+{
+    const int32x4_t t = vdupq_n_s32( T );
+    uint32x4_t acc = vdupq_n_u32( 0 );
+    int x;
+
+    for( x = 0; x + 8 <= w; x += 8 )
+    {
+        uint8x8_t c = vld1_u8( &p_c[x] );
+        int16x8_t a = vreinterpretq_s16_u16( vsubl_u8( vld1_u8( &p_p[x] ), c ) );
+        int16x8_t b = vreinterpretq_s16_u16( vsubl_u8( vld1_u8( &p_n[x] ), c ) );
+        int32x4_t lo = vmull_s16( vget_low_s16( a ), vget_low_s16( b ) );
+        int32x4_t hi = vmull_s16( vget_high_s16( a ), vget_high_s16( b ) );
+
+        acc = vsubq_u32( acc, vcgtq_s32( lo, t ) );
+        acc = vsubq_u32( acc, vcgtq_s32( hi, t ) );
+    }
+
+    uint64x2_t sum = vpaddlq_u32( acc );
+    return vgetq_lane_u64( sum, 0 ) + vgetq_lane_u64( sum, 1 )
+         + CombLine( p_c + x, p_p + x, p_n + x, w - x );
+}
+#endif
+
 #ifdef CAN_COMPILE_MMXEXT
 VLC_MMX
 static int CalculateInterlaceScoreMMX( const picture_t* p_pic_top,
@@ -602,10 +847,28 @@ int CalculateInterlaceScore( const picture_t* p_pic_top,
     if( p_pic_top->i_planes != p_pic_bot->i_planes )
         return -1;
 
+    int (*comb_line)( const uint8_t *, const uint8_t *, const uint8_t *, int );
+#ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+        comb_line = CombLineAVX2;
+    else
+#endif
+#ifdef __SSE2__
+    if (vlc_CPU_SSE2())
+        comb_line = CombLineSSE2;
+    else
+#endif
 #ifdef CAN_COMPILE_MMXEXT
     if (vlc_CPU_MMXEXT())
         return CalculateInterlaceScoreMMX( p_pic_top, p_pic_bot );
+    else
+#endif
+#ifdef CAN_COMPILE_NEON
+    if (vlc_CPU_ARM_NEON())
+        comb_line = CombLineNEON;
+    else
 #endif
+        comb_line = CombLine;
 
     int32_t i_score = 0;
 
@@ -636,30 +899,7 @@ int CalculateInterlaceScore( const picture_t* p_pic_top,
             uint8_t *p_p = &ngh->p[i_plane].p_pixels[(y-1)*wn]; /* prev line */
             uint8_t *p_n = &ngh->p[i_plane].p_pixels[(y+1)*wn]; /* next line */
 
-            for( int x = 0; x < w; ++x )
-            {
-                /* Worst case: need 17 bits for "comb". */
-                int_fast32_t C = *p_c;
-                int_fast32_t P = *p_p;
-                int_fast32_t N = *p_n;
-
-                /* Comments in Transcode's filter_ivtc.c attribute this
-                   combing metric to Gunnar Thalin.
-
-                    The idea is that if the picture is interlaced, both
-                    expressions will have the same sign, and this comes
-                    up positive. The value T = 100 has been chosen such
-                    that a pixel difference of 10 (on average) will
-                    trigger the detector.
-                */
-                int_fast32_t comb = (P - C) * (N - C);
-                if( comb > T )
-                    ++i_score;
-
-                ++p_c;
-                ++p_p;
-                ++p_n;
-            }
+            i_score += comb_line( p_c, p_p, p_n, w );
 
             /* Now the other field - swap current and neighbour pictures */
             const picture_t *tmp = cur;
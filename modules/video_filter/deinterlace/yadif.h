@@ -82,13 +82,15 @@ DECLARE_ASM_CONST(16, const xmm_reg, pw_1) = {0x0001000100010001ULL, 0x000100010
 
 #define FFABS abs
 
+/* xs is the distance between horizontally adjacent samples of the plane:
+ * 1, or 2 for the interleaved U/V plane of semi-planar chromas. */
 #define CHECK(j)\
-    {   int score = FFABS(cur[mrefs-1+(j)] - cur[prefs-1-(j)])\
-                  + FFABS(cur[mrefs  +(j)] - cur[prefs  -(j)])\
-                  + FFABS(cur[mrefs+1+(j)] - cur[prefs+1-(j)]);\
+    {   int score = FFABS(cur[mrefs+((j)-1)*xs] - cur[prefs-((j)+1)*xs])\
+                  + FFABS(cur[mrefs+ (j)   *xs] - cur[prefs- (j)   *xs])\
+                  + FFABS(cur[mrefs+((j)+1)*xs] - cur[prefs-((j)-1)*xs]);\
         if (score < spatial_score) {\
             spatial_score= score;\
-            spatial_pred= (cur[mrefs  +(j)] + cur[prefs  -(j)])>>1;\
+            spatial_pred= (cur[mrefs+(j)*xs] + cur[prefs-(j)*xs])>>1;\
 
 #define FILTER \
     for (x = 0;  x < w; x++) { \
@@ -100,8 +102,8 @@ DECLARE_ASM_CONST(16, const xmm_reg, pw_1) = {0x0001000100010001ULL, 0x000100010
         int temporal_diff2 =(FFABS(next[mrefs] - c) + FFABS(next[prefs] - e) )>>1; \
         int diff = FFMAX3(temporal_diff0>>1, temporal_diff1, temporal_diff2); \
         int spatial_pred = (c+e)>>1; \
-        int spatial_score = FFABS(cur[mrefs-1] - cur[prefs-1]) + FFABS(c-e) \
-                          + FFABS(cur[mrefs+1] - cur[prefs+1]) - 1; \
+        int spatial_score = FFABS(cur[mrefs-xs] - cur[prefs-xs]) + FFABS(c-e) \
+                          + FFABS(cur[mrefs+xs] - cur[prefs+xs]) - 1; \
  \
         CHECK(-1) CHECK(-2) }} }} \
         CHECK( 1) CHECK( 2) }} }} \
@@ -130,14 +132,14 @@ DECLARE_ASM_CONST(16, const xmm_reg, pw_1) = {0x0001000100010001ULL, 0x000100010
         next2++; \
     }
 
-static void yadif_filter_line_c(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode) {
+static inline void yadif_filter_line_c_step(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode, int xs) {
     int x;
     uint8_t *prev2= parity ? prev : cur ;
     uint8_t *next2= parity ? cur  : next;
     FILTER
 }
 
-static void yadif_filter_line_c_16bit(uint16_t *dst, uint16_t *prev, uint16_t *cur, uint16_t *next, int w, int prefs, int mrefs, int parity, int mode) {
+static inline void yadif_filter_line_c_16bit_step(uint16_t *dst, uint16_t *prev, uint16_t *cur, uint16_t *next, int w, int prefs, int mrefs, int parity, int mode, int xs) {
     int x;
     uint16_t *prev2= parity ? prev : cur ;
     uint16_t *next2= parity ? cur  : next;
@@ -145,3 +147,214 @@ static void yadif_filter_line_c_16bit(uint16_t *dst, uint16_t *prev, uint16_t *c
     prefs /= 2;
     FILTER
 }
+
+static void yadif_filter_line_c(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode) {
+    yadif_filter_line_c_step(dst, prev, cur, next, w, prefs, mrefs, parity, mode, 1);
+}
+
+static void yadif_filter_line_c_interleaved(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode) {
+    yadif_filter_line_c_step(dst, prev, cur, next, w, prefs, mrefs, parity, mode, 2);
+}
+
+static void yadif_filter_line_c_16bit(uint16_t *dst, uint16_t *prev, uint16_t *cur, uint16_t *next, int w, int prefs, int mrefs, int parity, int mode) {
+    yadif_filter_line_c_16bit_step(dst, prev, cur, next, w, prefs, mrefs, parity, mode, 1);
+}
+
+static void yadif_filter_line_c_16bit_interleaved(uint16_t *dst, uint16_t *prev, uint16_t *cur, uint16_t *next, int w, int prefs, int mrefs, int parity, int mode) {
+    yadif_filter_line_c_16bit_step(dst, prev, cur, next, w, prefs, mrefs, parity, mode, 2);
+}
+
+/* The intrinsics versions use the C code for the last pixels of a line */
+#define TAIL_8  yadif_filter_line_c
+#define TAIL_16 yadif_filter_line_c_16bit
+#define TAIL_8_INTERLEAVED  yadif_filter_line_c_interleaved
+#define TAIL_16_INTERLEAVED yadif_filter_line_c_16bit_interleaved
+
+#if defined(HAVE_AVX2_INTRINSICS) && defined(VLC_CPU_AVX2)
+// ================ AVX2 ================
+#include <immintrin.h>
+#define HAVE_YADIF_AVX2
+#define VLC_TARGET VLC_AVX2
+#define vec_t  __m256i
+#define mask_t __m256i
+#define VAND(a, b) _mm256_and_si256(a, b)
+#define VSEL(m, a, b) _mm256_blendv_epi8(b, a, m)
+
+#define RENAME(a) a ## _avx2
+#define pixel uint8_t
+#define STEP 16
+#define TAIL TAIL_8
+#define TAIL_INTERLEAVED TAIL_8_INTERLEAVED
+#define VLOAD(p) _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(p)))
+#define VSTORE(p, v) \
+    _mm_storeu_si128((__m128i *)(p), \
+                     _mm_packus_epi16(_mm256_castsi256_si128(v), \
+                                      _mm256_extracti128_si256(v, 1)))
+#define VADD(a, b) _mm256_add_epi16(a, b)
+#define VSUB(a, b) _mm256_sub_epi16(a, b)
+#define VSHR1(a) _mm256_srai_epi16(a, 1)
+#define VABS(a) _mm256_abs_epi16(a)
+#define VMIN(a, b) _mm256_min_epi16(a, b)
+#define VMAX(a, b) _mm256_max_epi16(a, b)
+#define VNEG(a) _mm256_sub_epi16(_mm256_setzero_si256(), a)
+#define VLT(a, b) _mm256_cmpgt_epi16(b, a)
+#define VSET1(k) _mm256_set1_epi16(k)
+#include "yadif_simd.h"
+#undef RENAME
+#undef pixel
+#undef STEP
+#undef TAIL
+#undef TAIL_INTERLEAVED
+#undef VLOAD
+#undef VSTORE
+#undef VADD
+#undef VSUB
+#undef VSHR1
+#undef VABS
+#undef VMIN
+#undef VMAX
+#undef VNEG
+#undef VLT
+#undef VSET1
+
+#define RENAME(a) a ## _avx2_16bit
+#define pixel uint16_t
+#define STEP 8
+#define TAIL TAIL_16
+#define TAIL_INTERLEAVED TAIL_16_INTERLEAVED
+#define VLOAD(p) _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(p)))
+#define VSTORE(p, v) \
+    _mm_storeu_si128((__m128i *)(p), \
+                     _mm_packus_epi32(_mm256_castsi256_si128(v), \
+                                      _mm256_extracti128_si256(v, 1)))
+#define VADD(a, b) _mm256_add_epi32(a, b)
+#define VSUB(a, b) _mm256_sub_epi32(a, b)
+#define VSHR1(a) _mm256_srai_epi32(a, 1)
+#define VABS(a) _mm256_abs_epi32(a)
+#define VMIN(a, b) _mm256_min_epi32(a, b)
+#define VMAX(a, b) _mm256_max_epi32(a, b)
+#define VNEG(a) _mm256_sub_epi32(_mm256_setzero_si256(), a)
+#define VLT(a, b) _mm256_cmpgt_epi32(b, a)
+#define VSET1(k) _mm256_set1_epi32(k)
+#include "yadif_simd.h"
+#undef RENAME
+#undef pixel
+#undef STEP
+#undef TAIL
+#undef TAIL_INTERLEAVED
+#undef VLOAD
+#undef VSTORE
+#undef VADD
+#undef VSUB
+#undef VSHR1
+#undef VABS
+#undef VMIN
+#undef VMAX
+#undef VNEG
+#undef VLT
+#undef VSET1
+
+#undef VLC_TARGET
+#undef vec_t
+#undef mask_t
+#undef VAND
+#undef VSEL
+#endif
+
+#if defined(__arm__) && defined(__ARM_NEON__)
+// ================ NEON ================
+#include <arm_neon.h>
+#define HAVE_YADIF_NEON
+#define VLC_TARGET
+
+#define RENAME(a) a ## _neon
+#define pixel uint8_t
+#define STEP 8
+#define TAIL TAIL_8
+#define TAIL_INTERLEAVED TAIL_8_INTERLEAVED
+#define vec_t  int16x8_t
+#define mask_t uint16x8_t
+#define VLOAD(p) vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p)))
+#define VSTORE(p, v) vst1_u8(p, vqmovun_s16(v))
+#define VADD(a, b) vaddq_s16(a, b)
+#define VSUB(a, b) vsubq_s16(a, b)
+#define VSHR1(a) vshrq_n_s16(a, 1)
+#define VABS(a) vabsq_s16(a)
+#define VMIN(a, b) vminq_s16(a, b)
+#define VMAX(a, b) vmaxq_s16(a, b)
+#define VNEG(a) vnegq_s16(a)
+#define VLT(a, b) vcltq_s16(a, b)
+#define VAND(a, b) vandq_u16(a, b)
+#define VSEL(m, a, b) vbslq_s16(m, a, b)
+#define VSET1(k) vdupq_n_s16(k)
+#include "yadif_simd.h"
+#undef RENAME
+#undef pixel
+#undef STEP
+#undef TAIL
+#undef TAIL_INTERLEAVED
+#undef vec_t
+#undef mask_t
+#undef VLOAD
+#undef VSTORE
+#undef VADD
+#undef VSUB
+#undef VSHR1
+#undef VABS
+#undef VMIN
+#undef VMAX
+#undef VNEG
+#undef VLT
+#undef VAND
+#undef VSEL
+#undef VSET1
+
+#define RENAME(a) a ## _neon_16bit
+#define pixel uint16_t
+#define STEP 4
+#define TAIL TAIL_16
+#define TAIL_INTERLEAVED TAIL_16_INTERLEAVED
+#define vec_t  int32x4_t
+#define mask_t uint32x4_t
+#define VLOAD(p) vreinterpretq_s32_u32(vmovl_u16(vld1_u16(p)))
+#define VSTORE(p, v) vst1_u16(p, vqmovun_s32(v))
+#define VADD(a, b) vaddq_s32(a, b)
+#define VSUB(a, b) vsubq_s32(a, b)
+#define VSHR1(a) vshrq_n_s32(a, 1)
+#define VABS(a) vabsq_s32(a)
+#define VMIN(a, b) vminq_s32(a, b)
+#define VMAX(a, b) vmaxq_s32(a, b)
+#define VNEG(a) vnegq_s32(a)
+#define VLT(a, b) vcltq_s32(a, b)
+#define VAND(a, b) vandq_u32(a, b)
+#define VSEL(m, a, b) vbslq_s32(m, a, b)
+#define VSET1(k) vdupq_n_s32(k)
+#include "yadif_simd.h"
+#undef RENAME
+#undef pixel
+#undef STEP
+#undef TAIL
+#undef TAIL_INTERLEAVED
+#undef vec_t
+#undef mask_t
+#undef VLOAD
+#undef VSTORE
+#undef VADD
+#undef VSUB
+#undef VSHR1
+#undef VABS
+#undef VMIN
+#undef VMAX
+#undef VNEG
+#undef VLT
+#undef VAND
+#undef VSEL
+#undef VSET1
+
+#undef VLC_TARGET
+#endif
+
+#undef TAIL_8
+#undef TAIL_16
+#undef TAIL_8_INTERLEAVED
+#undef TAIL_16_INTERLEAVED
@@ -0,0 +1,144 @@
+/*****************************************************************************
+ * yadif_simd.h : Yadif filter_line on vector intrinsics
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* This is the FILTER macro of yadif.h, written once for any vector unit.
+ * Pixels are widened to lanes twice their size, so that the sums and
+ * differences cannot overflow and results are bit-exact with the C code.
+ *
+ * The including file defines:
+ *  RENAME(a), VLC_TARGET, pixel, STEP (pixels per vector),
+ *  vec_t, mask_t, VLOAD(p) (widening load), VSTORE(p, v) (narrowing store),
+ *  VADD, VSUB, VSHR1 (arithmetic shift by 1), VABS, VMIN, VMAX, VNEG,
+ *  VLT(a, b) (a < b mask), VAND (of masks), VSEL(m, a, b) (m ? a : b),
+ *  VSET1, and TAIL and TAIL_INTERLEAVED, the C functions filtering the
+ *  remaining pixels of a plain and of an interleaved U/V line.
+ *
+ * As in the C code, w is in pixels while prefs and mrefs are in bytes, and
+ * xs is the distance between horizontally adjacent samples. */
+
+#define VABSDIFF(a, b) VABS(VSUB(a, b))
+#define SCORE(j) \
+    VADD(VADD(VABSDIFF(VLOAD(&cur[x + m + ((j) - 1) * xs]), \
+                       VLOAD(&cur[x + p - ((j) + 1) * xs])), \
+              VABSDIFF(VLOAD(&cur[x + m + (j) * xs]), \
+                       VLOAD(&cur[x + p - (j) * xs]))), \
+         VABSDIFF(VLOAD(&cur[x + m + ((j) + 1) * xs]), \
+                  VLOAD(&cur[x + p - ((j) - 1) * xs])))
+#define PRED(j) \
+    VSHR1(VADD(VLOAD(&cur[x + m + (j) * xs]), VLOAD(&cur[x + p - (j) * xs])))
+/* The nested C CHECK()s become masks: the second offset of a direction
+ * only counts where the first one did. */
+#define UPDATE(j) \
+    score = VSEL(ok, s, score); \
+    pred  = VSEL(ok, PRED(j), pred);
+
+VLC_TARGET
+static inline void RENAME(yadif_filter_step)(uint8_t *dst8, uint8_t *prev8,
+                                             uint8_t *cur8, uint8_t *next8,
+                                             int w, int prefs, int mrefs,
+                                             int parity, int mode, int xs)
+{
+    pixel *dst = (pixel *)dst8;
+    const pixel *prev = (const pixel *)prev8;
+    const pixel *cur  = (const pixel *)cur8;
+    const pixel *next = (const pixel *)next8;
+    const pixel *prev2 = parity ? prev : cur;
+    const pixel *next2 = parity ? cur  : next;
+    const int p = prefs / (int)sizeof(pixel);
+    const int m = mrefs / (int)sizeof(pixel);
+    int x;
+
+    for (x = 0; x + STEP <= w; x += STEP) {
+        vec_t c  = VLOAD(&cur[x + m]);
+        vec_t e  = VLOAD(&cur[x + p]);
+        vec_t p2 = VLOAD(&prev2[x]);
+        vec_t n2 = VLOAD(&next2[x]);
+        vec_t d  = VSHR1(VADD(p2, n2));
+
+        vec_t diff0 = VSHR1(VABSDIFF(p2, n2));
+        vec_t diff1 = VSHR1(VADD(VABSDIFF(VLOAD(&prev[x + m]), c),
+                                 VABSDIFF(VLOAD(&prev[x + p]), e)));
+        vec_t diff2 = VSHR1(VADD(VABSDIFF(VLOAD(&next[x + m]), c),
+                                 VABSDIFF(VLOAD(&next[x + p]), e)));
+        vec_t diff  = VMAX(VMAX(diff0, diff1), diff2);
+
+        vec_t pred  = VSHR1(VADD(c, e));
+        vec_t score = VSUB(VADD(VADD(VABSDIFF(VLOAD(&cur[x + m - xs]),
+                                              VLOAD(&cur[x + p - xs])),
+                                     VABSDIFF(c, e)),
+                                VABSDIFF(VLOAD(&cur[x + m + xs]),
+                                         VLOAD(&cur[x + p + xs]))),
+                           VSET1(1));
+        vec_t s;
+        mask_t ok;
+
+        s = SCORE(-1); ok = VLT(s, score);          UPDATE(-1)
+        s = SCORE(-2); ok = VAND(ok, VLT(s, score)); UPDATE(-2)
+        s = SCORE( 1); ok = VLT(s, score);          UPDATE( 1)
+        s = SCORE( 2); ok = VAND(ok, VLT(s, score)); UPDATE( 2)
+
+        if (mode < 2) {
+            vec_t b = VSHR1(VADD(VLOAD(&prev2[x + 2 * m]),
+                                 VLOAD(&next2[x + 2 * m])));
+            vec_t f = VSHR1(VADD(VLOAD(&prev2[x + 2 * p]),
+                                 VLOAD(&next2[x + 2 * p])));
+            vec_t de = VSUB(d, e), dc = VSUB(d, c);
+            vec_t bc = VSUB(b, c), fe = VSUB(f, e);
+            vec_t max = VMAX(VMAX(de, dc), VMIN(bc, fe));
+            vec_t min = VMIN(VMIN(de, dc), VMAX(bc, fe));
+
+            diff = VMAX(VMAX(diff, min), VNEG(max));
+        }
+
+        /* diff is never negative, so this is the C clipping */
+        pred = VMIN(VMAX(pred, VSUB(d, diff)), VADD(d, diff));
+        VSTORE(&dst[x], pred);
+    }
+
+    if (x < w)
+        (xs == 1 ? TAIL : TAIL_INTERLEAVED)
+            ((void *)(dst + x), (void *)(prev + x), (void *)(cur + x),
+             (void *)(next + x), w - x, prefs, mrefs, parity, mode);
+}
+
+VLC_TARGET
+static void RENAME(yadif_filter_line)(uint8_t *dst, uint8_t *prev,
+                                      uint8_t *cur, uint8_t *next,
+                                      int w, int prefs, int mrefs,
+                                      int parity, int mode)
+{
+    RENAME(yadif_filter_step)(dst, prev, cur, next, w, prefs, mrefs,
+                              parity, mode, 1);
+}
+
+VLC_TARGET
+static void RENAME(yadif_filter_line_interleaved)(uint8_t *dst, uint8_t *prev,
+                                                  uint8_t *cur, uint8_t *next,
+                                                  int w, int prefs, int mrefs,
+                                                  int parity, int mode)
+{
+    RENAME(yadif_filter_step)(dst, prev, cur, next, w, prefs, mrefs,
+                              parity, mode, 2);
+}
+
+#undef UPDATE
+#undef PRED
+#undef SCORE
+#undef VABSDIFF
@@ -183,13 +183,106 @@ static void Destroy( vlc_object_t *p_this )
     free( p_filter->p_sys );
 }
 
+typedef struct
+{
+    const picture_t *p_pic;
+    picture_t *p_outpic;
+    int i_plane;
+} gaussianblur_slice_t;
+
+static void FilterHorizontal( filter_t *p_filter, void *p_data,
+                              unsigned i_slice, unsigned i_slices )
+{
+    const gaussianblur_slice_t *p_slice = p_data;
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const picture_t *p_pic = p_slice->p_pic;
+    const int i_plane = p_slice->i_plane;
+    const int i_dim = p_sys->i_dim;
+    type_t *pt_buffer = p_sys->pt_buffer;
+    const type_t *pt_distribution = p_sys->pt_distribution;
+
+    const uint8_t *p_in = p_pic->p[i_plane].p_pixels;
+
+    const int i_visible_lines = p_pic->p[i_plane].i_visible_lines;
+    const int i_visible_pitch = p_pic->p[i_plane].i_visible_pitch;
+    const int i_in_pitch = p_pic->p[i_plane].i_pitch;
+
+    int i_line, i_col;
+    const int x_factor = p_pic->p[Y_PLANE].i_visible_pitch/i_visible_pitch-1;
+
+    for( i_line = filter_SliceRow( i_slice, i_slices, i_visible_lines );
+         i_line < (int)filter_SliceRow( i_slice + 1, i_slices, i_visible_lines );
+         i_line++ )
+    {
+        for( i_col = 0; i_col < i_visible_pitch ; i_col++ )
+        {
+            type_t t_value = 0;
+            int x;
+            const int c = i_line*i_in_pitch+i_col;
+            for( x = __MAX( -i_dim, -i_col*(x_factor+1) );
+                 x <= __MIN( i_dim, (i_visible_pitch - i_col)*(x_factor+1) + 1 );
+                 x++ )
+            {
+                t_value += pt_distribution[x+i_dim] *
+                           p_in[c+(x>>x_factor)];
+            }
+            pt_buffer[c] = t_value;
+        }
+    }
+}
+
+static void FilterVertical( filter_t *p_filter, void *p_data,
+                            unsigned i_slice, unsigned i_slices )
+{
+    const gaussianblur_slice_t *p_slice = p_data;
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const picture_t *p_pic = p_slice->p_pic;
+    const int i_plane = p_slice->i_plane;
+    const int i_dim = p_sys->i_dim;
+    const type_t *pt_buffer = p_sys->pt_buffer;
+    const type_t *pt_scale = p_sys->pt_scale;
+    const type_t *pt_distribution = p_sys->pt_distribution;
+
+    uint8_t *p_out = p_slice->p_outpic->p[i_plane].p_pixels;
+    const int i_out_pitch = p_slice->p_outpic->p[i_plane].i_pitch;
+
+    const int i_visible_lines = p_pic->p[i_plane].i_visible_lines;
+    const int i_visible_pitch = p_pic->p[i_plane].i_visible_pitch;
+    const int i_in_pitch = p_pic->p[i_plane].i_pitch;
+
+    int i_line, i_col;
+    const int x_factor = p_pic->p[Y_PLANE].i_visible_pitch/i_visible_pitch-1;
+    const int y_factor = p_pic->p[Y_PLANE].i_visible_lines/i_visible_lines-1;
+
+    for( i_line = filter_SliceRow( i_slice, i_slices, i_visible_lines );
+         i_line < (int)filter_SliceRow( i_slice + 1, i_slices, i_visible_lines );
+         i_line++ )
+    {
+        for( i_col = 0; i_col < i_visible_pitch ; i_col++ )
+        {
+            type_t t_value = 0;
+            int y;
+            const int c = i_line*i_in_pitch+i_col;
+            for( y = __MAX( -i_dim, (-i_line)*(y_factor+1) );
+                 y <= __MIN( i_dim, (i_visible_lines - i_line)*(y_factor+1) - 1 );
+                 y++ )
+            {
+                t_value += pt_distribution[y+i_dim] *
+                           pt_buffer[c+(y>>y_factor)*i_in_pitch];
+            }
+
+            const type_t t_scale = pt_scale[(i_line<<y_factor)*(i_in_pitch<<x_factor)+(i_col<<x_factor)];
+            p_out[i_line * i_out_pitch + i_col] = (uint8_t)(t_value / t_scale); // FIXME wouldn't it be better to round instead of trunc ?
+        }
+    }
+}
+
 static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 {
     picture_t *p_outpic;
     filter_sys_t *p_sys = p_filter->p_sys;
     int i_plane;
     const int i_dim = p_sys->i_dim;
-    type_t *pt_buffer;
     type_t *pt_scale;
     const type_t *pt_distribution = p_sys->pt_distribution;
 
@@ -208,7 +301,6 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
                                p_pic->p[Y_PLANE].i_pitch * sizeof( type_t ) );
     }
 
-    pt_buffer = p_sys->pt_buffer;
     if( !p_sys->pt_scale )
     {
         const int i_visible_lines = p_pic->p[Y_PLANE].i_visible_lines;
@@ -243,57 +335,18 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         }
     }
 
-    pt_scale = p_sys->pt_scale;
     for( i_plane = 0 ; i_plane < p_pic->i_planes ; i_plane++ )
     {
-
-        uint8_t *p_in = p_pic->p[i_plane].p_pixels;
-        uint8_t *p_out = p_outpic->p[i_plane].p_pixels;
-
-        const int i_visible_lines = p_pic->p[i_plane].i_visible_lines;
-        const int i_visible_pitch = p_pic->p[i_plane].i_visible_pitch;
-        const int i_in_pitch = p_pic->p[i_plane].i_pitch;
-
-        int i_line, i_col;
-        const int x_factor = p_pic->p[Y_PLANE].i_visible_pitch/i_visible_pitch-1;
-        const int y_factor = p_pic->p[Y_PLANE].i_visible_lines/i_visible_lines-1;
-
-        for( i_line = 0 ; i_line < i_visible_lines ; i_line++ )
-        {
-            for( i_col = 0; i_col < i_visible_pitch ; i_col++ )
-            {
-                type_t t_value = 0;
-                int x;
-                const int c = i_line*i_in_pitch+i_col;
-                for( x = __MAX( -i_dim, -i_col*(x_factor+1) );
-                     x <= __MIN( i_dim, (i_visible_pitch - i_col)*(x_factor+1) + 1 );
-                     x++ )
-                {
-                    t_value += pt_distribution[x+i_dim] *
-                               p_in[c+(x>>x_factor)];
-                }
-                pt_buffer[c] = t_value;
-            }
-        }
-        for( i_line = 0 ; i_line < i_visible_lines ; i_line++ )
-        {
-            for( i_col = 0; i_col < i_visible_pitch ; i_col++ )
-            {
-                type_t t_value = 0;
-                int y;
-                const int c = i_line*i_in_pitch+i_col;
-                for( y = __MAX( -i_dim, (-i_line)*(y_factor+1) );
-                     y <= __MIN( i_dim, (i_visible_lines - i_line)*(y_factor+1) - 1 );
-                     y++ )
-                {
-                    t_value += pt_distribution[y+i_dim] *
-                               pt_buffer[c+(y>>y_factor)*i_in_pitch];
-                }
-
-                const type_t t_scale = pt_scale[(i_line<<y_factor)*(i_in_pitch<<x_factor)+(i_col<<x_factor)];
-                p_out[i_line * p_outpic->p[i_plane].i_pitch + i_col] = (uint8_t)(t_value / t_scale); // FIXME wouldn't it be better to round instead of trunc ?
-            }
-        }
+        gaussianblur_slice_t slice = {
+            .p_pic = p_pic,
+            .p_outpic = p_outpic,
+            .i_plane = i_plane,
+        };
+        const unsigned i_max = p_pic->p[i_plane].i_visible_lines / 16;
+
+        /* The vertical pass needs the rows of the neighbouring slices */
+        filter_RunSlices( p_filter, i_max, FilterHorizontal, &slice );
+        filter_RunSlices( p_filter, i_max, FilterVertical, &slice );
     }
 
     return CopyInfoAndRelease( p_outpic, p_pic );
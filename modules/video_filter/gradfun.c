@@ -106,6 +106,7 @@ struct filter_sys_t {
     int              radius;
     const vlc_chroma_description_t *chroma;
     struct vf_priv_s cfg;
+    uint16_t         *buf[PICTURE_PLANE_MAX]; /* one per plane, as planes run in parallel */
 };
 
 static int Open(vlc_object_t *object)
@@ -129,7 +130,8 @@ static int Open(vlc_object_t *object)
     sys->radius   = var_CreateGetIntegerCommand(filter, CFG_PREFIX "radius");
     var_AddCallback(filter, CFG_PREFIX "strength", Callback, NULL);
     var_AddCallback(filter, CFG_PREFIX "radius",   Callback, NULL);
-    sys->cfg.buf = NULL;
+    for (int i = 0; i < PICTURE_PLANE_MAX; i++)
+        sys->buf[i] = NULL;
 
     struct vf_priv_s *cfg = &sys->cfg;
     cfg->thresh      = 0.0;
@@ -166,11 +168,49 @@ static void Close(vlc_object_t *object)
 
     var_DelCallback(filter, CFG_PREFIX "radius",   Callback, NULL);
     var_DelCallback(filter, CFG_PREFIX "strength", Callback, NULL);
-    vlc_free(sys->cfg.buf);
+    for (int i = 0; i < PICTURE_PLANE_MAX; i++)
+        vlc_free(sys->buf[i]);
     vlc_mutex_destroy(&sys->lock);
     free(sys);
 }
 
+typedef struct {
+    picture_t *src;
+    picture_t *dst;
+} gradfun_slice_t;
+
+/* The blur state runs down whole planes, so slices are sets of planes */
+static void FilterSlice(filter_t *filter, void *data,
+                        unsigned slice, unsigned slices)
+{
+    filter_sys_t *sys = filter->p_sys;
+    const gradfun_slice_t *job = data;
+    const video_format_t *fmt = &filter->fmt_in.video;
+    const int planes = job->dst->i_planes;
+
+    for (int i = filter_SliceRow(slice, slices, planes);
+         i < (int)filter_SliceRow(slice + 1, slices, planes); i++) {
+        const plane_t *srcp = &job->src->p[i];
+        plane_t       *dstp = &job->dst->p[i];
+        struct vf_priv_s cfg = sys->cfg;
+
+        cfg.buf = sys->buf[i];
+
+        const vlc_chroma_description_t *chroma = sys->chroma;
+        int w = fmt->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
+        int h = fmt->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
+        int r = (cfg.radius  * chroma->p[i].w.num / chroma->p[i].w.den +
+                 cfg.radius  * chroma->p[i].h.num / chroma->p[i].h.den) / 2;
+        r = VLC_CLIP((r + 1) & ~1, RADIUS_MIN, RADIUS_MAX);
+        if (__MIN(w, h) > 2 * r && cfg.buf) {
+            filter_plane(&cfg, dstp->p_pixels, srcp->p_pixels,
+                         w, h, dstp->i_pitch, srcp->i_pitch, r);
+        } else {
+            plane_CopyPixels(dstp, srcp);
+        }
+    }
+}
+
 static picture_t *Filter(filter_t *filter, picture_t *src)
 {
     filter_sys_t *sys = filter->p_sys;
@@ -192,28 +232,16 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
     cfg->thresh = (1 << 15) / strength;
     if (cfg->radius != radius) {
         cfg->radius = radius;
-        cfg->buf    = vlc_memalign(16,
-                                   (((fmt->i_width + 15) & ~15) * (cfg->radius + 1) / 2 + 32) * sizeof(*cfg->buf));
-    }
-
-    for (int i = 0; i < dst->i_planes; i++) {
-        const plane_t *srcp = &src->p[i];
-        plane_t       *dstp = &dst->p[i];
-
-        const vlc_chroma_description_t *chroma = sys->chroma;
-        int w = fmt->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
-        int h = fmt->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
-        int r = (cfg->radius  * chroma->p[i].w.num / chroma->p[i].w.den +
-                 cfg->radius  * chroma->p[i].h.num / chroma->p[i].h.den) / 2;
-        r = VLC_CLIP((r + 1) & ~1, RADIUS_MIN, RADIUS_MAX);
-        if (__MIN(w, h) > 2 * r && cfg->buf) {
-            filter_plane(cfg, dstp->p_pixels, srcp->p_pixels,
-                         w, h, dstp->i_pitch, srcp->i_pitch, r);
-        } else {
-            plane_CopyPixels(dstp, srcp);
+        for (unsigned i = 0; i < sys->chroma->plane_count; i++) {
+            vlc_free(sys->buf[i]);
+            sys->buf[i] = vlc_memalign(16,
+                                       (((fmt->i_width + 15) & ~15) * (cfg->radius + 1) / 2 + 32) * sizeof(*sys->buf[i]));
         }
     }
 
+    gradfun_slice_t slice = { .src = src, .dst = dst };
+    filter_RunSlices(filter, dst->i_planes, FilterSlice, &slice);
+
     picture_CopyProperties(dst, src);
     picture_Release(src);
     return dst;
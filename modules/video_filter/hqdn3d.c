@@ -91,6 +91,7 @@ struct filter_sys_t
 {
     const vlc_chroma_description_t *chroma;
     int w[3], h[3];
+    int wmax;
 
     float luma_spat;
     float chroma_spat;
@@ -140,7 +141,9 @@ static int Open(vlc_object_t *this)
         if (sys->w[i] > wmax) wmax = sys->w[i];
         sys->h[i] = fmt_out->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
     }
-    cfg->Line = malloc(wmax*sizeof(int));
+    /* One line buffer per plane, as the planes are denoised in parallel */
+    sys->wmax = wmax;
+    cfg->Line = malloc(3*wmax*sizeof(int));
     if (!cfg->Line) {
         free(sys);
         return VLC_ENOMEM;
@@ -188,11 +191,37 @@ static void Close(vlc_object_t *this)
 /*****************************************************************************
  * Filter
  *****************************************************************************/
-static picture_t *Filter(filter_t *filter, picture_t *src)
-{
+typedef struct {
+    picture_t *src;
     picture_t *dst;
+} hqdn3d_slice_t;
+
+/* Each plane carries its own temporal and line state, so slices are sets
+ * of planes rather than bands of rows */
+static void FilterSlice(filter_t *filter, void *data,
+                        unsigned slice, unsigned slices)
+{
     filter_sys_t *sys = filter->p_sys;
     struct vf_priv_s *cfg = &sys->cfg;
+    const hqdn3d_slice_t *job = data;
+
+    for (unsigned i = filter_SliceRow(slice, slices, 3);
+         i < filter_SliceRow(slice + 1, slices, 3); i++) {
+        const int spat = i ? 2 : 0;
+
+        deNoise(job->src->p[i].p_pixels, job->dst->p[i].p_pixels,
+                cfg->Line + i * sys->wmax, &cfg->Frame[i],
+                sys->w[i], sys->h[i],
+                job->src->p[i].i_pitch, job->dst->p[i].i_pitch,
+                cfg->Coefs[spat],
+                cfg->Coefs[spat],
+                cfg->Coefs[spat + 1]);
+    }
+}
+
+static picture_t *Filter(filter_t *filter, picture_t *src)
+{
+    picture_t *dst;
 
     if (!src) return NULL;
 
@@ -202,24 +231,8 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
         return NULL;
     }
 
-    deNoise(src->p[0].p_pixels, dst->p[0].p_pixels,
-            cfg->Line, &cfg->Frame[0], sys->w[0], sys->h[0],
-            src->p[0].i_pitch, dst->p[0].i_pitch,
-            cfg->Coefs[0],
-            cfg->Coefs[0],
-            cfg->Coefs[1]);
-    deNoise(src->p[1].p_pixels, dst->p[1].p_pixels,
-            cfg->Line, &cfg->Frame[1], sys->w[1], sys->h[1],
-            src->p[1].i_pitch, dst->p[1].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-    deNoise(src->p[2].p_pixels, dst->p[2].p_pixels,
-            cfg->Line, &cfg->Frame[2], sys->w[2], sys->h[2],
-            src->p[2].i_pitch, dst->p[2].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
+    hqdn3d_slice_t slice = { .src = src, .dst = dst };
+    filter_RunSlices(filter, 3, FilterSlice, &slice);
 
     return CopyInfoAndRelease(dst, src);
 }
@@ -1,8 +1,9 @@
 /*****************************************************************************
  * scale.c: video scaling module for YUVP/A, I420 and RGBA pictures
- *  Uses the low quality "nearest neighbour" algorithm.
+ *  Uses separable bilinear or bicubic filters, or the low quality
+ *  "nearest neighbour" algorithm.
  *****************************************************************************
- * Copyright (C) 2003-2007 VLC authors and VideoLAN
+ * Copyright (C) 2003-2013 VLC authors and VideoLAN
  * $Id$
  *
  * Authors: Gildas Bazin <gbazin@videolan.org>
@@ -30,92 +31,527 @@
 # include "config.h"
 #endif
 
+#include <math.h>
+
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#ifdef __SSE2__
+#   include <emmintrin.h>
+#endif
+#if defined(HAVE_AVX2_INTRINSICS) && defined(VLC_CPU_AVX2)
+#   include <immintrin.h>
+#   define CAN_COMPILE_AVX2 1
+#endif
+#if defined(__arm__) && defined(__ARM_NEON__)
+#   include <arm_neon.h>
+#   define CAN_COMPILE_NEON 1
+#endif
 
 /****************************************************************************
  * Local prototypes
  ****************************************************************************/
 static int  OpenFilter ( vlc_object_t * );
+static void CloseFilter( vlc_object_t * );
 static picture_t *Filter( filter_t *, picture_t * );
 
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
+#define MODE_TEXT N_("Scaling mode")
+#define MODE_LONGTEXT N_("Scaling mode to use.")
+
+enum
+{
+    SCALE_NEAREST,
+    SCALE_BILINEAR,
+    SCALE_BICUBIC,
+};
+
+static const int pi_mode_values[] = { SCALE_NEAREST, SCALE_BILINEAR,
+                                      SCALE_BICUBIC };
+static const char *const ppsz_mode_descriptions[] =
+{ N_("Nearest neighbour (bad quality)"), N_("Bilinear"),
+  N_("Bicubic (good quality)") };
+
 vlc_module_begin ()
     set_description( N_("Video scaling filter") )
+    set_category( CAT_VIDEO )
+    set_subcategory( SUBCAT_VIDEO_VFILTER )
     set_capability( "video filter2", 10 )
-    set_callbacks( OpenFilter, NULL )
+    add_integer( "scale-mode", SCALE_BILINEAR, MODE_TEXT, MODE_LONGTEXT,
+                 true )
+        change_integer_list( pi_mode_values, ppsz_mode_descriptions )
+    set_callbacks( OpenFilter, CloseFilter )
 vlc_module_end ()
 
 /*****************************************************************************
- * OpenFilter: probe the filter and return score
+ * Separable scaler
+ *****************************************************************************
+ * Pictures are scaled horizontally into 16 bits lines, then vertically.
+ * The filter coefficients of each output column and row are computed once
+ * for a given geometry. They are scaled by 1 << COEF_BITS and sum to it;
+ * the intermediate samples keep TMP_BITS bits of fraction.
  *****************************************************************************/
-static int OpenFilter( vlc_object_t *p_this )
+#define COEF_BITS 14
+#define TMP_BITS  6
+#define HSHIFT    (COEF_BITS - TMP_BITS)
+#define VSHIFT    (COEF_BITS + TMP_BITS)
+
+typedef struct
 {
-    filter_t *p_filter = (filter_t*)p_this;
+    unsigned i_src;         /* input samples */
+    unsigned i_dst;         /* output samples */
+    unsigned i_taps;        /* coefficients per output sample */
+    int      *pi_pos;       /* first input sample of each output one */
+    int16_t  *pi_coefs;     /* i_taps coefficients per output sample */
+} scale_filter_t;
 
-    if( ( p_filter->fmt_in.video.i_chroma != VLC_CODEC_YUVP &&
-          p_filter->fmt_in.video.i_chroma != VLC_CODEC_YUVA &&
-          p_filter->fmt_in.video.i_chroma != VLC_CODEC_I420 &&
-          p_filter->fmt_in.video.i_chroma != VLC_CODEC_YV12 &&
-          p_filter->fmt_in.video.i_chroma != VLC_CODEC_RGB32 &&
-          p_filter->fmt_in.video.i_chroma != VLC_CODEC_RGBA ) ||
-        p_filter->fmt_in.video.i_chroma != p_filter->fmt_out.video.i_chroma )
+typedef struct
+{
+    scale_filter_t h;
+    scale_filter_t v;
+    unsigned i_pixel_size;  /* interleaved samples per pixel */
+    size_t   i_tmp_pitch;   /* in samples */
+    int16_t *p_tmp;         /* i_src lines of the horizontal pass */
+} scale_plane_t;
+
+typedef void (*vscale_line_t)( uint8_t *, const int16_t *const *,
+                               const int16_t *, unsigned, unsigned );
+
+struct filter_sys_t
+{
+    int           i_mode;
+    vscale_line_t pf_vscale;
+
+    /* Geometry of the cached filters */
+    unsigned      i_src_width, i_src_height;
+    unsigned      i_dst_width, i_dst_height;
+    int           i_planes;
+    scale_plane_t planes[PICTURE_PLANE_MAX];
+};
+
+static double Kernel( int i_mode, double x )
+{
+    x = fabs( x );
+    if( i_mode == SCALE_BICUBIC ) /* Catmull-Rom spline */
     {
-        return VLC_EGENERIC;
+        if( x < 1. )
+            return ( 1.5 * x - 2.5 ) * x * x + 1.;
+        if( x < 2. )
+            return ( ( -0.5 * x + 2.5 ) * x - 4. ) * x + 2.;
+        return 0.;
     }
+    return x < 1. ? 1. - x : 0.;
+}
 
-    video_format_ScaleCropAr( &p_filter->fmt_out.video, &p_filter->fmt_in.video );
-    p_filter->pf_video_filter = Filter;
+static void FilterClean( scale_filter_t *f )
+{
+    free( f->pi_pos );
+    free( f->pi_coefs );
+    f->pi_pos = NULL;
+    f->pi_coefs = NULL;
+}
 
-    msg_Dbg( p_filter, "%ix%i -> %ix%i", p_filter->fmt_in.video.i_width,
-             p_filter->fmt_in.video.i_height, p_filter->fmt_out.video.i_width,
-             p_filter->fmt_out.video.i_height );
+/* Computes the coefficients resizing i_src samples to i_dst. The taps
+ * falling outside of the input are folded onto its edges. */
+static int FilterInit( scale_filter_t *f, int i_mode,
+                       unsigned i_src, unsigned i_dst )
+{
+    const double scale = (double)i_src / i_dst;
+    /* The kernel is stretched when downscaling, so that it keeps covering
+     * all input samples */
+    const double stretch = scale > 1. ? scale : 1.;
+    const double support = ( i_mode == SCALE_BICUBIC ? 2. : 1. ) * stretch;
+    const unsigned i_span = ceil( 2. * support );
+    const unsigned i_taps = __MIN( i_span, i_src );
+
+    f->i_src = i_src;
+    f->i_dst = i_dst;
+    f->i_taps = i_taps;
+    f->pi_pos = malloc( i_dst * sizeof(*f->pi_pos) );
+    f->pi_coefs = malloc( i_dst * i_taps * sizeof(*f->pi_coefs) );
+    if( !f->pi_pos || !f->pi_coefs )
+    {
+        FilterClean( f );
+        return VLC_ENOMEM;
+    }
 
+    for( unsigned i = 0; i < i_dst; i++ )
+    {
+        const double center = ( i + .5 ) * scale - .5;
+        const int i_start = floor( center - support ) + 1;
+        const int i_pos = VLC_CLIP( i_start, 0, (int)( i_src - i_taps ) );
+        double pf_weight[i_taps];
+        double sum = 0.;
+
+        for( unsigned t = 0; t < i_taps; t++ )
+            pf_weight[t] = 0.;
+        for( unsigned t = 0; t < i_span; t++ )
+        {
+            const int s = VLC_CLIP( i_start + (int)t, 0, (int)i_src - 1 );
+            const double w = Kernel( i_mode, ( i_start + (int)t - center ) / stretch );
+
+            pf_weight[s - i_pos] += w;
+            sum += w;
+        }
+
+        /* Normalize, the rounding error goes to the largest coefficient */
+        int16_t *pi_coefs = &f->pi_coefs[i * i_taps];
+        int i_sum = 0;
+        unsigned i_max = 0;
+        for( unsigned t = 0; t < i_taps; t++ )
+        {
+            pi_coefs[t] = lrint( pf_weight[t] / sum * ( 1 << COEF_BITS ) );
+            i_sum += pi_coefs[t];
+            if( pi_coefs[t] > pi_coefs[i_max] )
+                i_max = t;
+        }
+        pi_coefs[i_max] += ( 1 << COEF_BITS ) - i_sum;
+        f->pi_pos[i] = i_pos;
+    }
     return VLC_SUCCESS;
 }
 
-/****************************************************************************
- * Filter: the whole thing
- ****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void PlanesClean( filter_sys_t *p_sys )
 {
-    picture_t *p_pic_dst;
-    int i_plane;
+    for( int i = 0; i < p_sys->i_planes; i++ )
+    {
+        FilterClean( &p_sys->planes[i].h );
+        FilterClean( &p_sys->planes[i].v );
+        free( p_sys->planes[i].p_tmp );
+    }
+    p_sys->i_planes = 0;
+}
 
-    if( !p_pic ) return NULL;
+/* Tells whether plane i interleaves the U and V samples */
+static bool IsSemiPlanarChroma( const vlc_chroma_description_t *p_dsc,
+                                unsigned i )
+{
+    return p_dsc->plane_count == 2 && i == 1;
+}
 
-    if( (p_filter->fmt_in.video.i_height == 0) ||
-        (p_filter->fmt_in.video.i_width == 0) )
-        return NULL;
+/* Builds the filters of every plane for the current geometry, unless they
+ * are up to date */
+static int PlanesInit( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const video_format_t *p_in = &p_filter->fmt_in.video;
+    const video_format_t *p_out = &p_filter->fmt_out.video;
 
-    if( (p_filter->fmt_out.video.i_height == 0) ||
-        (p_filter->fmt_out.video.i_width == 0) )
-        return NULL;
+    if( p_sys->i_planes > 0 &&
+        p_sys->i_src_width == p_in->i_width &&
+        p_sys->i_src_height == p_in->i_height &&
+        p_sys->i_dst_width == p_out->i_width &&
+        p_sys->i_dst_height == p_out->i_height )
+        return VLC_SUCCESS;
 
-    video_format_ScaleCropAr( &p_filter->fmt_out.video, &p_filter->fmt_in.video );
+    PlanesClean( p_sys );
 
-    /* Request output picture */
-    p_pic_dst = filter_NewPicture( p_filter );
-    if( !p_pic_dst )
+    const vlc_chroma_description_t *p_dsc =
+        vlc_fourcc_GetChromaDescription( p_in->i_chroma );
+    if( !p_dsc )
+        return VLC_EGENERIC;
+
+    for( unsigned i = 0; i < p_dsc->plane_count; i++ )
     {
-        picture_Release( p_pic );
-        return NULL;
+        scale_plane_t *p_plane = &p_sys->planes[i];
+        /* The chroma plane of NV12 holds U/V pairs at half the width */
+        const bool b_pairs = IsSemiPlanarChroma( p_dsc, i );
+        const unsigned i_w_num = b_pairs ? 1 : p_dsc->p[i].w.num;
+        const unsigned i_w_den = b_pairs ? 2 : p_dsc->p[i].w.den;
+#define PLANE_SIZE( size, num, den ) ( ( (size) * (num) + (den) - 1 ) / (den) )
+        const unsigned i_src_w = PLANE_SIZE( p_in->i_width, i_w_num, i_w_den );
+        const unsigned i_src_h = PLANE_SIZE( p_in->i_height, p_dsc->p[i].h.num,
+                                             p_dsc->p[i].h.den );
+        const unsigned i_dst_w = PLANE_SIZE( p_out->i_width, i_w_num, i_w_den );
+        const unsigned i_dst_h = PLANE_SIZE( p_out->i_height, p_dsc->p[i].h.num,
+                                             p_dsc->p[i].h.den );
+#undef PLANE_SIZE
+
+        p_plane->i_pixel_size = p_dsc->pixel_size * ( b_pairs ? 2 : 1 );
+        p_plane->i_tmp_pitch = ( i_dst_w * p_plane->i_pixel_size + 15 ) & ~15;
+        p_plane->p_tmp = malloc( p_plane->i_tmp_pitch * i_src_h *
+                                 sizeof(*p_plane->p_tmp) );
+        p_sys->i_planes++;
+
+        if( !p_plane->p_tmp ||
+            FilterInit( &p_plane->h, p_sys->i_mode, i_src_w, i_dst_w ) ||
+            FilterInit( &p_plane->v, p_sys->i_mode, i_src_h, i_dst_h ) )
+        {
+            PlanesClean( p_sys );
+            return VLC_ENOMEM;
+        }
+    }
+
+    p_sys->i_src_width = p_in->i_width;
+    p_sys->i_src_height = p_in->i_height;
+    p_sys->i_dst_width = p_out->i_width;
+    p_sys->i_dst_height = p_out->i_height;
+    return VLC_SUCCESS;
+}
+
+/* Scales one line horizontally */
+static void HScaleLine( int16_t *p_dst, const uint8_t *p_src,
+                        const scale_filter_t *f, unsigned i_pixel_size )
+{
+    for( unsigned x = 0; x < f->i_dst; x++ )
+    {
+        const uint8_t *p_in = &p_src[f->pi_pos[x] * i_pixel_size];
+        const int16_t *pi_coefs = &f->pi_coefs[x * f->i_taps];
+
+        for( unsigned k = 0; k < i_pixel_size; k++ )
+        {
+            int i_sum = 1 << ( HSHIFT - 1 );
+
+            for( unsigned t = 0; t < f->i_taps; t++ )
+                i_sum += pi_coefs[t] * p_in[t * i_pixel_size + k];
+            *p_dst++ = i_sum >> HSHIFT;
+        }
+    }
+}
+
+/* Scales i_width samples vertically, from the i_taps lines of pp_lines,
+ * starting at sample x */
+static void VScaleLineFrom( uint8_t *p_dst, const int16_t *const *pp_lines,
+                            const int16_t *pi_coefs, unsigned i_taps,
+                            unsigned x, unsigned i_width )
+{
+    for( ; x < i_width; x++ )
+    {
+        int i_sum = 1 << ( VSHIFT - 1 );
+
+        for( unsigned t = 0; t < i_taps; t++ )
+            i_sum += pi_coefs[t] * pp_lines[t][x];
+        p_dst[x] = clip_uint8_vlc( i_sum >> VSHIFT );
+    }
+}
+
+static void VScaleLine( uint8_t *p_dst, const int16_t *const *pp_lines,
+                        const int16_t *pi_coefs, unsigned i_taps,
+                        unsigned i_width )
+{
+    VScaleLineFrom( p_dst, pp_lines, pi_coefs, i_taps, 0, i_width );
+}
+
+/* The vector versions accumulate two lines at a time with 16x16 bits
+ * multiply-adds, the sums cannot overflow 32 bits so they are bit-exact. */
+#define COEF_PAIR( t ) \
+    ( ( t ) + 1 < i_taps \
+      ? (int)( (uint16_t)pi_coefs[t] | ( (uint32_t)(uint16_t)pi_coefs[( t ) + 1] << 16 ) ) \
+      : (int)(uint16_t)pi_coefs[t] )
+#define NEXT_LINE( t ) \
+    ( ( t ) + 1 < i_taps ? pp_lines[( t ) + 1] : pp_lines[t] )
+
+#ifdef __SSE2__
+static void VScaleLineSSE2( uint8_t *p_dst, const int16_t *const *pp_lines,
+                            const int16_t *pi_coefs, unsigned i_taps,
+                            unsigned i_width )
+{
+    unsigned x;
+
+    for( x = 0; x + 8 <= i_width; x += 8 )
+    {
+        __m128i lo = _mm_set1_epi32( 1 << ( VSHIFT - 1 ) );
+        __m128i hi = lo;
+
+        for( unsigned t = 0; t < i_taps; t += 2 )
+        {
+            const __m128i c = _mm_set1_epi32( COEF_PAIR( t ) );
+            const __m128i a = _mm_loadu_si128( (const __m128i *)&pp_lines[t][x] );
+            const __m128i b = _mm_loadu_si128( (const __m128i *)&NEXT_LINE( t )[x] );
+
+            lo = _mm_add_epi32( lo, _mm_madd_epi16( _mm_unpacklo_epi16( a, b ), c ) );
+            hi = _mm_add_epi32( hi, _mm_madd_epi16( _mm_unpackhi_epi16( a, b ), c ) );
+        }
+        const __m128i v = _mm_packs_epi32( _mm_srai_epi32( lo, VSHIFT ),
+                                           _mm_srai_epi32( hi, VSHIFT ) );
+        _mm_storel_epi64( (__m128i *)&p_dst[x], _mm_packus_epi16( v, v ) );
     }
+    VScaleLineFrom( p_dst, pp_lines, pi_coefs, i_taps, x, i_width );
+}
+#endif
+
+#ifdef CAN_COMPILE_AVX2
+VLC_AVX2
+static void VScaleLineAVX2( uint8_t *p_dst, const int16_t *const *pp_lines,
+                            const int16_t *pi_coefs, unsigned i_taps,
+                            unsigned i_width )
+{
+    unsigned x;
+
+    for( x = 0; x + 16 <= i_width; x += 16 )
+    {
+        __m256i lo = _mm256_set1_epi32( 1 << ( VSHIFT - 1 ) );
+        __m256i hi = lo;
+
+        for( unsigned t = 0; t < i_taps; t += 2 )
+        {
+            const __m256i c = _mm256_set1_epi32( COEF_PAIR( t ) );
+            const __m256i a = _mm256_loadu_si256( (const __m256i *)&pp_lines[t][x] );
+            const __m256i b = _mm256_loadu_si256( (const __m256i *)&NEXT_LINE( t )[x] );
+
+            lo = _mm256_add_epi32( lo, _mm256_madd_epi16( _mm256_unpacklo_epi16( a, b ), c ) );
+            hi = _mm256_add_epi32( hi, _mm256_madd_epi16( _mm256_unpackhi_epi16( a, b ), c ) );
+        }
+        /* The unpacks and packs work within 128 bits lanes: the packs
+         * restore the sample order of each lane, the permute joins the
+         * lanes */
+        __m256i v = _mm256_packs_epi32( _mm256_srai_epi32( lo, VSHIFT ),
+                                        _mm256_srai_epi32( hi, VSHIFT ) );
+        v = _mm256_permute4x64_epi64( _mm256_packus_epi16( v, v ), 0x08 );
+        _mm_storeu_si128( (__m128i *)&p_dst[x], _mm256_castsi256_si128( v ) );
+    }
+    VScaleLineFrom( p_dst, pp_lines, pi_coefs, i_taps, x, i_width );
+}
+#endif
+
+#undef NEXT_LINE
+#undef COEF_PAIR
+
+#ifdef CAN_COMPILE_NEON
+static void VScaleLineNEON( uint8_t *p_dst, const int16_t *const *pp_lines,
+                            const int16_t *pi_coefs, unsigned i_taps,
+                            unsigned i_width )
+{
+    unsigned x;
+
+    for( x = 0; x + 8 <= i_width; x += 8 )
+    {
+        int32x4_t lo = vdupq_n_s32( 0 );
+        int32x4_t hi = lo;
+
+        for( unsigned t = 0; t < i_taps; t++ )
+        {
+            const int16x8_t a = vld1q_s16( &pp_lines[t][x] );
+
+            lo = vmlal_n_s16( lo, vget_low_s16( a ), pi_coefs[t] );
+            hi = vmlal_n_s16( hi, vget_high_s16( a ), pi_coefs[t] );
+        }
+        const int16x8_t v = vcombine_s16( vqmovn_s32( vrshrq_n_s32( lo, VSHIFT ) ),
+                                          vqmovn_s32( vrshrq_n_s32( hi, VSHIFT ) ) );
+        vst1_u8( &p_dst[x], vqmovun_s16( v ) );
+    }
+    VScaleLineFrom( p_dst, pp_lines, pi_coefs, i_taps, x, i_width );
+}
+#endif
+
+typedef struct
+{
+    const picture_t *p_src;
+    picture_t       *p_dst;
+} scale_slice_t;
+
+/* Horizontal pass of the i_slice-th band of input lines of every plane */
+static void HScaleSlice( filter_t *p_filter, void *p_data,
+                         unsigned i_slice, unsigned i_slices )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const scale_slice_t *p_slice = p_data;
+
+    for( int i = 0; i < p_sys->i_planes; i++ )
+    {
+        const scale_plane_t *p_plane = &p_sys->planes[i];
+        const plane_t *p_in = &p_slice->p_src->p[i];
+        const unsigned i_end = filter_SliceRow( i_slice + 1, i_slices,
+                                                p_plane->v.i_src );
+
+        for( unsigned y = filter_SliceRow( i_slice, i_slices,
+                                           p_plane->v.i_src ); y < i_end; y++ )
+            HScaleLine( &p_plane->p_tmp[y * p_plane->i_tmp_pitch],
+                        &p_in->p_pixels[y * p_in->i_pitch],
+                        &p_plane->h, p_plane->i_pixel_size );
+    }
+}
+
+/* Vertical pass of the i_slice-th band of output lines of every plane */
+static void VScaleSlice( filter_t *p_filter, void *p_data,
+                         unsigned i_slice, unsigned i_slices )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const scale_slice_t *p_slice = p_data;
+
+    for( int i = 0; i < p_sys->i_planes; i++ )
+    {
+        const scale_plane_t *p_plane = &p_sys->planes[i];
+        const scale_filter_t *v = &p_plane->v;
+        plane_t *p_out = &p_slice->p_dst->p[i];
+        const unsigned i_width = p_plane->h.i_dst * p_plane->i_pixel_size;
+        const unsigned i_end = filter_SliceRow( i_slice + 1, i_slices,
+                                                v->i_dst );
+        const int16_t *pp_lines[v->i_taps];
+
+        for( unsigned y = filter_SliceRow( i_slice, i_slices, v->i_dst );
+             y < i_end; y++ )
+        {
+            for( unsigned t = 0; t < v->i_taps; t++ )
+                pp_lines[t] = &p_plane->p_tmp[( v->pi_pos[y] + t ) *
+                                              p_plane->i_tmp_pitch];
+            p_sys->pf_vscale( &p_out->p_pixels[y * p_out->i_pitch], pp_lines,
+                              &v->pi_coefs[y * v->i_taps], v->i_taps,
+                              i_width );
+        }
+    }
+}
+
+static int ScaleSeparable( filter_t *p_filter, const picture_t *p_pic,
+                           picture_t *p_pic_dst )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( PlanesInit( p_filter ) )
+        return VLC_EGENERIC;
+
+    /* Pictures from a pool may be larger than the format, but not smaller */
+    for( int i = 0; i < p_sys->i_planes; i++ )
+    {
+        const scale_plane_t *p_plane = &p_sys->planes[i];
+
+        if( i >= p_pic->i_planes || i >= p_pic_dst->i_planes ||
+            p_pic->p[i].i_lines < (int)p_plane->v.i_src ||
+            p_pic->p[i].i_pitch < (int)( p_plane->h.i_src * p_plane->i_pixel_size ) ||
+            p_pic_dst->p[i].i_lines < (int)p_plane->v.i_dst ||
+            p_pic_dst->p[i].i_pitch < (int)( p_plane->h.i_dst * p_plane->i_pixel_size ) )
+            return VLC_EGENERIC;
+    }
+
+    scale_slice_t slice = { .p_src = p_pic, .p_dst = p_pic_dst };
+
+    filter_RunSlices( p_filter, p_sys->planes[0].v.i_src / 16,
+                      HScaleSlice, &slice );
+    filter_RunSlices( p_filter, p_sys->planes[0].v.i_dst / 16,
+                      VScaleSlice, &slice );
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * ScaleNearest: nearest neighbour scaling
+ *****************************************************************************/
+static void ScaleNearest( filter_t *p_filter, const picture_t *p_pic,
+                          picture_t *p_pic_dst )
+{
+    int i_plane;
+    const vlc_chroma_description_t *p_dsc =
+        vlc_fourcc_GetChromaDescription( p_filter->fmt_in.video.i_chroma );
 
     if( p_filter->fmt_in.video.i_chroma != VLC_CODEC_RGBA &&
         p_filter->fmt_in.video.i_chroma != VLC_CODEC_RGB32 )
     {
         for( i_plane = 0; i_plane < p_pic_dst->i_planes; i_plane++ )
         {
+            /* U/V pairs move together */
+            const int i_pixel = p_dsc && IsSemiPlanarChroma( p_dsc, i_plane )
+                              ? 2 : 1;
             const int i_src_pitch    = p_pic->p[i_plane].i_pitch;
             const int i_dst_pitch    = p_pic_dst->p[i_plane].i_pitch;
             const int i_src_height   = p_filter->fmt_in.video.i_height;
-            const int i_src_width    = p_filter->fmt_in.video.i_width;
+            const int i_src_width    = ( p_filter->fmt_in.video.i_width
+                                         + i_pixel - 1 ) / i_pixel;
             const int i_dst_height   = p_filter->fmt_out.video.i_height;
-            const int i_dst_width    = p_filter->fmt_out.video.i_width;
+            const int i_dst_width    = ( p_filter->fmt_out.video.i_width
+                                         + i_pixel - 1 ) / i_pixel;
             const int i_dst_visible_lines =
                                        p_pic_dst->p[i_plane].i_visible_lines;
             const int i_dst_visible_pitch =
@@ -146,6 +582,19 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
                 uint8_t *p_srcl = p_src
                        + (__MIN( i_src_height_1, l >> SHIFT_SIZE )*i_src_pitch);
 
+                if( i_pixel == 2 )
+                {
+                    for( int x = 0; x < i_dst_width; x++, k += i_width_coef )
+                    {
+                        const uint8_t *p_pair = &p_srcl[2 *
+                            __MIN( i_src_width_1, k >> SHIFT_SIZE )];
+                        p_dst[2 * x]     = p_pair[0];
+                        p_dst[2 * x + 1] = p_pair[1];
+                    }
+                    p_dst = p_dstendline;
+                    continue;
+                }
+
                 for( ; p_dst < p_dstendline; p_dst++, k += i_width_coef )
                 {
                     *p_dst = p_srcl[__MIN( i_src_width_1, k >> SHIFT_SIZE )];
@@ -196,6 +645,108 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             }
         }
     }
+}
+
+/*****************************************************************************
+ * OpenFilter: probe the filter and return score
+ *****************************************************************************/
+static int OpenFilter( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t*)p_this;
+    filter_sys_t *p_sys;
+
+    if( ( p_filter->fmt_in.video.i_chroma != VLC_CODEC_YUVP &&
+          p_filter->fmt_in.video.i_chroma != VLC_CODEC_YUVA &&
+          p_filter->fmt_in.video.i_chroma != VLC_CODEC_I420 &&
+          p_filter->fmt_in.video.i_chroma != VLC_CODEC_YV12 &&
+          p_filter->fmt_in.video.i_chroma != VLC_CODEC_NV12 &&
+          p_filter->fmt_in.video.i_chroma != VLC_CODEC_NV21 &&
+          p_filter->fmt_in.video.i_chroma != VLC_CODEC_RGB32 &&
+          p_filter->fmt_in.video.i_chroma != VLC_CODEC_RGBA ) ||
+        p_filter->fmt_in.video.i_chroma != p_filter->fmt_out.video.i_chroma )
+    {
+        return VLC_EGENERIC;
+    }
+
+    p_filter->p_sys = p_sys = calloc( 1, sizeof(*p_sys) );
+    if( !p_sys )
+        return VLC_ENOMEM;
+
+    /* Palette indexes cannot be interpolated */
+    p_sys->i_mode = var_InheritInteger( p_filter, "scale-mode" );
+    if( p_filter->fmt_in.video.i_chroma == VLC_CODEC_YUVP )
+        p_sys->i_mode = SCALE_NEAREST;
+
+#ifdef CAN_COMPILE_AVX2
+    if( vlc_CPU_AVX2() )
+        p_sys->pf_vscale = VScaleLineAVX2;
+    else
+#endif
+#ifdef __SSE2__
+    if( vlc_CPU_SSE2() )
+        p_sys->pf_vscale = VScaleLineSSE2;
+    else
+#endif
+#ifdef CAN_COMPILE_NEON
+    if( vlc_CPU_ARM_NEON() )
+        p_sys->pf_vscale = VScaleLineNEON;
+    else
+#endif
+        p_sys->pf_vscale = VScaleLine;
+
+    video_format_ScaleCropAr( &p_filter->fmt_out.video, &p_filter->fmt_in.video );
+    p_filter->pf_video_filter = Filter;
+
+    msg_Dbg( p_filter, "%ix%i -> %ix%i (%s)", p_filter->fmt_in.video.i_width,
+             p_filter->fmt_in.video.i_height, p_filter->fmt_out.video.i_width,
+             p_filter->fmt_out.video.i_height,
+             ppsz_mode_descriptions[VLC_CLIP( p_sys->i_mode, SCALE_NEAREST,
+                                              SCALE_BICUBIC )] );
+
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * CloseFilter: clean up the filter
+ *****************************************************************************/
+static void CloseFilter( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t*)p_this;
+
+    PlanesClean( p_filter->p_sys );
+    free( p_filter->p_sys );
+}
+
+/****************************************************************************
+ * Filter: the whole thing
+ ****************************************************************************/
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_pic_dst;
+
+    if( !p_pic ) return NULL;
+
+    if( (p_filter->fmt_in.video.i_height == 0) ||
+        (p_filter->fmt_in.video.i_width == 0) )
+        return NULL;
+
+    if( (p_filter->fmt_out.video.i_height == 0) ||
+        (p_filter->fmt_out.video.i_width == 0) )
+        return NULL;
+
+    video_format_ScaleCropAr( &p_filter->fmt_out.video, &p_filter->fmt_in.video );
+
+    /* Request output picture */
+    p_pic_dst = filter_NewPicture( p_filter );
+    if( !p_pic_dst )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    if( p_filter->p_sys->i_mode == SCALE_NEAREST ||
+        ScaleSeparable( p_filter, p_pic, p_pic_dst ) )
+        ScaleNearest( p_filter, p_pic, p_pic_dst );
 
     picture_CopyProperties( p_pic_dst, p_pic );
     picture_Release( p_pic );
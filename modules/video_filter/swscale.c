@@ -108,6 +108,8 @@ struct filter_sys_t
 static picture_t *Filter( filter_t *, picture_t * );
 static int  Init( filter_t * );
 static void Clean( filter_t * );
+static void CleanPictures( filter_t * );
+static bool IsResizeOnly( const video_format_t *, const video_format_t * );
 
 typedef struct
 {
@@ -152,6 +154,13 @@ static int OpenScaler( vlc_object_t *p_this )
                        &p_filter->fmt_out.video, 0 ) )
         return VLC_EGENERIC;
 
+    /* Narrow pictures would go through padded copies: leave plain resizes
+     * of those to the scale module */
+    if( IsResizeOnly( &p_filter->fmt_in.video, &p_filter->fmt_out.video ) &&
+        __MIN( p_filter->fmt_in.video.i_width,
+               p_filter->fmt_out.video.i_width ) < MINIMUM_WIDTH )
+        return VLC_EGENERIC;
+
     /* */
     p_filter->pf_video_filter = Filter;
     /* Allocate the memory needed to store the decoder's structure */
@@ -254,6 +263,26 @@ static bool IsFmtSimilar( const video_format_t *p_fmt1, const video_format_t *p_
            p_fmt1->i_height == p_fmt2->i_height;
 }
 
+/* Whether the scale module can do this conversion */
+static bool IsResizeOnly( const video_format_t *p_fmti,
+                          const video_format_t *p_fmto )
+{
+    if( p_fmti->i_chroma != p_fmto->i_chroma )
+        return false;
+
+    switch( p_fmti->i_chroma )
+    {
+    case VLC_CODEC_YUVA:
+    case VLC_CODEC_I420:
+    case VLC_CODEC_YV12:
+    case VLC_CODEC_RGB32:
+    case VLC_CODEC_RGBA:
+        return true;
+    default:
+        return false;
+    }
+}
+
 static void FixParameters( int *pi_fmt, bool *pb_has_a, bool *pb_swap_uv, vlc_fourcc_t fmt )
 {
     switch( fmt )
@@ -353,18 +382,21 @@ static int Init( filter_t *p_filter )
     {
         return VLC_SUCCESS;
     }
-    Clean( p_filter );
+    /* The contexts are reused by sws_getCachedContext() when possible */
+    CleanPictures( p_filter );
 
     /* Init with new parameters */
     ScalerConfiguration cfg;
     if( GetParameters( &cfg, p_fmti, p_fmto, p_sys->i_sws_flags ) )
     {
         msg_Err( p_filter, "format not supported" );
+        Clean( p_filter );
         return VLC_EGENERIC;
     }
     if( p_fmti->i_width <= 0 || p_fmto->i_width <= 0 )
     {
         msg_Err( p_filter, "0 width not supported" );
+        Clean( p_filter );
         return VLC_EGENERIC;
     }
 
@@ -375,20 +407,22 @@ static int Init( filter_t *p_filter )
 
     const unsigned i_fmti_width = p_fmti->i_width * p_sys->i_extend_factor;
     const unsigned i_fmto_width = p_fmto->i_width * p_sys->i_extend_factor;
+    if( !cfg.b_has_a && p_sys->ctxA )
+    {
+        sws_freeContext( p_sys->ctxA );
+        p_sys->ctxA = NULL;
+    }
     for( int n = 0; n < (cfg.b_has_a ? 2 : 1); n++ )
     {
         const int i_fmti = n == 0 ? cfg.i_fmti : PIX_FMT_GRAY8;
         const int i_fmto = n == 0 ? cfg.i_fmto : PIX_FMT_GRAY8;
-        struct SwsContext *ctx;
-
-        ctx = sws_getContext( i_fmti_width, p_fmti->i_height, i_fmti,
-                              i_fmto_width, p_fmto->i_height, i_fmto,
-                              cfg.i_sws_flags | p_sys->i_cpu_mask,
-                              p_sys->p_src_filter, p_sys->p_dst_filter, 0 );
-        if( n == 0 )
-            p_sys->ctx = ctx;
-        else
-            p_sys->ctxA = ctx;
+        struct SwsContext **pp_ctx = n == 0 ? &p_sys->ctx : &p_sys->ctxA;
+
+        *pp_ctx = sws_getCachedContext( *pp_ctx,
+                                        i_fmti_width, p_fmti->i_height, i_fmti,
+                                        i_fmto_width, p_fmto->i_height, i_fmto,
+                                        cfg.i_sws_flags | p_sys->i_cpu_mask,
+                                        p_sys->p_src_filter, p_sys->p_dst_filter, 0 );
     }
     if( p_sys->ctxA )
     {
@@ -431,7 +465,7 @@ static int Init( filter_t *p_filter )
 #endif
     return VLC_SUCCESS;
 }
-static void Clean( filter_t *p_filter )
+static void CleanPictures( filter_t *p_filter )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
@@ -445,6 +479,17 @@ static void Clean( filter_t *p_filter )
     if( p_sys->p_dst_a )
         picture_Release( p_sys->p_dst_a );
 
+    p_sys->p_src_a = NULL;
+    p_sys->p_dst_a = NULL;
+    p_sys->p_src_e = NULL;
+    p_sys->p_dst_e = NULL;
+}
+static void Clean( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    CleanPictures( p_filter );
+
     if( p_sys->ctxA )
         sws_freeContext( p_sys->ctxA );
 
@@ -454,10 +499,6 @@ static void Clean( filter_t *p_filter )
     /* We have to set it to null has we call be called again :( */
     p_sys->ctx = NULL;
     p_sys->ctxA = NULL;
-    p_sys->p_src_a = NULL;
-    p_sys->p_dst_a = NULL;
-    p_sys->p_src_e = NULL;
-    p_sys->p_dst_e = NULL;
 }
 
 static void GetPixels( uint8_t *pp_pixel[4], int pi_pitch[4],
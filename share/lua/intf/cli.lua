@@ -382,6 +382,7 @@ function stats(name,client)
     client:append("| video decoded    :    "..string.format("%5i",stats_tab["decoded_video"]))
     client:append("| frames displayed :    "..string.format("%5i",stats_tab["displayed_pictures"]))
     client:append("| frames lost      :    "..string.format("%5i",stats_tab["lost_pictures"]))
+    client:append("| frames copied    :    "..string.format("%5i (%.0f/s)",stats_tab["copied_pictures"],stats_tab["picture_copy_rate"]*1000000))
     client:append("|")
     client:append("+-[Audio Decoding]")
     client:append("| audio decoded    :    "..string.format("%5i",stats_tab["decoded_audio"]))
@@ -1354,7 +1354,8 @@ static void DecoderGetCc( decoder_t *p_dec, decoder_t *p_dec_cc )
 }
 
 static void DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
-                              int *pi_played_sum, int *pi_lost_sum )
+                              int *pi_played_sum, int *pi_lost_sum,
+                              int *pi_copied_sum )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
     vout_thread_t  *p_vout = p_owner->p_vout;
@@ -1459,10 +1460,13 @@ static void DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
         }
         int i_tmp_display;
         int i_tmp_lost;
-        vout_GetResetStatistic( p_vout, &i_tmp_display, &i_tmp_lost );
+        int i_tmp_copied;
+        vout_GetResetStatistic( p_vout, &i_tmp_display, &i_tmp_lost,
+                                &i_tmp_copied );
 
         *pi_played_sum += i_tmp_display;
         *pi_lost_sum += i_tmp_lost;
+        *pi_copied_sum += i_tmp_copied;
 
         if( !b_has_more || b_buffering_first )
             break;
@@ -1483,6 +1487,7 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
     int i_lost = 0;
     int i_decoded = 0;
     int i_displayed = 0;
+    int i_copied = 0;
 
     while( (p_pic = p_dec->pf_decode_video( p_dec, &p_block )) )
     {
@@ -1517,7 +1522,7 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
             ( !p_owner->p_packetizer || !p_owner->p_packetizer->pf_get_cc ) )
             DecoderGetCc( p_dec, p_dec );
 
-        DecoderPlayVideo( p_dec, p_pic, &i_displayed, &i_lost );
+        DecoderPlayVideo( p_dec, p_pic, &i_displayed, &i_lost, &i_copied );
     }
 
     /* Update ugly stat */
@@ -1525,11 +1530,17 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
 
     if( p_input != NULL && (i_decoded > 0 || i_lost > 0 || i_displayed > 0) )
     {
+        uint64_t i_copied_total = 0;
+
         vlc_mutex_lock( &p_input->p->counters.counters_lock );
         stats_Update( p_input->p->counters.p_decoded_video, i_decoded, NULL );
         stats_Update( p_input->p->counters.p_lost_pictures, i_lost , NULL);
         stats_Update( p_input->p->counters.p_displayed_pictures,
                       i_displayed, NULL);
+        stats_Update( p_input->p->counters.p_copied_pictures,
+                      i_copied, &i_copied_total );
+        stats_Update( p_input->p->counters.p_picture_copy_rate,
+                      i_copied_total, NULL );
         vlc_mutex_unlock( &p_input->p->counters.counters_lock );
     }
 }
@@ -1672,6 +1683,13 @@ static void DecoderPlaySout( decoder_t *p_dec, block_t *p_sout_block )
 
         vlc_mutex_unlock( &p_owner->lock );
 
+        /* Shed non-reference frames as early as possible while a muxer
+         * queue is backing up, it also spares transcoding them. */
+        if( !b_reject && sout_InputIsCongested( p_owner->p_sout_input )
+         && sout_BlockIsDisposable( p_owner->p_sout_input->p_fmt,
+                                    p_sout_block ) )
+            b_reject = true;
+
         if( !b_reject )
             sout_InputSendBuffer( p_owner->p_sout_input, p_sout_block ); // FIXME --VLC_TS_INVALID inspect stream_output/*
         else
@@ -2422,8 +2440,10 @@ static picture_t *vout_new_buffer( decoder_t *p_dec )
         /* Check the decoder doesn't leak pictures */
         vout_FixLeaks( p_owner->p_vout );
 
-        /* FIXME add a vout_WaitPictureAvailable (timedwait) */
-        msleep( VOUT_OUTMEM_SLEEP );
+        /* Wait for a picture to be released, still checking the exit and
+         * flush requests from time to time */
+        vout_WaitPictureAvailable( p_owner->p_vout,
+                                   mdate() + VOUT_OUTMEM_SLEEP );
     }
 }
 
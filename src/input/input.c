@@ -852,6 +852,8 @@ static void InitStatistics( input_thread_t * p_input )
         INIT_COUNTER( lost_abuffers, COUNTER );
         INIT_COUNTER( displayed_pictures, COUNTER );
         INIT_COUNTER( lost_pictures, COUNTER );
+        INIT_COUNTER( copied_pictures, COUNTER );
+        INIT_COUNTER( picture_copy_rate, DERIVATIVE );
         INIT_COUNTER( decoded_audio, COUNTER );
         INIT_COUNTER( decoded_video, COUNTER );
         INIT_COUNTER( decoded_sub, COUNTER );
@@ -1331,6 +1333,8 @@ error:
         EXIT_COUNTER( lost_abuffers );
         EXIT_COUNTER( displayed_pictures );
         EXIT_COUNTER( lost_pictures );
+        EXIT_COUNTER( copied_pictures );
+        EXIT_COUNTER( picture_copy_rate );
         EXIT_COUNTER( decoded_audio );
         EXIT_COUNTER( decoded_video );
         EXIT_COUNTER( decoded_sub );
@@ -1404,6 +1408,8 @@ static void End( input_thread_t * p_input )
             CL_CO( lost_abuffers );
             CL_CO( displayed_pictures );
             CL_CO( lost_pictures );
+            CL_CO( copied_pictures );
+            CL_CO( picture_copy_rate );
             CL_CO( decoded_audio) ;
             CL_CO( decoded_video );
             CL_CO( decoded_sub) ;
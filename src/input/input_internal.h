@@ -154,6 +154,8 @@ struct input_thread_private_t
         counter_t *p_lost_abuffers;
         counter_t *p_displayed_pictures;
         counter_t *p_lost_pictures;
+        counter_t *p_copied_pictures;
+        counter_t *p_picture_copy_rate;
         vlc_mutex_t counters_lock;
     } counters;
 
@@ -114,6 +114,8 @@ void stats_ComputeInputStats(input_thread_t *input, input_stats_t *st)
     /* Vouts */
     st->i_displayed_pictures = stats_GetTotal(input->p->counters.p_displayed_pictures);
     st->i_lost_pictures = stats_GetTotal(input->p->counters.p_lost_pictures);
+    st->i_copied_pictures = stats_GetTotal(input->p->counters.p_copied_pictures);
+    st->f_picture_copy_rate = stats_GetRate(input->p->counters.p_picture_copy_rate);
 
     vlc_mutex_unlock(&st->lock);
     vlc_mutex_unlock(&input->p->counters.counters_lock);
@@ -128,6 +130,7 @@ void stats_ReinitInputStats( input_stats_t *p_stats )
     p_stats->f_demux_bitrate = p_stats->f_average_demux_bitrate =
     p_stats->i_demux_corrupted = p_stats->i_demux_discontinuity =
     p_stats->i_displayed_pictures = p_stats->i_lost_pictures =
+    p_stats->i_copied_pictures = p_stats->f_picture_copy_rate =
     p_stats->i_played_abuffers = p_stats->i_lost_abuffers =
     p_stats->i_decoded_video = p_stats->i_decoded_audio =
     p_stats->i_sent_bytes = p_stats->i_sent_packets = p_stats->f_send_bitrate
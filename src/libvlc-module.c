@@ -386,6 +386,11 @@ static const char *const ppsz_pos_descriptions[] =
     "picture quality, for instance deinterlacing, or distort " \
     "the video.")
 
+#define VIDEO_FILTER_THREADS_TEXT N_("Video filter threads")
+#define VIDEO_FILTER_THREADS_LONGTEXT N_( \
+    "Number of threads sharing the work of slice-parallel video filters, " \
+    "including the calling one. 0 uses one per CPU core." )
+
 #define SNAP_PATH_TEXT N_("Video snapshot directory (or filename)")
 #define SNAP_PATH_LONGTEXT N_( \
     "Directory where the video snapshots will be stored.")
@@ -803,6 +808,11 @@ static const char *const ppsz_prefres[] = {
     "Specify an IP address (e.g. ::1 or 127.0.0.1) or a host name " \
     "(e.g. localhost) to restrict them to a specific network interface." )
 
+#define HTTP_THREADS_TEXT N_( "HTTP server threads" )
+#define HTTP_THREADS_LONGTEXT N_( \
+    "Number of threads serving the clients of each HTTP or RTSP server. " \
+    "0 picks one thread per CPU, up to 4." )
+
 #define HTTP_PORT_TEXT N_( "HTTP server port" )
 #define HTTP_PORT_LONGTEXT N_( \
     "The HTTP server will listen on this TCP port. " \
@@ -954,6 +964,18 @@ static const char *const ppsz_prefres[] = {
     "This allow you to configure the initial caching amount for stream output " \
     "muxer. This value should be set in milliseconds." )
 
+#define SOUT_MUX_MAX_BYTES_TEXT N_("Stream output muxer queue size (KiB)")
+#define SOUT_MUX_MAX_BYTES_LONGTEXT N_( \
+    "Maximum amount of data queued for each elementary stream in front " \
+    "of a muxer, e.g. while the output is stalled. Past three quarters of " \
+    "it, non-reference frames are dropped, past it the oldest data is " \
+    "dropped. 0 means unbounded." )
+
+#define SOUT_MUX_MAX_DELAY_TEXT N_("Stream output muxer queue delay (ms)")
+#define SOUT_MUX_MAX_DELAY_LONGTEXT N_( \
+    "Maximum duration of data queued for each elementary stream in front " \
+    "of a muxer. Data is dropped as with the queue size. 0 means unbounded." )
+
 #define PACKETIZER_TEXT N_("Preferred packetizer list")
 #define PACKETIZER_LONGTEXT N_( \
     "This allows you to select the order in which VLC will choose its " \
@@ -1622,6 +1644,9 @@ vlc_module_begin ()
     set_subcategory( SUBCAT_VIDEO_VFILTER )
     add_module_list_cat( "video-filter", SUBCAT_VIDEO_VFILTER, NULL,
                 VIDEO_FILTER_TEXT, VIDEO_FILTER_LONGTEXT, false )
+    add_integer( "video-filter-threads", 0, VIDEO_FILTER_THREADS_TEXT,
+                 VIDEO_FILTER_THREADS_LONGTEXT, true )
+        change_integer_range( 0, 64 )
     add_module_list( "video-splitter", "video splitter", NULL,
                      VIDEO_SPLITTER_TEXT, VIDEO_SPLITTER_LONGTEXT, false )
     add_obsolete_string( "vout-filter" ) /* since 2.0.0 */
@@ -1752,6 +1777,9 @@ vlc_module_begin ()
     add_string( "rtsp-host", NULL, RTSP_HOST_TEXT, RTSP_HOST_LONGTEXT, true )
     add_integer( "rtsp-port", 554, RTSP_PORT_TEXT, RTSP_PORT_LONGTEXT, true )
         change_integer_range( 1, 65535 )
+    add_integer( "http-threads", 0, HTTP_THREADS_TEXT,
+                 HTTP_THREADS_LONGTEXT, true )
+        change_integer_range( 0, 16 )
     add_loadfile( "http-cert", NULL, HTTP_CERT_TEXT, CERT_LONGTEXT, true )
     add_obsolete_string( "sout-http-cert" ) /* since 2.0.0 */
     add_loadfile( "http-key", NULL, HTTP_KEY_TEXT, KEY_LONGTEXT, true )
@@ -1911,6 +1939,12 @@ vlc_module_begin ()
                                 SOUT_SPU_LONGTEXT, true )
     add_integer( "sout-mux-caching", 1500, SOUT_MUX_CACHING_TEXT,
                                 SOUT_MUX_CACHING_LONGTEXT, true )
+    add_integer( "sout-mux-max-bytes", 0, SOUT_MUX_MAX_BYTES_TEXT,
+                                SOUT_MUX_MAX_BYTES_LONGTEXT, true )
+        change_integer_range( 0, 4*1024*1024 )
+    add_integer( "sout-mux-max-delay", 0, SOUT_MUX_MAX_DELAY_TEXT,
+                                SOUT_MUX_MAX_DELAY_LONGTEXT, true )
+        change_integer_range( 0, 600000 )
 
     set_section( N_("VLM"), NULL )
     add_loadfile( "vlm-conf", NULL, VLM_CONF_TEXT,
@@ -110,6 +110,7 @@ libvlc_int_t * libvlc_InternalCreate( void )
     priv->p_playlist = NULL;
     priv->p_dialog_provider = NULL;
     priv->p_vlm = NULL;
+    priv->p_slice_pool = NULL;
 
     vlc_ExitInit( &priv->exit );
 
@@ -535,6 +536,8 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
     if( p_playlist != NULL )
         playlist_Destroy( p_playlist );
 
+    filter_DestroySlicePool( p_libvlc );
+
     msg_Dbg( p_libvlc, "removing stats" );
 
 #if !defined( WIN32 ) && !defined( __OS2__ )
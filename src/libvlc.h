@@ -163,6 +163,7 @@ typedef struct libvlc_priv_t
 #ifdef ENABLE_SOUT
     sap_handler_t     *p_sap; ///< SAP SDP advertiser
 #endif
+    struct filter_slice_pool_t *p_slice_pool; ///< video filter slice workers
     struct vlc_actions *actions; ///< Hotkeys handler
 
     /* Interfaces */
@@ -182,6 +183,7 @@ static inline libvlc_priv_t *libvlc_priv (libvlc_int_t *libvlc)
 
 void playlist_ServicesDiscoveryKillAll( playlist_t *p_playlist );
 void intf_DestroyAll( libvlc_int_t * );
+void filter_DestroySlicePool( libvlc_int_t * );
 
 #define libvlc_stats( o ) (libvlc_priv((VLC_OBJECT(o))->p_libvlc)->b_stats)
 
@@ -39,6 +39,7 @@
 #include <vlc_common.h>
 #include <vlc_block.h>
 #include <vlc_fs.h>
+#include <vlc_atomic.h>
 
 /**
  * @section Block handling functions.
@@ -150,6 +151,130 @@ block_t *block_Alloc (size_t size)
     return b;
 }
 
+/**
+ * @section Shared payloads.
+ * A shared block is a lightweight reference to the payload of another block.
+ * The payload is released together with its last reference.
+ */
+typedef struct
+{
+    vlc_atomic_t refs;
+    block_t     *block; /**< owner of the payload */
+} block_payload_t;
+
+typedef struct
+{
+    block_t          self;
+    block_payload_t *payload;
+} block_shared_t;
+
+static void block_shared_Release (block_t *block)
+{
+    block_payload_t *payload = ((block_shared_t *)block)->payload;
+
+    block_Invalidate (block);
+    if (vlc_atomic_dec (&payload->refs) == 0)
+    {
+        block_Release (payload->block);
+        free (payload);
+    }
+    free (block);
+}
+
+static bool block_IsShared (const block_t *block)
+{
+    return block->pf_release == block_shared_Release;
+}
+
+static block_t *block_shared_New (block_payload_t *payload, const block_t *src)
+{
+    block_shared_t *sh = malloc (sizeof (*sh));
+    if (unlikely(sh == NULL))
+        return NULL;
+
+    block_t *block = &sh->self;
+    block_Init (block, src->p_start, src->i_size);
+    BlockMetaCopy (block, src);
+    block->p_next = NULL;
+    block->p_buffer = src->p_buffer;
+    block->i_buffer = src->i_buffer;
+    block->pf_release = block_shared_Release;
+    sh->payload = payload;
+    return block;
+}
+
+/**
+ * Turns a block into a shared block, so that further references to its
+ * payload can be taken with block_Share() without copying it.
+ * The block must not be used after this call. On error, the original block
+ * is returned and block_Share() falls back to a plain copy.
+ */
+block_t *block_Shared (block_t *block)
+{
+    block_Check (block);
+    if (block_IsShared (block))
+        return block;
+
+    block_payload_t *payload = malloc (sizeof (*payload));
+    if (unlikely(payload == NULL))
+        return block;
+
+    block_t *ref = block_shared_New (payload, block);
+    if (unlikely(ref == NULL))
+    {
+        free (payload);
+        return block;
+    }
+
+    ref->p_next = block->p_next;
+    block->p_next = NULL;
+    vlc_atomic_set (&payload->refs, 1);
+    payload->block = block;
+    return ref;
+}
+
+/**
+ * Takes a new reference to the payload of a shared block. The reference has
+ * its own metadata (dates, flags, p_buffer and i_buffer) but the payload
+ * must be treated as read-only, see block_Unshare().
+ * Blocks that are not shared are copied.
+ */
+block_t *block_Share (block_t *block)
+{
+    block_Check (block);
+    if (!block_IsShared (block))
+        return block_Duplicate (block);
+
+    block_payload_t *payload = ((block_shared_t *)block)->payload;
+    block_t *ref = block_shared_New (payload, block);
+    if (likely(ref != NULL))
+        vlc_atomic_inc (&payload->refs);
+    return ref;
+}
+
+/**
+ * Gives the caller a block whose payload can be written to: the same block
+ * if it is the only reference to its payload, or a private copy otherwise.
+ * The block must not be used after this call.
+ */
+block_t *block_Unshare (block_t *block)
+{
+    block_Check (block);
+    if (!block_IsShared (block)
+     || vlc_atomic_get (&((block_shared_t *)block)->payload->refs) == 1)
+        return block;
+
+    block_t *copy = block_Alloc (block->i_buffer);
+    if (likely(copy != NULL))
+    {
+        BlockMetaCopy (copy, block);
+        memcpy (copy->p_buffer, block->p_buffer, block->i_buffer);
+    }
+    block->p_next = NULL;
+    block_Release (block);
+    return copy;
+}
+
 block_t *block_Realloc( block_t *p_block, ssize_t i_prebody, size_t i_body )
 {
     size_t requested = i_prebody + i_body;
@@ -167,6 +292,15 @@ block_t *block_Realloc( block_t *p_block, ssize_t i_prebody, size_t i_body )
     assert( p_block->p_start + p_block->i_size
                                     >= p_block->p_buffer + p_block->i_buffer );
 
+    /* Shared payloads are read-only: copy before growing into the buffer */
+    if( block_IsShared( p_block )
+     && (i_prebody > 0 || i_body + (size_t)(-i_prebody) > p_block->i_buffer) )
+    {
+        p_block = block_Unshare( p_block );
+        if( p_block == NULL )
+            return NULL;
+    }
+
     /* Corner case: the current payload is discarded completely */
     if( i_prebody <= 0 && p_block->i_buffer <= (size_t)-i_prebody )
          p_block->i_buffer = 0; /* discard current payload */
@@ -262,7 +396,6 @@ block_t *block_Realloc( block_t *p_block, ssize_t i_prebody, size_t i_body )
     return p_block;
 }
 
-
 static void block_heap_Release (block_t *block)
 {
     block_Invalidate (block);
@@ -93,6 +93,10 @@ static filter_t *filter_chain_AppendFilterInternal( filter_chain_t *,
                                                     const char *, config_chain_t *,
                                                     const es_format_t *, const es_format_t * );
 
+static filter_t *filter_chain_AppendConvertedFilter( filter_chain_t *,
+                                                     const char *,
+                                                     config_chain_t * );
+
 static int filter_chain_AppendFromStringInternal( filter_chain_t *, const char * );
 
 static int filter_chain_DeleteFilterInternal( filter_chain_t *, filter_t * );
@@ -180,6 +184,11 @@ filter_t *filter_chain_AppendFilter( filter_chain_t *p_chain,
     filter_t *p_filter = filter_chain_AppendFilterInternal( p_chain, psz_name,
                                                             p_cfg, p_fmt_in,
                                                             p_fmt_out );
+    /* A named filter not handling the current chroma may still handle
+     * another one, reached through a conversion */
+    if( !p_filter && psz_name && !p_fmt_in && !p_fmt_out )
+        p_filter = filter_chain_AppendConvertedFilter( p_chain, psz_name,
+                                                       p_cfg );
     if( UpdateBufferFunctions( p_chain ) < 0 )
         msg_Err( p_filter, "Woah! This doesn't look good." );
     return p_filter;
@@ -450,6 +459,172 @@ error:
     return NULL;
 }
 
+/* Depth of each component, and chroma subsampling as the number of pixels
+ * per chroma sample in each direction */
+static void GetChromaPrecision( vlc_fourcc_t i_chroma,
+                                const vlc_chroma_description_t *p_dsc,
+                                unsigned *pi_bits, unsigned *pi_w,
+                                unsigned *pi_h )
+{
+    if( !vlc_fourcc_IsYUV( i_chroma ) )
+    {
+        /* Packed RGB keeps at most 8 bits per component, the fourth byte
+         * of 32 bits pixels being padding or alpha */
+        *pi_bits = __MIN( p_dsc->pixel_bits / 3, 8 );
+        *pi_w = *pi_h = 1;
+    }
+    else if( p_dsc->plane_count == 1 ) /* packed 4:2:2 */
+    {
+        *pi_bits = 8;
+        *pi_w = 2;
+        *pi_h = 1;
+    }
+    else /* the chroma plane of semi-planar chromas holds U/V pairs */
+    {
+        *pi_bits = p_dsc->pixel_bits;
+        *pi_w = p_dsc->p[1].w.den / p_dsc->p[1].w.num
+              * ( p_dsc->plane_count == 2 ? 2 : 1 );
+        *pi_h = p_dsc->p[1].h.den / p_dsc->p[1].h.num;
+    }
+}
+
+/**
+ * Estimates the cost of converting pictures from one chroma to another.
+ * Copies between layouts of the same samples are cheap, losing precision or
+ * chroma resolution and leaving the YUV or RGB colour space are not.
+ *
+ * \return the cost, 0 only if the chromas are the same, or -1 if either
+ * chroma is unknown
+ */
+static int ChromaConversionCost( vlc_fourcc_t i_from, vlc_fourcc_t i_to )
+{
+    const vlc_chroma_description_t *p_from =
+        vlc_fourcc_GetChromaDescription( i_from );
+    const vlc_chroma_description_t *p_to =
+        vlc_fourcc_GetChromaDescription( i_to );
+
+    if( !p_from || !p_to )
+        return -1;
+    if( i_from == i_to )
+        return 0;
+
+    unsigned i_from_bits, i_from_w, i_from_h, i_to_bits, i_to_w, i_to_h;
+    GetChromaPrecision( i_from, p_from, &i_from_bits, &i_from_w, &i_from_h );
+    GetChromaPrecision( i_to, p_to, &i_to_bits, &i_to_w, &i_to_h );
+
+    int i_cost = 1;
+
+    if( vlc_fourcc_IsYUV( i_from ) != vlc_fourcc_IsYUV( i_to ) )
+        i_cost += 16;
+    if( p_from->plane_count != p_to->plane_count )
+        i_cost += 1;
+    if( i_to_bits < i_from_bits )
+        i_cost += 8;
+    else if( i_to_bits > i_from_bits )
+        i_cost += 2;
+    if( i_to_w * i_to_h > i_from_w * i_from_h )
+        i_cost += 8;
+    else if( i_to_w != i_from_w || i_to_h != i_from_h )
+        i_cost += 4;
+    return i_cost;
+}
+
+#define MAX_CONVERSIONS 8
+
+/**
+ * Appends a named video filter behind a chroma conversion, for filters
+ * failing with the chroma at the end of the chain. The chromas are tried
+ * from the cheapest conversion on, up to MAX_CONVERSIONS of them.
+ */
+static filter_t *filter_chain_AppendConvertedFilter( filter_chain_t *p_chain,
+                                                     const char *psz_name,
+                                                     config_chain_t *p_cfg )
+{
+    const es_format_t *p_fmt = p_chain->last != NULL
+                             ? &p_chain->last->filter.fmt_out
+                             : &p_chain->fmt_in;
+    const vlc_fourcc_t i_chroma = p_fmt->video.i_chroma;
+
+    if( p_fmt->i_cat != VIDEO_ES || !p_chain->b_allow_fmt_out_change ||
+        !vlc_fourcc_GetChromaDescription( i_chroma ) )
+        return NULL;
+
+    /* Candidates, by increasing cost */
+    const vlc_fourcc_t *pp_lists[] = {
+        vlc_fourcc_GetYUVFallback( i_chroma ),
+        vlc_fourcc_GetRGBFallback( VLC_CODEC_RGB32 ),
+    };
+    vlc_fourcc_t pi_candidates[MAX_CONVERSIONS];
+    int pi_costs[MAX_CONVERSIONS];
+    unsigned i_candidates = 0;
+
+    for( unsigned l = 0; l < sizeof(pp_lists) / sizeof(pp_lists[0]); l++ )
+        for( const vlc_fourcc_t *p = pp_lists[l]; *p; p++ )
+        {
+            const int i_cost = ChromaConversionCost( i_chroma, *p );
+            unsigned i;
+
+            if( i_cost <= 0 )
+                continue;
+            for( i = 0; i < i_candidates && pi_candidates[i] != *p; i++ );
+            if( i < i_candidates )
+                continue;
+
+            /* Insertion after the candidates of the same cost, the most
+             * expensive one dropping out of a full list */
+            if( i_candidates == MAX_CONVERSIONS )
+            {
+                if( pi_costs[i_candidates - 1] <= i_cost )
+                    continue;
+                i_candidates--;
+            }
+            for( i = i_candidates; i > 0 && pi_costs[i - 1] > i_cost; i-- )
+            {
+                pi_candidates[i] = pi_candidates[i - 1];
+                pi_costs[i] = pi_costs[i - 1];
+            }
+            pi_candidates[i] = *p;
+            pi_costs[i] = i_cost;
+            i_candidates++;
+        }
+
+    es_format_t fmt_out;
+    es_format_Copy( &fmt_out, &p_chain->fmt_out );
+    filter_t *p_filter = NULL;
+
+    for( unsigned i = 0; i < i_candidates && !p_filter; i++ )
+    {
+        es_format_t fmt;
+
+        es_format_Copy( &fmt, p_fmt );
+        fmt.i_codec = fmt.video.i_chroma = pi_candidates[i];
+        if( !vlc_fourcc_IsYUV( fmt.video.i_chroma ) )
+            fmt.video.i_rmask = fmt.video.i_gmask = fmt.video.i_bmask = 0;
+
+        filter_t *p_conv = filter_chain_AppendFilterInternal( p_chain, NULL,
+                                                              NULL, NULL,
+                                                              &fmt );
+        es_format_Clean( &fmt );
+        if( !p_conv )
+            continue;
+
+        p_filter = filter_chain_AppendFilterInternal( p_chain, psz_name,
+                                                      p_cfg, NULL, NULL );
+        if( p_filter )
+        {
+            msg_Dbg( p_chain->p_this, "Filter '%s' appended after a "
+                     "conversion from %4.4s to %4.4s (cost %d)", psz_name,
+                     (const char *)&i_chroma,
+                     (const char *)&pi_candidates[i], pi_costs[i] );
+            break;
+        }
+        filter_chain_DeleteFilterInternal( p_chain, p_conv );
+        es_format_Clean( &p_chain->fmt_out );
+        es_format_Copy( &p_chain->fmt_out, &fmt_out );
+    }
+    es_format_Clean( &fmt_out );
+    return p_filter;
+}
 
 static int filter_chain_AppendFromStringInternal( filter_chain_t *p_chain,
                                                   const char *psz_string )
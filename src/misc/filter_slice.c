@@ -0,0 +1,226 @@
+/*****************************************************************************
+ * filter_slice.c : slice-parallel video filters
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <libvlc.h>
+#include <vlc_filter.h>
+
+/*
+ * All slice-parallel filters of a libvlc instance share one pool of worker
+ * threads, created on first use. A filter queues a job, the workers and the
+ * calling thread then take its slices one at a time until none are left.
+ * The caller taking part means a job always progresses, even if the workers
+ * are busy with the slices of other filters.
+ */
+typedef struct filter_slice_job_t filter_slice_job_t;
+
+struct filter_slice_job_t
+{
+    filter_t       *p_filter;
+    filter_slice_t  pf_slice;
+    void           *p_data;
+    unsigned        i_slices;
+    unsigned        i_next;  /* next slice to start */
+    unsigned        i_done;  /* slices completed */
+
+    filter_slice_job_t *p_next;
+};
+
+typedef struct filter_slice_pool_t
+{
+    vlc_mutex_t lock;
+    vlc_cond_t  wait;   /* workers wait for slices to start */
+    vlc_cond_t  done;   /* callers wait for the slices of their job */
+
+    filter_slice_job_t *p_jobs; /* jobs with slices left to start */
+    bool        b_closing;
+
+    unsigned     i_threads;
+    vlc_thread_t threads[];
+} filter_slice_pool_t;
+
+static vlc_mutex_t pool_lock = VLC_STATIC_MUTEX;
+
+/* Takes the next slice of a job, which must have some left */
+static unsigned TakeSlice( filter_slice_pool_t *p_pool,
+                           filter_slice_job_t *p_job )
+{
+    vlc_assert_locked( &p_pool->lock );
+
+    unsigned i_slice = p_job->i_next++;
+    if( p_job->i_next == p_job->i_slices )
+    {
+        filter_slice_job_t **pp_job = &p_pool->p_jobs;
+        while( *pp_job != p_job )
+            pp_job = &(*pp_job)->p_next;
+        *pp_job = p_job->p_next;
+    }
+    return i_slice;
+}
+
+static void RunSlice( filter_slice_pool_t *p_pool, filter_slice_job_t *p_job,
+                      unsigned i_slice )
+{
+    vlc_mutex_unlock( &p_pool->lock );
+    p_job->pf_slice( p_job->p_filter, p_job->p_data, i_slice, p_job->i_slices );
+    vlc_mutex_lock( &p_pool->lock );
+
+    if( ++p_job->i_done == p_job->i_slices )
+        vlc_cond_broadcast( &p_pool->done );
+}
+
+static void *Worker( void *data )
+{
+    filter_slice_pool_t *p_pool = data;
+    int canc = vlc_savecancel();
+
+    vlc_mutex_lock( &p_pool->lock );
+    for( ;; )
+    {
+        while( p_pool->p_jobs == NULL && !p_pool->b_closing )
+            vlc_cond_wait( &p_pool->wait, &p_pool->lock );
+        if( p_pool->b_closing )
+            break;
+
+        filter_slice_job_t *p_job = p_pool->p_jobs;
+        RunSlice( p_pool, p_job, TakeSlice( p_pool, p_job ) );
+    }
+    vlc_mutex_unlock( &p_pool->lock );
+
+    vlc_restorecancel( canc );
+    return NULL;
+}
+
+static filter_slice_pool_t *CreatePool( vlc_object_t *p_obj )
+{
+    int i_threads = var_InheritInteger( p_obj, "video-filter-threads" );
+    if( i_threads <= 0 )
+        i_threads = vlc_GetCPUCount();
+    /* The calling thread takes its share of the slices */
+    i_threads--;
+
+    filter_slice_pool_t *p_pool =
+        malloc( sizeof( *p_pool ) + i_threads * sizeof( vlc_thread_t ) );
+    if( unlikely( p_pool == NULL ) )
+        return NULL;
+
+    vlc_mutex_init( &p_pool->lock );
+    vlc_cond_init( &p_pool->wait );
+    vlc_cond_init( &p_pool->done );
+    p_pool->p_jobs = NULL;
+    p_pool->b_closing = false;
+    p_pool->i_threads = 0;
+
+    for( int i = 0; i < i_threads; i++ )
+    {
+        if( vlc_clone( &p_pool->threads[i], Worker, p_pool,
+                       VLC_THREAD_PRIORITY_VIDEO ) )
+            break;
+        p_pool->i_threads++;
+    }
+
+    msg_Dbg( p_obj, "video filter slices run on %u thread(s)",
+             p_pool->i_threads + 1 );
+    return p_pool;
+}
+
+static filter_slice_pool_t *GetPool( filter_t *p_filter )
+{
+    libvlc_priv_t *priv = libvlc_priv( p_filter->p_libvlc );
+
+    vlc_mutex_lock( &pool_lock );
+    if( priv->p_slice_pool == NULL )
+        priv->p_slice_pool = CreatePool( VLC_OBJECT(p_filter->p_libvlc) );
+    filter_slice_pool_t *p_pool = priv->p_slice_pool;
+    vlc_mutex_unlock( &pool_lock );
+
+    return p_pool;
+}
+
+void filter_RunSlices( filter_t *p_filter, unsigned i_max,
+                       filter_slice_t pf_slice, void *p_data )
+{
+    filter_slice_pool_t *p_pool = GetPool( p_filter );
+    unsigned i_slices = p_pool ? p_pool->i_threads + 1 : 1;
+
+    if( i_slices > i_max )
+        i_slices = i_max;
+    if( i_slices <= 1 )
+    {
+        pf_slice( p_filter, p_data, 0, 1 );
+        return;
+    }
+
+    filter_slice_job_t job = {
+        .p_filter = p_filter,
+        .pf_slice = pf_slice,
+        .p_data   = p_data,
+        .i_slices = i_slices,
+        .i_next   = 0,
+        .i_done   = 0,
+        .p_next   = NULL,
+    };
+
+    vlc_mutex_lock( &p_pool->lock );
+    filter_slice_job_t **pp_last = &p_pool->p_jobs;
+    while( *pp_last != NULL )
+        pp_last = &(*pp_last)->p_next;
+    *pp_last = &job;
+    vlc_cond_broadcast( &p_pool->wait );
+
+    while( job.i_next < job.i_slices )
+        RunSlice( p_pool, &job, TakeSlice( p_pool, &job ) );
+    while( job.i_done < job.i_slices )
+        vlc_cond_wait( &p_pool->done, &p_pool->lock );
+    vlc_mutex_unlock( &p_pool->lock );
+}
+
+/**
+ * Stops the slice workers of a libvlc instance, once no filters are left.
+ */
+void filter_DestroySlicePool( libvlc_int_t *p_libvlc )
+{
+    libvlc_priv_t *priv = libvlc_priv( p_libvlc );
+    filter_slice_pool_t *p_pool = priv->p_slice_pool;
+
+    if( p_pool == NULL )
+        return;
+    priv->p_slice_pool = NULL;
+
+    vlc_mutex_lock( &p_pool->lock );
+    assert( p_pool->p_jobs == NULL );
+    p_pool->b_closing = true;
+    vlc_cond_broadcast( &p_pool->wait );
+    vlc_mutex_unlock( &p_pool->lock );
+
+    for( unsigned i = 0; i < p_pool->i_threads; i++ )
+        vlc_join( p_pool->threads[i], NULL );
+
+    vlc_cond_destroy( &p_pool->done );
+    vlc_cond_destroy( &p_pool->wait );
+    vlc_mutex_destroy( &p_pool->lock );
+    free( p_pool );
+}
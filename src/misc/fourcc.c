@@ -811,6 +811,8 @@ static const staticentry_t p_list_video[] = {
         A("NV16"),
     B(VLC_CODEC_NV61, "Biplanar 4:2:2 Y/VU"),
         A("NV61"),
+    B(VLC_CODEC_P010, "Biplanar 4:2:0 Y/UV 10-bit LE"),
+        A("P010"),
 
     B(VLC_CODEC_I420_9L, "Planar 4:2:0 YUV 9-bit LE"),
         A("I09L"),
@@ -1587,6 +1589,9 @@ const char *vlc_fourcc_GetDescription( int i_cat, vlc_fourcc_t i_fourcc )
 #define VLC_CODEC_YUV_SEMIPLANAR_420 \
     VLC_CODEC_NV12, VLC_CODEC_NV21
 
+#define VLC_CODEC_YUV_SEMIPLANAR_420_16 \
+    VLC_CODEC_P010
+
 #define VLC_CODEC_YUV_PLANAR_420_16 \
     VLC_CODEC_I420_10L, VLC_CODEC_I420_10B, VLC_CODEC_I420_9L, VLC_CODEC_I420_9B
 
@@ -1623,6 +1628,14 @@ static const vlc_fourcc_t p_J420_fallback[] = {
 static const vlc_fourcc_t p_YV12_fallback[] = {
     VLC_CODEC_YV12, VLC_CODEC_I420, VLC_CODEC_J420, VLC_CODEC_FALLBACK_420, 0
 };
+static const vlc_fourcc_t p_NV12_fallback[] = {
+    VLC_CODEC_NV12, VLC_CODEC_NV21, VLC_CODEC_YUV_PLANAR_420,
+    VLC_CODEC_FALLBACK_420, 0
+};
+static const vlc_fourcc_t p_NV21_fallback[] = {
+    VLC_CODEC_NV21, VLC_CODEC_NV12, VLC_CODEC_YUV_PLANAR_420,
+    VLC_CODEC_FALLBACK_420, 0
+};
 
 #define VLC_CODEC_FALLBACK_420_16 \
     VLC_CODEC_I420, VLC_CODEC_YV12, VLC_CODEC_J420, VLC_CODEC_FALLBACK_420
@@ -1639,6 +1652,10 @@ static const vlc_fourcc_t p_I420_10L_fallback[] = {
 static const vlc_fourcc_t p_I420_10B_fallback[] = {
     VLC_CODEC_I420_10B, VLC_CODEC_I420_10L, VLC_CODEC_FALLBACK_420_16, 0
 };
+static const vlc_fourcc_t p_P010_fallback[] = {
+    VLC_CODEC_P010, VLC_CODEC_I420_10L, VLC_CODEC_I420_10B, VLC_CODEC_NV12,
+    VLC_CODEC_FALLBACK_420_16, 0
+};
 
 #define VLC_CODEC_FALLBACK_422 \
     VLC_CODEC_YUV_PACKED, VLC_CODEC_YUV_PLANAR_420, \
@@ -1747,6 +1764,9 @@ static const vlc_fourcc_t *pp_YUV_fallback[] = {
     p_I420_10L_fallback,
     p_I420_10B_fallback,
     p_J420_fallback,
+    p_NV12_fallback,
+    p_NV21_fallback,
+    p_P010_fallback,
     p_I422_fallback,
     p_I422_9L_fallback,
     p_I422_9B_fallback,
@@ -1778,6 +1798,7 @@ static const vlc_fourcc_t p_list_YUV[] = {
     VLC_CODEC_YUV_PACKED,
     VLC_CODEC_I411, VLC_CODEC_YUV_PLANAR_410, VLC_CODEC_Y211,
     VLC_CODEC_YUV_PLANAR_420_16,
+    VLC_CODEC_YUV_SEMIPLANAR_420_16,
     VLC_CODEC_YUV_PLANAR_422_16,
     VLC_CODEC_YUV_PLANAR_444_16,
     0,
@@ -1929,6 +1950,7 @@ static const struct
 
     { { VLC_CODEC_I420_10L,
         VLC_CODEC_I420_10B, 0 },               PLANAR_16(3, 2, 2, 10) },
+    { { VLC_CODEC_P010, 0 },                   PLANAR_16(2, 1, 2, 10) },
     { { VLC_CODEC_I420_9L,
         VLC_CODEC_I420_9B, 0 },                PLANAR_16(3, 2, 2,  9) },
     { { VLC_CODEC_I422_10L,
@@ -48,40 +48,173 @@ struct picture_gc_sys_t {
     void (*unlock)(picture_t *);
 
     /* */
-    int64_t tick;
+    unsigned tick;
+
+    /* Pool created around the picture */
+    picture_pool_t *pool;
+
+    /* Pool and slot the picture is returned to when released. The low
+     * bit of owner is set while one thread uses or changes them: either
+     * the releasing thread, or a reservation moving the picture. */
+    atomic_uintptr_t owner;
+    int              index;
+    /* Whether the picture is in the free list of its owner */
+    atomic_bool      listed;
 };
 
+#define OWNER_BUSY 1
+
+/* The free pictures of a pool are kept in a lock-free stack of slot
+ * indexes. The head packs the top index in its low 32 bits and a counter
+ * bumped by every change in its high 32 bits, so that a pop cannot succeed
+ * with a stale next index (ABA). A 16-bit counter could wrap while a pop
+ * is preempted; 2^32 changes cannot happen in that time. */
+#define FREE_NONE   0xffff
+#define FREE_TAG    (UINT64_C(1) << 32)
+
 struct picture_pool_t {
     /* */
     picture_pool_t *master;
-    int64_t        tick;
+    atomic_uint    tick;
     /* */
     int            picture_count;
     picture_t      **picture;
     bool           *picture_reserved;
+
+    /* Free list */
+    atomic_uint_least64_t free_head;
+    atomic_uint    *free_next;
+
+    /* Releases counter and waiters of picture_pool_Wait() */
+    atomic_uint    released;
+    atomic_uint    released_seen;
+    atomic_uint    waiters;
+    vlc_mutex_t    lock;
+    vlc_cond_t     wait;
 };
 
 static void Destroy(picture_t *);
 static int  Lock(picture_t *);
 static void Unlock(picture_t *);
 
+static void Push(picture_pool_t *pool, int index)
+{
+    uint_least64_t head = atomic_load(&pool->free_head);
+    uint_least64_t next;
+
+    do {
+        atomic_store(&pool->free_next[index], head % FREE_TAG);
+        next = ((head & ~(FREE_TAG - 1)) + FREE_TAG) | index;
+    } while (!atomic_compare_exchange_weak(&pool->free_head, &head, next));
+}
+
+static int Pop(picture_pool_t *pool)
+{
+    uint_least64_t head = atomic_load(&pool->free_head);
+    uint_least64_t next;
+    int index;
+
+    do {
+        index = head % FREE_TAG;
+        if (index == FREE_NONE)
+            return -1;
+        next = ((head & ~(FREE_TAG - 1)) + FREE_TAG)
+             | atomic_load(&pool->free_next[index]);
+    } while (!atomic_compare_exchange_weak(&pool->free_head, &head, next));
+    return index;
+}
+
+static bool IsEmpty(picture_pool_t *pool)
+{
+    return atomic_load(&pool->free_head) % FREE_TAG == FREE_NONE;
+}
+
+/* Takes the exclusive use of the owner and slot of a picture, and
+ * returns its owner. This spins: the owner is held for a few instructions,
+ * except by Release(), which also holds it while taking the pool mutex to
+ * wake the waiters of picture_pool_Wait(). Only a reservation or deletion
+ * of the pool, moving the picture, may spin that long. */
+static picture_pool_t *OwnerLock(picture_gc_sys_t *gc_sys)
+{
+    uintptr_t owner = atomic_load(&gc_sys->owner);
+
+    for (;;) {
+        if (owner & OWNER_BUSY)
+            owner = atomic_load(&gc_sys->owner);
+        else if (atomic_compare_exchange_weak(&gc_sys->owner, &owner,
+                                              owner | OWNER_BUSY))
+            return (picture_pool_t *)owner;
+    }
+}
+
+static void OwnerUnlock(picture_gc_sys_t *gc_sys, picture_pool_t *owner)
+{
+    atomic_store(&gc_sys->owner, (uintptr_t)owner);
+}
+
+/* Returns a picture to the free list of its pool, and wakes the threads
+ * waiting for it. The owner stays locked until the pool is no longer
+ * used, so that a reserved pool is not deleted under our feet. */
+static void Release(picture_t *picture)
+{
+    picture_gc_sys_t *gc_sys = picture->gc.p_sys;
+    picture_pool_t *pool = OwnerLock(gc_sys);
+
+    atomic_store(&gc_sys->listed, true);
+    Push(pool, gc_sys->index);
+    atomic_fetch_add(&pool->released, 1);
+    if (atomic_load(&pool->waiters) > 0) {
+        vlc_mutex_lock(&pool->lock);
+        vlc_cond_broadcast(&pool->wait);
+        vlc_mutex_unlock(&pool->lock);
+    }
+    OwnerUnlock(gc_sys, pool);
+}
+
+/* Marks an used picture as free, unless it is released concurrently */
+static void ForceRelease(picture_t *picture)
+{
+    uintptr_t refcount = vlc_atomic_get(&picture->gc.refcount);
+
+    while (refcount > 0 && refcount < (uintptr_t)INTPTR_MAX) {
+        uintptr_t old = vlc_atomic_compare_swap(&picture->gc.refcount,
+                                                refcount, 0);
+        if (old == refcount) {
+            Unlock(picture);
+            Release(picture);
+            return;
+        }
+        refcount = old;
+    }
+}
+
 static picture_pool_t *Create(picture_pool_t *master, int picture_count)
 {
+    assert(picture_count < FREE_NONE);
+
     picture_pool_t *pool = calloc(1, sizeof(*pool));
     if (!pool)
         return NULL;
 
     pool->master = master;
-    pool->tick = master ? master->tick : 1;
+    atomic_init(&pool->tick, master ? atomic_load(&master->tick) : 1);
     pool->picture_count = picture_count;
     pool->picture = calloc(pool->picture_count, sizeof(*pool->picture));
     pool->picture_reserved = calloc(pool->picture_count, sizeof(*pool->picture_reserved));
-    if (!pool->picture || !pool->picture_reserved) {
+    pool->free_next = calloc(pool->picture_count, sizeof(*pool->free_next));
+    if (!pool->picture || !pool->picture_reserved || !pool->free_next) {
         free(pool->picture);
         free(pool->picture_reserved);
+        free(pool->free_next);
         free(pool);
         return NULL;
     }
+    atomic_init(&pool->free_head, FREE_NONE);
+    atomic_init(&pool->released, 0);
+    atomic_init(&pool->released_seen, 0);
+    atomic_init(&pool->waiters, 0);
+    vlc_mutex_init(&pool->lock);
+    vlc_cond_init(&pool->wait);
     return pool;
 }
 
@@ -106,6 +239,10 @@ picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg
         gc_sys->lock        = cfg->lock;
         gc_sys->unlock      = cfg->unlock;
         gc_sys->tick        = 0;
+        gc_sys->pool        = pool;
+        atomic_init(&gc_sys->owner, (uintptr_t)pool);
+        gc_sys->index       = i;
+        atomic_init(&gc_sys->listed, true);
 
         /* */
         vlc_atomic_set(&picture->gc.refcount, 0);
@@ -116,6 +253,9 @@ picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg
         pool->picture[i] = picture;
         pool->picture_reserved[i] = false;
     }
+    /* Pushed backward, so that the first pictures are used first */
+    for (int i = cfg->picture_count - 1; i >= 0; i--)
+        Push(pool, i);
     return pool;
 
 }
@@ -162,17 +302,29 @@ picture_pool_t *picture_pool_Reserve(picture_pool_t *master, int count)
         return NULL;
 
     int found = 0;
-    for (int i = 0; i < master->picture_count && found < count; i++) {
-        if (master->picture_reserved[i])
-            continue;
+    while (found < count) {
+        int i = Pop(master);
+        if (i < 0)
+            break;
+
+        picture_t *picture = master->picture[i];
+        picture_gc_sys_t *gc_sys = picture->gc.p_sys;
 
-        assert(vlc_atomic_get(&master->picture[i]->gc.refcount) == 0);
+        assert(vlc_atomic_get(&picture->gc.refcount) == 0);
         master->picture_reserved[i] = true;
 
-        pool->picture[found]          = master->picture[i];
+        pool->picture[found]          = picture;
         pool->picture_reserved[found] = false;
+        /* The release that freed it may still be waking up our waiters */
+        OwnerLock(gc_sys);
+        gc_sys->index = found;
+        OwnerUnlock(gc_sys, pool);
         found++;
     }
+    pool->picture_count = found;
+    for (int i = found - 1; i >= 0; i--)
+        Push(pool, i);
+
     if (found < count) {
         picture_pool_Delete(pool);
         return NULL;
@@ -184,14 +336,24 @@ void picture_pool_Delete(picture_pool_t *pool)
 {
     for (int i = 0; i < pool->picture_count; i++) {
         picture_t *picture = pool->picture[i];
+        picture_gc_sys_t *gc_sys = picture->gc.p_sys;
+
         if (pool->master) {
             for (int j = 0; j < pool->master->picture_count; j++) {
-                if (pool->master->picture[j] == picture)
-                    pool->master->picture_reserved[j] = false;
+                if (pool->master->picture[j] != picture)
+                    continue;
+
+                /* A free picture goes back to the master now, one still
+                 * in use (or being released) when its release gets the
+                 * owner after us */
+                OwnerLock(gc_sys);
+                pool->master->picture_reserved[j] = false;
+                gc_sys->index = j;
+                if (atomic_load(&gc_sys->listed))
+                    Push(pool->master, j);
+                OwnerUnlock(gc_sys, pool->master);
             }
         } else {
-            picture_gc_sys_t *gc_sys = picture->gc.p_sys;
-
             assert(vlc_atomic_get(&picture->gc.refcount) == 0);
             assert(!pool->picture_reserved[i]);
 
@@ -205,6 +367,9 @@ void picture_pool_Delete(picture_pool_t *pool)
             free(gc_sys);
         }
     }
+    vlc_cond_destroy(&pool->wait);
+    vlc_mutex_destroy(&pool->lock);
+    free(pool->free_next);
     free(pool->picture_reserved);
     free(pool->picture);
     free(pool);
@@ -212,28 +377,49 @@ void picture_pool_Delete(picture_pool_t *pool)
 
 picture_t *picture_pool_Get(picture_pool_t *pool)
 {
-    for (int i = 0; i < pool->picture_count; i++) {
-        if (pool->picture_reserved[i])
-            continue;
+    unsigned released = atomic_load(&pool->released);
+    picture_t *picture = NULL;
+    int failed = FREE_NONE;
 
-        picture_t *picture = pool->picture[i];
-        if (vlc_atomic_get(&picture->gc.refcount) > 0)
-            continue;
+    for (;;) {
+        int i = Pop(pool);
+        if (i < 0)
+            break;
 
-        if (Lock(picture))
-            continue;
+        picture = pool->picture[i];
+        atomic_store(&picture->gc.p_sys->listed, false);
+        if (!Lock(picture))
+            break;
 
-        /* */
-        picture->p_next = NULL;
-        picture->gc.p_sys->tick = pool->tick++;
-        picture_Hold(picture);
-        return picture;
+        /* Kept aside until the end, so that it is not tried again */
+        atomic_store(&pool->free_next[i], failed);
+        failed = i;
+        picture = NULL;
     }
-    return NULL;
+    while (failed != FREE_NONE) {
+        int next = atomic_load(&pool->free_next[failed]);
+        atomic_store(&pool->picture[failed]->gc.p_sys->listed, true);
+        Push(pool, failed);
+        failed = next;
+    }
+
+    if (!picture) {
+        atomic_store(&pool->released_seen, released);
+        return NULL;
+    }
+
+    /* */
+    picture->p_next = NULL;
+    picture->gc.p_sys->tick = atomic_fetch_add(&pool->tick, 1);
+    vlc_atomic_set(&picture->gc.refcount, 1);
+    return picture;
 }
 
 void picture_pool_NonEmpty(picture_pool_t *pool, bool reset)
 {
+    if (!reset && !IsEmpty(pool))
+        return;
+
     picture_t *old = NULL;
 
     for (int i = 0; i < pool->picture_count; i++) {
@@ -241,30 +427,46 @@ void picture_pool_NonEmpty(picture_pool_t *pool, bool reset)
             continue;
 
         picture_t *picture = pool->picture[i];
-        if (reset) {
-            if (vlc_atomic_get(&picture->gc.refcount) > 0)
-                Unlock(picture);
-            vlc_atomic_set(&picture->gc.refcount, 0);
-        } else if (vlc_atomic_get(&picture->gc.refcount) == 0) {
-            return;
-        } else if (!old || picture->gc.p_sys->tick < old->gc.p_sys->tick) {
+        if (reset)
+            ForceRelease(picture);
+        else if (vlc_atomic_get(&picture->gc.refcount) > 0 &&
+                 (!old || (int)(picture->gc.p_sys->tick -
+                                old->gc.p_sys->tick) < 0))
             old = picture;
-        }
-    }
-    if (!reset && old) {
-        if (vlc_atomic_get(&old->gc.refcount) > 0)
-            Unlock(old);
-        vlc_atomic_set(&old->gc.refcount, 0);
     }
+    if (!reset && old)
+        ForceRelease(old);
 }
+
+void picture_pool_Wait(picture_pool_t *pool, mtime_t deadline)
+{
+    vlc_mutex_lock(&pool->lock);
+    atomic_fetch_add(&pool->waiters, 1);
+    while (atomic_load(&pool->released) == atomic_load(&pool->released_seen))
+        if (vlc_cond_timedwait(&pool->wait, &pool->lock, deadline))
+            break;
+    atomic_fetch_sub(&pool->waiters, 1);
+    vlc_mutex_unlock(&pool->lock);
+}
+
 int picture_pool_GetSize(picture_pool_t *pool)
 {
     return pool->picture_count;
 }
 
+bool picture_pool_OwnsPic(picture_pool_t *pool, picture_t *picture)
+{
+    while (pool->master)
+        pool = pool->master;
+
+    return picture->gc.pf_destroy == Destroy &&
+           picture->gc.p_sys->pool == pool;
+}
+
 static void Destroy(picture_t *picture)
 {
     Unlock(picture);
+    Release(picture);
 }
 
 static int Lock(picture_t *picture)
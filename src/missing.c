@@ -167,6 +167,24 @@ int httpd_StreamSend (httpd_stream_t *stream, uint8_t *data, int count)
     assert (0);
 }
 
+int httpd_StreamSendBlock (httpd_stream_t *stream, block_t *block)
+{
+    (void) stream; (void) block;
+    assert (0);
+}
+
+void httpd_StreamSetBufferSize (httpd_stream_t *stream, size_t size)
+{
+    (void) stream; (void) size;
+    assert (0);
+}
+
+void httpd_StreamSetSlowPolicy (httpd_stream_t *stream, int policy)
+{
+    (void) stream; (void) policy;
+    assert (0);
+}
+
 int httpd_UrlCatch (httpd_url_t *url, int request, httpd_callback_t cb,
                     httpd_callback_sys_t *data)
 {
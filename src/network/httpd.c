@@ -39,6 +39,9 @@
 #include <vlc_charset.h>
 #include <vlc_url.h>
 #include <vlc_mime.h>
+#include <vlc_block.h>
+#include <vlc_atomic.h>
+#include <vlc_fs.h>
 #include "../libvlc.h"
 
 #include <string.h>
@@ -51,6 +54,7 @@
 #ifdef HAVE_POLL
 # include <poll.h>
 #endif
+#include <fcntl.h>
 
 #if defined( WIN32 )
 #   include <winsock2.h>
@@ -65,9 +69,29 @@
 #define HTTPD_CL_BUFSIZE 10000
 #endif
 
+/* Maximum number of stream blocks sent at once */
+#define HTTPD_CL_IOV 64
+
+#define HTTPD_MAX_WORKERS 16
+
 static void httpd_ClientClean( httpd_client_t *cl );
+static void httpd_HostWake( httpd_host_t * );
+
+/* each worker serves its own set of clients in its own thread */
+typedef struct
+{
+    httpd_host_t *host;
+    vlc_thread_t thread;
+    vlc_mutex_t  lock;
+
+    int            i_client;
+    httpd_client_t **client;
+
+    /* wake up pipe, used when stream data arrive for waiting clients */
+    int          wake[2];
+    vlc_atomic_t waiting;
+} httpd_worker_t;
 
-/* each host run in his own thread */
 struct httpd_host_t
 {
     VLC_COMMON_MEMBERS
@@ -80,7 +104,10 @@ struct httpd_host_t
     unsigned     nfd;
     unsigned     port;
 
-    vlc_thread_t thread;
+    /* the first worker also accepts connections */
+    httpd_worker_t *worker;
+    unsigned    i_worker;
+
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
@@ -91,9 +118,6 @@ struct httpd_host_t
     int         i_url;
     httpd_url_t **url;
 
-    int            i_client;
-    httpd_client_t **client;
-
     /* TLS data */
     vlc_tls_creds_t *p_tls;
 };
@@ -163,6 +187,22 @@ struct httpd_client_t
     httpd_message_t query;  /* client -> httpd */
     httpd_message_t answer; /* httpd -> client */
 
+    /* stream mode: references to stream blocks still to be sent */
+    block_t  *p_chain;
+    block_t **pp_chain_last;
+
+    /* stream mode statistics */
+    struct
+    {
+        uint64_t i_sent;    /* bytes sent */
+        uint64_t i_dropped; /* bytes skipped because the client was late */
+        unsigned i_drops;
+        int64_t  i_lag;     /* maximum distance to the live position */
+        mtime_t  i_start;   /* date of the stream request */
+        mtime_t  i_ttff;    /* time until the first block was sent */
+        bool     b_ttff_counted;
+    } stats;
+
     /* TLS data */
     vlc_tls_t *p_tls;
 };
@@ -615,6 +655,12 @@ void httpd_RedirectDelete( httpd_redirect_t *rdir )
 /*****************************************************************************
  * High Level Funtions: httpd_stream_t
  *****************************************************************************/
+typedef struct
+{
+    block_t *p_block;   /* shared block, see block_Shared() */
+    int64_t  i_pos;     /* absolute position of its first byte */
+} httpd_stream_block_t;
+
 struct httpd_stream_t
 {
     vlc_mutex_t lock;
@@ -626,13 +672,58 @@ struct httpd_stream_t
     uint8_t *p_header;
     int     i_header;
 
-    /* circular buffer */
-    int         i_buffer_size;      /* buffer size, can't be reallocated smaller */
-    uint8_t     *p_buffer;          /* buffer */
+    /* circular buffer of blocks, clients send them without copying */
+    size_t      i_buffer_size;      /* maximum amount of buffered data */
+    httpd_stream_block_t *p_ring;
+    unsigned    i_ring_size;        /* allocated entries */
+    unsigned    i_ring_first;
+    unsigned    i_ring_count;
     int64_t     i_buffer_pos;       /* absolute position from begining */
-    int64_t     i_buffer_last_pos;  /* a new connection will start with that */
+    int64_t     i_buffer_last_pos;  /* a new connection will start with that
+                                     * if no keyframe is buffered */
+    int64_t     i_key_pos;          /* last random access point, or -1 */
+
+    int         i_slow_policy;      /* what to do with late clients */
+
+    /* statistics */
+    struct
+    {
+        unsigned i_clients;
+        unsigned i_drops;           /* late clients that skipped data */
+        unsigned i_kicks;           /* late clients that were disconnected */
+        unsigned i_ttff;            /* clients with a time to first frame */
+        mtime_t  i_ttff_total;
+        mtime_t  i_ttff_max;
+    } stats;
 };
 
+#define HTTPD_STREAM_BUFSIZE 5000000 /* 5 Mo per stream by default */
+
+static httpd_stream_block_t *httpd_StreamBlock( httpd_stream_t *stream,
+                                                unsigned i )
+{
+    return &stream->p_ring[(stream->i_ring_first + i) % stream->i_ring_size];
+}
+
+/* Returns the index of the block holding the given position, or the number
+ * of buffered blocks if the position is not buffered yet. */
+static unsigned httpd_StreamFind( httpd_stream_t *stream, int64_t i_pos )
+{
+    unsigned i_low = 0, i_high = stream->i_ring_count;
+
+    while( i_low < i_high )
+    {
+        unsigned i_mid = (i_low + i_high) / 2;
+        const httpd_stream_block_t *b = httpd_StreamBlock( stream, i_mid );
+
+        if( b->i_pos + (int64_t)b->p_block->i_buffer <= i_pos )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
 static int httpd_StreamCallBack( httpd_callback_sys_t *p_sys,
                                  httpd_client_t *cl, httpd_message_t *answer,
                                  const httpd_message_t *query )
@@ -646,54 +737,85 @@ static int httpd_StreamCallBack( httpd_callback_sys_t *p_sys,
 
     if( answer->i_body_offset > 0 )
     {
-        int64_t i_write;
-        int     i_pos;
-
-#if 0
-        fprintf( stderr, "httpd_StreamCallBack i_body_offset=%lld\n",
-                 answer->i_body_offset );
-#endif
+        int64_t i_offset = answer->i_body_offset;
+        unsigned i_count = 0;
 
-        if( answer->i_body_offset >= stream->i_buffer_pos )
+        vlc_mutex_lock( &stream->lock );
+        if( i_offset >= stream->i_buffer_pos )
         {
-            /* fprintf( stderr, "httpd_StreamCallBack: no data\n" ); */
+            vlc_mutex_unlock( &stream->lock );
             return VLC_EGENERIC;    /* wait, no data available */
         }
-        if( answer->i_body_offset + stream->i_buffer_size <
-            stream->i_buffer_pos )
+
+        int64_t i_first = stream->i_buffer_pos;
+        if( stream->i_ring_count > 0 )
+            i_first = httpd_StreamBlock( stream, 0 )->i_pos;
+
+        if( i_offset < i_first )
         {
             /* this client isn't fast enough */
-#if 0
-            fprintf( stderr, "fixing i_body_offset (old=%lld new=%lld)\n",
-                     answer->i_body_offset, stream->i_buffer_last_pos );
-#endif
-            answer->i_body_offset = stream->i_buffer_last_pos;
-        }
+            int64_t i_next = stream->i_buffer_last_pos;
+
+            switch( stream->i_slow_policy )
+            {
+                case HTTPD_STREAM_SLOW_DISCONNECT:
+                    stream->stats.i_kicks++;
+                    vlc_mutex_unlock( &stream->lock );
+                    cl->i_state = HTTPD_CLIENT_DEAD;
+                    return VLC_EGENERIC;
+
+                case HTTPD_STREAM_SLOW_KEYFRAME:
+                    /* resume where the client can decode again */
+                    if( stream->i_key_pos >= 0 )
+                        i_next = stream->i_key_pos;
+                    break;
+            }
 
-        i_pos   = answer->i_body_offset % stream->i_buffer_size;
-        i_write = stream->i_buffer_pos - answer->i_body_offset;
-        if( i_write > HTTPD_CL_BUFSIZE )
+            cl->stats.i_dropped += i_next - i_offset;
+            cl->stats.i_drops++;
+            stream->stats.i_drops++;
+            i_offset = i_next;
+        }
+        if( cl->stats.i_ttff > 0 && !cl->stats.b_ttff_counted )
         {
-            i_write = HTTPD_CL_BUFSIZE;
+            stream->stats.i_ttff++;
+            stream->stats.i_ttff_total += cl->stats.i_ttff;
+            if( stream->stats.i_ttff_max < cl->stats.i_ttff )
+                stream->stats.i_ttff_max = cl->stats.i_ttff;
+            cl->stats.b_ttff_counted = true;
         }
-        else if( i_write <= 0 )
+        if( cl->stats.i_lag < stream->i_buffer_pos - i_offset )
+            cl->stats.i_lag = stream->i_buffer_pos - i_offset;
+
+        /* Hand out references to the buffered blocks */
+        for( unsigned i = httpd_StreamFind( stream, i_offset );
+             i < stream->i_ring_count && i_count < HTTPD_CL_IOV; i++ )
         {
-            return VLC_EGENERIC;    /* wait, no data available */
+            const httpd_stream_block_t *b = httpd_StreamBlock( stream, i );
+            block_t *p_ref = block_Share( b->p_block );
+            if( p_ref == NULL )
+                break;
+
+            size_t i_skip = i_offset - b->i_pos;
+            p_ref->p_buffer += i_skip;
+            p_ref->i_buffer -= i_skip;
+
+            *cl->pp_chain_last = p_ref;
+            cl->pp_chain_last = &p_ref->p_next;
+            i_offset += p_ref->i_buffer;
+            i_count++;
         }
+        vlc_mutex_unlock( &stream->lock );
 
-        /* Don't go past the end of the circular buffer */
-        i_write = __MIN( i_write, stream->i_buffer_size - i_pos );
+        if( i_count == 0 )
+            return VLC_EGENERIC;
 
         /* using HTTPD_MSG_ANSWER -> data available */
         answer->i_proto  = HTTPD_PROTO_HTTP;
         answer->i_version= 0;
         answer->i_type   = HTTPD_MSG_ANSWER;
 
-        answer->i_body = i_write;
-        answer->p_body = xmalloc( i_write );
-        memcpy( answer->p_body, &stream->p_buffer[i_pos], i_write );
-
-        answer->i_body_offset += i_write;
+        answer->i_body_offset = i_offset;
 
         return VLC_SUCCESS;
     }
@@ -716,8 +838,15 @@ static int httpd_StreamCallBack( httpd_callback_sys_t *p_sys,
                 answer->p_body = xmalloc( stream->i_header );
                 memcpy( answer->p_body, stream->p_header, stream->i_header );
             }
-            answer->i_body_offset = stream->i_buffer_last_pos;
+            /* Start at the last random access point: the client receives
+             * everything since then as fast as it can read it. */
+            if( stream->i_key_pos >= 0 )
+                answer->i_body_offset = stream->i_key_pos;
+            else
+                answer->i_body_offset = stream->i_buffer_last_pos;
+            stream->stats.i_clients++;
             vlc_mutex_unlock( &stream->lock );
+            cl->stats.i_start = mdate();
         }
         else
         {
@@ -785,8 +914,14 @@ httpd_stream_t *httpd_StreamNew( httpd_host_t *host,
     }
     stream->i_header = 0;
     stream->p_header = NULL;
-    stream->i_buffer_size = 5000000;    /* 5 Mo per stream */
-    stream->p_buffer = xmalloc( stream->i_buffer_size );
+    stream->i_buffer_size = HTTPD_STREAM_BUFSIZE;
+    stream->p_ring = NULL;
+    stream->i_ring_size = 0;
+    stream->i_ring_first = 0;
+    stream->i_ring_count = 0;
+    stream->i_key_pos = -1;
+    stream->i_slow_policy = HTTPD_STREAM_SLOW_KEYFRAME;
+    memset( &stream->stats, 0, sizeof( stream->stats ) );
     /* We set to 1 to make life simpler
      * (this way i_body_offset can never be 0) */
     stream->i_buffer_pos = 1;
@@ -819,56 +954,146 @@ int httpd_StreamHeader( httpd_stream_t *stream, uint8_t *p_data, int i_data )
     return VLC_SUCCESS;
 }
 
-int httpd_StreamSend( httpd_stream_t *stream, uint8_t *p_data, int i_data )
+/* Drops the oldest blocks beyond the buffer size. The last random access
+ * point is kept unless the buffer grows twice as big.
+ * Must be called with the stream lock held. */
+static void httpd_StreamTrim( httpd_stream_t *stream )
 {
-    int i_count;
-    int i_pos;
-
-    if( i_data < 0 || p_data == NULL )
+    while( stream->i_ring_count > 1 )
     {
-        return VLC_SUCCESS;
-    }
-    vlc_mutex_lock( &stream->lock );
+        httpd_stream_block_t *first = httpd_StreamBlock( stream, 0 );
+        httpd_stream_block_t *b = httpd_StreamBlock( stream, 1 );
+        int64_t i_left = stream->i_buffer_pos - b->i_pos;
+
+        if( i_left < (int64_t)stream->i_buffer_size )
+            break;
+        if( first->i_pos == stream->i_key_pos
+         && i_left < 2 * (int64_t)stream->i_buffer_size )
+            break;
 
-    /* save this pointer (to be used by new connection) */
-    stream->i_buffer_last_pos = stream->i_buffer_pos;
+        if( first->i_pos == stream->i_key_pos )
+            stream->i_key_pos = -1;
+        block_Release( first->p_block );
+        stream->i_ring_first = (stream->i_ring_first + 1) % stream->i_ring_size;
+        stream->i_ring_count--;
+    }
+}
 
-    i_pos = stream->i_buffer_pos % stream->i_buffer_size;
-    i_count = i_data;
-    while( i_count > 0)
+int httpd_StreamSendBlock( httpd_stream_t *stream, block_t *p_block )
+{
+    while( p_block != NULL )
     {
-        int i_copy;
+        block_t *p_next = p_block->p_next;
+
+        p_block->p_next = NULL;
+        if( p_block->i_buffer == 0 )
+        {
+            block_Release( p_block );
+            p_block = p_next;
+            continue;
+        }
+        /* clients get references to it: it must not be changed anymore */
+        p_block = block_Shared( p_block );
+
+        vlc_mutex_lock( &stream->lock );
+        if( stream->i_ring_count == stream->i_ring_size )
+        {
+            unsigned i_size = stream->i_ring_size ? 2 * stream->i_ring_size
+                                                  : 64;
+            httpd_stream_block_t *p_ring =
+                malloc( i_size * sizeof( *p_ring ) );
+            if( unlikely(p_ring == NULL) )
+            {
+                vlc_mutex_unlock( &stream->lock );
+                block_Release( p_block );
+                block_ChainRelease( p_next );
+                return VLC_ENOMEM;
+            }
+            for( unsigned i = 0; i < stream->i_ring_count; i++ )
+                p_ring[i] = *httpd_StreamBlock( stream, i );
+            free( stream->p_ring );
+            stream->p_ring = p_ring;
+            stream->i_ring_size = i_size;
+            stream->i_ring_first = 0;
+        }
 
-        i_copy = __MIN( i_count, stream->i_buffer_size - i_pos );
+        /* save this pointer (to be used by new connection) */
+        stream->i_buffer_last_pos = stream->i_buffer_pos;
 
-        /* Ok, we can't go past the end of our buffer */
-        memcpy( &stream->p_buffer[i_pos], p_data, i_copy );
+        httpd_stream_block_t *b =
+            httpd_StreamBlock( stream, stream->i_ring_count++ );
+        b->p_block = p_block;
+        b->i_pos = stream->i_buffer_pos;
+        if( p_block->i_flags & BLOCK_FLAG_TYPE_I )
+            stream->i_key_pos = b->i_pos;
+        stream->i_buffer_pos += p_block->i_buffer;
+        httpd_StreamTrim( stream );
+        vlc_mutex_unlock( &stream->lock );
 
-        i_pos = ( i_pos + i_copy ) % stream->i_buffer_size;
-        i_count -= i_copy;
-        p_data  += i_copy;
+        p_block = p_next;
     }
 
-    stream->i_buffer_pos += i_data;
+    httpd_HostWake( stream->url->host );
+    return VLC_SUCCESS;
+}
+
+int httpd_StreamSend( httpd_stream_t *stream, uint8_t *p_data, int i_data )
+{
+    if( i_data <= 0 || p_data == NULL )
+    {
+        return VLC_SUCCESS;
+    }
 
+    block_t *p_block = block_Alloc( i_data );
+    if( unlikely(p_block == NULL) )
+        return VLC_ENOMEM;
+    memcpy( p_block->p_buffer, p_data, i_data );
+
+    return httpd_StreamSendBlock( stream, p_block );
+}
+
+void httpd_StreamSetBufferSize( httpd_stream_t *stream, size_t i_size )
+{
+    vlc_mutex_lock( &stream->lock );
+    stream->i_buffer_size = i_size;
+    httpd_StreamTrim( stream );
+    vlc_mutex_unlock( &stream->lock );
+}
+
+void httpd_StreamSetSlowPolicy( httpd_stream_t *stream, int i_policy )
+{
+    vlc_mutex_lock( &stream->lock );
+    stream->i_slow_policy = i_policy;
     vlc_mutex_unlock( &stream->lock );
-    return VLC_SUCCESS;
 }
 
 void httpd_StreamDelete( httpd_stream_t *stream )
 {
+    if( stream->stats.i_clients > 0 )
+        msg_Dbg( stream->url->host, "stream %s: %u client(s), time to first "
+                 "frame %"PRId64" ms average, %"PRId64" ms maximum, "
+                 "%u late client(s) skipped data, %u disconnected",
+                 stream->url->psz_url, stream->stats.i_clients,
+                 stream->stats.i_ttff
+                     ? stream->stats.i_ttff_total / stream->stats.i_ttff / 1000
+                     : 0,
+                 stream->stats.i_ttff_max / 1000,
+                 stream->stats.i_drops, stream->stats.i_kicks );
+
     httpd_UrlDelete( stream->url );
     vlc_mutex_destroy( &stream->lock );
+    for( unsigned i = 0; i < stream->i_ring_count; i++ )
+        block_Release( httpd_StreamBlock( stream, i )->p_block );
+    free( stream->p_ring );
     free( stream->psz_mime );
     free( stream->p_header );
-    free( stream->p_buffer );
     free( stream );
 }
 
 /*****************************************************************************
  * Low level
  *****************************************************************************/
-static void* httpd_HostThread( void * );
+static void* httpd_WorkerThread( void * );
 static httpd_host_t *httpd_HostCreate( vlc_object_t *, const char *,
                                        const char *, vlc_tls_creds_t * );
 
@@ -945,6 +1170,118 @@ static struct httpd
     int          i_host;
 } httpd = { VLC_STATIC_MUTEX, NULL, 0 };
 
+static int httpd_WorkerStart( httpd_host_t *host, httpd_worker_t *worker )
+{
+    worker->host = host;
+    vlc_mutex_init( &worker->lock );
+    worker->i_client = 0;
+    worker->client = NULL;
+    vlc_atomic_set( &worker->waiting, 0 );
+
+#ifndef WIN32
+    if( vlc_pipe( worker->wake ) == 0 )
+    {
+        fcntl( worker->wake[0], F_SETFL,
+               fcntl( worker->wake[0], F_GETFL ) | O_NONBLOCK );
+        fcntl( worker->wake[1], F_SETFL,
+               fcntl( worker->wake[1], F_GETFL ) | O_NONBLOCK );
+    }
+    else
+#endif
+        worker->wake[0] = worker->wake[1] = -1;
+
+    if( vlc_clone( &worker->thread, httpd_WorkerThread, worker,
+                   VLC_THREAD_PRIORITY_LOW ) )
+    {
+        if( worker->wake[0] != -1 )
+        {
+            close( worker->wake[0] );
+            close( worker->wake[1] );
+        }
+        vlc_mutex_destroy( &worker->lock );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static void httpd_WorkerStop( httpd_worker_t *worker )
+{
+    vlc_cancel( worker->thread );
+    vlc_join( worker->thread, NULL );
+
+    for( int i = 0; i < worker->i_client; i++ )
+    {
+        httpd_client_t *cl = worker->client[i];
+        msg_Warn( worker->host, "client still connected" );
+        httpd_ClientClean( cl );
+        free( cl );
+    }
+    free( worker->client );
+
+    if( worker->wake[0] != -1 )
+    {
+        close( worker->wake[0] );
+        close( worker->wake[1] );
+    }
+    vlc_mutex_destroy( &worker->lock );
+}
+
+static void httpd_WorkerWake( httpd_worker_t *worker )
+{
+    ssize_t val = write( worker->wake[1], "", 1 );
+    (void) val; /* if the pipe is full, the worker is awake anyway */
+}
+
+/* Gives a new client to the least busy worker.
+ * Must be called with the lock of the calling worker held. */
+static void httpd_WorkerAdd( httpd_worker_t *self, httpd_client_t *cl )
+{
+    httpd_host_t *host = self->host;
+    httpd_worker_t *worker = self;
+    int i_min = self->i_client;
+
+    for( unsigned i = 0; i < host->i_worker; i++ )
+    {
+        httpd_worker_t *w = &host->worker[i];
+        if( w == self )
+            continue;
+
+        vlc_mutex_lock( &w->lock );
+        if( w->i_client < i_min )
+        {
+            i_min = w->i_client;
+            worker = w;
+        }
+        vlc_mutex_unlock( &w->lock );
+    }
+
+    if( worker == self )
+    {
+        TAB_APPEND( self->i_client, self->client, cl );
+        return;
+    }
+
+    vlc_mutex_lock( &worker->lock );
+    TAB_APPEND( worker->i_client, worker->client, cl );
+    vlc_mutex_unlock( &worker->lock );
+    if( worker->wake[1] != -1 )
+        httpd_WorkerWake( worker );
+}
+
+/* Wakes up the workers that have clients waiting for stream data.
+ * The waiting flag is set before a worker looks for new data, and the data
+ * are queued before the flag is read here, so no wake up is missed. */
+static void httpd_HostWake( httpd_host_t *host )
+{
+    for( unsigned i = 0; i < host->i_worker; i++ )
+    {
+        httpd_worker_t *worker = &host->worker[i];
+
+        if( worker->wake[1] != -1 && vlc_atomic_get( &worker->waiting ) )
+            httpd_WorkerWake( worker );
+    }
+}
+
 static httpd_host_t *httpd_HostCreate( vlc_object_t *p_this,
                                        const char *hostvar,
                                        const char *portvar,
@@ -1018,17 +1355,28 @@ static httpd_host_t *httpd_HostCreate( vlc_object_t *p_this,
     host->port     = port;
     host->i_url    = 0;
     host->url      = NULL;
-    host->i_client = 0;
-    host->client   = NULL;
     host->p_tls    = p_tls;
 
-    /* create the thread */
-    if( vlc_clone( &host->thread, httpd_HostThread, host,
-                   VLC_THREAD_PRIORITY_LOW ) )
+    /* create the worker threads */
+    unsigned i_worker = var_InheritInteger( p_this, "http-threads" );
+    if( i_worker == 0 )
+        i_worker = __MIN( vlc_GetCPUCount(), 4 );
+    i_worker = __MIN( i_worker, HTTPD_MAX_WORKERS );
+
+    host->worker = malloc( i_worker * sizeof( *host->worker ) );
+    if( host->worker == NULL )
+        goto error;
+    for( host->i_worker = 0; host->i_worker < i_worker; host->i_worker++ )
+        if( httpd_WorkerStart( host, &host->worker[host->i_worker] ) )
+            break;
+
+    if( host->i_worker == 0 )
     {
         msg_Err( p_this, "cannot spawn http host thread" );
+        free( host->worker );
         goto error;
     }
+    msg_Dbg( host, "HTTP host using %u thread(s)", host->i_worker );
 
     /* now add it to httpd */
     TAB_APPEND( httpd.i_host, httpd.host, host );
@@ -1076,8 +1424,9 @@ void httpd_HostDelete( httpd_host_t *host )
     }
     TAB_REMOVE( httpd.i_host, httpd.host, host );
 
-    vlc_cancel( host->thread );
-    vlc_join( host->thread, NULL );
+    for( unsigned i = 0; i < host->i_worker; i++ )
+        httpd_WorkerStop( &host->worker[i] );
+    free( host->worker );
 
     msg_Dbg( host, "HTTP host removed" );
 
@@ -1085,16 +1434,6 @@ void httpd_HostDelete( httpd_host_t *host )
     {
         msg_Err( host, "url still registered: %s", host->url[i]->psz_url );
     }
-    for( i = 0; i < host->i_client; i++ )
-    {
-        httpd_client_t *cl = host->client[i];
-        msg_Warn( host, "client still connected" );
-        httpd_ClientClean( cl );
-        TAB_REMOVE( host->i_client, host->client, cl );
-        free( cl );
-        i--;
-        /* TODO */
-    }
 
     vlc_tls_Delete( host->p_tls );
     net_ListenClose( host->fds );
@@ -1164,28 +1503,37 @@ void httpd_UrlDelete( httpd_url_t *url )
 
     vlc_mutex_lock( &host->lock );
     TAB_REMOVE( host->i_url, host->url, url );
+    vlc_mutex_unlock( &host->lock );
 
-    vlc_mutex_destroy( &url->lock );
-    free( url->psz_url );
-    free( url->psz_user );
-    free( url->psz_password );
-
-    for( i = 0; i < host->i_client; i++ )
+    /* Workers look the url up with their own lock held, it cannot be
+     * assigned to any client anymore. */
+    for( unsigned w = 0; w < host->i_worker; w++ )
     {
-        httpd_client_t *client = host->client[i];
+        httpd_worker_t *worker = &host->worker[w];
 
-        if( client->url == url )
+        vlc_mutex_lock( &worker->lock );
+        for( i = 0; i < worker->i_client; i++ )
         {
-            /* TODO complete it */
-            msg_Warn( host, "force closing connections" );
-            httpd_ClientClean( client );
-            TAB_REMOVE( host->i_client, host->client, client );
-            free( client );
-            i--;
+            httpd_client_t *client = worker->client[i];
+
+            if( client->url == url )
+            {
+                /* TODO complete it */
+                msg_Warn( host, "force closing connections" );
+                httpd_ClientClean( client );
+                TAB_REMOVE( worker->i_client, worker->client, client );
+                free( client );
+                i--;
+            }
         }
+        vlc_mutex_unlock( &worker->lock );
     }
+
+    vlc_mutex_destroy( &url->lock );
+    free( url->psz_url );
+    free( url->psz_user );
+    free( url->psz_password );
     free( url );
-    vlc_mutex_unlock( &host->lock );
 }
 
 static void httpd_MsgInit( httpd_message_t *msg )
@@ -1274,6 +1622,15 @@ static void httpd_ClientInit( httpd_client_t *cl, mtime_t now )
     cl->i_buffer = 0;
     cl->p_buffer = xmalloc( cl->i_buffer_size );
     cl->b_stream_mode = false;
+    cl->p_chain = NULL;
+    cl->pp_chain_last = &cl->p_chain;
+    cl->stats.i_sent = 0;
+    cl->stats.i_dropped = 0;
+    cl->stats.i_drops = 0;
+    cl->stats.i_lag = 0;
+    cl->stats.i_start = 0;
+    cl->stats.i_ttff = 0;
+    cl->stats.b_ttff_counted = false;
 
     httpd_MsgInit( &cl->query );
     httpd_MsgInit( &cl->answer );
@@ -1302,6 +1659,10 @@ static void httpd_ClientClean( httpd_client_t *cl )
     httpd_MsgClean( &cl->answer );
     httpd_MsgClean( &cl->query );
 
+    block_ChainRelease( cl->p_chain );
+    cl->p_chain = NULL;
+    cl->pp_chain_last = &cl->p_chain;
+
     free( cl->p_buffer );
     cl->p_buffer = NULL;
 }
@@ -1352,6 +1713,66 @@ ssize_t httpd_NetSend (httpd_client_t *cl, const uint8_t *p, size_t i_len)
     return val;
 }
 
+/* Sends as much as possible of the pending stream blocks */
+static ssize_t httpd_NetSendChain( httpd_client_t *cl )
+{
+    ssize_t val;
+
+#ifndef WIN32
+    if( cl->p_tls == NULL )
+    {
+        struct iovec iov[HTTPD_CL_IOV];
+        struct msghdr hdr;
+        unsigned i_iov = 0;
+
+        for( block_t *b = cl->p_chain; b != NULL && i_iov < HTTPD_CL_IOV;
+             b = b->p_next )
+        {
+            iov[i_iov].iov_base = b->p_buffer;
+            iov[i_iov].iov_len = b->i_buffer;
+            i_iov++;
+        }
+
+        memset( &hdr, 0, sizeof (hdr) );
+        hdr.msg_iov = iov;
+        hdr.msg_iovlen = i_iov;
+        do
+            val = sendmsg( cl->fd, &hdr, 0 );
+        while (val == -1 && errno == EINTR);
+    }
+    else
+#endif
+        val = httpd_NetSend( cl, cl->p_chain->p_buffer,
+                             cl->p_chain->i_buffer );
+    if( val <= 0 )
+        return val;
+
+    cl->stats.i_sent += val;
+
+    /* Release what was sent */
+    size_t i_sent = val;
+    while( i_sent > 0 )
+    {
+        block_t *b = cl->p_chain;
+
+        if( i_sent < b->i_buffer )
+        {
+            b->p_buffer += i_sent;
+            b->i_buffer -= i_sent;
+            break;
+        }
+        i_sent -= b->i_buffer;
+        cl->p_chain = b->p_next;
+        block_Release( b );
+
+        if( cl->stats.i_ttff == 0 && cl->stats.i_start > 0 )
+            cl->stats.i_ttff = __MAX( mdate() - cl->stats.i_start, 1 );
+    }
+    if( cl->p_chain == NULL )
+        cl->pp_chain_last = &cl->p_chain;
+    return val;
+}
+
 
 static const struct
 {
@@ -1825,13 +2246,21 @@ static void httpd_ClientSend( httpd_client_t *cl )
         fprintf( stderr, "%s",  cl->p_buffer );*/
     }
 
-    i_len = httpd_NetSend( cl, &cl->p_buffer[cl->i_buffer],
-                           cl->i_buffer_size - cl->i_buffer );
-    if( i_len >= 0 )
+    if( cl->i_buffer < cl->i_buffer_size )
     {
-        cl->i_buffer += i_len;
+        i_len = httpd_NetSend( cl, &cl->p_buffer[cl->i_buffer],
+                               cl->i_buffer_size - cl->i_buffer );
+        if( i_len >= 0 )
+            cl->i_buffer += i_len;
+    }
+    else if( cl->p_chain != NULL )
+        i_len = httpd_NetSendChain( cl );
+    else
+        i_len = 0;
 
-        if( cl->i_buffer >= cl->i_buffer_size )
+    if( i_len >= 0 )
+    {
+        if( cl->i_buffer >= cl->i_buffer_size && cl->p_chain == NULL )
         {
             if( cl->answer.i_body == 0  && cl->answer.i_body_offset > 0 )
             {
@@ -1844,6 +2273,8 @@ static void httpd_ClientSend( httpd_client_t *cl )
 
                 cl->url->catch[i_msg].cb( cl->url->catch[i_msg].p_sys, cl,
                                           &cl->answer, &cl->query );
+                if( cl->i_state == HTTPD_CLIENT_DEAD )
+                    return; /* too late client */
             }
 
             if( cl->answer.i_body > 0 )
@@ -1857,7 +2288,7 @@ static void httpd_ClientSend( httpd_client_t *cl )
                 cl->answer.i_body = 0;
                 cl->answer.p_body = NULL;
             }
-            else
+            else if( cl->p_chain == NULL )
             {
                 /* send finished */
                 cl->i_state = HTTPD_CLIENT_SEND_DONE;
@@ -1900,24 +2331,17 @@ static void httpd_ClientTlsHandshake( httpd_client_t *cl )
     }
 }
 
-static void* httpd_HostThread( void *data )
+static void* httpd_WorkerThread( void *data )
 {
-    httpd_host_t *host = data;
+    httpd_worker_t *worker = data;
+    httpd_host_t *host = worker->host;
+    /* the first worker accepts connections for all of them */
+    unsigned nlisten = (worker == host->worker) ? host->nfd : 0;
     int canc = vlc_savecancel();
 
-    vlc_mutex_lock( &host->lock );
-    while( host->i_ref > 0 )
+    for( ;; )
     {
-        struct pollfd ufd[host->nfd + host->i_client];
-        unsigned nfd;
-        for( nfd = 0; nfd < host->nfd; nfd++ )
-        {
-            ufd[nfd].fd = host->fds[nfd];
-            ufd[nfd].events = POLLIN;
-            ufd[nfd].revents = 0;
-        }
-
-        /* add all socket that should be read/write and close dead connection */
+        vlc_mutex_lock( &host->lock );
         while( host->i_url <= 0 )
         {
             mutex_cleanup_push( &host->lock );
@@ -1926,20 +2350,49 @@ static void* httpd_HostThread( void *data )
             canc = vlc_savecancel();
             vlc_cleanup_pop();
         }
+        vlc_mutex_unlock( &host->lock );
+
+        vlc_mutex_lock( &worker->lock );
 
+        struct pollfd ufd[nlisten + 1 + worker->i_client];
+        unsigned nfd;
+        for( nfd = 0; nfd < nlisten; nfd++ )
+        {
+            ufd[nfd].fd = host->fds[nfd];
+            ufd[nfd].events = POLLIN;
+            ufd[nfd].revents = 0;
+        }
+        if( worker->wake[0] != -1 )
+        {
+            ufd[nfd].fd = worker->wake[0];
+            ufd[nfd].events = POLLIN;
+            ufd[nfd].revents = 0;
+            nfd++;
+        }
+        const unsigned nfd_clients = nfd;
+
+        /* add all socket that should be read/write and close dead connection */
         mtime_t now = mdate();
         bool b_low_delay = false;
+        bool b_waiting = false;
 
-        for(int i_client = 0; i_client < host->i_client; i_client++ )
+        for(int i_client = 0; i_client < worker->i_client; i_client++ )
         {
-            httpd_client_t *cl = host->client[i_client];
+            httpd_client_t *cl = worker->client[i_client];
             if( cl->i_ref < 0 || ( cl->i_ref == 0 &&
                 ( cl->i_state == HTTPD_CLIENT_DEAD ||
                   ( cl->i_activity_timeout > 0 &&
                     cl->i_activity_date+cl->i_activity_timeout < now) ) ) )
             {
+                if( cl->b_stream_mode )
+                    msg_Dbg( host, "stream client gone: %"PRIu64" bytes sent, "
+                             "%"PRIu64" bytes dropped (%u times), "
+                             "maximum lag %"PRId64" bytes, time to first "
+                             "frame %"PRId64" ms", cl->stats.i_sent,
+                             cl->stats.i_dropped, cl->stats.i_drops,
+                             cl->stats.i_lag, cl->stats.i_ttff / 1000 );
                 httpd_ClientClean( cl );
-                TAB_REMOVE( host->i_client, host->client, cl );
+                TAB_REMOVE( worker->i_client, worker->client, cl );
                 free( cl );
                 i_client--;
                 continue;
@@ -1951,17 +2404,7 @@ static void* httpd_HostThread( void *data )
             pufd->fd = cl->fd;
             pufd->events = pufd->revents = 0;
 
-            if( ( cl->i_state == HTTPD_CLIENT_RECEIVING )
-                  || ( cl->i_state == HTTPD_CLIENT_TLS_HS_IN ) )
-            {
-                pufd->events = POLLIN;
-            }
-            else if( ( cl->i_state == HTTPD_CLIENT_SENDING )
-                  || ( cl->i_state == HTTPD_CLIENT_TLS_HS_OUT ) )
-            {
-                pufd->events = POLLOUT;
-            }
-            else if( cl->i_state == HTTPD_CLIENT_RECEIVE_DONE )
+            if( cl->i_state == HTTPD_CLIENT_RECEIVE_DONE )
             {
                 httpd_message_t *answer = &cl->answer;
                 httpd_message_t *query  = &cl->query;
@@ -2054,6 +2497,7 @@ static void* httpd_HostThread( void *data )
                     bool b_auth_failed = false;
 
                     /* Search the url and trigger callbacks */
+                    vlc_mutex_lock( &host->lock );
                     for(int i = 0; i < host->i_url; i++ )
                     {
                         httpd_url_t *url = host->url[i];
@@ -2120,6 +2564,7 @@ static void* httpd_HostThread( void *data )
                             }
                         }
                     }
+                    vlc_mutex_unlock( &host->lock );
 
                     if( answer )
                     {
@@ -2209,7 +2654,8 @@ static void* httpd_HostThread( void *data )
                     cl->i_state = HTTPD_CLIENT_WAITING;
                 }
             }
-            else if( cl->i_state == HTTPD_CLIENT_WAITING )
+
+            if( cl->i_state == HTTPD_CLIENT_WAITING )
             {
                 int64_t i_offset = cl->answer.i_body_offset;
                 int     i_msg = cl->query.i_type;
@@ -2217,6 +2663,9 @@ static void* httpd_HostThread( void *data )
                 httpd_MsgInit( &cl->answer );
                 cl->answer.i_body_offset = i_offset;
 
+                /* Set before looking for data, see httpd_HostWake() */
+                vlc_atomic_set( &worker->waiting, 1 );
+
                 cl->url->catch[i_msg].cb( cl->url->catch[i_msg].p_sys, cl,
                                           &cl->answer, &cl->query );
                 if( cl->answer.i_type != HTTPD_MSG_NONE )
@@ -2231,19 +2680,42 @@ static void* httpd_HostThread( void *data )
                 }
             }
 
+            switch( cl->i_state )
+            {
+                case HTTPD_CLIENT_RECEIVING:
+                case HTTPD_CLIENT_TLS_HS_IN:
+                    pufd->events = POLLIN;
+                    break;
+                case HTTPD_CLIENT_SENDING:
+                case HTTPD_CLIENT_TLS_HS_OUT:
+                    pufd->events = POLLOUT;
+                    break;
+                case HTTPD_CLIENT_WAITING:
+                    b_waiting = true;
+                    break;
+                default:
+                    b_low_delay = true;
+                    break;
+            }
+
             if (pufd->events != 0)
                 nfd++;
-            else
-                b_low_delay = true;
         }
-        vlc_mutex_unlock( &host->lock );
+        vlc_mutex_unlock( &worker->lock );
         vlc_restorecancel( canc );
 
-        /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING */
-        int ret = poll( ufd, nfd, b_low_delay ? 20 : -1 );
+        /* Waiting clients are woken up when stream data arrive, we will wait
+         * 20ms (not too big) if that is not possible. */
+        int timeout = -1;
+        if( b_low_delay )
+            timeout = 0;
+        else if( b_waiting && worker->wake[0] == -1 )
+            timeout = 20;
+        int ret = poll( ufd, nfd, timeout );
 
         canc = vlc_savecancel();
-        vlc_mutex_lock( &host->lock );
+        vlc_atomic_set( &worker->waiting, 0 );
+        vlc_mutex_lock( &worker->lock );
         switch( ret )
         {
             case -1:
@@ -2254,19 +2726,28 @@ static void* httpd_HostThread( void *data )
                     msleep( 100000 );
                 }
             case 0:
+                vlc_mutex_unlock( &worker->lock );
                 continue;
         }
 
+        if( worker->wake[0] != -1 && ufd[nlisten].revents )
+        {
+            char dummy[64];
+            while( read( worker->wake[0], dummy, sizeof (dummy) ) > 0 );
+        }
+
         /* Handle client sockets */
         now = mdate();
-        nfd = host->nfd;
+        const unsigned nfd_max = nfd;
+        nfd = nfd_clients;
 
-        for( int i_client = 0; i_client < host->i_client; i_client++ )
+        for( int i_client = 0; i_client < worker->i_client; i_client++ )
         {
-            httpd_client_t *cl = host->client[i_client];
-            const struct pollfd *pufd = &ufd[nfd];
+            httpd_client_t *cl = worker->client[i_client];
 
-            assert( pufd < &ufd[sizeof(ufd) / sizeof(ufd[0])] );
+            if( nfd >= nfd_max )
+                break; // clients added while polling
+            const struct pollfd *pufd = &ufd[nfd];
 
             if( cl->fd != pufd->fd )
                 continue; // we were not waiting for this client
@@ -2292,7 +2773,7 @@ static void* httpd_HostThread( void *data )
         }
 
         /* Handle server sockets (accept new connections) */
-        for( nfd = 0; nfd < host->nfd; nfd++ )
+        for( nfd = 0; nfd < nlisten; nfd++ )
         {
             httpd_client_t *cl;
             int fd = ufd[nfd].fd;
@@ -2317,10 +2798,17 @@ static void* httpd_HostThread( void *data )
                 p_tls = NULL;
 
             cl = httpd_ClientNew( fd, p_tls, now );
+            if( cl == NULL )
+            {
+                if( p_tls != NULL )
+                    vlc_tls_SessionDelete( p_tls );
+                net_Close( fd );
+                continue;
+            }
 
-            TAB_APPEND( host->i_client, host->client, cl );
+            httpd_WorkerAdd( worker, cl );
         }
+        vlc_mutex_unlock( &worker->lock );
     }
-    vlc_mutex_unlock( &host->lock );
     return NULL;
 }
@@ -110,11 +110,14 @@ sout_instance_t *sout_NewInstance( vlc_object_t *p_parent, const char *psz_dest
     /* *** init descriptor *** */
     p_sout->psz_sout    = strdup( psz_dest );
     p_sout->i_out_pace_nocontrol = 0;
+    atomic_init( &p_sout->i_congested, 0 );
 
     vlc_mutex_init( &p_sout->lock );
     p_sout->p_stream = NULL;
 
     var_Create( p_sout, "sout-mux-caching", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT );
+    var_Create( p_sout, "sout-mux-max-bytes", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT );
+    var_Create( p_sout, "sout-mux-max-delay", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT );
 
     p_sout->p_stream = sout_StreamChainNew( p_sout, psz_chain, NULL, NULL );
     if( p_sout->p_stream )
@@ -237,6 +240,53 @@ int sout_InputSendBuffer( sout_packetizer_input_t *p_input,
     return i_ret;
 }
 
+/*****************************************************************************
+ * sout_InputIsCongested: tells whether some muxer input queue is close to
+ * its bounds, so that the sender should shed what it can
+ *****************************************************************************/
+bool sout_InputIsCongested( sout_packetizer_input_t *p_input )
+{
+    return atomic_load( &p_input->p_sout->i_congested ) > 0;
+}
+
+/*****************************************************************************
+ * sout_BlockIsDisposable: tells whether a block is a frame that no other
+ * frame references, and may thus be dropped without damaging the stream
+ *****************************************************************************/
+bool sout_BlockIsDisposable( const es_format_t *p_fmt, const block_t *p_block )
+{
+    switch( p_fmt->i_codec )
+    {
+        case VLC_CODEC_MPGV:
+        case VLC_CODEC_MP4V:
+            /* B frames are never references in MPEG-1/2 and MPEG-4 part 2 */
+            return ( p_block->i_flags & BLOCK_FLAG_TYPE_B ) != 0;
+
+        case VLC_CODEC_H264:
+        {
+            /* B slices may be references (B pyramid), only trust the
+             * nal_ref_idc of the first slice of the Annex B frame */
+            const uint8_t *p = p_block->p_buffer;
+            const uint8_t *p_end = p + p_block->i_buffer;
+
+            for( ; p + 3 < p_end; p++ )
+            {
+                if( p[0] != 0 || p[1] != 0 || p[2] != 1 )
+                    continue;
+
+                const uint8_t i_nal = p[3];
+                if( ( i_nal & 0x1f ) == 1 || ( i_nal & 0x1f ) == 5 )
+                    return ( i_nal & 0x60 ) == 0;
+                p += 3;
+            }
+            return false;
+        }
+
+        default:
+            return false;
+    }
+}
+
 #undef sout_AccessOutNew
 /*****************************************************************************
  * sout_AccessOutNew: allocate a new access out
@@ -366,6 +416,8 @@ sout_mux_t * sout_MuxNew( sout_instance_t *p_sout, const char *psz_mux,
     p_mux->b_add_stream_any_time = false;
     p_mux->b_waiting_stream = true;
     p_mux->i_add_stream_start = -1;
+    p_mux->i_max_bytes = var_GetInteger( p_sout, "sout-mux-max-bytes" ) * 1024;
+    p_mux->i_max_delay = var_GetInteger( p_sout, "sout-mux-max-delay" ) * INT64_C(1000);
 
     p_mux->p_module =
         module_need( p_mux, "sout mux", p_mux->psz_mux, true );
@@ -458,6 +510,12 @@ sout_input_t *sout_MuxAddStream( sout_mux_t *p_mux, es_format_t *p_fmt )
     p_input->p_fmt  = p_fmt;
     p_input->p_fifo = block_FifoNew();
     p_input->p_sys  = NULL;
+    p_input->b_congested = false;
+    p_input->b_resync = false;
+    p_input->b_keyframes = false;
+    p_input->i_queued_peak = 0;
+    p_input->i_dropped = 0;
+    p_input->i_dropped_bytes = 0;
 
     TAB_APPEND( p_mux->i_nb_inputs, p_mux->pp_inputs, p_input );
     if( p_mux->pf_addstream( p_mux, p_input ) < 0 )
@@ -504,25 +562,122 @@ void sout_MuxDeleteStream( sout_mux_t *p_mux, sout_input_t *p_input )
             msg_Warn( p_mux, "no more input streams for this mux" );
         }
 
+        if( p_input->b_congested )
+            atomic_fetch_sub( &p_mux->p_sout->i_congested, 1 );
+        msg_Dbg( p_mux, "input %4.4s: at most %zu bytes queued, %u blocks "
+                 "(%zu bytes) dropped", (const char *)&p_input->p_fmt->i_codec,
+                 p_input->i_queued_peak, p_input->i_dropped,
+                 p_input->i_dropped_bytes );
+
         block_FifoRelease( p_input->p_fifo );
         free( p_input );
     }
 }
 
+/* Whether the queue of an input is over num/den of its bounds */
+static bool MuxInputIsOver( sout_mux_t *p_mux, sout_input_t *p_input,
+                            mtime_t i_last_dts, unsigned num, unsigned den )
+{
+    if( p_mux->i_max_bytes > 0
+     && block_FifoSize( p_input->p_fifo ) * den > p_mux->i_max_bytes * num )
+        return true;
+
+    if( p_mux->i_max_delay > 0 && block_FifoCount( p_input->p_fifo ) > 0 )
+    {
+        const block_t *p_first = block_FifoShow( p_input->p_fifo );
+        if( p_first->i_dts > VLC_TS_INVALID
+         && ( i_last_dts - p_first->i_dts ) * den > p_mux->i_max_delay * num )
+            return true;
+    }
+    return false;
+}
+
+static void MuxInputDrop( sout_input_t *p_input, block_t *p_block )
+{
+    p_input->i_dropped++;
+    p_input->i_dropped_bytes += p_block->i_buffer;
+    block_Release( p_block );
+}
+
+/* Enforces the bounds of an input queue once the muxer had its go at it */
+static void MuxInputBound( sout_mux_t *p_mux, sout_input_t *p_input,
+                           mtime_t i_last_dts )
+{
+    size_t i_size = block_FifoSize( p_input->p_fifo );
+    if( i_size > p_input->i_queued_peak )
+        p_input->i_queued_peak = i_size;
+
+    if( p_mux->i_max_bytes == 0 && p_mux->i_max_delay == 0 )
+        return;
+
+    if( MuxInputIsOver( p_mux, p_input, i_last_dts, 1, 1 ) )
+    {
+        if( p_input->p_fmt->i_cat == VIDEO_ES )
+        {
+            /* The next frames may reference the dropped ones: drop
+             * everything queued and, if the stream flags its keyframes,
+             * wait for the next one. */
+            while( block_FifoCount( p_input->p_fifo ) > 0 )
+            {
+                MuxInputDrop( p_input, block_FifoGet( p_input->p_fifo ) );
+                p_input->b_resync = p_input->b_keyframes;
+            }
+        }
+        else
+        {
+            while( MuxInputIsOver( p_mux, p_input, i_last_dts, 1, 1 ) )
+                MuxInputDrop( p_input, block_FifoGet( p_input->p_fifo ) );
+        }
+        msg_Warn( p_mux, "input %4.4s queue overflow, %u blocks dropped so far",
+                  (const char *)&p_input->p_fmt->i_codec, p_input->i_dropped );
+    }
+
+    bool b_congested = MuxInputIsOver( p_mux, p_input, i_last_dts, 3, 4 );
+    if( b_congested != p_input->b_congested )
+    {
+        p_input->b_congested = b_congested;
+        if( b_congested )
+            atomic_fetch_add( &p_mux->p_sout->i_congested, 1 );
+        else
+            atomic_fetch_sub( &p_mux->p_sout->i_congested, 1 );
+    }
+}
+
 /*****************************************************************************
  * sout_MuxSendBuffer:
  *****************************************************************************/
 void sout_MuxSendBuffer( sout_mux_t *p_mux, sout_input_t *p_input,
                          block_t *p_buffer )
 {
+    const mtime_t i_dts = p_buffer->i_dts;
+
+    if( p_buffer->i_flags & BLOCK_FLAG_TYPE_I )
+        p_input->b_keyframes = true;
+    if( p_input->b_resync )
+    {
+        if( !( p_buffer->i_flags & BLOCK_FLAG_TYPE_I ) )
+        {
+            MuxInputDrop( p_input, p_buffer );
+            return;
+        }
+        p_input->b_resync = false;
+    }
+    /* Frames no other frame references go first */
+    if( p_input->b_congested
+     && sout_BlockIsDisposable( p_input->p_fmt, p_buffer ) )
+    {
+        MuxInputDrop( p_input, p_buffer );
+        return;
+    }
+
     block_FifoPut( p_input->p_fifo, p_buffer );
 
     if( p_mux->p_sout->i_out_pace_nocontrol )
     {
         mtime_t current_date = mdate();
-        if ( current_date > p_buffer->i_dts )
+        if ( current_date > i_dts )
             msg_Warn( p_mux, "late buffer for mux input (%"PRId64")",
-                      current_date - p_buffer->i_dts );
+                      current_date - i_dts );
     }
 
     if( p_mux->b_waiting_stream )
@@ -530,15 +685,16 @@ void sout_MuxSendBuffer( sout_mux_t *p_mux, sout_input_t *p_input,
         const int64_t i_caching = var_GetInteger( p_mux->p_sout, "sout-mux-caching" ) * INT64_C(1000);
 
         if( p_mux->i_add_stream_start < 0 )
-            p_mux->i_add_stream_start = p_buffer->i_dts;
+            p_mux->i_add_stream_start = i_dts;
 
         /* Wait until we have enought data before muxing */
         if( p_mux->i_add_stream_start < 0 ||
-            p_buffer->i_dts < p_mux->i_add_stream_start + i_caching )
+            i_dts < p_mux->i_add_stream_start + i_caching )
             return;
         p_mux->b_waiting_stream = false;
     }
     p_mux->pf_mux( p_mux );
+    MuxInputBound( p_mux, p_input, i_dts );
 }
 
 
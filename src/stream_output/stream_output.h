@@ -49,6 +49,8 @@ void sout_DeleteInstance( sout_instance_t * );
 sout_packetizer_input_t *sout_InputNew( sout_instance_t *, es_format_t * );
 int sout_InputDelete( sout_packetizer_input_t * );
 int sout_InputSendBuffer( sout_packetizer_input_t *, block_t* );
+bool sout_InputIsCongested( sout_packetizer_input_t * );
+bool sout_BlockIsDisposable( const es_format_t *, const block_t * );
 
 /* Announce system */
 
@@ -25,18 +25,20 @@
 # define LIBVLC_VOUT_STATISTIC_H
 # include <vlc_atomic.h>
 
-/* NOTE: Both statistics are atomic on their own, so one might be older than
- * the other one. Currently, only one of them is updated at a time, so this
+/* NOTE: The statistics are atomic on their own, so one might be older than
+ * the other ones. Currently, only one of them is updated at a time, so this
  * is a non-issue. */
 typedef struct {
     atomic_uint displayed;
     atomic_uint lost;
+    atomic_uint copied; /* pictures copied before being displayed */
 } vout_statistic_t;
 
 static inline void vout_statistic_Init(vout_statistic_t *stat)
 {
     atomic_init(&stat->displayed, 0);
     atomic_init(&stat->lost, 0);
+    atomic_init(&stat->copied, 0);
 }
 
 static inline void vout_statistic_Clean(vout_statistic_t *stat)
@@ -44,10 +46,11 @@ static inline void vout_statistic_Clean(vout_statistic_t *stat)
     (void) stat;
 }
 
-static inline void vout_statistic_GetReset(vout_statistic_t *stat, int *displayed, int *lost)
+static inline void vout_statistic_GetReset(vout_statistic_t *stat, int *displayed, int *lost, int *copied)
 {
     *displayed = atomic_exchange(&stat->displayed, 0);
     *lost      = atomic_exchange(&stat->lost, 0);
+    *copied    = atomic_exchange(&stat->copied, 0);
 }
 
 static inline void vout_statistic_AddDisplayed(vout_statistic_t *stat,
@@ -61,4 +64,9 @@ static inline void vout_statistic_AddLost(vout_statistic_t *stat, int lost)
     atomic_fetch_add(&stat->lost, lost);
 }
 
+static inline void vout_statistic_AddCopied(vout_statistic_t *stat, int copied)
+{
+    atomic_fetch_add(&stat->copied, copied);
+}
+
 #endif
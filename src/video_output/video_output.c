@@ -286,9 +286,10 @@ void vout_ChangePause(vout_thread_t *vout, bool is_paused, mtime_t date)
     vout_control_WaitEmpty(&vout->p->control);
 }
 
-void vout_GetResetStatistic(vout_thread_t *vout, int *displayed, int *lost)
+void vout_GetResetStatistic(vout_thread_t *vout, int *displayed, int *lost,
+                            int *copied)
 {
-    vout_statistic_GetReset( &vout->p->statistic, displayed, lost );
+    vout_statistic_GetReset( &vout->p->statistic, displayed, lost, copied );
 }
 
 void vout_Flush(vout_thread_t *vout, mtime_t date)
@@ -342,6 +343,12 @@ void vout_FixLeaks( vout_thread_t *vout )
 
     vlc_mutex_unlock(&vout->p->picture_lock);
 }
+
+void vout_WaitPictureAvailable(vout_thread_t *vout, mtime_t deadline)
+{
+    /* The picture lock is not held, the pictures are released with it */
+    picture_pool_Wait(vout->p->decoder_pool, deadline);
+}
 void vout_NextPicture(vout_thread_t *vout, mtime_t *duration)
 {
     vout_control_cmd_t cmd;
@@ -974,13 +981,13 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
      * - be sure to end up with a direct buffer.
      * - blend subtitles, and in a fast access buffer
      */
-    bool is_direct = vout->p->decoder_pool == vout->p->display_pool;
     picture_t *todisplay = filtered;
     if (do_early_spu && subpic) {
         todisplay = picture_pool_Get(vout->p->private_pool);
         if (todisplay) {
             VideoFormatCopyCropAr(&todisplay->format, &filtered->format);
             picture_Copy(todisplay, filtered);
+            vout_statistic_AddCopied(&vout->p->statistic, 1);
             if (vout->p->spu_blend)
                 picture_BlendSubpicture(todisplay, vout->p->spu_blend, subpic);
         }
@@ -992,12 +999,16 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
             return VLC_EGENERIC;
     }
 
+    /* Pictures rendered into the display pool, by the decoder or the
+     * filters, are displayed as is. A filtered display converts any. */
     picture_t *direct;
-    if (!is_direct && todisplay) {
+    if (sys->display.use_dr && todisplay &&
+        !picture_pool_OwnsPic(vout->p->display_pool, todisplay)) {
         direct = picture_pool_Get(vout->p->display_pool);
         if (direct) {
             VideoFormatCopyCropAr(&direct->format, &todisplay->format);
             picture_Copy(direct, todisplay);
+            vout_statistic_AddCopied(&vout->p->statistic, 1);
         }
         picture_Release(todisplay);
     } else {
@@ -39,7 +39,7 @@ void spu_OffsetSubtitleDate( spu_t *p_spu, mtime_t i_duration );
 /**
  * This function will return and reset internal statistics.
  */
-void vout_GetResetStatistic( vout_thread_t *p_vout, int *pi_displayed, int *pi_lost );
+void vout_GetResetStatistic( vout_thread_t *p_vout, int *pi_displayed, int *pi_lost, int *pi_copied );
 
 /**
  * This function will ensure that all ready/displayed pciture have at most
@@ -55,6 +55,12 @@ void vout_Flush( vout_thread_t *p_vout, mtime_t i_date );
  */
 void vout_FixLeaks( vout_thread_t *p_vout );
 
+/**
+ * This function will wait until a picture is released to the decoder pool,
+ * or until the given deadline, after vout_GetPicture failed.
+ */
+void vout_WaitPictureAvailable( vout_thread_t *p_vout, mtime_t i_deadline );
+
 /*
  * Reset the states of the vout.
  */
@@ -85,6 +85,7 @@ struct vout_thread_sys_t
         char           *title;
         vout_display_t *vd;
         bool           use_dr;
+        bool           is_shared; /* decoder renders into the display pool, not the filters */
         picture_t      *filtered;
     } display;
 
@@ -110,19 +110,38 @@ static void NoDrInit(vout_thread_t *vout)
 {
     vout_thread_sys_t *sys = vout->p;
 
+    /* A filtered display converts the pictures into its own buffers, they
+     * do not need to be copied into a display pool first */
     if (sys->display.use_dr)
         sys->display_pool = vout_display_Pool(sys->display.vd, 3);
     else
-        //sys->display_pool = picture_pool_Reserve(sys->decoder_pool, DISPLAY_PICTURE_COUNT);
-        sys->display_pool = picture_pool_NewFromFormat(&sys->display.vd->source, DISPLAY_PICTURE_COUNT);
+        sys->display_pool = NULL;
 }
-static void NoDrClean(vout_thread_t *vout)
+
+/* Not enough direct buffers for the filters too: the decoder still renders
+ * into the display pool, the filters and subpictures into system memory,
+ * copied into the pictures reserved for display. */
+static int SharedInit(vout_thread_t *vout, picture_pool_t *pool,
+                      unsigned private_picture)
 {
     vout_thread_sys_t *sys = vout->p;
 
-    if (!sys->display.use_dr)
-        picture_pool_Delete(sys->display_pool);
+    sys->private_pool = picture_pool_NewFromFormat(&sys->display.vd->source,
+                                                   private_picture);
+    if (!sys->private_pool)
+        return VLC_EGENERIC;
+    sys->display_pool = picture_pool_Reserve(pool, DISPLAY_PICTURE_COUNT);
+    if (!sys->display_pool) {
+        picture_pool_Delete(sys->private_pool);
+        sys->private_pool = NULL;
+        return VLC_EGENERIC;
+    }
+    sys->display.is_shared = true;
+    msg_Dbg(vout, "Decoding into %d direct buffers, filtering in system memory",
+            picture_pool_GetSize(pool));
+    return VLC_SUCCESS;
 }
+
 int vout_InitWrapper(vout_thread_t *vout)
 {
     vout_thread_sys_t *sys = vout->p;
@@ -130,21 +149,28 @@ int vout_InitWrapper(vout_thread_t *vout)
     video_format_t source = vd->source;
 
     sys->display.use_dr = !vout_IsDisplayFiltered(vd);
+    sys->display.is_shared = false;
     const bool allow_dr = !vd->info.has_pictures_invalid && !vd->info.is_slow && sys->display.use_dr;
     const unsigned private_picture  = 4; /* XXX 3 for filter, 1 for SPU */
     const unsigned decoder_picture  = 1 + sys->dpb_size;
     const unsigned kept_picture     = 1; /* last displayed picture */
-    const unsigned reserved_picture = DISPLAY_PICTURE_COUNT +
-                                      private_picture +
+    const unsigned shared_picture   = DISPLAY_PICTURE_COUNT +
                                       kept_picture;
+    const unsigned reserved_picture = shared_picture +
+                                      private_picture;
     picture_pool_t *display_pool =
         vout_display_Pool(vd, allow_dr ? __MAX(VOUT_MAX_PICTURES,
                                                reserved_picture + decoder_picture) : 3);
     if (allow_dr &&
-        picture_pool_GetSize(display_pool) >= reserved_picture + decoder_picture) {
+        (unsigned)picture_pool_GetSize(display_pool) >= reserved_picture + decoder_picture) {
         sys->dpb_size     = picture_pool_GetSize(display_pool) - reserved_picture;
         sys->decoder_pool = display_pool;
         sys->display_pool = display_pool;
+    } else if (allow_dr &&
+               (unsigned)picture_pool_GetSize(display_pool) >= shared_picture + decoder_picture &&
+               !SharedInit(vout, display_pool, private_picture)) {
+        sys->dpb_size     = picture_pool_GetSize(display_pool) - shared_picture;
+        sys->decoder_pool = display_pool;
     } else if (!sys->decoder_pool) {
         sys->decoder_pool =
             picture_pool_NewFromFormat(&source,
@@ -160,7 +186,8 @@ int vout_InitWrapper(vout_thread_t *vout)
         }
         NoDrInit(vout);
     }
-    sys->private_pool = picture_pool_Reserve(sys->decoder_pool, private_picture);
+    if (!sys->display.is_shared)
+        sys->private_pool = picture_pool_Reserve(sys->decoder_pool, private_picture);
     sys->display.filtered = NULL;
     return VLC_SUCCESS;
 }
@@ -176,8 +203,10 @@ void vout_EndWrapper(vout_thread_t *vout)
     if (sys->private_pool)
         picture_pool_Delete(sys->private_pool);
 
-    if (sys->decoder_pool != sys->display_pool) {
-        NoDrClean(vout);
+    if (sys->display.is_shared) {
+        /* The decoder pool belongs to the display */
+        picture_pool_Delete(sys->display_pool);
+    } else if (sys->decoder_pool != sys->display_pool) {
         picture_pool_Delete(sys->decoder_pool);
     }
 }
@@ -194,8 +223,6 @@ void vout_ManageWrapper(vout_thread_t *vout)
     vout_ManageDisplay(vd, !sys->display.use_dr || reset_display_pool);
 
     if (reset_display_pool) {
-        NoDrClean(vout);
-
         sys->display.use_dr = !vout_IsDisplayFiltered(vd);
         NoDrInit(vout);
     }
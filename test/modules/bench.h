@@ -0,0 +1,64 @@
+/*****************************************************************************
+ * bench.h: shared helpers of the module primitive tests
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_TEST_MODULES_BENCH_H
+#define VLC_TEST_MODULES_BENCH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Width of the lines the primitives are timed on */
+#define BENCH_WIDTH 1920
+
+/* The tests only check the primitives against their C version, which is
+ * what make check runs. Given a number of lines (or frames) as argument,
+ * they also time every version on that many. Returns 0 if not given. */
+static inline unsigned bench_count(int argc, char *argv[])
+{
+    return (argc > 1) ? strtoul(argv[1], NULL, 10) : 0;
+}
+
+static inline double bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Fills count samples of sample_size (1 or 2) bytes with values up to max.
+ * Mostly smooth content, with some noise and big steps, exercises all the
+ * paths of the filters, unlike uniform noise. seed shifts the ramp, so that
+ * the pictures of a sequence differ. */
+static inline void bench_fill(void *buf, size_t count, int sample_size,
+                              unsigned max, unsigned seed)
+{
+    for (size_t i = 0; i < count; i++) {
+        unsigned v = (rand() % 8) ? (i * 7 + seed * 3) % (max + 1)
+                                  : (unsigned)rand() % (max + 1);
+        if (sample_size == 2)
+            ((uint16_t *)buf)[i] = v;
+        else
+            ((uint8_t *)buf)[i] = v;
+    }
+}
+
+#endif
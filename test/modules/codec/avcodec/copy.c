@@ -0,0 +1,244 @@
+/*****************************************************************************
+ * copy.c: conformance and speed of the hardware surface copies
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Checks the NV12 and YV12 surface copies of every vector unit usable on
+ * this CPU, with and without copy threads, against plain loops. Given a
+ * number of frames as argument, also reports the throughput of each on
+ * that many 3840x2160 surfaces, in GB/s of surface read. Video memory
+ * cannot be mapped here, so the surfaces are flushed from the CPU caches
+ * before each copy to get uncached reads alike.
+ */
+
+#define MODULE_STRING "test"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../../../modules/codec/avcodec/copy.c"
+#include "../../bench.h"
+
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+#define WIDTH  3840
+#define HEIGHT 2160
+#define PITCH  4096
+
+/* Evicts a surface from the caches, as if it was write combining memory */
+static void flush(const uint8_t *p, size_t size)
+{
+#ifdef __SSE2__
+    for (size_t i = 0; i < size; i += 64)
+        _mm_clflush(&p[i]);
+    _mm_mfence();
+#else
+    (void) p; (void) size;
+#endif
+}
+
+typedef struct
+{
+    const char *name;
+    unsigned    cpu;
+} kernel_t;
+
+/* A surface of the given layout, the planes starting offset bytes after
+ * an aligned address */
+typedef struct
+{
+    uint8_t *base;
+    uint8_t *planes[3];
+    size_t   pitches[3];
+    size_t   size;
+} surface_t;
+
+static void surface_init(surface_t *s, bool nv12, unsigned offset)
+{
+    const size_t luma = (size_t)PITCH * HEIGHT;
+
+    s->size = luma * 3 / 2 + 64;
+    s->base = vlc_memalign(64, s->size);
+    if (s->base == NULL)
+        abort();
+    for (size_t i = 0; i < s->size; i++)
+        s->base[i] = rand();
+
+    s->planes[0]  = s->base + offset;
+    s->pitches[0] = PITCH;
+    if (nv12) {
+        s->planes[1]  = s->planes[0] + luma;
+        s->pitches[1] = PITCH;
+    } else {
+        s->planes[1]  = s->planes[0] + luma;
+        s->planes[2]  = s->planes[1] + luma / 4;
+        s->pitches[1] = s->pitches[2] = PITCH / 2;
+    }
+}
+
+static void copy(picture_t *dst, surface_t *s, bool nv12, unsigned width,
+                 unsigned height, copy_cache_t *cache, unsigned cpu)
+{
+    const copy_frame_t frame = {
+        dst, s->planes, s->pitches, width, height, nv12, cpu
+    };
+    CopyFrame(cache, &frame);
+}
+
+/* Compares a YV12 picture to the surface it was copied from */
+static bool check(const picture_t *pic, const surface_t *s, bool nv12,
+                  unsigned width, unsigned height)
+{
+    for (unsigned y = 0; y < height; y++)
+        if (memcmp(&pic->p[0].p_pixels[y * pic->p[0].i_pitch],
+                   &s->planes[0][y * s->pitches[0]], width))
+            return false;
+
+    for (unsigned y = 0; y < height / 2; y++) {
+        const uint8_t *v = &pic->p[1].p_pixels[y * pic->p[1].i_pitch];
+        const uint8_t *u = &pic->p[2].p_pixels[y * pic->p[2].i_pitch];
+
+        for (unsigned x = 0; x < width / 2; x++) {
+            const uint8_t *src_v, *src_u;
+
+            if (nv12) {
+                src_u = &s->planes[1][y * s->pitches[1] + 2 * x];
+                src_v = src_u + 1;
+            } else {
+                src_v = &s->planes[1][y * s->pitches[1] + x];
+                src_u = &s->planes[2][y * s->pitches[2] + x];
+            }
+            if (u[x] != *src_u || v[x] != *src_v)
+                return false;
+        }
+    }
+    return true;
+}
+
+static picture_t *picture_new(unsigned width, unsigned height)
+{
+    video_format_t fmt;
+
+    video_format_Setup(&fmt, VLC_CODEC_YV12, width, height, 1, 1);
+    picture_t *pic = picture_NewFromFormat(&fmt);
+    if (pic == NULL)
+        abort();
+    return pic;
+}
+
+int main(int argc, char *argv[])
+{
+    static const unsigned sizes[][2] = {
+        { 2, 2 }, { 30, 6 }, { 66, 10 }, { 130, 34 }, { 720, 576 },
+        { 1918, 1080 }, { WIDTH, HEIGHT },
+    };
+    const unsigned frames = bench_count(argc, argv);
+    unsigned cpus = vlc_GetCPUCount();
+    unsigned cpu = vlc_CPU(); /* tested by the vlc_CPU_*() of copy.c */
+    kernel_t kernels[4];
+    size_t n = 0;
+    int ret = 0;
+
+    kernels[n++] = (kernel_t){ "C", 0 };
+#ifdef CAN_COMPILE_SSE2
+    if (vlc_CPU_SSE2())
+        kernels[n++] = (kernel_t){ "SSE2", VLC_CPU_SSE2 };
+    if (vlc_CPU_SSE2() && vlc_CPU_SSSE3() && vlc_CPU_SSE4_1())
+        kernels[n++] = (kernel_t){ "SSE4.1", VLC_CPU_SSE2 | VLC_CPU_SSSE3
+                                             | VLC_CPU_SSE4_1 };
+#endif
+#ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+        kernels[n++] = (kernel_t){ "AVX2", VLC_CPU_AVX2 };
+#endif
+
+    srand(0);
+
+    for (int nv12 = 0; nv12 < 2; nv12++)
+        for (unsigned offset = 0; offset < 32; offset += 16) {
+            surface_t s;
+
+            surface_init(&s, nv12, offset);
+            for (size_t k = 0; k < n; k++) {
+                unsigned mismatches = 0;
+
+                /* The copy threads are checked even on a single CPU */
+                for (unsigned threads = 0; threads < 4; threads += 3)
+                    for (size_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]);
+                         i++) {
+                        const unsigned w = sizes[i][0], h = sizes[i][1];
+                        picture_t *pic = picture_new(w, h);
+                        copy_cache_t cache;
+
+                        if (InitCache(&cache, w, threads))
+                            abort();
+                        copy(pic, &s, nv12, w, h, &cache, kernels[k].cpu);
+                        if (!check(pic, &s, nv12, w, h))
+                            mismatches++;
+                        CopyCleanCache(&cache);
+                        picture_Release(pic);
+                    }
+
+                printf("%s +%-2u %-6s %s\n", nv12 ? "NV12" : "YV12", offset,
+                       kernels[k].name, mismatches ? "MISMATCH" : "exact");
+                if (mismatches)
+                    ret = 1;
+            }
+            vlc_free(s.base);
+        }
+
+    for (int nv12 = 0; nv12 < 2 && frames > 0; nv12++) {
+        picture_t *pic = picture_new(WIDTH, HEIGHT);
+        double reference = 0.;
+        surface_t s;
+
+        surface_init(&s, nv12, 0);
+        for (size_t k = 0; k < n; k++)
+            /* 1, 2, 4... threads, each kernel */
+            for (unsigned threads = 1; threads <= cpus; threads *= 2) {
+                copy_cache_t cache;
+                double elapsed = 0.;
+
+                if (InitCache(&cache, WIDTH, threads - 1))
+                    abort();
+                for (unsigned f = 0; f < frames; f++) {
+                    flush(s.base, s.size);
+
+                    double start = bench_now();
+                    copy(pic, &s, nv12, WIDTH, HEIGHT, &cache,
+                         kernels[k].cpu);
+                    elapsed += bench_now() - start;
+                }
+                CopyCleanCache(&cache);
+
+                double gbps = frames * (WIDTH * HEIGHT * 3. / 2.)
+                            / elapsed / 1e9;
+                if (reference == 0.)
+                    reference = gbps;
+                printf("%s %-6s %u thread(s) %6.2f GB/s (x%.2f)\n",
+                       nv12 ? "NV12" : "YV12", kernels[k].name, threads,
+                       gbps, gbps / reference);
+            }
+        vlc_free(s.base);
+        picture_Release(pic);
+    }
+    return ret;
+}
@@ -0,0 +1,312 @@
+/*****************************************************************************
+ * rtsp-load.c: load test for the RTSP VoD server
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Opens many RTSP sessions on a VoD media over the loopback, and reports
+ * the start-up latency (PLAY request to first RTP packet) and, given the
+ * PID of the server, its CPU usage as sessions per core. Example:
+ *
+ *   vlc -I dummy --rtsp-host 127.0.0.1 --rtsp-port 8554 \
+ *       --rtsp-share-window 2000 --vlm-conf vod.vlm &
+ *   ./test_modules_stream_out_rtsp_load /movie 200 10 $!
+ *
+ * with vod.vlm containing:
+ *   new movie vod enabled
+ *   setup movie input file:///path/to/file.ts
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define MAX_TRACKS 8
+
+typedef struct
+{
+    int      fd;                 /* RTSP connection */
+    int      rtp[MAX_TRACKS];    /* RTP sockets */
+    unsigned tracks;
+    char     id[64];             /* RTSP session identifier */
+    unsigned cseq;
+    double   play;               /* when PLAY was sent */
+    double   first;              /* when the first RTP packet arrived */
+    unsigned long packets;
+} session_t;
+
+static const char *host = "127.0.0.1";
+static unsigned port = 8554;
+
+static double now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Sends a request and receives the answer into buf (headers and body) */
+static int request (session_t *s, const char *method, const char *url,
+                    const char *headers, char *buf, size_t size)
+{
+    char session[80] = "";
+
+    if (s->id[0])
+        snprintf (session, sizeof (session), "Session: %s\r\n", s->id);
+
+    int len = snprintf (buf, size, "%s %s RTSP/1.0\r\nCSeq: %u\r\n"
+                        "User-Agent: rtsp-load\r\n%s%s\r\n",
+                        method, url, ++s->cseq, headers, session);
+    if (send (s->fd, buf, len, 0) != len)
+        return -1;
+
+    size_t got = 0;
+    for (;;)
+    {
+        ssize_t val = recv (s->fd, buf + got, size - got - 1, 0);
+        if (val <= 0)
+            return -1;
+        got += val;
+        buf[got] = '\0';
+
+        char *end = strstr (buf, "\r\n\r\n");
+        if (end == NULL)
+            continue;
+
+        const char *cl = strstr (buf, "Content-Length:");
+        size_t body = (cl != NULL && cl < end) ? strtoul (cl + 15, NULL, 10)
+                                               : 0;
+        if (got >= (size_t)(end + 4 - buf) + body)
+            break;
+    }
+    return strncmp (buf, "RTSP/1.0 200", 12) ? -1 : 0;
+}
+
+static int session_start (session_t *s, const char *path)
+{
+    char buf[8192], url[256], hdr[128];
+    struct sockaddr_in addr = { .sin_family = AF_INET };
+
+    memset (s, 0, sizeof (*s));
+    s->fd = socket (AF_INET, SOCK_STREAM, 0);
+    addr.sin_port = htons (port);
+    inet_pton (AF_INET, host, &addr.sin_addr);
+    if (connect (s->fd, (struct sockaddr *)&addr, sizeof (addr)))
+        return -1;
+
+    snprintf (url, sizeof (url), "rtsp://%s:%u%s", host, port, path);
+    if (request (s, "DESCRIBE", url, "Accept: application/sdp\r\n",
+                 buf, sizeof (buf)))
+        return -1;
+
+    /* Track control URLs */
+    char controls[MAX_TRACKS][256];
+    const char *media = strstr (buf, "\r\n\r\n");
+    while (media != NULL && s->tracks < MAX_TRACKS
+        && (media = strstr (media, "\nm=")) != NULL)
+    {
+        const char *ctl = strstr (media, "a=control:");
+        const char *next = strstr (media + 1, "\nm=");
+        if (ctl == NULL || (next != NULL && ctl > next))
+            return -1;
+        sscanf (ctl + 10, "%255[^\r\n]", controls[s->tracks++]);
+        media = next;
+    }
+    if (s->tracks == 0)
+        return -1;
+
+    for (unsigned i = 0; i < s->tracks; i++)
+    {
+        socklen_t len = sizeof (addr);
+
+        s->rtp[i] = socket (AF_INET, SOCK_DGRAM, 0);
+        addr.sin_port = 0;
+        if (bind (s->rtp[i], (struct sockaddr *)&addr, sizeof (addr))
+         || getsockname (s->rtp[i], (struct sockaddr *)&addr, &len))
+            return -1;
+
+        unsigned lport = ntohs (addr.sin_port);
+        snprintf (hdr, sizeof (hdr),
+                  "Transport: RTP/AVP;unicast;client_port=%u-%u\r\n",
+                  lport, lport + 1);
+        if (request (s, "SETUP", controls[i], hdr, buf, sizeof (buf)))
+            return -1;
+
+        if (!s->id[0])
+        {
+            const char *ses = strstr (buf, "Session: ");
+            if (ses == NULL)
+                return -1;
+            sscanf (ses + 9, "%63[^;\r\n]", s->id);
+        }
+    }
+
+    s->play = now ();
+    return request (s, "PLAY", url, "Range: npt=0.000-\r\n",
+                    buf, sizeof (buf));
+}
+
+static void session_stop (session_t *s, const char *path)
+{
+    char buf[1024], url[256];
+
+    snprintf (url, sizeof (url), "rtsp://%s:%u%s", host, port, path);
+    if (s->id[0])
+        request (s, "TEARDOWN", url, "", buf, sizeof (buf));
+    for (unsigned i = 0; i < s->tracks; i++)
+        close (s->rtp[i]);
+    close (s->fd);
+}
+
+/* CPU time consumed by a process, in seconds */
+static double cpu_time (long pid)
+{
+    char path[64];
+    unsigned long utime, stime;
+
+    snprintf (path, sizeof (path), "/proc/%ld/stat", pid);
+    FILE *stream = fopen (path, "r");
+    if (stream == NULL)
+        return -1.;
+
+    int val = fscanf (stream, "%*d %*s %*c %*d %*d %*d %*d %*d %*u %*u "
+                      "%*u %*u %*u %lu %lu", &utime, &stime);
+    fclose (stream);
+    if (val != 2)
+        return -1.;
+    return (double)(utime + stime) / sysconf (_SC_CLK_TCK);
+}
+
+static int cmp_double (const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        fprintf (stderr, "Usage: %s <path> <sessions> [seconds] [server PID]"
+                 " [host] [port]\n", argv[0]);
+        return 1;
+    }
+
+    const char *path = argv[1];
+    unsigned n = strtoul (argv[2], NULL, 10);
+    double duration = (argc > 3) ? strtod (argv[3], NULL) : 10.;
+    long pid = (argc > 4) ? strtol (argv[4], NULL, 10) : 0;
+    if (argc > 5)
+        host = argv[5];
+    if (argc > 6)
+        port = strtoul (argv[6], NULL, 10);
+
+    session_t *sessions = calloc (n, sizeof (*sessions));
+    struct pollfd *ufd = calloc (n * MAX_TRACKS, sizeof (*ufd));
+    unsigned *owner = calloc (n * MAX_TRACKS, sizeof (*owner));
+    if (sessions == NULL || ufd == NULL || owner == NULL)
+        return 1;
+
+    double cpu_start = pid ? cpu_time (pid) : -1.;
+    double start = now ();
+    unsigned started = 0, nfd = 0;
+
+    for (unsigned i = 0; i < n; i++)
+    {
+        if (session_start (sessions + i, path))
+        {
+            fprintf (stderr, "session %u failed to start\n", i);
+            continue;
+        }
+        started++;
+        for (unsigned j = 0; j < sessions[i].tracks; j++)
+        {
+            ufd[nfd].fd = sessions[i].rtp[j];
+            ufd[nfd].events = POLLIN;
+            owner[nfd++] = i;
+        }
+    }
+
+    double end = start + duration;
+    for (double t = now (); t < end; t = now ())
+    {
+        if (poll (ufd, nfd, (end - t) * 1000 + 1) <= 0)
+            continue;
+
+        t = now ();
+        for (unsigned i = 0; i < nfd; i++)
+        {
+            if (!(ufd[i].revents & POLLIN))
+                continue;
+
+            char pkt[2048];
+            session_t *s = sessions + owner[i];
+            while (recv (ufd[i].fd, pkt, sizeof (pkt), MSG_DONTWAIT) > 0)
+            {
+                if (s->packets++ == 0)
+                    s->first = t;
+            }
+        }
+    }
+
+    double wall = now () - start;
+    double cpu = (cpu_start >= 0.) ? cpu_time (pid) - cpu_start : -1.;
+
+    double *latency = calloc (n, sizeof (*latency));
+    unsigned playing = 0;
+    unsigned long packets = 0;
+    for (unsigned i = 0; i < n; i++)
+    {
+        packets += sessions[i].packets;
+        if (sessions[i].packets > 0)
+            latency[playing++] = sessions[i].first - sessions[i].play;
+        session_stop (sessions + i, path);
+    }
+    qsort (latency, playing, sizeof (*latency), cmp_double);
+
+    printf ("sessions: %u requested, %u started, %u playing\n",
+            n, started, playing);
+    printf ("packets: %lu (%.1f/s)\n", packets, packets / wall);
+    if (playing > 0)
+        printf ("start-up latency: min %.1f ms, median %.1f ms, "
+                "max %.1f ms\n", latency[0] * 1000.,
+                latency[playing / 2] * 1000.,
+                latency[playing - 1] * 1000.);
+    if (cpu >= 0.)
+        printf ("server CPU: %.2f s in %.2f s, %.1f sessions/core\n",
+                cpu, wall, (cpu > 0.) ? playing * wall / cpu : 0.);
+
+    free (latency);
+    free (owner);
+    free (ufd);
+    free (sessions);
+    return playing == n ? 0 : 1;
+}
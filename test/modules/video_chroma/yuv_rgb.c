@@ -0,0 +1,272 @@
+/*****************************************************************************
+ * yuv_rgb.c: conformance and speed of the YUV to RGB line conversions
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Checks the C line conversion against a floating point model of each
+ * colour matrix and range, and the vector versions usable on this CPU
+ * against the C one, for every chroma layout and pixel size. The
+ * conversions are static, so the module source is included. Given a number
+ * of 1920 pixels lines as argument, also reports their speed on that many.
+ */
+
+#define MODULE_STRING "test"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../../modules/video_chroma/yuv_rgb.c"
+#include "../bench.h"
+
+#define WIDTH   BENCH_WIDTH
+#define MARGIN  64
+
+static uint8_t luma[WIDTH], cb[WIDTH / 2], cr[WIDTH / 2], cbcr[WIDTH];
+static uint8_t ref[4 * WIDTH + MARGIN], out[4 * WIDTH + MARGIN];
+
+/* Random samples, including the values outside of the limited range */
+static void fill(void)
+{
+    for (int i = 0; i < WIDTH; i++)
+        luma[i] = rand();
+    for (int i = 0; i < WIDTH / 2; i++) {
+        cb[i] = cbcr[2 * i] = rand();
+        cr[i] = cbcr[2 * i + 1] = rand();
+    }
+}
+
+typedef struct
+{
+    const char *name;
+    unsigned    pixel_size;
+    uint32_t    rmask, gmask, bmask;
+} rgb_format_t;
+
+static const rgb_format_t formats[] = {
+    { "RV16", 2, 0xf800, 0x07e0, 0x001f },
+    { "RV15", 2, 0x7c00, 0x03e0, 0x001f },
+    { "RV24", 3, 0xff0000, 0x00ff00, 0x0000ff },
+    { "RV32", 4, 0x00ff0000, 0x0000ff00, 0x000000ff },
+    { "RV32", 4, 0x0000ff00, 0x00ff0000, 0xff000000 },
+};
+
+static void setup(yuv_rgb_t *conv, const rgb_format_t *f, bool bt709,
+                  bool full_range)
+{
+    video_format_t fmt;
+
+    memset(&fmt, 0, sizeof (fmt));
+    fmt.i_chroma = f->pixel_size == 2 ? VLC_CODEC_RGB16
+                 : f->pixel_size == 3 ? VLC_CODEC_RGB24 : VLC_CODEC_RGB32;
+    fmt.i_rmask = f->rmask;
+    fmt.i_gmask = f->gmask;
+    fmt.i_bmask = f->bmask;
+    if (SetPacking(conv, &fmt, f->pixel_size))
+        abort();
+    SetMatrix(conv, bt709, full_range);
+}
+
+static uint32_t get_pixel(const uint8_t *p, unsigned pixel_size)
+{
+    switch (pixel_size) {
+        case 2:  return *(const uint16_t *)p;
+        case 3:  return p[0] | (p[1] << 8) | (p[2] << 16);
+        default: return *(const uint32_t *)p;
+    }
+}
+
+static int component(uint32_t pixel, uint32_t mask)
+{
+    int shift = 0;
+
+    while (!((mask >> shift) & 1))
+        shift++;
+    return (pixel & mask) >> shift;
+}
+
+/* Floating point conversion of one pixel, with the same quantization of
+ * the components as the module */
+static void model(int rgb[3], int y, int u, int v, bool bt709,
+                  bool full_range, const rgb_format_t *f)
+{
+    const double kr = bt709 ? .2126 : .299, kb = bt709 ? .0722 : .114;
+    const double kg = 1. - kr - kb;
+    const double yf = full_range ? y : (y - 16) * 255. / 219.;
+    const double uf = full_range ? u - 128 : (u - 128) * 255. / 224.;
+    const double vf = full_range ? v - 128 : (v - 128) * 255. / 224.;
+    const double c[3] = {
+        yf + 2. * (1. - kr) * vf,
+        yf - 2. * (1. - kb) * kb / kg * uf - 2. * (1. - kr) * kr / kg * vf,
+        yf + 2. * (1. - kb) * uf,
+    };
+    const uint32_t masks[3] = { f->rmask, f->gmask, f->bmask };
+
+    for (int i = 0; i < 3; i++) {
+        int bits = 0;
+        for (uint32_t m = masks[i]; m; m &= m - 1)
+            bits++;
+
+        int c8 = c[i] < 0. ? 0 : c[i] > 255. ? 255 : (int)(c[i] + .5);
+        rgb[i] = c8 >> (8 - bits);
+    }
+}
+
+/* Compares the C conversion of a whole line to the model */
+static unsigned check_model(const yuv_rgb_t *conv, const rgb_format_t *f,
+                            bool bt709, bool full_range)
+{
+    unsigned mismatches = 0;
+
+    LineC(out, luma, cb, cr, WIDTH, conv, false, f->pixel_size);
+    for (int x = 0; x < WIDTH; x++) {
+        const uint32_t pixel = get_pixel(&out[x * f->pixel_size],
+                                         f->pixel_size);
+        const uint32_t masks[3] = { f->rmask, f->gmask, f->bmask };
+        int rgb[3];
+
+        model(rgb, luma[x], cb[x / 2], cr[x / 2], bt709, full_range, f);
+        for (int i = 0; i < 3; i++)
+            if (abs(component(pixel, masks[i]) - rgb[i]) > 1)
+                mismatches++;
+    }
+    return mismatches;
+}
+
+typedef struct
+{
+    const char           *name;
+    const yuv_rgb_line_t (*lines)[3];
+} kernel_t;
+
+#define LINE(name, interleaved, size) \
+static void name(uint8_t *p_dst, const uint8_t *p_y, const uint8_t *p_u, \
+                 const uint8_t *p_v, unsigned i_width, const yuv_rgb_t *p) \
+{ \
+    LineC(p_dst, p_y, p_u, p_v, i_width, p, interleaved, size); \
+}
+LINE(Planar16C, false, 2)
+LINE(Planar24C, false, 3)
+LINE(Planar32C, false, 4)
+LINE(SemiPlanar16C, true, 2)
+LINE(SemiPlanar24C, true, 3)
+LINE(SemiPlanar32C, true, 4)
+#undef LINE
+
+static const yuv_rgb_line_t linesC[2][3] = {
+    { Planar16C, Planar24C, Planar32C },
+    { SemiPlanar16C, SemiPlanar24C, SemiPlanar32C },
+};
+
+static void run(yuv_rgb_line_t line, uint8_t *dst, bool interleaved,
+                unsigned width, const yuv_rgb_t *conv)
+{
+    if (interleaved)
+        line(dst, luma, cbcr, cbcr, width, conv);
+    else
+        line(dst, luma, cb, cr, width, conv);
+}
+
+int main(int argc, char *argv[])
+{
+    static const unsigned widths[] = { 1, 2, 7, 8, 15, 16, 17, 31, 33, 64,
+                                       719, 1917, WIDTH };
+    const unsigned lines = bench_count(argc, argv);
+    kernel_t kernels[3];
+    size_t n = 0;
+    int ret = 0;
+
+    kernels[n++] = (kernel_t){ "C", linesC };
+#ifdef CAN_COMPILE_SSSE3_INTRINSICS
+    if (vlc_CPU_SSSE3())
+        kernels[n++] = (kernel_t){ "SSSE3", linesSSSE3 };
+#endif
+#ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+        kernels[n++] = (kernel_t){ "AVX2", linesAVX2 };
+#endif
+
+    srand(0);
+    fill();
+
+    /* Conformance of the C version */
+    for (size_t fi = 0; fi < sizeof (formats) / sizeof (formats[0]); fi++)
+        for (int matrix = 0; matrix < 4; matrix++) {
+            const rgb_format_t *f = &formats[fi];
+            const bool bt709 = matrix & 1, full_range = matrix & 2;
+            yuv_rgb_t conv;
+
+            setup(&conv, f, bt709, full_range);
+            unsigned mismatches = check_model(&conv, f, bt709, full_range);
+            printf("%s %08x BT.%d %-7s %s\n", f->name, f->rmask,
+                   bt709 ? 709 : 601, full_range ? "full" : "limited",
+                   mismatches ? "MISMATCH" : "ok");
+            if (mismatches)
+                ret = 1;
+        }
+
+    for (size_t fi = 0; fi < sizeof (formats) / sizeof (formats[0]); fi++)
+        for (int interleaved = 0; interleaved < 2; interleaved++) {
+            const rgb_format_t *f = &formats[fi];
+            const unsigned size = f->pixel_size;
+            double reference = 0.;
+            yuv_rgb_t conv;
+
+            setup(&conv, f, true, false);
+            for (size_t k = 0; k < n; k++) {
+                const yuv_rgb_line_t line =
+                    kernels[k].lines[interleaved][size - 2];
+                unsigned mismatches = 0;
+
+                /* Bit-exactness against the C version, without writing
+                 * past the line */
+                for (size_t wi = 0; wi < sizeof (widths) / sizeof (widths[0]);
+                     wi++) {
+                    const unsigned w = widths[wi];
+
+                    memset(ref, 0x55, sizeof (ref));
+                    memset(out, 0x55, sizeof (out));
+                    run(linesC[interleaved][size - 2], ref, interleaved, w,
+                        &conv);
+                    run(line, out, interleaved, w, &conv);
+                    if (memcmp(ref, out, sizeof (ref)))
+                        mismatches++;
+                }
+
+                printf("%-4s %08x %-5s %-6s %s", f->name, f->rmask,
+                       interleaved ? "NV12" : "I420", kernels[k].name,
+                       mismatches ? "MISMATCH" : "exact   ");
+                if (lines > 0) {
+                    double start = bench_now();
+                    for (unsigned l = 0; l < lines; l++)
+                        run(line, out, interleaved, WIDTH, &conv);
+                    double mpixels = lines * (double)WIDTH
+                                   / (bench_now() - start) / 1e6;
+
+                    if (k == 0)
+                        reference = mpixels;
+                    printf(" %8.1f Mpixels/s (x%.2f)", mpixels,
+                           mpixels / reference);
+                }
+                printf("\n");
+                if (mismatches)
+                    ret = 1;
+            }
+        }
+    return ret;
+}
@@ -0,0 +1,267 @@
+/*****************************************************************************
+ * deinterlace.c: exactness and speed of the deinterlacer pixel primitives
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Checks every version of the line merge, block motion, comb score and
+ * phosphor dimmer primitives usable on this CPU against the C one. The
+ * primitives are static, so the module sources are included. Given a number
+ * of 1920 pixels lines as argument, also reports their speed on that many.
+ */
+
+#define MODULE_STRING "test"
+
+#include <stdio.h>
+
+#include "../../../modules/video_filter/deinterlace/merge.c"
+#include "../../../modules/video_filter/deinterlace/helpers.c"
+#include "../../../modules/video_filter/deinterlace/algo_phosphor.c"
+#include "../bench.h"
+
+#define WIDTH   BENCH_WIDTH
+#define PITCH   (WIDTH + 64)
+#define ROWS    8
+
+static uint8_t src[3][ROWS * PITCH];
+static uint8_t ref[2 * PITCH], out[2 * PITCH];
+static unsigned lines;
+
+static void fill(void)
+{
+    for (int f = 0; f < 3; f++)
+        bench_fill(src[f], ROWS * PITCH, 1, 255, f);
+}
+
+static double reference;
+
+/* Prints one result, the first version of each primitive being the C one.
+ * The speed loops do nothing unless lines were given. */
+static int report(const char *primitive, const char *name, bool first,
+                  unsigned mismatches, bool exact, double start)
+{
+    printf("%-7s %-6s %s", primitive, name,
+           mismatches ? (exact ? "MISMATCH" : "approx  ") : "exact   ");
+    if (lines > 0) {
+        double mpixels = lines * (double)WIDTH / (bench_now() - start) / 1e6;
+
+        if (first)
+            reference = mpixels;
+        printf(" %8.1f Mpixels/s (x%.2f)", mpixels, mpixels / reference);
+    }
+    printf("\n");
+    return mismatches && exact;
+}
+
+/*** Merge ***/
+typedef void (*merge_t)(void *, const void *, const void *, size_t);
+
+/* The SIMD merges round up, like the pavg instructions */
+static int test_merge(const char *name, merge_t merge, merge_t ref_merge,
+                      int size, bool first)
+{
+    static const int widths[] = { 1, 7, 16, 31, 33, 64, 720, 1917 };
+    unsigned mismatches = 0;
+
+    for (size_t i = 0; i < sizeof (widths) / sizeof (widths[0]); i++)
+        for (int off = 0; off < 4; off++) {
+            size_t bytes = widths[i] * size;
+
+            ref_merge(ref, src[0] + off * size, src[1] + PITCH, bytes);
+            merge(out, src[0] + off * size, src[1] + PITCH, bytes);
+            for (size_t x = 0; x < bytes; x += size) {
+                int a = size == 2 ? *(uint16_t *)&ref[x] : ref[x];
+                int b = size == 2 ? *(uint16_t *)&out[x] : out[x];
+                if (abs(a - b) > 1)
+                    mismatches++;
+            }
+        }
+
+    double start = bench_now();
+    for (unsigned l = 0; l < lines; l++)
+        merge(out, src[0] + (l & 3) * PITCH, src[1], WIDTH * size);
+    return report(size == 1 ? "merge" : "merge16", name, first, mismatches,
+                  true, start);
+}
+
+/*** Motion ***/
+typedef int (*motion_t)(uint8_t *, uint8_t *, int, int, int *, int *);
+
+static int test_motion(const char *name, motion_t motion, bool exact,
+                       bool first)
+{
+    unsigned mismatches = 0;
+
+    for (int bx = 0; bx < WIDTH / 8; bx++) {
+        int rt, rb, ot, ob;
+        int r = TestForMotionInBlock(src[0] + bx * 8, src[1] + bx * 8,
+                                     PITCH, PITCH, &rt, &rb);
+        int o = motion(src[0] + bx * 8, src[1] + bx * 8, PITCH, PITCH,
+                       &ot, &ob);
+        if (r != o || rt != ot || rb != ob)
+            mismatches++;
+    }
+
+    double start = bench_now();
+    int sum = 0;
+    for (unsigned l = 0; l < lines / 8; l++)
+        for (int bx = 0; bx < WIDTH / 8; bx++) {
+            int t, b;
+            sum += motion(src[l & 1] + bx * 8, src[2] + bx * 8, PITCH, PITCH,
+                          &t, &b);
+        }
+    if (sum < 0)
+        abort();
+    return report("motion", name, first, mismatches, exact, start);
+}
+
+/*** Comb score ***/
+typedef int (*comb_t)(const uint8_t *, const uint8_t *, const uint8_t *, int);
+
+static int test_comb(const char *name, comb_t comb, bool first)
+{
+    static const int widths[] = { 1, 7, 16, 31, 33, 720, 1917 };
+    unsigned mismatches = 0;
+
+    for (size_t i = 0; i < sizeof (widths) / sizeof (widths[0]); i++)
+        for (int y = 1; y < ROWS - 1; y++) {
+            const uint8_t *c = src[0] + y * PITCH;
+            const uint8_t *p = src[1] + (y - 1) * PITCH;
+            const uint8_t *n = src[1] + (y + 1) * PITCH;
+
+            if (comb(c, p, n, widths[i]) != CombLine(c, p, n, widths[i]))
+                mismatches++;
+        }
+
+    double start = bench_now();
+    int sum = 0;
+    for (unsigned l = 0; l < lines; l++)
+        sum += comb(src[l & 1] + PITCH, src[2], src[2] + 2 * PITCH, WIDTH);
+    if (sum < 0)
+        abort();
+    return report("comb", name, first, mismatches, true, start);
+}
+
+/*** Phosphor dimmer ***/
+static int test_darken(const char *name, darken_line_t luma,
+                       darken_line_t chroma, bool first)
+{
+    static const int widths[] = { 1, 7, 16, 31, 33, 64, 720, 1917 };
+    unsigned mismatches = 0;
+
+    for (size_t i = 0; i < sizeof (widths) / sizeof (widths[0]); i++)
+        for (int strength = 1; strength <= 3; strength++) {
+            const int w = widths[i];
+
+            memcpy(ref, src[0], w);
+            memcpy(out, src[0], w);
+            DarkenLumaLine(ref, w, strength);
+            luma(out, w, strength);
+            if (memcmp(ref, out, w))
+                mismatches++;
+
+            memcpy(ref, src[1], w);
+            memcpy(out, src[1], w);
+            DarkenChromaLine(ref, w, strength);
+            chroma(out, w, strength);
+            if (memcmp(ref, out, w))
+                mismatches++;
+        }
+
+    double start = bench_now();
+    for (unsigned l = 0; l < lines; l++) {
+        memcpy(out, src[l & 1], WIDTH);
+        if (l & 2)
+            chroma(out, WIDTH, 1);
+        else
+            luma(out, WIDTH, 1);
+    }
+    return report("darken", name, first, mismatches, true, start);
+}
+
+int main(int argc, char *argv[])
+{
+    int ret = 0;
+
+    lines = bench_count(argc, argv);
+    srand(0);
+    fill();
+
+    ret |= test_merge("C", Merge8BitGeneric, Merge8BitGeneric, 1, true);
+#if defined(CAN_COMPILE_SSE)
+    if (vlc_CPU_SSE2())
+        ret |= test_merge("SSE2", Merge8BitSSE2, Merge8BitGeneric, 1, false);
+#endif
+#if defined(CAN_COMPILE_AVX2)
+    if (vlc_CPU_AVX2())
+        ret |= test_merge("AVX2", Merge8BitAVX2, Merge8BitGeneric, 1, false);
+#endif
+    ret |= test_merge("C", Merge16BitGeneric, Merge16BitGeneric, 2, true);
+#if defined(CAN_COMPILE_SSE)
+    if (vlc_CPU_SSE2())
+        ret |= test_merge("SSE2", Merge16BitSSE2, Merge16BitGeneric, 2, false);
+#endif
+#if defined(CAN_COMPILE_AVX2)
+    if (vlc_CPU_AVX2())
+        ret |= test_merge("AVX2", Merge16BitAVX2, Merge16BitGeneric, 2, false);
+#endif
+
+    ret |= test_motion("C", TestForMotionInBlock, true, true);
+#if defined(CAN_COMPILE_MMXEXT)
+    /* The MMX version misses differences above 127 */
+    if (vlc_CPU_MMXEXT())
+        ret |= test_motion("MMX", TestForMotionInBlockMMX, false, false);
+#endif
+#if defined(__SSE2__)
+    ret |= test_motion("SSE2", TestForMotionInBlockSSE2, true, false);
+#endif
+#if defined(CAN_COMPILE_NEON)
+    if (vlc_CPU_ARM_NEON())
+        ret |= test_motion("NEON", TestForMotionInBlockNEON, true, false);
+#endif
+
+    ret |= test_comb("C", CombLine, true);
+#if defined(__SSE2__)
+    ret |= test_comb("SSE2", CombLineSSE2, false);
+#endif
+#if defined(CAN_COMPILE_AVX2)
+    if (vlc_CPU_AVX2())
+        ret |= test_comb("AVX2", CombLineAVX2, false);
+#endif
+#if defined(CAN_COMPILE_NEON)
+    if (vlc_CPU_ARM_NEON())
+        ret |= test_comb("NEON", CombLineNEON, false);
+#endif
+
+    ret |= test_darken("C", DarkenLumaLine, DarkenChromaLine, true);
+#if defined(__SSE2__)
+    ret |= test_darken("SSE2", DarkenLumaLineSSE2, DarkenChromaLineSSE2,
+                       false);
+#endif
+#if defined(CAN_COMPILE_AVX2)
+    if (vlc_CPU_AVX2())
+        ret |= test_darken("AVX2", DarkenLumaLineAVX2, DarkenChromaLineAVX2,
+                           false);
+#endif
+#if defined(CAN_COMPILE_NEON)
+    if (vlc_CPU_ARM_NEON())
+        ret |= test_darken("NEON", DarkenLumaLineNEON, DarkenChromaLineNEON,
+                           false);
+#endif
+    return ret;
+}
@@ -0,0 +1,92 @@
+/*****************************************************************************
+ * scale.c: symmetry of the scaler filter coefficients
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Checks that the bilinear and bicubic filters weigh the input samples of
+ * mirrored output samples as mirror images, so that both edges of a
+ * symmetric picture are scaled alike, and that the weights of each output
+ * sample sum to one. The filter setup is static, so the module source is
+ * included.
+ */
+
+#define MODULE_STRING "test"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../../modules/video_filter/scale.c"
+
+/* Spreads the coefficients of output sample i over the input samples */
+static void weights(const scale_filter_t *f, unsigned i, int *w)
+{
+    for (unsigned s = 0; s < f->i_src; s++)
+        w[s] = 0;
+    for (unsigned t = 0; t < f->i_taps; t++)
+        w[f->pi_pos[i] + t] += f->pi_coefs[i * f->i_taps + t];
+}
+
+static unsigned check(int mode, unsigned src, unsigned dst)
+{
+    scale_filter_t f;
+    int left[src], right[src];
+    unsigned mismatches = 0;
+
+    if (FilterInit(&f, mode, src, dst))
+        abort();
+    for (unsigned i = 0; i < dst; i++) {
+        int sum = 0;
+
+        weights(&f, i, left);
+        weights(&f, dst - 1 - i, right);
+        for (unsigned s = 0; s < src; s++) {
+            /* The rounding error may go to either central coefficient */
+            if (abs(left[s] - right[src - 1 - s]) > 1)
+                mismatches++;
+            sum += left[s];
+        }
+        if (sum != 1 << COEF_BITS)
+            mismatches++;
+    }
+    FilterClean(&f);
+    return mismatches;
+}
+
+int main(void)
+{
+    static const unsigned sizes[][2] = {
+        { 720, 1280 }, { 1280, 720 }, { 1920, 1080 }, { 352, 1920 },
+        { 17, 5 }, { 5, 17 }, { 3, 2 }, { 2, 7 }, { 1, 4 },
+    };
+    static const int modes[] = { SCALE_BILINEAR, SCALE_BICUBIC };
+    int ret = 0;
+
+    for (size_t m = 0; m < sizeof (modes) / sizeof (modes[0]); m++)
+        for (size_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+            const unsigned src = sizes[i][0], dst = sizes[i][1];
+            unsigned mismatches = check(modes[m], src, dst);
+
+            printf("%-8s %4u -> %4u %s\n",
+                   modes[m] == SCALE_BICUBIC ? "bicubic" : "bilinear",
+                   src, dst, mismatches ? "ASYMMETRIC" : "ok");
+            if (mismatches)
+                ret = 1;
+        }
+    return ret;
+}
@@ -0,0 +1,248 @@
+/*****************************************************************************
+ * yadif.c: bit-exactness and speed of the Yadif line filters
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Checks that every line filter of the deinterlacer Yadif mode usable on
+ * this CPU gives the same output as the C reference. The C filter of
+ * interleaved U/V lines is first checked against the plain one run on each
+ * component. Given a number of 1920 pixels lines as argument, also reports
+ * the speed of each filter on that many.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include "../../../modules/video_filter/deinterlace/common.h"
+#include "../../../modules/video_filter/deinterlace/yadif.h"
+#include "../bench.h"
+
+typedef void (*filter_line_t)(uint8_t *, uint8_t *, uint8_t *, uint8_t *,
+                              int, int, int, int, int);
+
+typedef struct
+{
+    const char   *name;
+    filter_line_t filter;
+    int           pixel_size;
+    bool          interleaved;
+} kernel_t;
+
+#define KERNEL(name, f, size) \
+    kernels[n++] = (kernel_t){ name, (filter_line_t)f, size, false }
+#define KERNEL_UV(name, f, size) \
+    kernels[n++] = (kernel_t){ name, (filter_line_t)f, size, true }
+
+/* Lists the line filters usable on this CPU, C versions first */
+static size_t get_kernels(kernel_t *kernels)
+{
+    size_t n = 0;
+
+    KERNEL("C", yadif_filter_line_c, 1);
+#if defined(HAVE_YADIF_MMX)
+    if (vlc_CPU_MMX())
+        KERNEL("MMX", yadif_filter_line_mmx, 1);
+#endif
+#if defined(HAVE_YADIF_SSE2)
+    if (vlc_CPU_SSE2())
+        KERNEL("SSE2", yadif_filter_line_sse2, 1);
+#endif
+#if defined(HAVE_YADIF_SSSE3)
+    if (vlc_CPU_SSSE3())
+        KERNEL("SSSE3", yadif_filter_line_ssse3, 1);
+#endif
+#if defined(HAVE_YADIF_AVX2)
+    if (vlc_CPU_AVX2())
+        KERNEL("AVX2", yadif_filter_line_avx2, 1);
+#endif
+#if defined(HAVE_YADIF_NEON)
+    if (vlc_CPU_ARM_NEON())
+        KERNEL("NEON", yadif_filter_line_neon, 1);
+#endif
+    KERNEL("C 16", yadif_filter_line_c_16bit, 2);
+#if defined(HAVE_YADIF_AVX2)
+    if (vlc_CPU_AVX2())
+        KERNEL("AVX2 16", yadif_filter_line_avx2_16bit, 2);
+#endif
+#if defined(HAVE_YADIF_NEON)
+    if (vlc_CPU_ARM_NEON())
+        KERNEL("NEON 16", yadif_filter_line_neon_16bit, 2);
+#endif
+    KERNEL_UV("C UV", yadif_filter_line_c_interleaved, 1);
+#if defined(HAVE_YADIF_AVX2)
+    if (vlc_CPU_AVX2())
+        KERNEL_UV("AVX2 UV", yadif_filter_line_interleaved_avx2, 1);
+#endif
+#if defined(HAVE_YADIF_NEON)
+    if (vlc_CPU_ARM_NEON())
+        KERNEL_UV("NEON UV", yadif_filter_line_interleaved_neon, 1);
+#endif
+    KERNEL_UV("C UV16", yadif_filter_line_c_16bit_interleaved, 2);
+#if defined(HAVE_YADIF_AVX2)
+    if (vlc_CPU_AVX2())
+        KERNEL_UV("AVX2 UV16", yadif_filter_line_interleaved_avx2_16bit, 2);
+#endif
+#if defined(HAVE_YADIF_NEON)
+    if (vlc_CPU_ARM_NEON())
+        KERNEL_UV("NEON UV16", yadif_filter_line_interleaved_neon_16bit, 2);
+#endif
+    return n;
+}
+
+#define ROWS    8                   /* rows around the filtered one */
+#define MARGIN  64                  /* pixels, the asm versions overrun */
+#define PITCH   ((BENCH_WIDTH + 2 * MARGIN) * 2)
+
+static uint8_t frames[3][ROWS * PITCH];
+static uint8_t ref[PITCH], out[PITCH];
+static uint8_t planes[3][ROWS * PITCH], plane_out[PITCH];
+
+/* Fills the previous, current and next pictures, with max as largest value */
+static void fill(int pixel_size, unsigned max)
+{
+    for (int f = 0; f < 3; f++)
+        bench_fill(frames[f], ROWS * PITCH / pixel_size, pixel_size, max, f);
+}
+
+static void run(const kernel_t *k, uint8_t *dst, int w, int row,
+                int parity, int mode)
+{
+    const int offset = row * PITCH + MARGIN * k->pixel_size;
+
+    k->filter(dst + MARGIN * k->pixel_size, frames[0] + offset,
+              frames[1] + offset, frames[2] + offset, w, PITCH, -PITCH,
+              parity, mode);
+#if defined(HAVE_YADIF_MMX)
+    /* The MMX version leaves the FPU state to its caller */
+    if (k->filter == (filter_line_t)yadif_filter_line_mmx)
+        __asm__ volatile ("emms");
+#endif
+}
+
+/* Filters the interleaved line with the C version, then each component on
+ * its own with the plain one, and compares. w counts samples of both. */
+static unsigned check_interleaved(int pixel_size, int w, int row, int parity,
+                                  int mode)
+{
+    const kernel_t plain = {
+        "", pixel_size == 2 ? (filter_line_t)yadif_filter_line_c_16bit
+                            : (filter_line_t)yadif_filter_line_c,
+        pixel_size, false };
+    const kernel_t uv = {
+        "", pixel_size == 2 ? (filter_line_t)yadif_filter_line_c_16bit_interleaved
+                            : (filter_line_t)yadif_filter_line_c_interleaved,
+        pixel_size, true };
+    const int samples = PITCH / pixel_size;
+    unsigned mismatches = 0;
+
+    run(&uv, ref, w, row, parity, mode);
+    for (int comp = 0; comp < 2; comp++) {
+        /* The component alone, with the same margin on the left */
+        for (int f = 0; f < 3; f++)
+            for (int y = 0; y < ROWS; y++)
+                for (int k = -MARGIN / 2; MARGIN + 2 * k + comp < samples; k++)
+                    memcpy(&planes[f][(y * samples + MARGIN + k) * pixel_size],
+                           &frames[f][(y * samples + MARGIN + 2 * k + comp)
+                                      * pixel_size], pixel_size);
+
+        const int offset = row * PITCH + MARGIN * pixel_size;
+        plain.filter(plane_out + MARGIN * pixel_size, planes[0] + offset,
+                     planes[1] + offset, planes[2] + offset, (w + 1 - comp) / 2,
+                     PITCH, -PITCH, parity, mode);
+        for (int x = comp; x < w; x += 2)
+            if (memcmp(&ref[(MARGIN + x) * pixel_size],
+                       &plane_out[(MARGIN + x / 2) * pixel_size], pixel_size))
+                mismatches++;
+    }
+    return mismatches;
+}
+
+int main(int argc, char *argv[])
+{
+    static const int widths[] = { 1, 3, 8, 15, 16, 17, 31, 33, 720, 1917 };
+    static const unsigned depths[] = { 255, 1023, 65535 };
+    const unsigned lines = bench_count(argc, argv);
+    kernel_t kernels[16];
+    const size_t n = get_kernels(kernels);
+    double reference[2][3] = { { 0., 0., 0. }, { 0., 0., 0. } };
+    int ret = 0;
+
+    srand(0);
+    for (size_t i = 0; i < n; i++) {
+        const kernel_t *k = &kernels[i];
+        const kernel_t *c = kernels;
+
+        while (c->pixel_size != k->pixel_size
+            || c->interleaved != k->interleaved)
+            c++;
+
+        /* Bit-exactness against the C version */
+        unsigned mismatches = 0;
+        for (size_t d = 0; d < 3; d++) {
+            if ((k->pixel_size == 1) != (depths[d] == 255))
+                continue;
+            fill(k->pixel_size, depths[d]);
+            for (size_t wi = 0; wi < sizeof (widths) / sizeof (widths[0]); wi++)
+                for (int parity = 0; parity < 2; parity++)
+                    for (int mode = 0; mode <= 2; mode += 2)
+                        for (int row = 3; row < ROWS - 3; row++) {
+                            const int w = widths[wi];
+                            const size_t len = w * k->pixel_size;
+
+                            if (c == k && k->interleaved) {
+                                mismatches += check_interleaved(
+                                    k->pixel_size, w, row, parity, mode);
+                                continue;
+                            }
+                            run(c, ref, w, row, parity, mode);
+                            run(k, out, w, row, parity, mode);
+                            if (memcmp(ref + MARGIN * k->pixel_size,
+                                       out + MARGIN * k->pixel_size, len))
+                                mismatches++;
+                        }
+        }
+
+        printf("%-9s %s", k->name, mismatches ? "MISMATCH" : "exact   ");
+        if (lines > 0) {
+            fill(k->pixel_size, k->pixel_size == 2 ? 1023 : 255);
+            double start = bench_now();
+            for (unsigned l = 0; l < lines; l++)
+                run(k, out, BENCH_WIDTH, 3 + (l & 1), l & 1, 0);
+            double mpixels = lines * (double)BENCH_WIDTH
+                           / (bench_now() - start) / 1e6;
+
+            if (c == k)
+                reference[k->interleaved][k->pixel_size] = mpixels;
+            printf(" %8.1f Mpixels/s (x%.2f)", mpixels,
+                   mpixels / reference[k->interleaved][k->pixel_size]);
+        }
+        printf("\n");
+        if (mismatches)
+            ret = 1;
+    }
+    return ret;
+}
@@ -0,0 +1,207 @@
+/*****************************************************************************
+ * filter_slice.c: benchmark of the slice-parallel video filters
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Runs a video filter over I420 pictures with 1, 2, 4... slice threads and
+ * reports the frame rate for each, and whether the output matches the one
+ * of a single thread. The thread count goes up to the number of CPUs,
+ * unless given. Example:
+ *
+ *   ./test_src_misc_filter_slice hqdn3d 100 1920 1080 8
+ *   ./test_src_misc_filter_slice "deinterlace{mode=yadif}"
+ */
+
+#define MODULE_STRING "test"
+
+#include <string.h>
+#include <time.h>
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_es.h>
+#include <vlc_picture.h>
+#include <vlc_filter.h>
+#include <vlc_configuration.h>
+
+static picture_t *BufferNew( filter_t *p_filter )
+{
+    return picture_NewFromFormat( &p_filter->fmt_out.video );
+}
+
+static void BufferDel( filter_t *p_filter, picture_t *p_pic )
+{
+    VLC_UNUSED( p_filter );
+    picture_Release( p_pic );
+}
+
+static int BufferInit( filter_t *p_filter, void *p_data )
+{
+    VLC_UNUSED( p_data );
+    p_filter->pf_video_buffer_new = BufferNew;
+    p_filter->pf_video_buffer_del = BufferDel;
+    return VLC_SUCCESS;
+}
+
+/* Releases the output of a filter, which may be several pictures */
+static void ReleaseChain( picture_t *p_pic )
+{
+    while( p_pic != NULL )
+    {
+        picture_t *p_next = p_pic->p_next;
+        picture_Release( p_pic );
+        p_pic = p_next;
+    }
+}
+
+static double now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool SamePicture( const picture_t *a, const picture_t *b )
+{
+    for( int i = 0; i < a->i_planes; i++ )
+        for( int y = 0; y < a->p[i].i_visible_lines; y++ )
+            if( memcmp( a->p[i].p_pixels + y * a->p[i].i_pitch,
+                        b->p[i].p_pixels + y * b->p[i].i_pitch,
+                        a->p[i].i_visible_pitch ) )
+                return false;
+    return true;
+}
+
+/* Filters the same source picture, returns the frame rate and the last
+ * output picture */
+static double Bench( const char *psz_filter, unsigned i_threads,
+                     unsigned i_frames, const video_format_t *p_fmt,
+                     picture_t *p_src, picture_t **pp_out )
+{
+    char psz_threads[32];
+    const char *ppsz_args[] = {
+        "--ignore-config", "-q", "--no-media-library", psz_threads,
+    };
+
+    snprintf( psz_threads, sizeof( psz_threads ),
+              "--video-filter-threads=%u", i_threads );
+    libvlc_instance_t *p_vlc = libvlc_new( 4, ppsz_args );
+    assert( p_vlc != NULL );
+
+    filter_chain_t *p_chain = filter_chain_New( p_vlc->p_libvlc_int,
+                                                "video filter2", false,
+                                                BufferInit, NULL, NULL );
+    assert( p_chain != NULL );
+
+    es_format_t fmt;
+    es_format_Init( &fmt, VIDEO_ES, p_fmt->i_chroma );
+    fmt.video = *p_fmt;
+    filter_chain_Reset( p_chain, &fmt, &fmt );
+
+    char *psz_name;
+    config_chain_t *p_cfg;
+    free( config_ChainCreate( &psz_name, &p_cfg, psz_filter ) );
+    if( filter_chain_AppendFilter( p_chain, psz_name, p_cfg,
+                                   &fmt, &fmt ) == NULL )
+    {
+        fprintf( stderr, "cannot load video filter %s\n", psz_filter );
+        exit( 1 );
+    }
+    config_ChainDestroy( p_cfg );
+    free( psz_name );
+
+    /* Warm-up, also starts the slice threads and fills the history of
+     * temporal filters */
+    for( int i = 0; i < 3; i++ )
+    {
+        picture_Hold( p_src );
+        p_src->date = VLC_TS_0 + i * 40000;
+        ReleaseChain( filter_chain_VideoFilter( p_chain, p_src ) );
+    }
+
+    picture_t *p_out = NULL;
+    double start = now();
+    for( unsigned i = 0; i < i_frames; i++ )
+    {
+        ReleaseChain( p_out );
+        picture_Hold( p_src );
+        p_src->date = VLC_TS_0 + ( i + 3 ) * 40000;
+        p_out = filter_chain_VideoFilter( p_chain, p_src );
+        assert( p_out != NULL );
+    }
+    double fps = i_frames / ( now() - start );
+
+    *pp_out = p_out;
+    filter_chain_Delete( p_chain );
+    libvlc_release( p_vlc );
+    return fps;
+}
+
+int main( int argc, char *argv[] )
+{
+    const char *psz_filter = ( argc > 1 ) ? argv[1] : "sharpen";
+    unsigned i_frames = ( argc > 2 ) ? strtoul( argv[2], NULL, 10 ) : 100;
+    unsigned i_width = ( argc > 3 ) ? strtoul( argv[3], NULL, 10 ) : 1920;
+    unsigned i_height = ( argc > 4 ) ? strtoul( argv[4], NULL, 10 ) : 1080;
+    long i_max = ( argc > 5 ) ? strtol( argv[5], NULL, 10 )
+                              : sysconf( _SC_NPROCESSORS_ONLN );
+
+    setenv( "VLC_PLUGIN_PATH", "../modules", 0 );
+
+    video_format_t fmt;
+    memset( &fmt, 0, sizeof( fmt ) );
+    video_format_Setup( &fmt, VLC_CODEC_I420, i_width, i_height, 1, 1 );
+
+    picture_t *p_src = picture_NewFromFormat( &fmt );
+    assert( p_src != NULL );
+    srand( 0 );
+    for( int i = 0; i < p_src->i_planes; i++ )
+        for( int y = 0; y < p_src->p[i].i_lines; y++ )
+            for( int x = 0; x < p_src->p[i].i_pitch; x++ )
+                p_src->p[i].p_pixels[y * p_src->p[i].i_pitch + x] =
+                    ( x + y ) / 4 + rand() % 16;
+
+    picture_t *p_ref = NULL;
+    int i_ret = 0;
+    for( long i_threads = 1; i_threads <= i_max; i_threads *= 2 )
+    {
+        picture_t *p_out;
+        double fps = Bench( psz_filter, i_threads, i_frames, &fmt,
+                            p_src, &p_out );
+        bool b_same = p_ref == NULL || SamePicture( p_ref, p_out );
+
+        printf( "%s %ux%u: %2ld thread(s) %8.1f fps%s\n", psz_filter,
+                i_width, i_height, i_threads, fps,
+                b_same ? "" : " (output differs)" );
+        if( !b_same )
+            i_ret = 1;
+
+        if( p_ref == NULL )
+            p_ref = p_out;
+        else
+            ReleaseChain( p_out );
+    }
+
+    ReleaseChain( p_ref );
+    picture_Release( p_src );
+    return i_ret;
+}
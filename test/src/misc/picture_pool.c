@@ -0,0 +1,225 @@
+/*****************************************************************************
+ * picture_pool.c: picture pool allocation and waiting tests
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+#include <vlc_picture_pool.h>
+
+#define PICTURES 8
+
+static picture_pool_t *pool_new(void)
+{
+    video_format_t fmt;
+
+    video_format_Setup(&fmt, VLC_CODEC_I420, 16, 16, 1, 1);
+    picture_pool_t *pool = picture_pool_NewFromFormat(&fmt, PICTURES);
+    assert(pool != NULL);
+    return pool;
+}
+
+static void test_pool_GetRelease(void)
+{
+    picture_pool_t *pool = pool_new();
+    picture_t *pics[PICTURES];
+
+    for (int i = 0; i < PICTURES; i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+        for (int j = 0; j < i; j++)
+            assert(pics[j] != pics[i]);
+    }
+    assert(picture_pool_Get(pool) == NULL);
+
+    /* The last released picture is the first one reused */
+    picture_Release(pics[3]);
+    picture_t *pic = picture_pool_Get(pool);
+    assert(pic == pics[3]);
+    assert(picture_pool_Get(pool) == NULL);
+
+    /* A picture held twice only returns on its last release */
+    picture_Hold(pic);
+    picture_Release(pic);
+    assert(picture_pool_Get(pool) == NULL);
+
+    /* The oldest picture is forced back */
+    picture_pool_NonEmpty(pool, false);
+    assert(picture_pool_Get(pool) == pics[0]);
+
+    picture_pool_NonEmpty(pool, true);
+    for (int i = 0; i < PICTURES; i++)
+        assert(picture_pool_Get(pool) != NULL);
+    picture_pool_NonEmpty(pool, true);
+    picture_pool_Delete(pool);
+}
+
+static void test_pool_Reserve(void)
+{
+    picture_pool_t *pool = pool_new();
+
+    picture_pool_t *reserved = picture_pool_Reserve(pool, PICTURES - 2);
+    assert(reserved != NULL);
+    assert(picture_pool_Reserve(pool, 3) == NULL);
+
+    picture_t *a = picture_pool_Get(pool), *b = picture_pool_Get(pool);
+    assert(a != NULL && b != NULL && a != b);
+    assert(picture_pool_Get(pool) == NULL);
+    assert(picture_pool_OwnsPic(reserved, a));
+
+    /* The reserved pictures return to the reserved pool */
+    picture_t *pic = picture_pool_Get(reserved);
+    assert(pic != NULL && pic != a && pic != b);
+    picture_Release(pic);
+    assert(picture_pool_Get(pool) == NULL);
+    for (int i = 0; i < PICTURES - 2; i++)
+        assert(picture_pool_Get(reserved) != NULL);
+    assert(picture_pool_Get(reserved) == NULL);
+    picture_pool_NonEmpty(reserved, true);
+
+    /* And to the master pool once it is deleted */
+    picture_pool_Delete(reserved);
+    for (int i = 0; i < PICTURES - 2; i++)
+        assert(picture_pool_Get(pool) != NULL);
+    assert(picture_pool_Get(pool) == NULL);
+
+    picture_pool_NonEmpty(pool, true);
+    picture_pool_Delete(pool);
+}
+
+typedef struct
+{
+    picture_t *pics[PICTURES];
+    int        count;
+    mtime_t    delay;
+} releaser_t;
+
+static void *Releaser(void *data)
+{
+    releaser_t *r = data;
+
+    for (int i = 0; i < r->count; i++) {
+        msleep(r->delay);
+        picture_Release(r->pics[i]);
+    }
+    return NULL;
+}
+
+static void test_pool_ReserveDelete(void)
+{
+    picture_pool_t *pool = pool_new();
+    releaser_t r = { .count = PICTURES, .delay = 0 };
+    vlc_thread_t th;
+
+    /* Pictures released while their reserved pool is deleted return to
+     * the master exactly once */
+    for (int n = 0; n < 1000; n++) {
+        picture_pool_t *reserved = picture_pool_Reserve(pool, PICTURES);
+        assert(reserved != NULL);
+
+        r.count = n % (PICTURES + 1);
+        for (int i = 0; i < r.count; i++)
+            r.pics[i] = picture_pool_Get(reserved);
+        if (vlc_clone(&th, Releaser, &r, VLC_THREAD_PRIORITY_LOW))
+            abort();
+        picture_pool_Delete(reserved);
+        vlc_join(th, NULL);
+
+        for (int i = 0; i < PICTURES; i++) {
+            r.pics[i] = picture_pool_Get(pool);
+            assert(r.pics[i] != NULL);
+            for (int j = 0; j < i; j++)
+                assert(r.pics[j] != r.pics[i]);
+        }
+        assert(picture_pool_Get(pool) == NULL);
+        for (int i = 0; i < PICTURES; i++)
+            picture_Release(r.pics[i]);
+    }
+    picture_pool_Delete(pool);
+}
+
+static void test_pool_Wait(void)
+{
+    picture_pool_t *pool = pool_new();
+    releaser_t r = { .count = PICTURES, .delay = CLOCK_FREQ / 100 };
+    vlc_thread_t th;
+
+    for (int i = 0; i < PICTURES; i++)
+        r.pics[i] = picture_pool_Get(pool);
+    assert(picture_pool_Get(pool) == NULL);
+
+    /* Times out when nothing is released */
+    mtime_t start = mdate();
+    picture_pool_Wait(pool, start + CLOCK_FREQ / 20);
+    assert(mdate() - start >= CLOCK_FREQ / 20);
+
+    /* Wakes up on each release, well before the deadline */
+    if (vlc_clone(&th, Releaser, &r, VLC_THREAD_PRIORITY_LOW))
+        abort();
+    for (int i = 0; i < PICTURES; i++) {
+        picture_t *pic;
+
+        while ((pic = picture_pool_Get(pool)) == NULL)
+            picture_pool_Wait(pool, mdate() + 10 * CLOCK_FREQ);
+        r.pics[i] = pic;
+    }
+    vlc_join(th, NULL);
+    assert(mdate() - start < 5 * CLOCK_FREQ);
+
+    /* Does not wait if a picture was released after the failed get */
+    picture_Release(r.pics[0]);
+    start = mdate();
+    picture_pool_Wait(pool, start + 10 * CLOCK_FREQ);
+    assert(mdate() - start < 5 * CLOCK_FREQ);
+
+    /* Concurrent releases, all pictures back in the pool */
+    r.count = PICTURES - 1;
+    r.delay = 0;
+    for (int i = 0; i < r.count; i++)
+        r.pics[i] = r.pics[i + 1];
+    if (vlc_clone(&th, Releaser, &r, VLC_THREAD_PRIORITY_LOW))
+        abort();
+    for (int n = 0; n < 100000; n++) {
+        picture_t *pic = picture_pool_Get(pool);
+        if (pic)
+            picture_Release(pic);
+    }
+    vlc_join(th, NULL);
+    for (int i = 0; i < PICTURES; i++)
+        assert(picture_pool_Get(pool) != NULL);
+    assert(picture_pool_Get(pool) == NULL);
+
+    picture_pool_NonEmpty(pool, true);
+    picture_pool_Delete(pool);
+}
+
+int main(void)
+{
+    log("Testing picture pool get and release\n");
+    test_pool_GetRelease();
+    log("Testing picture pool reservation\n");
+    test_pool_Reserve();
+    log("Testing picture pool reservation and concurrent releases\n");
+    test_pool_ReserveDelete();
+    log("Testing picture pool waiting\n");
+    test_pool_Wait();
+
+    return 0;
+}